@@ -0,0 +1,625 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Measures the per cycle latency of the parts of the control hot path
+	and writes min/median/p99/max (in microseconds) for each of them as JSON:
+
+	cbf_bench [--cycles N] [--output file.json] [--examples dir] [--solver name ...] [controller.xml ...]
+
+	Covered are pseudo_inverse() and damped_pseudo_inverse() with each 
+	PseudoInverseSolver (or only those given with --solver, named as for 
+	pseudo_inverse_solver()) over a grid of jacobian sizes, on a jacobian
+	drifting slowly like that of an arm along a trajectory. For these the 
+	largest deviation from the JacobiSVD result is reported as well. Then
+	the KDL sensor transforms on a 7 DOF chain and a tree
+	and the native chain transforms on the same chain (when built with KDL), CompositeSensorTransform,
+	PythonSensorTransform with a script assigning lists and one writing
+	the arrays in place (when built with Python), and
+	PrimitiveController::step() for a built in linear controller (also as 
+	PrimitiveControllerN) and for each given XML controller file whose controller acts on a DummyResource
+	(when built with XSD), e.g. doc/examples/xml/kdl_kuka_pos.xml. Other
+	files are skipped with a note on stderr. Without controller files the
+	DummyResource examples from doc/examples/xml are run (or from the
+	directory given with --examples).
+*/
+
+#include <cbf/config.h>
+#include <cbf/types.h>
+#include <cbf/utilities.h>
+#include <cbf/sensor_transform.h>
+#include <cbf/linear_transform.h>
+#include <cbf/composite_transform.h>
+#include <cbf/primitive_controller.h>
+#include <cbf/primitive_controller_n.h>
+#include <cbf/dummy_resource.h>
+#include <cbf/dummy_reference.h>
+#include <cbf/identity_transform.h>
+#include <cbf/generic_transform.h>
+#include <cbf/square_potential.h>
+#include <cbf/combination_strategy.h>
+
+#ifdef CBF_HAVE_KDL
+	#include <cbf/kdl_transforms.h>
+	#include <cbf/chain_kinematics.h>
+	#include <kdl/chain.hpp>
+	#include <kdl/tree.hpp>
+	#include <kdl/segment.hpp>
+	#include <kdl/joint.hpp>
+	#include <kdl/frames.hpp>
+#endif
+
+#ifdef CBF_HAVE_PYTHON
+	#include <cbf/python_wrap.h>
+#endif
+
+#ifdef CBF_HAVE_XSD
+	#include <cbf/xml_object_factory.h>
+	#include <cbf/xsd_error_handler.h>
+	#include <cbf/schemas.hxx>
+#endif
+
+#include <boost/shared_ptr.hpp>
+
+#include <errno.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace CBF;
+
+/**
+	@brief One timed operation of the hot path
+*/
+struct Benchmark {
+	Benchmark(const std::string &name) : m_Name(name) { }
+	virtual ~Benchmark() { }
+
+	//! The operation whose latency is measured
+	virtual void cycle() = 0;
+
+	//! How far the results are off a reference, negative if there is none
+	virtual double deviation() { return -1; }
+
+	std::string m_Name;
+};
+
+typedef boost::shared_ptr<Benchmark> BenchmarkPtr;
+
+
+const Float damping_constant = 0.01;
+
+/**
+	Inverts a jacobian that drifts a little each cycle, so the 
+	WarmStartedSVD gets to warm start like in a running controller
+*/
+struct PseudoInverseBenchmark : public Benchmark {
+	PseudoInverseBenchmark(
+		unsigned int rows, 
+		unsigned int columns, 
+		bool damped, 
+		const std::string &solver_name
+	) :
+		Benchmark(""),
+		m_Start(FloatMatrix::Random(rows, columns)),
+		m_Drift(FloatMatrix::Random(rows, columns)),
+		m_Damped(damped),
+		m_Step(0),
+		m_Workspace(pseudo_inverse_solver(solver_name))
+	{
+		std::stringstream name;
+		name << (damped ? "damped_pseudo_inverse " : "pseudo_inverse ") << solver_name << " " << rows << "x" << columns;
+		m_Name = name.str();
+	}
+
+	virtual void cycle() {
+		m_Matrix = m_Start + sin(0.001 * m_Step++) * m_Drift;
+		invert(m_Workspace, m_Result);
+	}
+
+	//! The largest deviation from the JacobiSVD result over some more cycles
+	virtual double deviation() {
+		PseudoInverseWorkspace reference_workspace(JacobiSVDSolver);
+		FloatMatrix reference;
+		double max_deviation = 0;
+
+		for (unsigned int i = 0; i < 100; ++i) {
+			cycle();
+			invert(reference_workspace, reference);
+			max_deviation = std::max(max_deviation, (double)(m_Result - reference).cwiseAbs().maxCoeff());
+		}
+
+		return max_deviation;
+	}
+
+	void invert(PseudoInverseWorkspace &workspace, FloatMatrix &result) {
+		if (m_Damped)
+			damped_pseudo_inverse(m_Matrix, result, workspace, damping_constant);
+		else
+			pseudo_inverse(m_Matrix, result, workspace);
+	}
+
+	FloatMatrix m_Start;
+	FloatMatrix m_Drift;
+	FloatMatrix m_Matrix;
+	FloatMatrix m_Result;
+	bool m_Damped;
+	unsigned int m_Step;
+	PseudoInverseWorkspace m_Workspace;
+};
+
+
+/**
+	Updates the sensor transform with a resource value that changes a
+	little each cycle, like it does in a running controller, and reads
+	the task jacobian, so transforms computing it lazily pay for it too
+*/
+struct SensorTransformBenchmark : public Benchmark {
+	SensorTransformBenchmark(const std::string &name, SensorTransformPtr sensor_transform) :
+		Benchmark(name),
+		m_SensorTransform(sensor_transform),
+		m_ResourceValue(FloatVector::Constant(sensor_transform->resource_dim(), 0.1))
+	{ }
+
+	virtual void cycle() {
+		m_ResourceValue.array() += 0.0001;
+		m_SensorTransform->update(m_ResourceValue);
+		m_SensorTransform->task_jacobian();
+	}
+
+	SensorTransformPtr m_SensorTransform;
+	FloatVector m_ResourceValue;
+};
+
+
+struct ControllerBenchmark : public Benchmark {
+	ControllerBenchmark(const std::string &name, ControllerPtr controller) :
+		Benchmark(name),
+		m_Controller(controller)
+	{ }
+
+	virtual void cycle() {
+		m_Controller->step();
+	}
+
+	ControllerPtr m_Controller;
+};
+
+
+struct LatencyStatistics {
+	std::string m_Name;
+	double m_Min, m_Median, m_P99, m_Max, m_Mean;
+
+	//! See Benchmark::deviation()
+	double m_Deviation;
+};
+
+double now_in_microseconds() {
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return 1e6 * t.tv_sec + 1e-3 * t.tv_nsec;
+}
+
+LatencyStatistics measure(Benchmark &benchmark, unsigned int cycles) {
+	//! Warm up caches and lazily sized buffers
+	for (unsigned int i = 0; i < std::min(cycles, 100u); ++i)
+		benchmark.cycle();
+
+	std::vector<double> samples(cycles);
+	for (unsigned int i = 0; i < cycles; ++i) {
+		double start = now_in_microseconds();
+		benchmark.cycle();
+		samples[i] = now_in_microseconds() - start;
+	}
+
+	LatencyStatistics statistics;
+	statistics.m_Name = benchmark.m_Name;
+	statistics.m_Mean = 0;
+	for (unsigned int i = 0; i < cycles; ++i)
+		statistics.m_Mean += samples[i] / cycles;
+
+	std::sort(samples.begin(), samples.end());
+	statistics.m_Min = samples.front();
+	statistics.m_Median = samples[cycles / 2];
+	statistics.m_P99 = samples[std::min(cycles - 1, (unsigned int)ceil(0.99 * cycles) - 1)];
+	statistics.m_Max = samples.back();
+
+	statistics.m_Deviation = benchmark.deviation();
+
+	return statistics;
+}
+
+//! Benchmark names are file names or built from fixed strings, but quote them properly anyway
+std::string json_string(const std::string &s) {
+	std::string result = "\"";
+	for (unsigned int i = 0; i < s.size(); ++i) {
+		if (s[i] == '"' || s[i] == '\\') result += '\\';
+		result += s[i];
+	}
+	return result + "\"";
+}
+
+void write_json(std::ostream &out, const std::vector<LatencyStatistics> &statistics, unsigned int cycles) {
+	out << "{" << std::endl;
+	out << "  \"cycles\": " << cycles << "," << std::endl;
+	out << "  \"unit\": \"us\"," << std::endl;
+	out << "  \"benchmarks\": [" << std::endl;
+
+	for (unsigned int i = 0; i < statistics.size(); ++i) {
+		const LatencyStatistics &s = statistics[i];
+		out
+			<< "    {"
+			<< "\"name\": " << json_string(s.m_Name) << ", "
+			<< "\"min\": " << s.m_Min << ", "
+			<< "\"median\": " << s.m_Median << ", "
+			<< "\"p99\": " << s.m_P99 << ", "
+			<< "\"max\": " << s.m_Max << ", "
+			<< "\"mean\": " << s.m_Mean;
+
+		if (s.m_Deviation >= 0)
+			out << ", \"max_deviation\": " << s.m_Deviation;
+
+		out << "}" << (i + 1 < statistics.size() ? "," : "") << std::endl;
+	}
+
+	out << "  ]" << std::endl;
+	out << "}" << std::endl;
+}
+
+//! A 3x7 linear controller with a subordinate, built anew for each benchmark
+PrimitiveControllerPtr create_linear_controller(const FloatMatrix &coefficients) {
+	std::vector<SubordinateControllerPtr> subordinates;
+	subordinates.push_back(SubordinateControllerPtr(new SubordinateController(
+		0.1,
+		std::vector<ConvergenceCriterionPtr>(),
+		ReferencePtr(new DummyReference(1, 7)),
+		PotentialPtr(new SquarePotential(7)),
+		SensorTransformPtr(new IdentitySensorTransform(7)),
+		EffectorTransformPtr(new GenericEffectorTransform(7, 7)),
+		std::vector<SubordinateControllerPtr>(),
+		CombinationStrategyPtr(new AddingStrategy)
+	)));
+
+	return PrimitiveControllerPtr(new PrimitiveController(
+		1.0,
+		std::vector<ConvergenceCriterionPtr>(),
+		ReferencePtr(new DummyReference(1, 3)),
+		PotentialPtr(new SquarePotential(3)),
+		SensorTransformPtr(new LinearSensorTransform(coefficients)),
+		EffectorTransformPtr(new DampedGenericEffectorTransform(3, 7)),
+		subordinates,
+		CombinationStrategyPtr(new AddingStrategy),
+		ResourcePtr(new DummyResource(FloatVector::Constant(7, 0.1)))
+	));
+}
+
+#ifdef CBF_HAVE_KDL
+	//! The 7 DOF arm from tests/cbf_test_7dof_kdl_chain.cpp, with named segments for the tree
+	KDL::Chain create_chain() {
+		using namespace KDL;
+		Chain chain;
+
+		chain.addSegment(Segment("base", Joint(Joint::None), Frame(Rotation(), Vector(0.0, 0.0, 0.118))));
+		chain.addSegment(Segment("a1", Joint(Joint::RotZ), Frame(Rotation::RotZ(M_PI), Vector(0.0, 0.0, 0.192))));
+		chain.addSegment(Segment("a2", Joint(Joint::RotY), Frame(Rotation(), Vector(0.0, 0.0, 0.208))));
+		chain.addSegment(Segment("e1", Joint(Joint::RotZ), Frame(Rotation::RotZ(M_PI), Vector(0.0, 0.0, 0.192))));
+		chain.addSegment(Segment("a3", Joint(Joint::RotY), Frame(Rotation(), Vector(0.0, 0.0, 0.208))));
+		chain.addSegment(Segment("a4", Joint(Joint::RotZ), Frame(Rotation::RotZ(M_PI), Vector(0.0, 0.0, 0.182))));
+		chain.addSegment(Segment("a5", Joint(Joint::RotY), Frame(Rotation(), Vector(0.0, 0.0, 0.0))));
+		chain.addSegment(Segment("a6", Joint(Joint::RotZ), Frame(Rotation::RotZ(-M_PI), Vector(0.0, 0.0, 0.12))));
+
+		return chain;
+	}
+#endif
+
+#ifndef CBF_BENCH_EXAMPLES_DIR
+	#define CBF_BENCH_EXAMPLES_DIR "doc/examples/xml"
+#endif
+
+//! The examples that run a PrimitiveController on a DummyResource
+const char *example_file_names[] = {
+	"linear.xml",
+	"generic.xml",
+	"sensor_chain.xml",
+	"composite_sensor_transform.xml",
+	"composite_potential.xml",
+	"quaternion.xml",
+	"simple_factor.xml",
+	"simple_norm.xml",
+#ifdef CBF_HAVE_KDL
+	"kdl_simple_pos.xml",
+	"kdl_kuka_pos.xml",
+	"kdl_axis_angle.xml",
+	"kdl_kuka_composite.xml",
+	"simple_tree.xml",
+#endif
+#ifdef CBF_HAVE_PYTHON
+	"python_wrap.xml",
+#endif
+};
+
+//! The solvers compared when none are given with --solver
+const char *default_solver_names[] = {
+	"JacobiSVD",
+	"WarmStartedSVD",
+	"QR",
+	"DampedLeastSquares",
+#ifdef CBF_HAVE_EIGEN_3_3
+	"BDCSVD",
+	"CompleteOrthogonalDecomposition",
+#endif
+};
+
+//! Whether the solver implements pseudo_inverse() or damped_pseudo_inverse() respectively
+bool supports(PseudoInverseSolver solver, bool damped) {
+	if (damped)
+		return solver == JacobiSVDSolver || solver == BDCSVDSolver || solver == WarmStartedSVDSolver || solver == DampedLeastSquaresSolver;
+
+	return solver != DampedLeastSquaresSolver;
+}
+
+#ifdef CBF_HAVE_XSD
+	//! Returns a null pointer (and says why) if the file does not hold a PrimitiveController on a DummyResource
+	ControllerPtr load_controller(const std::string &file_name) {
+		CBF::XSDErrorHandler err_handler;
+		ObjectNamespacePtr object_namespace(new ObjectNamespace);
+
+		std::auto_ptr<CBFSchema::Object> xml_instance(
+			CBFSchema::Object_(file_name, err_handler, xml_schema::flags::dont_validate));
+
+		ObjectPtr object = XMLObjectFactory::instance()->create<Object>(*xml_instance, object_namespace);
+
+		PrimitiveControllerPtr controller = boost::dynamic_pointer_cast<PrimitiveController>(object);
+		if (!controller.get()) {
+			std::cerr << "skipping " << file_name << ": not a PrimitiveController" << std::endl;
+			return ControllerPtr();
+		}
+
+		if (!boost::dynamic_pointer_cast<DummyResource>(controller->resource()).get()) {
+			std::cerr << "skipping " << file_name << ": does not run against a DummyResource" << std::endl;
+			return ControllerPtr();
+		}
+
+		return controller;
+	}
+#endif
+
+int main(int argc, char *argv[]) {
+	unsigned int cycles = 10000;
+	std::string output_file_name;
+	std::string examples_dir = CBF_BENCH_EXAMPLES_DIR;
+	std::vector<std::string> controller_file_names;
+	std::vector<std::string> solver_names;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+
+		if (arg == "--help") {
+			std::cout << "usage: " << argv[0] << " [--cycles N] [--output file.json] [--examples dir] [--solver name ...] [controller.xml ...]" << std::endl;
+			return EXIT_SUCCESS;
+		}
+
+		if (arg != "--cycles" && arg != "--output" && arg != "--examples" && arg != "--solver") {
+			controller_file_names.push_back(arg);
+			continue;
+		}
+
+		if (i + 1 >= argc) {
+			std::cerr << arg << " needs a value" << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		const char *value = argv[++i];
+		if (arg == "--cycles") {
+			char *end;
+			errno = 0;
+			const long n = strtol(value, &end, 10);
+			if (end == value || *end != '\0' || errno != 0 || n <= 0 || n > 100000000L) {
+				std::cerr << "--cycles must be a number from 1 to 100000000, not " << value << std::endl;
+				return EXIT_FAILURE;
+			}
+			cycles = n;
+		} else if (arg == "--output") {
+			output_file_name = value;
+		} else if (arg == "--solver") {
+			try {
+				pseudo_inverse_solver(value);
+			} catch (const std::exception &e) {
+				std::cerr << e.what() << std::endl;
+				return EXIT_FAILURE;
+			}
+			solver_names.push_back(value);
+		} else {
+			examples_dir = value;
+		}
+	}
+
+	if (controller_file_names.empty()) {
+		for (unsigned int i = 0; i < sizeof(example_file_names) / sizeof(example_file_names[0]); ++i)
+			controller_file_names.push_back(examples_dir + "/" + example_file_names[i]);
+	}
+
+	if (solver_names.empty()) {
+		for (unsigned int i = 0; i < sizeof(default_solver_names) / sizeof(default_solver_names[0]); ++i)
+			solver_names.push_back(default_solver_names[i]);
+	}
+
+	srand(0);
+	std::vector<BenchmarkPtr> benchmarks;
+
+	const unsigned int task_dims[] = { 3, 6 };
+	const unsigned int resource_dims[] = { 7, 20, 40 };
+	for (unsigned int t = 0; t < sizeof(task_dims) / sizeof(task_dims[0]); ++t) {
+		for (unsigned int r = 0; r < sizeof(resource_dims) / sizeof(resource_dims[0]); ++r) {
+			for (unsigned int damped = 0; damped < 2; ++damped) {
+				for (unsigned int s = 0; s < solver_names.size(); ++s) {
+					if (supports(pseudo_inverse_solver(solver_names[s]), damped))
+						benchmarks.push_back(BenchmarkPtr(new PseudoInverseBenchmark(task_dims[t], resource_dims[r], damped, solver_names[s])));
+				}
+			}
+		}
+	}
+
+	//! const, so the coefficient matrix constructor gets picked
+	const FloatMatrix coefficients = FloatMatrix::Random(3, 7);
+	benchmarks.push_back(BenchmarkPtr(new SensorTransformBenchmark(
+		"CompositeSensorTransform 2x LinearSensorTransform",
+		SensorTransformPtr(new CompositeSensorTransform(
+			SensorTransformPtr(new LinearSensorTransform(coefficients)),
+			SensorTransformPtr(new LinearSensorTransform(coefficients))
+		))
+	)));
+
+	//! Controllers that do not need KDL or XSD, so there are always some
+	benchmarks.push_back(BenchmarkPtr(new ControllerBenchmark(
+		"PrimitiveController::step() LinearSensorTransform 3x7 with subordinate",
+		create_linear_controller(coefficients)
+	)));
+
+	benchmarks.push_back(BenchmarkPtr(new ControllerBenchmark(
+		"PrimitiveControllerN<3, 7>::step() LinearSensorTransform 3x7 with subordinate",
+		make_fixed_size_controller(create_linear_controller(coefficients))
+	)));
+
+	#ifdef CBF_HAVE_KDL
+		boost::shared_ptr<KDL::Chain> chain(new KDL::Chain(create_chain()));
+
+		boost::shared_ptr<KDL::Tree> tree(new KDL::Tree("root"));
+		tree->addChain(*chain, "root");
+		std::vector<std::string> segment_names(1, "a6");
+
+		benchmarks.push_back(BenchmarkPtr(new SensorTransformBenchmark(
+			"KDLChainPositionSensorTransform",
+			SensorTransformPtr(new KDLChainPositionSensorTransform(chain)))));
+
+		benchmarks.push_back(BenchmarkPtr(new SensorTransformBenchmark(
+			"KDLChainAxisAngleSensorTransform",
+			SensorTransformPtr(new KDLChainAxisAngleSensorTransform(chain)))));
+
+		benchmarks.push_back(BenchmarkPtr(new SensorTransformBenchmark(
+			"KDLChainPoseSensorTransform",
+			SensorTransformPtr(new KDLChainPoseSensorTransform(chain)))));
+
+		benchmarks.push_back(BenchmarkPtr(new SensorTransformBenchmark(
+			"KDLTreePositionSensorTransform",
+			SensorTransformPtr(new KDLTreePositionSensorTransform(tree, segment_names)))));
+
+		benchmarks.push_back(BenchmarkPtr(new SensorTransformBenchmark(
+			"KDLTreeAxisAngleSensorTransform",
+			SensorTransformPtr(new KDLTreeAxisAngleSensorTransform(tree, segment_names)))));
+
+		benchmarks.push_back(BenchmarkPtr(new SensorTransformBenchmark(
+			"CompositeSensorTransform KDLChainPosition + KDLChainAxisAngle",
+			SensorTransformPtr(new CompositeSensorTransform(
+				SensorTransformPtr(new KDLChainPositionSensorTransform(chain)),
+				SensorTransformPtr(new KDLChainAxisAngleSensorTransform(chain))
+			))
+		)));
+
+		benchmarks.push_back(BenchmarkPtr(new SensorTransformBenchmark(
+			"ChainPositionSensorTransform",
+			SensorTransformPtr(new ChainPositionSensorTransform(ChainKinematicsPtr(new ChainKinematics(*chain)))))));
+
+		benchmarks.push_back(BenchmarkPtr(new SensorTransformBenchmark(
+			"ChainAxisAngleSensorTransform",
+			SensorTransformPtr(new ChainAxisAngleSensorTransform(ChainKinematicsPtr(new ChainKinematics(*chain)))))));
+
+		benchmarks.push_back(BenchmarkPtr(new SensorTransformBenchmark(
+			"ChainPoseSensorTransform",
+			SensorTransformPtr(new ChainPoseSensorTransform(ChainKinematicsPtr(new ChainKinematics(*chain)))))));
+	#endif
+
+	#ifdef CBF_HAVE_PYTHON
+		const char *python_scripts[][2] = {
+			{
+				"PythonSensorTransform lists",
+				"jacobian = j\n"
+				"result = [sum(a * b for a, b in zip(row, resource)) for row in j]\n"
+			},
+			{
+				"PythonSensorTransform in place",
+				"for i in range(3):\n"
+				"	result[i] = 0\n"
+				"	for k in range(7):\n"
+				"		jacobian[i, k] = j[i][k]\n"
+				"		result[i] += j[i][k] * resource[k]\n"
+			}
+		};
+
+		std::stringstream init_script;
+		init_script << "j = [";
+		for (unsigned int row = 0; row < 3; ++row) {
+			init_script << "[";
+			for (unsigned int col = 0; col < 7; ++col)
+				init_script << coefficients(row, col) << ", ";
+			init_script << "], ";
+		}
+		init_script << "]\n";
+
+		for (unsigned int i = 0; i < 2; ++i) {
+			PythonSensorTransformPtr python_transform(new PythonSensorTransform(3, 7));
+			python_transform->m_InitScript = init_script.str();
+			python_transform->m_ExecScript = python_scripts[i][1];
+			benchmarks.push_back(BenchmarkPtr(new SensorTransformBenchmark(python_scripts[i][0], python_transform)));
+		}
+	#endif
+
+	#ifdef CBF_HAVE_XSD
+		for (unsigned int i = 0; i < controller_file_names.size(); ++i) {
+			try {
+				ControllerPtr controller = load_controller(controller_file_names[i]);
+				if (controller.get())
+					benchmarks.push_back(BenchmarkPtr(new ControllerBenchmark(
+						"PrimitiveController::step() " + controller_file_names[i], controller)));
+			} catch (const xml_schema::exception &e) {
+				std::cerr << "skipping " << controller_file_names[i] << ": " << e << std::endl;
+			} catch (const std::exception &e) {
+				std::cerr << "skipping " << controller_file_names[i] << ": " << e.what() << std::endl;
+			}
+		}
+	#else
+		std::cerr << "not running the controller files, CBF was built without XSD support" << std::endl;
+	#endif
+
+	std::vector<LatencyStatistics> statistics;
+	for (unsigned int i = 0; i < benchmarks.size(); ++i) {
+		std::cerr << "running " << benchmarks[i]->m_Name << std::endl;
+		statistics.push_back(measure(*benchmarks[i], cycles));
+	}
+
+	if (output_file_name.empty()) {
+		write_json(std::cout, statistics, cycles);
+	} else {
+		std::ofstream out(output_file_name.c_str());
+		if (!out) {
+			std::cerr << "could not open " << output_file_name << std::endl;
+			return EXIT_FAILURE;
+		}
+		write_json(out, statistics, cycles);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -20,8 +20,50 @@
 
 #include "cbf_run_controller.h"
 
+#include <boost/scoped_ptr.hpp>
+
+#include <iostream>
+
+#include <time.h>
+#include <unistd.h>
+
 namespace CBF {
 
+	namespace {
+		/**
+			The settings are single words written by any thread and read by
+			the control loop, so relaxed atomic accesses suffice
+		*/
+		template <class T> T load(const T *value) {
+			return __atomic_load_n(value, __ATOMIC_RELAXED);
+		}
+
+		template <class T> void store(T *value, T new_value) {
+			__atomic_store_n(value, new_value, __ATOMIC_RELAXED);
+		}
+
+		//! Field by field, so a status can be copied while it is being written
+		void copy_status(const CBFRunControllerStatus *from, CBFRunControllerStatus *to) {
+			store(&to->cycle, load(&from->cycle));
+			store(&to->running, load(&from->running));
+			store(&to->converged, load(&from->converged));
+			store(&to->steps_left, load(&from->steps_left));
+			store(&to->step_duration, load(&from->step_duration));
+			store(&to->period, load(&from->period));
+			store(&to->jitter, load(&from->jitter));
+			store(&to->overruns, load(&from->overruns));
+			store(&to->max_period, load(&from->max_period));
+			store(&to->max_jitter, load(&from->max_jitter));
+			store(&to->max_overrun, load(&from->max_overrun));
+		}
+
+		unsigned long microseconds() {
+			timespec t;
+			clock_gettime(CLOCK_MONOTONIC, &t);
+			return t.tv_sec * 1000000ul + t.tv_nsec / 1000;
+		}
+	}
+
 	CBFRunController::CBFRunController(
 				unsigned int sleep_time,
 				unsigned int steps,
@@ -33,14 +75,17 @@ namespace CBF {
 		:
 		m_ObjectNamespace(new ObjectNamespace),
 		m_SleepTime(sleep_time),
+		m_Period(0),
+		m_OverrunPolicy(CyclePacer::Skip),
 		m_Steps(steps),
 		m_VerbosityLevel(verbosity_level),
-		m_ControllerRunning(false),
-		m_ObjectNamespaceSet(false),
-		m_Converged(false)
 		#ifdef CBF_HAVE_QT
-			,m_QtSupport(qt_support)
+			m_QtSupport(qt_support),
 		#endif
+		m_ControllerRunning(false),
+		m_ObjectNamespaceSet(false),
+		m_Converged(false),
+		m_StatusSequence(0)
 	{
 	// nothing to do
 	}
@@ -53,24 +98,62 @@ namespace CBF {
 			throw ControllerNotFoundExcepption();
 		}
 
-		// does nothing if the controller is already running.
-		if(checkControllerRuns(true)){
-			throw ControllerRunningException();
+		// looking the controller up once, the loop does not touch the namespace.
+		ControllerPtr controller;
+		RealTimeOptions real_time_options;
+		{
+			boost::mutex::scoped_lock lock(m_ObjectNamespaceMutex);
+
+			// does nothing if the controller is already running.
+			if(checkControllerRuns(true)){
+				throw ControllerRunningException();
+			}
+
+			controller = m_ObjectNamespace -> get<CBF::Controller>(controller_name);
+			real_time_options = m_RealTimeOptions;
+		}
+
+		// restored when leaving, the calling thread may go on with other work.
+		boost::scoped_ptr<ScopedRealTime> real_time;
+		try {
+			real_time.reset(new ScopedRealTime(real_time_options));
+		} catch (std::runtime_error &e) {
+			std::cerr << "Warning: " << e.what() << ", running without." << std::endl;
+		}
+
+		// without a period the loop sleeps for sleepTime() after each step.
+		boost::scoped_ptr<CyclePacer> pacer;
+		if (period() > 0) {
+			pacer.reset(new CyclePacer(period() * 1000ull, overrunPolicy(), "cbf_run_controller"));
+			pacer -> start();
 		}
 
+		CBFRunControllerStatus status;
+		status.running = true;
+
 		// if the stepcount is 0 we are stepping till convergence
 		// setting stepCount != 0 in execution will make us leave this while-clause
 		// and go on with the next while clause till stepCount is less or equal 0.
-		while ((stepCount() == 0) 
-			&& (setConverged(m_ObjectNamespace -> get<CBF::Controller>(controller_name) -> step()) == false)) {
+		while (stepCount() == 0) {
+			const unsigned long start = microseconds();
+			const bool converged = setConverged(controller -> step());
+
+			status.cycle++;
+			status.converged = converged;
+			status.steps_left = 0;
+			status.step_duration = microseconds() - start;
+			publishStatus(status);
+
+			if (converged)
+				{ break; }
 
 			if (!checkControllerRuns()) //stops execution
-				{return; }
+				{ break; }
 
 			if (verbosityLevel())
 				{ std::cout << "step" << std::endl; }
 
-			usleep(sleepTime() * 1000);
+			waitForNextCycle(pacer.get(), status);
 
 			#ifdef CBF_HAVE_QT
 				if (qtSupport()) QApplication::processEvents();
@@ -82,19 +165,28 @@ namespace CBF {
 				{ std::cout << "step" << std::endl; }
 
 			if (!checkControllerRuns()) //stops execution
-				{return; }
+				{ break; }
 
-			m_ObjectNamespace -> get<CBF::Controller>(controller_name) -> step();
+			const unsigned long start = microseconds();
+			status.converged = controller -> step();
+			status.step_duration = microseconds() - start;
 
-			usleep(sleepTime() * 1000);
+			waitForNextCycle(pacer.get(), status);
 
 			#ifdef CBF_HAVE_QT
 				if (qtSupport()) QApplication::processEvents();
 			#endif
 			decStepCount();
+
+			status.cycle++;
+			status.steps_left = stepCount();
+			publishStatus(status);
 		}
 		//setting m_ControllerRunning to false.
 		stop_controller();
+
+		status.running = false;
+		publishStatus(status);
 	}
 
 	void CBFRunController::stop_controller(){
@@ -102,75 +194,133 @@ namespace CBF {
 	}
 
 	void CBFRunController::setSleepTime(unsigned int time){
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_SleepTimeMonitor);
-		m_SleepTime = time;
+		store(&m_SleepTime, time);
 	}
 
 	unsigned int CBFRunController::sleepTime(){
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_SleepTimeMonitor);
-		return m_SleepTime;
+		return load(&m_SleepTime);
+	}
+
+	void CBFRunController::setPeriod(unsigned int period){
+		store(&m_Period, period);
+	}
+
+	unsigned int CBFRunController::period(){
+		return load(&m_Period);
+	}
+
+	void CBFRunController::setOverrunPolicy(CyclePacer::OverrunPolicy policy){
+		store(&m_OverrunPolicy, policy);
+	}
+
+	CyclePacer::OverrunPolicy CBFRunController::overrunPolicy(){
+		return load(&m_OverrunPolicy);
+	}
+
+	void CBFRunController::setRealTimeOptions(const RealTimeOptions &options){
+		boost::mutex::scoped_lock lock(m_ObjectNamespaceMutex);
+		m_RealTimeOptions = options;
+	}
+
+	RealTimeOptions CBFRunController::realTimeOptions(){
+		boost::mutex::scoped_lock lock(m_ObjectNamespaceMutex);
+		return m_RealTimeOptions;
+	}
+
+	void CBFRunController::waitForNextCycle(CyclePacer *pacer, CBFRunControllerStatus &status){
+		if (!pacer) {
+			usleep(sleepTime() * 1000);
+			return;
+		}
+
+		pacer -> wait();
+
+		status.period = pacer -> last_period() / 1000;
+		status.jitter = pacer -> jitter() / 1000;
+		status.overruns = pacer -> overruns();
+		status.max_period = pacer -> max_period() / 1000;
+		status.max_jitter = pacer -> max_jitter() / 1000;
+		status.max_overrun = pacer -> max_overrun() / 1000;
 	}
 
 	void CBFRunController::setStepCount(unsigned int steps){
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_StepsMonitor);
-		m_Steps = steps;
+		store(&m_Steps, steps);
 	}
 
 	unsigned int CBFRunController::stepCount(){
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_StepsMonitor);
-		return m_Steps;
+		return load(&m_Steps);
 	}
 
 	void CBFRunController::decStepCount(){
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_StepsMonitor);
-		m_Steps--;
+		// not below 0 when setStepCount(0) came in between.
+		unsigned int steps = load(&m_Steps);
+		while (steps > 0 && !__atomic_compare_exchange_n(&m_Steps, &steps, steps - 1, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) { }
 	}
 
 	void CBFRunController::setVerbosityLevel(unsigned int verbosity_level){
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_VerbosityLevelMonitor);
-		m_VerbosityLevel = verbosity_level;
+		store(&m_VerbosityLevel, verbosity_level);
 	}
 
 	unsigned int CBFRunController::verbosityLevel(){
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_VerbosityLevelMonitor);
-		return m_VerbosityLevel;
+		return load(&m_VerbosityLevel);
 	}
 
 	bool CBFRunController::checkControllerRuns(bool running){
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_ControllerRunningMonitor);
-		bool was_running = m_ControllerRunning;		
-		m_ControllerRunning = running;
-		return was_running;
+		return __atomic_exchange_n(&m_ControllerRunning, running, __ATOMIC_ACQ_REL);
 	}
 
 	bool CBFRunController::checkControllerRuns(){
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_ControllerRunningMonitor);
-		return m_ControllerRunning;
+		return __atomic_load_n(&m_ControllerRunning, __ATOMIC_ACQUIRE);
 	}
 
 	bool CBFRunController::checkObjectNamespaceSet(){
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_ControllerRunningMonitor);
+		boost::mutex::scoped_lock lock(m_ObjectNamespaceMutex);
 		return m_ObjectNamespaceSet;
 	}
 	
 	bool CBFRunController::setConverged(bool converged){
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_ConvergedMonitor);
-		m_Converged = converged;
-		return m_Converged;
+		store(&m_Converged, converged);
+		return converged;
 	}
 	
 	bool CBFRunController::checkConverged(){
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_ConvergedMonitor);
-		return m_Converged;
+		return load(&m_Converged);
+	}
+
+	void CBFRunController::publishStatus(const CBFRunControllerStatus &status){
+		// readers of the other copy are not disturbed, readers of this one notice the odd sequence.
+		const unsigned long sequence = m_StatusSequence;
+		__atomic_store_n(&m_StatusSequence, sequence + 1, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+
+		copy_status(&status, &m_Status[(sequence / 2 + 1) % 2]);
+
+		__atomic_store_n(&m_StatusSequence, sequence + 2, __ATOMIC_RELEASE);
+	}
+
+	CBFRunControllerStatus CBFRunController::status(){
+		CBFRunControllerStatus status;
+
+		while (true) {
+			// the last complete status, which is not written until the one after the next
+			const unsigned long sequence = __atomic_load_n(&m_StatusSequence, __ATOMIC_ACQUIRE);
+			const unsigned long published = sequence / 2;
+
+			copy_status(&m_Status[published % 2], &status);
+
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if (__atomic_load_n(&m_StatusSequence, __ATOMIC_RELAXED) < 2 * (published + 1) + 1)
+				return status;
+		}
 	}
 	
 	bool CBFRunController::checkControllerExists(std::string controller_name)
 		throw(ObjectNamespaceNotSetException, ControllerNotFoundExcepption){
+		boost::mutex::scoped_lock lock(m_ObjectNamespaceMutex);
 		// Throws an exception when no ObjectNamespace is set.
-		if(!checkObjectNamespaceSet()){
+		if(!m_ObjectNamespaceSet){
 			throw ObjectNamespaceNotSetException();
 		}
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_ControllerRunningMonitor);
 		//returns whether the controller is in the ObjectNamespace.
 		CBF_DEBUG("checking for controller");
 		try{
@@ -185,8 +335,8 @@ namespace CBF {
 		throw(ControllerRunningException)
 	{
 		//controller should be stopped when we change the ObjectNamespace
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_ControllerRunningMonitor);
-		if(!m_ControllerRunning){
+		boost::mutex::scoped_lock lock(m_ObjectNamespaceMutex);
+		if(!checkControllerRuns()){
 			m_ObjectNamespace = object_namespace;
 			m_ObjectNamespaceSet = true;
 		} else {
@@ -198,7 +348,7 @@ namespace CBF {
 		 throw(ObjectNamespaceNotSetException)
 	{
 		//controller should be stopped while we copy the object_namespace
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_ControllerRunningMonitor);
+		boost::mutex::scoped_lock lock(m_ObjectNamespaceMutex);
 		if (m_ObjectNamespaceSet) {
 			return CBF::ObjectNamespacePtr(new CBF::ObjectNamespace(*m_ObjectNamespace));
 		} else {
@@ -208,13 +358,11 @@ namespace CBF {
 
 #ifdef CBF_HAVE_QT
 	void CBFRunController::setQTSupport(bool qt_support){
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_QtSupportMonitor);
-		m_QtSupport = qt_support;
+		store(&m_QtSupport, qt_support);
 	}
 
 	bool CBFRunController::qtSupport(){
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_QtSupportMonitor);
-		return m_QtSupport;
+		return load(&m_QtSupport);
 	}
 #endif
 
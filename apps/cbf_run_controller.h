@@ -26,15 +26,14 @@
 #include <cbf/control_basis.h>
 #include <cbf/debug_macros.h>
 #include <cbf/namespace.h>
+#include <cbf/cycle_pacer.h>
 
 #ifdef CBF_HAVE_QT
 	#include <QApplication>
 #endif
 
-#include <IceUtil/Monitor.h> 
-#include <IceUtil/RecMutex.h>
-
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <stdexcept>
 
@@ -84,10 +83,96 @@ struct ControllerNotFoundExcepption : std::runtime_error {
 
 
 
+/**
+	@brief What the control loop of a CBFRunController did in its
+	last cycle, see CBFRunController::status().
+*/
+struct CBFRunControllerStatus {
+	CBFRunControllerStatus() :
+		cycle(0),
+		running(false),
+		converged(false),
+		steps_left(0),
+		step_duration(0),
+		period(0),
+		jitter(0),
+		overruns(0),
+		max_period(0),
+		max_jitter(0),
+		max_overrun(0)
+	{ }
+
+	/**
+		@brief The cycles run since start_controller().
+	*/
+	unsigned long cycle;
+
+	/**
+		@brief Whether the control loop is running.
+	*/
+	bool running;
+
+	/**
+		@brief Whether the controller converged in the last step().
+	*/
+	bool converged;
+
+	/**
+		@brief The steps left to perform, 0 when running until convergence.
+	*/
+	unsigned int steps_left;
+
+	/**
+		@brief The duration of the last step() in microseconds.
+	*/
+	unsigned long step_duration;
+
+	/**
+		@brief The time between the last two cycles in microseconds, 0
+		without a fixed period (see CBFRunController::setPeriod()).
+	*/
+	unsigned long period;
+
+	/**
+		@brief How late the last cycle started after its deadline in
+		microseconds, 0 without a fixed period.
+	*/
+	unsigned long jitter;
+
+	/**
+		@brief The cycles that ended after their deadline since
+		start_controller(), 0 without a fixed period.
+	*/
+	unsigned long overruns;
+
+	/**
+		@brief The largest period, jitter and overrun (how late a cycle
+		ended after its deadline) since start_controller() in
+		microseconds, 0 without a fixed period.
+	*/
+	unsigned long max_period;
+	unsigned long max_jitter;
+	unsigned long max_overrun;
+};
+
 /**
 	@brief A struct that runs a controller from a controller 
 	name and a ObjectNamespacePtr. The execution of the controller
 	and all functions are (meant to be) threadsafe.
+
+	The control loop never takes a lock: the settings (sleep time,
+	step count, verbosity, Qt support, running) are single words
+	accessed atomically, and the status of each cycle is published to
+	observers through a double buffer (see status()). Only the
+	ObjectNamespace is guarded by a mutex, which the loop does not
+	touch after start_controller() looked the controller up.
+
+	With a period set (setPeriod()) the loop runs at a fixed rate,
+	sleeping until absolute deadlines instead of for the sleep time,
+	and records the period, jitter and overruns into the histograms
+	cbf_run_controller.period, .jitter and .overrun (see
+	print_cycle_time_histograms()). Their current and largest values 
+	are also part of the status, for observers of the running loop.
 */
 struct CBFRunController {
 	public:
@@ -137,6 +222,44 @@ struct CBFRunController {
 	*/
 	unsigned int sleepTime();
 
+	/**
+		@brief Sets the period of the control loop in microseconds, 0 to
+		sleep for the sleep-time after each step instead (thread-save).
+		Takes effect at the next start_controller().
+	*/
+	void setPeriod(unsigned int period);
+
+	/**
+		@brief Returns the period in microseconds (thread-save).
+	*/
+	unsigned int period();
+
+	/**
+		@brief Sets what happens when a step takes longer than the period
+		(thread-save). Takes effect at the next start_controller().
+	*/
+	void setOverrunPolicy(CyclePacer::OverrunPolicy policy);
+
+	/**
+		@brief Returns the overrun policy (thread-save).
+	*/
+	CyclePacer::OverrunPolicy overrunPolicy();
+
+	/**
+		@brief Sets the scheduling priority, CPU and memory locking that
+		start_controller() applies to the thread calling it (thread-save).
+		The priority and CPU are restored and the memory unlocked when
+		start_controller() returns, see ScopedRealTime. When they can not be applied
+		(e.g. for lack of privileges) a warning is printed and the
+		controller runs without them.
+	*/
+	void setRealTimeOptions(const RealTimeOptions &options);
+
+	/**
+		@brief Returns the real time options (thread-save).
+	*/
+	RealTimeOptions realTimeOptions();
+
 	/**
 		@brief Changes the amount of steps (thread-save).
 
@@ -183,7 +306,8 @@ struct CBFRunController {
 	/**
 		@brief Starts to run the controller 'controller_name' from the m_ObjectNamespace.
 		m_ObjectNamespace must be set before. Waits for m_SleepTime milliseconds after each
-		step of execution. Execution can be stopped through stop_controller().
+		step of execution, or until the next deadline when a period is set. Execution can
+		be stopped through stop_controller().
 
 		If m_Steps == 0 the controller runs until convergence.
 		If m_Steps > 0 this amount of steps will be performed.
@@ -226,6 +350,12 @@ struct CBFRunController {
 	*/
 	bool checkConverged();
 
+	/**
+		@brief Returns the status the control loop published after its last
+		cycle (thread safe). Never blocks the control loop.
+	*/
+	CBFRunControllerStatus status();
+
 
 	private:
 
@@ -239,6 +369,21 @@ struct CBFRunController {
 	*/
 	unsigned int m_SleepTime;
 
+	/**
+		@brief Holds the period in microseconds, 0 for none.
+	*/
+	unsigned int m_Period;
+
+	/**
+		@brief Holds the overrun policy.
+	*/
+	CyclePacer::OverrunPolicy m_OverrunPolicy;
+
+	/**
+		@brief Holds the real time options, guarded by m_ObjectNamespaceMutex.
+	*/
+	RealTimeOptions m_RealTimeOptions;
+
 	/**
 		@brief Holds the amount of steps to perform.
 	*/
@@ -273,41 +418,34 @@ struct CBFRunController {
 
 	/**
 		@brief The mutex-lock that is used for the thread 
-		syncronization of the sleep-time resource.
+		syncronization of the ObjectNamespace, and of setting
+		it against starting the controller. Also guards the
+		real time options.
 	*/
-	IceUtil::Monitor<IceUtil::RecMutex> m_SleepTimeMonitor;
+	boost::mutex m_ObjectNamespaceMutex;
 
 	/**
-		@brief The mutex-lock that is used for the thread 
-		syncronization of the steps resource.
+		@brief Two copies of the status, the control loop writes the one
+		observers are not reading.
 	*/
-	IceUtil::Monitor<IceUtil::RecMutex> m_StepsMonitor;
+	CBFRunControllerStatus m_Status[2];
 
 	/**
-		@brief The mutex-lock that is used for the thread 
-		syncronization of the verbosity-level resource.
+		@brief Twice the number of statuses published, plus 1 while the
+		control loop writes the next one.
 	*/
-	IceUtil::Monitor<IceUtil::RecMutex> m_VerbosityLevelMonitor;
+	unsigned long m_StatusSequence;
 
 	/**
-		@brief The mutex-lock that is used for the thread 
-		syncronization of the controllerRunning resource.
+		@brief Publishes the status of a cycle. Only called by the control loop.
 	*/
-	IceUtil::Monitor<IceUtil::RecMutex> m_ControllerRunningMonitor;
-	
+	void publishStatus(const CBFRunControllerStatus &status);
+
 	/**
-		@brief The mutex-lock that is used for the thread 
-		syncronization of the converged resource.
+		@brief Sleeps until the next cycle: until the pacer's next deadline,
+		or for the sleep time without a pacer. Updates the timing of the status.
 	*/
-	IceUtil::Monitor<IceUtil::RecMutex> m_ConvergedMonitor;
-
-	#ifdef CBF_HAVE_QT
-		/**
-			@brief The mutex-lock that is used for the thread 
-			syncronization of the qt-support resource.
-		*/
-		IceUtil::Monitor<IceUtil::RecMutex> m_QtSupportMonitor;
-	#endif
+	void waitForNextCycle(CyclePacer *pacer, CBFRunControllerStatus &status);
 
 	/**
 		@brief a thread safe way to check whether the controller
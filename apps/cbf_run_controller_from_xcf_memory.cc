@@ -27,6 +27,8 @@
 #include "xcf_memory_run_controller.h"
 #include "cbf_run_controller.h"
 
+#include <cbf/cycle_pacer.h>
+
 #ifdef CBF_HAVE_QT
 	#include <QApplication>
 	#include <QWaitCondition>
@@ -47,6 +49,25 @@ namespace po = boost::program_options;
 const unsigned int SLEEP_TIME = 0;
 const unsigned int STEPS = 0;
 
+/**
+	Prints what the control loop did in its last cycle, as published by 
+	the loop. The histograms are left to the loop's thread.
+*/
+void report(CBF::CBFRunControllerPtr run_controller) {
+	CBF::CBFRunControllerStatus status = run_controller->status();
+	std::cout
+		<< "cycle " << status.cycle
+		<< (status.running ? " running" : " stopped")
+		<< (status.converged ? ", converged" : "")
+		<< ", step " << status.step_duration << " us"
+		<< ", period " << status.period << " us"
+		<< ", jitter " << status.jitter << " us"
+		<< ", overruns " << status.overruns
+		<< ", max period " << status.max_period << " us"
+		<< ", max jitter " << status.max_jitter << " us"
+		<< ", max overrun " << status.max_overrun << " us" << std::endl;
+}
+
 int main(int argc, char *argv[]) {
 	po::options_description options_description("Allowed options");
 	options_description.add_options() 
@@ -74,6 +95,36 @@ int main(int argc, char *argv[]) {
 			po::value<unsigned int>(),
 			"Verbosity level"
 		)
+		(
+			"period",
+			po::value<unsigned int>(),
+			"run controllers at a fixed rate, cycles start every period microseconds"
+		)
+		(
+			"overrun",
+			po::value<std::string>(),
+			"what to do when a cycle takes longer than the period: skip (the missed cycles, default) or catch-up"
+		)
+		(
+			"priority",
+			po::value<int>(),
+			"run the control loop with this SCHED_FIFO priority"
+		)
+		(
+			"cpu",
+			po::value<int>(),
+			"pin the control loop to this CPU"
+		)
+		(
+			"lock-memory",
+			po::value<bool>(),
+			"lock all pages into memory"
+		)
+		(
+			"report-interval",
+			po::value<unsigned int>(),
+			"print the status (period, jitter, overruns) every this many seconds"
+		)
 		#ifdef CBF_HAVE_QT
 			(
 				"qt-main-loop",
@@ -139,6 +190,35 @@ int main(int argc, char *argv[]) {
 			verbosity_level = variables_map["verbose"].as<unsigned int>();
 		}
 
+	CBF::CyclePacer::OverrunPolicy overrun_policy = CBF::CyclePacer::Skip;
+	if (variables_map.count("overrun")) {
+		std::string overrun = variables_map["overrun"].as<std::string>();
+		if (overrun == "catch-up") {
+			overrun_policy = CBF::CyclePacer::CatchUp;
+		} else if (overrun != "skip") {
+			std::cout << "Unknown overrun policy: " << overrun << std::endl;
+			std::cout << options_description << std::endl;
+			return(EXIT_FAILURE);
+		}
+	}
+
+	CBF::RealTimeOptions real_time_options;
+	if (variables_map.count("priority")) {
+		real_time_options.priority = variables_map["priority"].as<int>();
+	}
+	if (variables_map.count("cpu")) {
+		real_time_options.cpu = variables_map["cpu"].as<int>();
+	}
+	if (variables_map.count("lock-memory")) {
+		real_time_options.lock_memory = variables_map["lock-memory"].as<bool>();
+	}
+
+	// in seconds, 0 for no reports.
+	unsigned int report_interval = 0;
+	if (variables_map.count("report-interval")) {
+		report_interval = variables_map["report-interval"].as<unsigned int>();
+	}
+
 	#ifdef CBF_HAVE_QT
 		bool qt_support = false;
 		if (variables_map.count("qt-main-loop")) {
@@ -168,6 +248,16 @@ int main(int argc, char *argv[]) {
 				#endif
 					);
 
+	CBF::CBFRunControllerPtr run_controller = controller.runController();
+	if (variables_map.count("period")) {
+		run_controller->setPeriod(variables_map["period"].as<unsigned int>());
+	}
+	run_controller->setOverrunPolicy(overrun_policy);
+	run_controller->setRealTimeOptions(real_time_options);
+
+	const unsigned long long report_nanoseconds = report_interval * 1000000000ULL;
+	unsigned long long next_report = CBF::cycle_time_now() + report_nanoseconds;
+
 	CBF_DEBUG("ready...");
 	while(true){
 		#ifdef CBF_HAVE_QT
@@ -179,9 +269,15 @@ int main(int argc, char *argv[]) {
 			mutex.unlock();
 		#else
 			CBF_DEBUG("sleeping...");
-			// we just go to sleep. controller will run everything
-			usleep(10000 * 10000);
+			// we just go to sleep (until the next report). controller will run everything
+			if (report_interval) sleep(report_interval);
+			else usleep(10000 * 10000);
 		#endif
+
+		if (report_interval && CBF::cycle_time_now() >= next_report) {
+			report(run_controller);
+			next_report += report_nanoseconds;
+		}
 	}
 
 	CBF_DEBUG("Quitting with success");
@@ -26,6 +26,7 @@
 #include <cbf/xsd_error_handler.h>
 #include <cbf/object_list.h>
 #include <cbf/xml_object_factory.h>
+#include <cbf/cycle_pacer.h>
 
 #ifdef CBF_HAVE_QT
 	#include <QApplication>
@@ -42,9 +43,32 @@
 #include <cbf/schemas.hxx>
 
 #include <boost/program_options.hpp>
+#include <boost/scoped_ptr.hpp>
 
 namespace po = boost::program_options;
 
+/**
+	Sleeps until the next cycle: until the pacer's next deadline, or for
+	sleep_time milliseconds without a pacer. Prints the cycle time
+	histograms every report_interval nanoseconds (never if 0).
+*/
+void wait_for_next_cycle(
+	CBF::CyclePacer *pacer,
+	unsigned int sleep_time,
+	unsigned long long report_interval,
+	unsigned long long &next_report
+) {
+	if (pacer)
+		pacer->wait();
+	else
+		usleep((long long int)sleep_time * 1000);
+
+	if (report_interval && CBF::cycle_time_now() >= next_report) {
+		CBF::print_cycle_time_histograms(std::cout);
+		next_report += report_interval;
+	}
+}
+
 int main(int argc, char *argv[]) {
 	po::options_description options_description("Allowed options");
 	options_description.add_options() 
@@ -57,6 +81,36 @@ int main(int argc, char *argv[]) {
 			po::value<unsigned int>(), 
 			"time to sleep between cycles in milliseconds"
 		)
+		(
+			"period",
+			po::value<unsigned int>(),
+			"run at a fixed rate, cycles start every period microseconds (replaces sleep-time)"
+		)
+		(
+			"overrun",
+			po::value<std::string>(),
+			"what to do when a cycle takes longer than the period: skip (the missed cycles, default) or catch-up"
+		)
+		(
+			"priority",
+			po::value<int>(),
+			"run with this SCHED_FIFO priority"
+		)
+		(
+			"cpu",
+			po::value<int>(),
+			"pin the control loop to this CPU"
+		)
+		(
+			"lock-memory",
+			po::value<bool>(),
+			"lock all pages into memory"
+		)
+		(
+			"report-interval",
+			po::value<unsigned int>(),
+			"print the cycle time histograms (period, jitter, overruns) every this many seconds"
+		)
 		(
 			"steps", 
 			po::value<unsigned int>(), 
@@ -110,6 +164,42 @@ int main(int argc, char *argv[]) {
 	if (variables_map.count("sleep-time"))
 		sleep_time = variables_map["sleep-time"].as<unsigned int>();
 
+	//! period in microseconds, 0 for sleeping sleep_time instead
+	unsigned int period = 0;
+
+	if (variables_map.count("period"))
+		period = variables_map["period"].as<unsigned int>();
+
+	CBF::CyclePacer::OverrunPolicy overrun_policy = CBF::CyclePacer::Skip;
+
+	if (variables_map.count("overrun")) {
+		std::string overrun = variables_map["overrun"].as<std::string>();
+		if (overrun == "catch-up") {
+			overrun_policy = CBF::CyclePacer::CatchUp;
+		} else if (overrun != "skip") {
+			std::cout << "Unknown overrun policy: " << overrun << std::endl;
+			std::cout << options_description << std::endl;
+			return(EXIT_FAILURE);
+		}
+	}
+
+	CBF::RealTimeOptions real_time_options;
+
+	if (variables_map.count("priority"))
+		real_time_options.priority = variables_map["priority"].as<int>();
+
+	if (variables_map.count("cpu"))
+		real_time_options.cpu = variables_map["cpu"].as<int>();
+
+	if (variables_map.count("lock-memory"))
+		real_time_options.lock_memory = variables_map["lock-memory"].as<bool>();
+
+	//! report interval in nanoseconds
+	unsigned long long report_interval = 0;
+
+	if (variables_map.count("report-interval"))
+		report_interval = variables_map["report-interval"].as<unsigned int>() * 1000000000ULL;
+
 	if (!variables_map.count("object")) {
 		std::cout << "No XML files with object descriptions provided" << std::endl;
 		std::cout << options_description << std::endl;
@@ -158,6 +248,19 @@ int main(int argc, char *argv[]) {
 
 		CBF::ControllerPtr controller = object_namespace->get<CBF::Controller>(controller_name);
 
+		try {
+			CBF::setup_real_time(real_time_options);
+		} catch (std::runtime_error &e) {
+			std::cerr << "Warning: " << e.what() << ", running without." << std::endl;
+		}
+
+		boost::scoped_ptr<CBF::CyclePacer> pacer;
+		if (period > 0)
+			pacer.reset(new CBF::CyclePacer(period * 1000ULL, overrun_policy, "cbf_run_controller"));
+
+		unsigned long long next_report = CBF::cycle_time_now() + report_interval;
+		if (pacer) pacer->start();
+
 		if (variables_map.count("steps")) {
 			for (
 				unsigned int step = 0, steps = variables_map["steps"].as<unsigned int>(); 
@@ -168,7 +271,7 @@ int main(int argc, char *argv[]) {
 					{ std::cout << "steps" << std::endl; }
 
 				controller->step(); 
-				usleep((long long int)sleep_time * 1000); 
+				wait_for_next_cycle(pacer.get(), sleep_time, report_interval, next_report);
 				#ifdef CBF_HAVE_QT
 					if (qt_support) QApplication::processEvents();
 				#endif
@@ -178,12 +281,15 @@ int main(int argc, char *argv[]) {
 				if (variables_map.count("verbose"))
 					{ std::cout << "step" << std::endl; }
 
-				usleep(sleep_time * 1000);
+				wait_for_next_cycle(pacer.get(), sleep_time, report_interval, next_report);
 				#ifdef CBF_HAVE_QT
 					if (qt_support) QApplication::processEvents();
 				#endif
 			}
 		}
+
+		if (pacer || report_interval)
+			CBF::print_cycle_time_histograms(std::cout);
 	} catch (const xml_schema::exception& e) {
 		std::cerr << "Error during parsing:" << std::endl;
 		std::cerr << e << std::endl;
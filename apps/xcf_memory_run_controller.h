@@ -102,6 +102,12 @@ struct XCFMemoryRunController {
 		void handle_events();
 	#endif
 
+	/**
+		@brief Returns the CBFRunController which is used for the execution,
+		e.g. to set its period or to observe its status().
+	*/
+	CBFRunControllerPtr runController() { return m_RunController; }
+
 	private:
 
 	/**
@@ -59,7 +59,7 @@ boost::shared_ptr<KDL::Chain> createChain (int iNumJointTriples=5) {
 CBF::PrimitiveControllerPtr createController (boost::shared_ptr<KDL::Chain> chain) {
 	//! position + orientation control = 6D
 	CBF::DummyReferencePtr reference(new CBF::DummyReference(1,6));
-	reference->references()[0] = CBF::FloatVector::Unit(6,1);
+	reference->set_reference(CBF::FloatVector::Unit(6,1));
 
 	//! sensor transform for position + axis angle control
 	std::vector<CBF::SensorTransformPtr> sensorTrafos = boost::assign::list_of
@@ -45,10 +45,27 @@ namespace CBF {
 			const std::vector<FloatVector > &references,
 			const FloatVector &input
 		) {
+			//! Find the closest reference
+			unsigned int min_index = 0;
+
+			if (m_ReferenceIndex.applies(references.size())) {
+				min_index = m_ReferenceIndex.closest(references, input, m_ReferencesVersion);
+			} else {
+				Float min_distance = distance(input, references[0]);
+
+				for (unsigned int i = 1; i < references.size(); ++i) {
+					Float cur_distance = distance(input, references[i]);
+					if (cur_distance < min_distance) {
+						min_index = i;
+						min_distance = cur_distance;
+					}
+				}
+			}
+
 			CBF_DEBUG("[AxisAnglePotential]: input: " << input.transpose());
-			CBF_DEBUG("[AxisAnglePotential]: ref: " << references[0].transpose());
+			CBF_DEBUG("[AxisAnglePotential]: ref: " << references[min_index].transpose());
 			Quaternion in; in.from_axis_angle3(input);
-			Quaternion ref; ref.from_axis_angle3(references[0]);
+			Quaternion ref; ref.from_axis_angle3(references[min_index]);
 			if (in.dot(ref) < 0) ref *= -1.;
 
 			Quaternion step = ref * in.conjugate();
@@ -70,7 +87,8 @@ namespace CBF {
 
 	#ifdef CBF_HAVE_XSD
 		AxisAnglePotential::AxisAnglePotential(const CBFSchema::AxisAnglePotential &xml_instance, ObjectNamespacePtr object_namespace) :
-			Potential(xml_instance, object_namespace) {
+			Potential(xml_instance, object_namespace),
+			m_ReferenceIndex(ReferenceIndex::Rotation) {
 			CBF_DEBUG("[AxisAnglePotential(const AxisAnglePotentialType &xml_instance)]: yay!");
 			CBF_DEBUG("Coefficient: " << xml_instance.Coefficient());
 			m_Coefficient = xml_instance.Coefficient();
@@ -25,7 +25,8 @@ namespace CBF {
 	#ifdef CBF_HAVE_XSD
 
 		AxisPotential::AxisPotential(const CBFSchema::AxisPotential &xml_instance, ObjectNamespacePtr object_namespace) :
-			Potential(xml_instance, object_namespace) {
+			Potential(xml_instance, object_namespace),
+			m_ReferenceIndex(ReferenceIndex::Direction) {
 			CBF_DEBUG("[AxisAnglePotential(const AxisAnglePotentialType &xml_instance)]: yay!");
 			CBF_DEBUG("Coefficient: " << xml_instance.Coefficient());
 			m_Coefficient = xml_instance.Coefficient();
@@ -138,11 +138,7 @@ cbf_controller_set_reference(struct cbf_primitive_controller* c, double *referen
 		return -1;
 	}
 
-	std::copy(
-		reference,
-		reference + d->references()[0].size(),
-		d->references()[0].data()
-	);
+	d->set_reference(Eigen::Map<CBF::FloatVector>(reference, d->dim()));
 
 	return 1;
 }
@@ -158,9 +154,11 @@ cbf_controller_get_reference(struct cbf_primitive_controller* c, double *referen
 		return -1;
 	}
 
+	const CBF::FloatVector &current = static_cast<const CBF::DummyReference &>(*d).references()[0];
+
 	std::copy(
-		d->references()[0].data(),
-		d->references()[0].data() + d->references()[0].size(),
+		current.data(),
+		current.data() + current.size(),
 		reference
 		);
 
@@ -181,7 +179,8 @@ cbf_controller_step(struct cbf_primitive_controller *c, double *in, double *out)
 		}
 
 		//! Copy data over into the resource (assuming it's a dummy resource)..
-		std::copy(in, in+res->dim(), res -> m_Variables.data());
+		//! Through set(), so the resource gets a new version
+		res->set(Eigen::Map<const CBF::FloatVector>(in, res->dim()));
 
 		CBF_DEBUG(res->m_Variables);
 
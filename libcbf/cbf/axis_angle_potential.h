@@ -25,6 +25,7 @@
 #include <cbf/types.h>
 #include <cbf/utilities.h>
 #include <cbf/potential.h>
+#include <cbf/reference_index.h>
 #include <cbf/namespace.h>
 
 #include <boost/shared_ptr.hpp>
@@ -37,7 +38,8 @@ namespace CBF {
 		@brief A potential function operating on the space of rotations...
 	
 		represented as Axis Angle, but with all information encoded into the
-		direction and length of the axis.
+		direction and length of the axis. The gradient step heads for the 
+		reference reached by the smallest rotation.
 	*/
 	struct AxisAnglePotential : public Potential {
 		AxisAnglePotential(const CBFSchema::AxisAnglePotential &xml_instance, ObjectNamespacePtr object_namespace);
@@ -45,9 +47,13 @@ namespace CBF {
 		//! @brief  This coefficient determines the rate of convergence. Choose between 0 and 1.
 		Float m_Coefficient;
 
+		//! Finds the closest of many references, see ReferenceIndex
+		ReferenceIndex m_ReferenceIndex;
+
 		AxisAnglePotential(Float coefficient = 1.) :
 		   Potential(5. / 180. * M_PI),
-			m_Coefficient(coefficient)
+			m_Coefficient(coefficient),
+			m_ReferenceIndex(ReferenceIndex::Rotation)
 		{
 		}
 	
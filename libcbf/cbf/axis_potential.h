@@ -26,6 +26,7 @@
 #include <cbf/utilities.h>
 #include <cbf/potential.h>
 #include <cbf/quaternion.h>
+#include <cbf/reference_index.h>
 #include <cbf/exceptions.h>
 #include <cbf/namespace.h>
 
@@ -45,9 +46,13 @@ namespace CBF {
 		int m_Dimension;
 		Float m_Coefficient;
 
+		//! Finds the closest of many references, see ReferenceIndex
+		ReferenceIndex m_ReferenceIndex;
+
 		AxisPotential(int dimension = 3, Float coefficient = 0.1) :
 			m_Dimension(dimension),
-			m_Coefficient(coefficient) 
+			m_Coefficient(coefficient),
+			m_ReferenceIndex(ReferenceIndex::Direction)
 		{
 
 		}
@@ -60,14 +65,19 @@ namespace CBF {
 			assert(references.size() > 0);
 
 			//! Find the closest reference
-			Float min_distance = distance(references[0], input);
 			unsigned int min_index = 0;
 
-			for (unsigned int i = 1; i < references.size(); ++i) {
-				Float cur_distance = distance(references[i], input);
-				if (cur_distance < min_distance) {
-					min_index = i;
-					min_distance = cur_distance;
+			if (m_ReferenceIndex.applies(references.size())) {
+				min_index = m_ReferenceIndex.closest(references, input, m_ReferencesVersion);
+			} else {
+				Float min_distance = distance(references[0], input);
+
+				for (unsigned int i = 1; i < references.size(); ++i) {
+					Float cur_distance = distance(references[i], input);
+					if (cur_distance < min_distance) {
+						min_index = i;
+						min_distance = cur_distance;
+					}
 				}
 			}
 
@@ -29,20 +29,26 @@
 
 #include <cbf/dummy_reference.h>
 #include <cbf/spacenavi_reference.h>
+#include <cbf/reference_channel.h>
+#include <cbf/task_space_plan.h>
 
 #include <cbf/linear_transform.h>
 #include <cbf/generic_transform.h>
 #include <cbf/composite_transform.h>
 #include <cbf/kdl_transforms.h>
+#include <cbf/chain_kinematics.h>
+#include <cbf/expression_sensor_transform.h>
 
 #include <cbf/controller_sequence.h>
 #include <cbf/combination_strategy.h>
 
 #include <cbf/potential.h>
+#include <cbf/reference_index.h>
 #include <cbf/composite_potential.h>
 #include <cbf/square_potential.h>
 #include <cbf/axis_potential.h>
 #include <cbf/axis_angle_potential.h>
+#include <cbf/expression_potential.h>
 
 #include <cbf/utilities.h>
 
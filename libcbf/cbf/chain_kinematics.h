@@ -0,0 +1,275 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#ifndef CBF_CHAIN_KINEMATICS_HH
+#define CBF_CHAIN_KINEMATICS_HH
+
+#include <cbf/config.h>
+#include <cbf/types.h>
+#include <cbf/object.h>
+#include <cbf/namespace.h>
+#include <cbf/sensor_transform.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <Eigen/Core>
+
+#include <vector>
+
+namespace KDL {
+	class Chain;
+}
+
+namespace CBFSchema {
+	class ChainKinematics;
+	class ChainPositionSensorTransform;
+	class ChainAxisAngleSensorTransform;
+	class ChainPoseSensorTransform;
+}
+
+namespace CBF {
+
+	typedef Eigen::Matrix<Float, 3, 3> Matrix3;
+	typedef Eigen::Matrix<Float, 3, 1> Vector3;
+
+	/**
+		@brief Forward kinematics and geometric jacobian of a serial chain,
+		without going through KDL in the control loop.
+
+		The chain is flattened into one link transform per joint (fixed
+		segments are merged into their neighbours), stored column wise in
+		contiguous arrays, together with the joint axes. update() then
+		computes the end effector frame and the jacobian in a single pass
+		over these arrays with fixed size 3x3 math and no allocation. Joints
+		rotating about a coordinate axis of their frame (like KDL's RotX,
+		RotY and RotZ) only touch two columns of the rotation.
+
+		Like KDL, the jacobian has the linear velocities in the first three
+		rows and the angular velocities in the last three, all in the base
+		frame, with the end effector as reference point.
+
+		Like KDLChainKinematics, update() skips the computation when called
+		again with the same joint values, so transforms can share an
+		instance. update() only computes the end effector frame, the
+		jacobian is filled in by update_jacobian() once it is asked for.
+	*/
+	struct ChainKinematics : public Object {
+		enum JointType {
+			FixedJoint,
+			RotationalJoint,
+			TranslationalJoint
+		};
+
+		//! An empty chain, see add_segment()
+		ChainKinematics();
+
+		//! This constructor is only implemented when KDL support is enabled
+		ChainKinematics(const KDL::Chain &chain);
+
+		//! This constructor is only implemented when XSD and KDL support are enabled
+		ChainKinematics(const CBFSchema::ChainKinematics &xml_instance, ObjectNamespacePtr object_namespace);
+
+		/**
+			@brief Appends a segment like a KDL::Segment, i.e. whose pose is
+
+			translation(joint_origin) * joint motion(q) * tip
+
+			where the joint motion is a rotation about or a translation along
+			the (normalized) axis.
+		*/
+		void add_segment(
+			JointType type,
+			const Vector3 &axis,
+			const Vector3 &joint_origin,
+			const Matrix3 &tip_rotation,
+			const Vector3 &tip_translation
+		);
+
+		//! Compute the frame for the joint values, unless the last call already did
+		void update(const FloatVector &resource_value);
+
+		//! Compute the jacobian for the joint values (and the frame, if update() did not), unless already done
+		void update_jacobian(const FloatVector &resource_value);
+
+		//! The orientation of the end effector
+		const Matrix3 &rotation() const { return m_Rotation; }
+
+		//! The position of the end effector
+		const Vector3 &position() const { return m_Position; }
+
+		//! 6 x resource_dim(), see the class documentation
+		const FloatMatrix &jacobian() const { return m_Jacobian; }
+
+		//! The orientation of the end effector as rotation axis scaled by the angle, like KDL::Rotation::GetRot()
+		Vector3 axis_angle() const;
+
+		unsigned int resource_dim() const { return m_JointTypes.size(); }
+
+		//! How often the frame was actually computed
+		unsigned long computations() const { return m_Computations; }
+
+		//! How often update_jacobian() actually computed the jacobian
+		unsigned long jacobian_computations() const { return m_JacobianComputations; }
+
+		protected:
+			void init();
+
+			//! Appends all segments of the chain, only implemented when KDL support is enabled
+			void add_chain(const KDL::Chain &chain);
+
+			//! Frame, joint axes and origins, with m_Mutex held
+			void update_frames(const FloatVector &resource_value);
+
+			//! Per joint
+			std::vector<JointType> m_JointTypes;
+
+			//! The joint axes in the frame of their joint, 3 x joints
+			Eigen::Matrix<Float, 3, Eigen::Dynamic> m_Axes;
+
+			//! The coordinate axis a joint moves about (0, 1, 2) or -1 for a general axis
+			std::vector<int> m_AxisIndices;
+
+			/**
+				Link i leads from the moving frame of joint i - 1 (the base
+				for i = 0) to the frame of joint i (the end effector for i =
+				joints), i.e. there is one link more than there are joints.
+				The rotations are stored as 3 x 3 (links) and the
+				translations as 3 x links.
+			*/
+			Eigen::Matrix<Float, 3, Eigen::Dynamic> m_LinkRotations;
+			Eigen::Matrix<Float, 3, Eigen::Dynamic> m_LinkTranslations;
+
+			//! Intermediate results: joint axes and origins in the base frame, 3 x joints
+			Eigen::Matrix<Float, 3, Eigen::Dynamic> m_JointAxes;
+			Eigen::Matrix<Float, 3, Eigen::Dynamic> m_JointOrigins;
+
+			Matrix3 m_Rotation;
+			Vector3 m_Position;
+			FloatMatrix m_Jacobian;
+
+			//! The joint values the results were computed for
+			FloatVector m_ResourceValue;
+			bool m_Computed;
+			bool m_JacobianComputed;
+			unsigned long m_Computations;
+			unsigned long m_JacobianComputations;
+
+			boost::mutex m_Mutex;
+	};
+
+	typedef boost::shared_ptr<ChainKinematics> ChainKinematicsPtr;
+
+
+	/**
+		@brief Base class of the sensor transforms computing a part of the
+		end effector pose of a ChainKinematics.
+
+		These are drop in replacements for the KDLChain*SensorTransforms,
+		computing the same results.
+	*/
+	struct BaseChainSensorTransform : public SensorTransform {
+		BaseChainSensorTransform(ChainKinematicsPtr kinematics);
+
+		//! This constructor is only implemented when XSD and KDL support are enabled
+		BaseChainSensorTransform(
+			ChainKinematicsPtr kinematics,
+			const CBFSchema::SensorTransform &xml_instance,
+			ObjectNamespacePtr object_namespace
+		);
+
+		virtual unsigned int resource_dim() const { return m_Kinematics->resource_dim(); }
+
+		ChainKinematicsPtr kinematics() { return m_Kinematics; }
+
+		//! Like BaseKDLChainSensorTransform::update_batch()
+		virtual void update_batch(
+			const FloatMatrix &resource_values, 
+			FloatMatrix &results, 
+			FloatMatrix &task_jacobians
+		);
+
+		protected:
+			//! Possibly shared with other transforms over the same chain
+			ChainKinematicsPtr m_Kinematics;
+
+			//! Copy the current m_Kinematics into column i of update_batch()'s results
+			virtual void store_batch_column(unsigned int i, FloatMatrix &results, FloatMatrix &task_jacobians) = 0;
+	};
+
+
+	/**
+		@brief The end effector position, like KDLChainPositionSensorTransform
+	*/
+	struct ChainPositionSensorTransform : public BaseChainSensorTransform {
+		ChainPositionSensorTransform(ChainKinematicsPtr kinematics);
+
+		ChainPositionSensorTransform(const CBFSchema::ChainPositionSensorTransform &xml_instance, ObjectNamespacePtr object_namespace);
+
+		virtual unsigned int task_dim() const { return 3u; }
+
+		virtual void update(const FloatVector &resource_value);
+
+		virtual void update_jacobian(const FloatVector &resource_value);
+
+		protected:
+			virtual void store_batch_column(unsigned int i, FloatMatrix &results, FloatMatrix &task_jacobians);
+	};
+
+
+	/**
+		@brief The end effector orientation as scaled axis, like KDLChainAxisAngleSensorTransform
+	*/
+	struct ChainAxisAngleSensorTransform : public BaseChainSensorTransform {
+		ChainAxisAngleSensorTransform(ChainKinematicsPtr kinematics);
+
+		ChainAxisAngleSensorTransform(const CBFSchema::ChainAxisAngleSensorTransform &xml_instance, ObjectNamespacePtr object_namespace);
+
+		virtual unsigned int task_dim() const { return 3u; }
+
+		virtual void update(const FloatVector &resource_value);
+
+		virtual void update_jacobian(const FloatVector &resource_value);
+
+		protected:
+			virtual void store_batch_column(unsigned int i, FloatMatrix &results, FloatMatrix &task_jacobians);
+	};
+
+
+	/**
+		@brief Position and scaled axis of the end effector, like KDLChainPoseSensorTransform
+	*/
+	struct ChainPoseSensorTransform : public BaseChainSensorTransform {
+		ChainPoseSensorTransform(ChainKinematicsPtr kinematics);
+
+		ChainPoseSensorTransform(const CBFSchema::ChainPoseSensorTransform &xml_instance, ObjectNamespacePtr object_namespace);
+
+		virtual unsigned int task_dim() const { return 6u; }
+
+		virtual void update(const FloatVector &resource_value);
+
+		virtual void update_jacobian(const FloatVector &resource_value);
+
+		protected:
+			virtual void store_batch_column(unsigned int i, FloatMatrix &results, FloatMatrix &task_jacobians);
+	};
+
+} // namespace
+
+#endif
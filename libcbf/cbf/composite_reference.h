@@ -26,6 +26,7 @@
 #include <cbf/config.h>
 #include <cbf/reference.h>
 #include <cbf/namespace.h>
+#include <cbf/profiling.h>
 
 #include <vector>
 #include <algorithm>
@@ -39,6 +40,9 @@ namespace CBF {
 
 	Note that this class only combines the first reference, even if one of the wrapped classes 
 	provides more than one..
+
+	The version() changes when one of the wrapped references' versions
+	changed. If one of them does not keep versions, neither does this one.
 */
 struct CompositeReference : public Reference
 {
@@ -48,6 +52,14 @@ struct CompositeReference : public Reference
 		std::vector<FloatVector>  m_ReferenceValues;
 		std::vector<FloatVector>  m_EmptyReferenceValues;
 
+		//! The versions of the m_References seen by the last update()
+		std::vector<unsigned long> m_ReferenceVersions;
+
+		#ifdef CBF_PROFILING
+			//! "<name>.update" for each of the m_References
+			std::vector<CycleTimeHistogram*> m_CycleTimeHistograms;
+		#endif
+
 	public:
 		CompositeReference(const CBFSchema::CompositeReference &xml_instance, ObjectNamespacePtr object_namespace);
 
@@ -69,6 +81,13 @@ struct CompositeReference : public Reference
 			
 			m_ReferenceValues.push_back(FloatVector(dim));
 			m_UpdateSuccessfull = false;
+			m_ReferenceVersions.assign(m_References.size(), 0);
+
+			#ifdef CBF_PROFILING
+				m_CycleTimeHistograms.clear();
+				for (unsigned int i = 0; i < m_References.size(); ++i)
+					m_CycleTimeHistograms.push_back(cycle_time_histogram(m_References[i]->name() + ".update", m_References[i].get()));
+			#endif
 		}
 	
 		/**
@@ -90,15 +109,21 @@ struct CompositeReference : public Reference
 					  ref=m_References.begin(), end=m_References.end();
 				  ref != end; ++ref)
 			{
-				(*ref)->update();
+				{
+					CBF_PROFILE_SCOPE(m_CycleTimeHistograms[ref - m_References.begin()]);
+					(*ref)->update();
+				}
 
-				if ((*ref)->get().size() == 0)
+				if ((*ref)->get().size() == 0) {
+					update_version();
 					return;
+				}
 				ref_values.segment(current_start_index, (*ref)->dim())
 					= (*ref)->get()[0];
 				current_start_index += (*ref)->dim();
 			}
 			m_UpdateSuccessfull = true;
+			update_version();
 		}
 
 		virtual const std::vector<ReferencePtr> &references() { 
@@ -111,6 +136,31 @@ struct CompositeReference : public Reference
 			See update()
 		*/
 		virtual std::vector<FloatVector> &get();
+
+	protected:
+		/**
+			@brief Bumps the version when one of the m_References' versions
+			changed since the last update()
+
+			Falls back to version 0 when one of them does not keep versions,
+			so a ReferenceIndex compares the combined reference instead.
+		*/
+		void update_version() {
+			bool versioned = true, changed = false;
+			for (unsigned int i = 0, len = m_References.size(); i < len; ++i) {
+				const unsigned long version = m_References[i]->version();
+				versioned &= (version != 0);
+				if (version != m_ReferenceVersions[i]) {
+					m_ReferenceVersions[i] = version;
+					changed = true;
+				}
+			}
+
+			if (!versioned)
+				__atomic_store_n(&m_Version, 0, __ATOMIC_RELAXED);
+			else if (changed || version() == 0)
+				bump_version();
+		}
 };
 
 typedef boost::shared_ptr<CompositeReference> CompositeReferencePtr;
@@ -43,6 +43,9 @@ struct CompositeResource : public Resource
 		std::vector<ResourcePtr> m_Resources;
 		FloatVector m_ResourceValues;
 
+		//! The versions of m_Resources m_ResourceValues were read from
+		std::vector<unsigned long> m_ResourceVersions;
+
 	public:
 		CompositeResource(const CBFSchema::CompositeResource &xml_instance, ObjectNamespacePtr object_namespace);
 
@@ -63,6 +66,7 @@ struct CompositeResource : public Resource
 			}
 			
 			m_ResourceValues = FloatVector(dim);
+			m_ResourceVersions.assign(m_Resources.size(), 0);
 		}
 
 		const std::vector<ResourcePtr> &resources() {
@@ -82,6 +86,7 @@ struct CompositeResource : public Resource
 		*/
 		virtual void update() {
 			unsigned int current_start_index = 0;
+			bool changed = false;
 	
 			for (
 				unsigned int i = 0, len = m_Resources.size();
@@ -93,7 +98,14 @@ struct CompositeResource : public Resource
 				m_ResourceValues.segment(current_start_index, m_Resources[i]->get().size())
 						= m_Resources[i]->get();
 				current_start_index += m_Resources[i]->dim();			
+
+				changed |= m_Resources[i]->version() == 0 || m_Resources[i]->version() != m_ResourceVersions[i];
+				m_ResourceVersions[i] = m_Resources[i]->version();
 			}
+
+			//! Our value changed only if one of the combined ones did
+			if (changed)
+				bump_version();
 		}
 
 	
@@ -25,6 +25,8 @@
 
 #include <cbf/sensor_transform.h>
 #include <cbf/namespace.h>
+#include <cbf/profiling.h>
+#include <cbf/thread_pool.h>
 
 #include <vector>
 
@@ -46,11 +48,36 @@ namespace CBF {
 
 		Note that you are not limited to two transforms. But you can use an arbitrary
 		positive non zero number of transforms...
+
+		With a ThreadPool set (see set_thread_pool()) the transforms are updated in 
+		parallel, each copying its results into its own rows of the composite ones.
+		Their jacobians are only collected on the first task_jacobian() call, again 
+		in parallel. Then the transforms must not share state with each other.
 	*/
 	struct CompositeSensorTransform : public SensorTransform {
 
 		protected:
 			std::vector<SensorTransformPtr> m_SensorTransforms;
+
+			//! The first task space row of each of the m_SensorTransforms
+			std::vector<unsigned int> m_TaskOffsets;
+
+			ThreadPoolPtr m_ThreadPool;
+
+			struct TransformUpdate;
+
+			//! Update the i-th transform and copy its result into place
+			void update_transform(unsigned int i, const FloatVector &resource_value);
+
+			//! Copy the task jacobian of the i-th transform into place
+			void update_transform_jacobian(unsigned int i);
+
+			struct TransformBatchUpdate;
+
+			#ifdef CBF_PROFILING
+				//! "<name>.update" for each of the m_SensorTransforms
+				std::vector<CycleTimeHistogram*> m_CycleTimeHistograms;
+			#endif
 	
 		public:
 			CompositeSensorTransform(std::vector<SensorTransformPtr> transforms = std::vector<SensorTransformPtr>()) 
@@ -69,8 +96,28 @@ namespace CBF {
 			}
 
 			virtual void set_transforms(std::vector<SensorTransformPtr> transforms);
+
+			//! Update the transforms in parallel on the pool, or sequentially if it is null (the default)
+			void set_thread_pool(ThreadPoolPtr thread_pool) 
+				{ m_ThreadPool = thread_pool; }
+
+			ThreadPoolPtr thread_pool() 
+				{ return m_ThreadPool; }
 		
 			virtual void update(const FloatVector &resource_value);
+
+			//! Collects the transforms' jacobians, see SensorTransform::update_jacobian()
+			virtual void update_jacobian(const FloatVector &resource_value);
+
+			/**
+				@brief Batch-evaluates each transform (in parallel with a ThreadPool
+				set) and stacks their results and jacobians row-wise
+			*/
+			virtual void update_batch(
+				const FloatMatrix &resource_values, 
+				FloatMatrix &results, 
+				FloatMatrix &task_jacobians
+			);
 	
 			virtual const std::vector<SensorTransformPtr> &sensor_transforms() const {
 				return m_SensorTransforms;
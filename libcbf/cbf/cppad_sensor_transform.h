@@ -9,33 +9,63 @@
 
 #include <boost/shared_ptr.hpp>
 
+#include <vector>
+
 namespace CBF {
 
 typedef Eigen::Matrix< CppAD::AD<Float>, Eigen::Dynamic, 1> ADFloatVector;
 
 /**
 	@brief A SensorTransform that is parametrized with an AppAD::ADFun<Float> which enables automatic calculation of the task jacobian (CppAD is an automatic differentiation package)
+
+	update() runs the tape forward once for the result. The jacobian is 
+	computed lazily from this zero order sweep, column by column with first 
+	order forward sweeps or, when the function has fewer outputs than inputs, 
+	row by row with reverse sweeps.
+
+	With sparse set, the tape is optimized once at construction and the 
+	sparsity pattern of the jacobian is determined, so that only its nonzero 
+	entries are computed by CppAD's SparseJacobianForward() or 
+	SparseJacobianReverse() (again depending on the dimensions), reusing the 
+	coloring between updates. This pays off for functions where each output 
+	depends on a few inputs only.
 */
 struct CppADSensorTransform : public SensorTransform {
 	CppAD::ADFun<Float> m_Func;
 
 	CppADSensorTransform(const CppAD::ADFun<Float> &fun, 
 								unsigned int task_dim, 
-								unsigned int resource_dim) {
-		assert(fun.Domain() == resource_dim);
-		assert(fun.Range()  == task_dim);
-		m_Func = fun;
-		m_Result = FloatVector(task_dim);
-		m_TaskJacobian = FloatMatrix((int)task_dim, (int)resource_dim);
-	}
-
-	virtual void update(const FloatVector &resource_value) {
-		m_Result = m_Func.Forward(0, resource_value);
-		// this creates a task_dim * resource_dim vector
-		m_TaskJacobian = m_Func.Jacobian(resource_value);
-		// correctly reshape matrix:
-		m_TaskJacobian.conservativeResize(m_Func.Range(), m_Func.Domain());
-	}
+								unsigned int resource_dim,
+								bool sparse = false);
+
+	virtual void update(const FloatVector &resource_value);
+
+	virtual void update_jacobian(const FloatVector &resource_value);
+
+	//! The number of structurally nonzero jacobian entries, only meaningful in sparse mode
+	unsigned int nonzeros() const { return m_Rows.size(); }
+
+	protected:
+		bool m_Sparse;
+
+		//! Whether the jacobian is computed with forward (or else reverse) sweeps
+		bool m_Forward;
+
+		//! The sparsity pattern, task_dim x resource_dim, row major
+		std::vector<bool> m_Pattern;
+
+		//! The coordinates of the nonzero entries
+		std::vector<size_t> m_Rows;
+		std::vector<size_t> m_Cols;
+
+		//! The values of the nonzero entries
+		FloatVector m_Values;
+
+		//! Keeps the coloring of the pattern between updates
+		CppAD::sparse_jacobian_work m_Work;
+
+		//! Directions for the dense sweeps
+		FloatVector m_Direction;
 };
 
 typedef boost::shared_ptr<CppADSensorTransform> CppADSensorTransformPtr;
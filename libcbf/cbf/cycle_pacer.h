@@ -0,0 +1,171 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#ifndef CBF_CYCLE_PACER_HH
+#define CBF_CYCLE_PACER_HH
+
+#include <cbf/config.h>
+#include <cbf/profiling.h>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <string>
+
+namespace CBF {
+
+/**
+	@brief Runs a control loop at a fixed rate by sleeping until absolute
+	deadlines on CLOCK_MONOTONIC, so the period does not drift with the
+	time the cycles take.
+
+	Call start() once and wait() after each cycle. A cycle still running
+	at its deadline is an overrun, handled according to the policy.
+
+	The time between wake ups, the jitter (how late the wake up was) and
+	the overruns (how late the cycle ended) are recorded into the
+	histograms name.period, name.jitter and name.overrun, see
+	print_cycle_time_histograms(). Each pacer has its own, so pacers of 
+	the same name are listed as name#2 and so on. Recording does not 
+	allocate.
+
+	The accessors are meant for the thread running the loop, which may
+	pass them on to others, e.g. through CBFRunController::status().
+*/
+struct CyclePacer {
+	enum OverrunPolicy {
+		//! Drop the missed cycles, the next deadline is the next one in the future
+		Skip,
+		//! Keep all deadlines, missed cycles run back to back until caught up
+		CatchUp
+	};
+
+	//! period in nanoseconds
+	CyclePacer(
+		unsigned long long period,
+		OverrunPolicy policy = Skip,
+		const std::string &name = "cycle_pacer"
+	);
+
+	//! The first deadline is one period from now
+	void start();
+
+	/**
+		@brief Sleeps until the next deadline, returns the number of
+		deadlines missed since the last call (0 without an overrun)
+	*/
+	unsigned int wait();
+
+	unsigned long long period() const { return m_Period; }
+
+	OverrunPolicy policy() const { return m_Policy; }
+
+	//! The number of cycles that ended after their deadline since start()
+	unsigned long long overruns() const { return m_Overruns; }
+
+	//! How late the last wake up was, in nanoseconds
+	unsigned long long jitter() const { return m_Jitter; }
+
+	//! The time between the last two wake ups, in nanoseconds
+	unsigned long long last_period() const { return m_LastPeriod; }
+
+	//! The largest of last_period(), jitter() and the overruns since start(), in nanoseconds
+	unsigned long long max_period() const { return m_MaxPeriod; }
+	unsigned long long max_jitter() const { return m_MaxJitter; }
+	unsigned long long max_overrun() const { return m_MaxOverrun; }
+
+	CycleTimeHistogram *m_PeriodHistogram;
+	CycleTimeHistogram *m_JitterHistogram;
+	CycleTimeHistogram *m_OverrunHistogram;
+
+	protected:
+		unsigned long long m_Period;
+		OverrunPolicy m_Policy;
+
+		unsigned long long m_Deadline;
+		unsigned long long m_LastWakeUp;
+
+		unsigned long long m_Overruns;
+		unsigned long long m_Jitter;
+		unsigned long long m_LastPeriod;
+
+		unsigned long long m_MaxPeriod;
+		unsigned long long m_MaxJitter;
+		unsigned long long m_MaxOverrun;
+};
+
+/**
+	@brief How setup_real_time() prepares the calling thread for a control loop
+*/
+struct RealTimeOptions {
+	RealTimeOptions() : priority(0), cpu(-1), lock_memory(false) { }
+
+	//! SCHED_FIFO priority, 0 keeps the scheduling policy
+	int priority;
+
+	//! The CPU to pin the thread to, -1 for any
+	int cpu;
+
+	//! Lock all current and future pages into memory (mlockall())
+	bool lock_memory;
+};
+
+/**
+	@brief Applies the options to the calling thread (and the process for
+	lock_memory). Throws with the reason if one of them fails, e.g. for
+	lack of privileges. The options stay applied to the thread, see 
+	ScopedRealTime for threads that go on with other work.
+*/
+void setup_real_time(const RealTimeOptions &options);
+
+/**
+	@brief Applies the options like setup_real_time() for the lifetime of 
+	the object, then restores the scheduling policy, priority and CPU 
+	affinity the thread had before, and unlocks the memory if this
+	object locked it.
+
+	If applying one of the options throws, the ones already applied are
+	restored before. Unlocking calls munlockall(), which unlocks all of
+	the process' pages, so only use lock_memory when nothing else locks
+	memory. Has to be destroyed by the thread that created it.
+*/
+struct ScopedRealTime {
+	ScopedRealTime(const RealTimeOptions &options);
+
+	~ScopedRealTime() { restore(); }
+
+	protected:
+		void restore();
+
+		RealTimeOptions m_Options;
+
+		int m_Policy;
+		sched_param m_Parameters;
+
+		#ifdef __linux__
+			cpu_set_t m_CPUs;
+		#endif
+
+		//! Whether mlockall() succeeded, so restore() has to unlock
+		bool m_LockedMemory;
+};
+
+} // namespace
+
+#endif
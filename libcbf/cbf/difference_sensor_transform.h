@@ -50,16 +50,20 @@ namespace CBF {
 		}
 
 		void update(const FloatVector &resource_value) {
-			assert(m_Transform1->task_jacobian().rows() == m_Transform2->task_jacobian().rows());
+			assert(m_Transform1->task_dim() == m_Transform2->task_dim());
 
-			m_Transform1->update(resource_value);
-			m_Transform2->update(resource_value);
+			m_Transform1->update_if_changed(resource_value, m_UpdateVersion);
+			m_Transform2->update_if_changed(resource_value, m_UpdateVersion);
 
-			//! The jacobian is just the difference of the individual transforms
-			m_TaskJacobian = m_Transform1->task_jacobian() - m_Transform2->task_jacobian();
-
-			//! And the result is just the difference of the individual results.
+			//! The result is just the difference of the individual results..
 			m_Result = m_Transform1->result() - m_Transform2->result();
+
+			defer_jacobian(resource_value);
+		}
+
+		void update_jacobian(const FloatVector &resource_value) {
+			//! ..and the jacobian the difference of the individual jacobians
+			m_TaskJacobian = m_Transform1->task_jacobian() - m_Transform2->task_jacobian();
 		}
 
 		unsigned int resource_dim() const { return m_Transform1->resource_dim(); }
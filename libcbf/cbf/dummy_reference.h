@@ -50,6 +50,8 @@ namespace CBF {
 			for (unsigned int i = 0; i < num_references; ++i)
 				for (unsigned int j = 0; j < dim; ++j)
 					m_References[i][j] = 0;
+
+			bump_version();
 		}
 
 		virtual void update() { }
@@ -62,6 +64,7 @@ namespace CBF {
 				CBF_THROW_RUNTIME_ERROR("dims differ");
 
 			m_References = refs;
+			bump_version();
 			for (unsigned int i = 0; i < refs.size(); ++i)
 				CBF_DEBUG("new reference[" << i << "]: " << refs[i]);
 		}
@@ -74,13 +77,23 @@ namespace CBF {
 				CBF_THROW_RUNTIME_ERROR("ref dim mismatch");
 
 			m_References[0] = ref;
+			bump_version();
 			CBF_DEBUG("new reference[0]: " << ref);
 		}
 
+		/**
+			Changes made through this are not noticed (like through get()),
+			use set_references() or set_reference() to change the references
+		*/
 		virtual std::vector<FloatVector> &references() {
 			return m_References;
 		}
 
+		//! For reading the references, keeps the version
+		const std::vector<FloatVector> &references() const {
+			return m_References;
+		}
+
 		virtual unsigned int dim() {
 			return m_References[0].size();
 		}
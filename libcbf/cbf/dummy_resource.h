@@ -36,11 +36,12 @@ namespace CBF {
 	struct DummyResource : public Resource {
 		DummyResource(const CBFSchema::DummyResource &xml_instance, ObjectNamespacePtr object_namespace);
 
+		//! Call set() instead of writing this directly, to keep the version()
 		FloatVector m_Variables;
 
 		DummyResource(const FloatVector &values) :
 			m_Variables(values) {
-
+			bump_version();
 		}
 
 		/**
@@ -58,6 +59,7 @@ namespace CBF {
 				for (unsigned int i = 0; i < variables; ++i)
 					m_Variables[i] = 2 * M_PI * ((Float)rand()-(RAND_MAX/2.0))/(Float)RAND_MAX;
 			}
+			bump_version();
 		}
 	
 	
@@ -70,6 +72,7 @@ namespace CBF {
 	
 		virtual void set(const FloatVector &arg) {
 			m_Variables = arg;
+			bump_version();
 		}
 	
 		virtual void add(const FloatVector &arg);
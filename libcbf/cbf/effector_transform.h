@@ -33,6 +33,8 @@ namespace CBFSchema {
 }
 
 namespace CBF {
+
+	struct PseudoInverseWorkspace;
 	
 	class EffectorTransform;
 	typedef boost::shared_ptr<EffectorTransform> EffectorTransformPtr;
@@ -100,6 +102,19 @@ namespace CBF {
 			return m_InverseTaskJacobian; 
 		}
 	
+		/**
+			EffectorTransforms that compute the inverse task jacobian from
+			a SVD of the task jacobian return it (along with the inverted
+			singular values) here, so that e.g. the nullspace projection 
+			or manipulability measures can reuse it. 
+
+			The default returns NULL, meaning no decomposition is available.
+			May only be called after a call to update().
+		*/
+		virtual const PseudoInverseWorkspace *decomposition() const {
+			return 0;
+		}
+	
 		virtual unsigned int task_dim() const { 
 			return m_InverseTaskJacobian.cols();
 		}
@@ -0,0 +1,154 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#ifndef CBF_EXPRESSION_HH
+#define CBF_EXPRESSION_HH
+
+#include <cbf/config.h>
+#include <cbf/types.h>
+
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace CBF {
+
+	/**
+		@brief A set of math expressions compiled to bytecode, evaluated
+		together with their derivatives and without allocation.
+
+		The expressions are written in the usual infix notation with the
+		operators + - * / ^ (power), parentheses, the numbers pi and e and the
+		functions sin, cos, tan, asin, acos, atan, atan2, exp, log, sqrt, abs
+		and pow. Inputs are elements of the variables given to the
+		constructor, e.g. x[0], or just x for a variable of dimension 1:
+
+		<PRE>
+		cos(x[0]) + 0.5 * cos(x[0] + x[1])
+		</PRE>
+
+		Compiling the expressions turns them into one instruction list in
+		which each instruction writes its own register and only reads
+		registers written before. Constant subexpressions are folded, and
+		subexpressions occurring repeatedly (also in different expressions)
+		are computed only once.
+
+		evaluate() runs through the instructions once. Its jacobian variant
+		additionally propagates the derivatives with respect to the first
+		tangent_dim inputs along (forward mode differentiation), skipping
+		the registers not depending on them.
+	*/
+	struct ExpressionProgram {
+		//! A name and its dimension
+		typedef std::pair<std::string, unsigned int> Variable;
+
+		/**
+			@brief Compiles the expressions, throwing a std::runtime_error
+			pointing at the offending column on syntax errors.
+
+			The inputs to evaluate() are the variables' elements in the given
+			order.
+		*/
+		ExpressionProgram(
+			const std::vector<std::string> &expressions = std::vector<std::string>(),
+			const std::vector<Variable> &variables = std::vector<Variable>()
+		);
+
+		//! The number of expressions
+		unsigned int output_dim() const { return m_Outputs.size(); }
+
+		//! The total size of the variables
+		unsigned int input_dim() const { return m_InputDim; }
+
+		//! The number of instructions left after compiling
+		unsigned int size() const { return m_Instructions.size(); }
+
+		//! Evaluate the expressions, result has to be of size output_dim()
+		void evaluate(const FloatVector &input, FloatVector &result);
+
+		/**
+			@brief Evaluate the expressions and their derivatives by the
+			first tangent_dim inputs.
+
+			result has to be of size output_dim() and jacobian of size
+			output_dim() x tangent_dim.
+		*/
+		void evaluate(
+			const FloatVector &input,
+			FloatVector &result,
+			FloatMatrix &jacobian,
+			unsigned int tangent_dim
+		);
+
+		enum OpCode {
+			Constant,
+			Input,
+			Add,
+			Subtract,
+			Multiply,
+			Divide,
+			Power,
+			Atan2,
+			Negate,
+			Sin,
+			Cos,
+			Tan,
+			Asin,
+			Acos,
+			Atan,
+			Exp,
+			Log,
+			Sqrt,
+			Abs
+		};
+
+		//! Writes register i for the i-th instruction
+		struct Instruction {
+			OpCode op;
+
+			//! The operand registers, or the input index for Input
+			unsigned int a, b;
+
+			//! The value for Constant
+			Float value;
+		};
+
+		protected:
+			friend struct ExpressionCompiler;
+
+			std::vector<Instruction> m_Instructions;
+
+			//! The register holding the result of each expression
+			std::vector<unsigned int> m_Outputs;
+
+			unsigned int m_InputDim;
+
+			//! The registers
+			FloatVector m_Values;
+
+			//! Derivatives of the registers, tangent_dim x size()
+			FloatMatrix m_Tangents;
+
+			//! Whether a register depends on the tangent inputs at all
+			std::vector<char> m_Active;
+	};
+
+} // namespace
+
+#endif
@@ -0,0 +1,104 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#ifndef CBF_EXPRESSION_POTENTIAL_HH
+#define CBF_EXPRESSION_POTENTIAL_HH
+
+#include <cbf/config.h>
+#include <cbf/types.h>
+#include <cbf/potential.h>
+#include <cbf/expression.h>
+#include <cbf/reference_index.h>
+#include <cbf/namespace.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+namespace CBFSchema { class ExpressionPotential; }
+
+namespace CBF {
+
+	/**
+		@brief A potential given by an ExpressionProgram expression of the
+		input x and the reference r, both of dimension dim().
+
+		The gradient step descends the potential towards the closest
+		reference, i.e. it is -coefficient times the derivative of the
+		expression by x, clamped like the one of SquarePotential. With
+
+		<PRE>
+		0.5 * ((x[0] - r[0])^2 + 4 * (x[1] - r[1])^2)
+		</PRE>
+
+		this is a SquarePotential converging faster in the second
+		dimension. Replaces PythonPotential on the control path, see
+		ExpressionSensorTransform.
+	*/
+	struct ExpressionPotential : public Potential {
+		ExpressionPotential(const std::string &expression, unsigned int dim, Float coefficient = 1.0);
+
+		ExpressionPotential(const CBFSchema::ExpressionPotential &xml_instance, ObjectNamespacePtr object_namespace);
+
+		virtual Float norm(const FloatVector &v) {
+			return v.norm();
+		}
+
+		virtual Float distance(const FloatVector &v1, const FloatVector &v2) {
+			return (v1 - v2).norm();
+		}
+
+		virtual unsigned int dim() const {
+			return m_Dim;
+		}
+
+		//! The value of the expression
+		Float value(const FloatVector &reference, const FloatVector &input);
+
+		virtual void gradient (
+			FloatVector &result,
+			const std::vector<FloatVector > &references,
+			const FloatVector &input
+		);
+
+		Float m_Coefficient;
+
+		//! Finds the closest of many references, see ReferenceIndex
+		ReferenceIndex m_ReferenceIndex;
+
+		protected:
+			void init(const std::string &expression);
+
+			unsigned int m_Dim;
+
+			ExpressionProgram m_Program;
+
+			//! Input and reference stacked, the inputs of m_Program
+			FloatVector m_Input;
+
+			FloatVector m_Value;
+			FloatMatrix m_Gradient;
+	};
+
+	typedef boost::shared_ptr<ExpressionPotential> ExpressionPotentialPtr;
+
+} // namespace
+
+#endif
@@ -0,0 +1,79 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#ifndef CBF_EXPRESSION_SENSOR_TRANSFORM_HH
+#define CBF_EXPRESSION_SENSOR_TRANSFORM_HH
+
+#include <cbf/config.h>
+#include <cbf/types.h>
+#include <cbf/sensor_transform.h>
+#include <cbf/expression.h>
+#include <cbf/namespace.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+namespace CBFSchema { class ExpressionSensorTransform; }
+
+namespace CBF {
+
+	/**
+		@brief A SensorTransform given by one ExpressionProgram expression per
+		task space dimension, in the resource variable x.
+
+		A replacement for PythonSensorTransform on the control path: the
+		expressions are compiled once at construction, the jacobian is
+		computed by differentiating them instead of being written by hand,
+		and updates do not allocate. E.g. the end effector position of a
+		planar two link arm:
+
+		<PRE>
+		&lt;SensorTransform xsi:type="ExpressionSensorTransform"&gt;
+			&lt;ResourceDimension&gt;2&lt;/ResourceDimension&gt;
+			&lt;Expression&gt;cos(x[0]) + cos(x[0] + x[1])&lt;/Expression&gt;
+			&lt;Expression&gt;sin(x[0]) + sin(x[0] + x[1])&lt;/Expression&gt;
+		&lt;/SensorTransform&gt;
+		</PRE>
+	*/
+	struct ExpressionSensorTransform : public SensorTransform {
+		ExpressionSensorTransform(const std::vector<std::string> &expressions, unsigned int resource_dim);
+
+		ExpressionSensorTransform(const CBFSchema::ExpressionSensorTransform &xml_instance, ObjectNamespacePtr object_namespace);
+
+		virtual unsigned int task_dim() const { return m_Program.output_dim(); }
+
+		virtual unsigned int resource_dim() const { return m_Program.input_dim(); }
+
+		virtual void update(const FloatVector &resource_value);
+
+		virtual void update_jacobian(const FloatVector &resource_value);
+
+		protected:
+			void init(const std::vector<std::string> &expressions, unsigned int resource_dim);
+
+			ExpressionProgram m_Program;
+	};
+
+	typedef boost::shared_ptr<ExpressionSensorTransform> ExpressionSensorTransformPtr;
+
+} // namespace
+
+#endif
@@ -17,6 +17,97 @@ namespace CBF {
 
 
 
+/**
+	A simple functor that implements a multiplication operation
+	where first and second result types may vary, but the result
+	is of the first type..
+*/
+template<typename T, typename U> 
+struct multiplies { 
+	typedef T first_argument_type;
+	typedef U second_argument_type;
+	typedef T result_type;
+	T operator()(T const& t, U const& u) const { return t * u; } 
+};
+
+
+/**
+	@brief How the transforms below apply their operations: the 
+	operation writes its result for in into out, where in and out may 
+	be blocks of the operands' and the transform's results and 
+	jacobians, so the operations do not allocate in update().
+
+	Operations provide operator()(const In &in, Out &out), like 
+	negate, multiply_by, add and subtract below, or 
+	operator()(const In1 &in1, const In2 &in2, Out &out) for 
+	BlockWiseInnerProductSensorTransform.
+
+	out is taken by const reference so blocks can be passed, see the 
+	Eigen documentation on functions taking Eigen types as parameters.
+*/
+template<class Operation, class In, class Out>
+inline void apply_operation(Operation &operation, const In &in, const Out &out) {
+	operation(in, out.const_cast_derived());
+}
+
+/**
+	@brief Binary version of apply_operation()
+*/
+template<class Operation, class In1, class In2, class Out>
+inline void apply_operation(Operation &operation, const In1 &in1, const In2 &in2, const Out &out) {
+	operation(in1, in2, out.const_cast_derived());
+}
+
+//! Writes -in into out
+struct negate {
+	template<class In, class Out>
+	void operator()(const In &in, Out &out) const { out = -in; }
+};
+
+//! Writes in * factor into out
+struct multiply_by {
+	multiply_by(Float factor = 1.0) : m_Factor(factor) { }
+
+	template<class In, class Out>
+	void operator()(const In &in, Out &out) const { out = in * m_Factor; }
+
+	Float m_Factor;
+};
+
+//! Writes in + operand into out
+template<class T>
+struct add {
+	add(const T &operand = T()) : m_Operand(operand) { }
+
+	template<class In, class Out>
+	void operator()(const In &in, Out &out) const { out = in + m_Operand; }
+
+	T m_Operand;
+};
+
+//! Writes in - operand into out
+template<class T>
+struct subtract {
+	subtract(const T &operand = T()) : m_Operand(operand) { }
+
+	template<class In, class Out>
+	void operator()(const In &in, Out &out) const { out = in - m_Operand; }
+
+	T m_Operand;
+};
+
+//! Adds in to out, see BlockWiseAccumulateSensorTransform
+struct add_to {
+	template<class In, class Out>
+	void operator()(const In &in, Out &out) const { out += in; }
+};
+
+//! Subtracts in from out, see BlockWiseAccumulateSensorTransform
+struct subtract_from {
+	template<class In, class Out>
+	void operator()(const In &in, Out &out) const { out -= in; }
+};
+
 /**
 	@brief A generic SensorTransform that allows to be parametrized
 	with two functors, one acting on the result of the 
@@ -73,11 +164,16 @@ struct ApplySensorTransform : public SensorTransform {
 
 	virtual void update(const FloatVector &resource_value) {
 		CBF_DEBUG("update");
-		m_Operand->update(resource_value);
-		m_Result = m_VectorOperation(m_Operand->result());
-		m_TaskJacobian = m_MatrixOperation(m_Operand->task_jacobian());
+		m_Operand->update_if_changed(resource_value, m_UpdateVersion);
+		apply_operation(m_VectorOperation, m_Operand->result(), m_Result);
+		defer_jacobian(resource_value);
 
 		CBF_DEBUG("result " << m_Result);
+	}
+
+	virtual void update_jacobian(const FloatVector &resource_value) {
+		apply_operation(m_MatrixOperation, m_Operand->task_jacobian(), m_TaskJacobian);
+
 		CBF_DEBUG("jac    " << m_TaskJacobian);
 	}
 
@@ -156,19 +252,32 @@ struct BlockWiseApplySensorTransform : public SensorTransform {
 	#endif
 
 	virtual void update(const FloatVector &resource_value) {
-		m_Operand->update(resource_value);
-		FloatVector tmp_result = m_Operand->result();
-		FloatMatrix tmp_jacobian = m_Operand->task_jacobian();
+		m_Operand->update_if_changed(resource_value, m_UpdateVersion);
+		const FloatVector &result = m_Operand->result();
 		
 		for (unsigned int i = 0, n = m_Operand->task_dim(); i < n; i += m_Blocksize) {
 			CBF_DEBUG("i " << i);
 			CBF_DEBUG("vector");
-			m_Result.segment(i, m_Blocksize)
-					= m_VectorOperation(tmp_result.segment(i, m_Blocksize));
+			apply_operation(
+				m_VectorOperation,
+				result.segment(i, m_Blocksize),
+				m_Result.segment(i, m_Blocksize)
+			);
+		}
+
+		defer_jacobian(resource_value);
+	}
 
+	virtual void update_jacobian(const FloatVector &resource_value) {
+		const FloatMatrix &jacobian = m_Operand->task_jacobian();
+		
+		for (unsigned int i = 0, n = m_Operand->task_dim(); i < n; i += m_Blocksize) {
 			CBF_DEBUG("matrix");
-			m_TaskJacobian.block(i, 0, m_Blocksize, tmp_jacobian.cols())
-					= m_MatrixOperation(tmp_jacobian.block(i, 0, m_Blocksize, tmp_jacobian.cols()));
+			apply_operation(
+				m_MatrixOperation,
+				jacobian.middleRows(i, m_Blocksize),
+				m_TaskJacobian.middleRows(i, m_Blocksize)
+			);
 		}
 	}
 
@@ -262,28 +371,37 @@ struct BlockWiseInnerProductSensorTransform : public SensorTransform {
 	#endif
 
 	virtual void update(const FloatVector &resource_value) {
-		m_Operand1->update(resource_value);
-		m_Operand2->update(resource_value);
-		FloatVector tmp_result1 = m_Operand1->result();
-		FloatMatrix tmp_jacobian1 = m_Operand1->task_jacobian();
-		FloatVector tmp_result2 = m_Operand2->result();
-		FloatMatrix tmp_jacobian2 = m_Operand2->task_jacobian();
+		m_Operand1->update_if_changed(resource_value, m_UpdateVersion);
+		m_Operand2->update_if_changed(resource_value, m_UpdateVersion);
+		const FloatVector &result1 = m_Operand1->result();
+		const FloatVector &result2 = m_Operand2->result();
 		
 		for (unsigned int i = 0, n = m_Operand1->task_dim(); i < n; i += m_Blocksize) {
 			CBF_DEBUG("i " << i);
 			CBF_DEBUG("vector");
-			m_Result.segment(i, m_Blocksize)
-					= m_VectorOperation(
-							tmp_result1.segment(i, m_Blocksize),
-							tmp_result2.segment(i, m_Blocksize)
-							);
+			apply_operation(
+				m_VectorOperation,
+				result1.segment(i, m_Blocksize),
+				result2.segment(i, m_Blocksize),
+				m_Result.segment(i, m_Blocksize)
+			);
+		}
+
+		defer_jacobian(resource_value);
+	}
 
+	virtual void update_jacobian(const FloatVector &resource_value) {
+		const FloatMatrix &jacobian1 = m_Operand1->task_jacobian();
+		const FloatMatrix &jacobian2 = m_Operand2->task_jacobian();
+		
+		for (unsigned int i = 0, n = m_Operand1->task_dim(); i < n; i += m_Blocksize) {
 			CBF_DEBUG("matrix");
-			m_TaskJacobian.block(i, 0, m_Blocksize, tmp_jacobian1.cols())
-					= m_MatrixOperation(
-							tmp_jacobian1.block(i, 0, m_Blocksize, tmp_jacobian1.cols()),
-							tmp_jacobian2.block(i, 0, m_Blocksize, tmp_jacobian2.cols())
-							);
+			apply_operation(
+				m_MatrixOperation,
+				jacobian1.middleRows(i, m_Blocksize),
+				jacobian2.middleRows(i, m_Blocksize),
+				m_TaskJacobian.middleRows(i, m_Blocksize)
+			);
 		}
 	}
 
@@ -322,6 +440,9 @@ make_BlockWiseInnerProductSensorTransform(
 
 /**
 	@brief Accumulate blocks of size block_size with a VectorOperation and a MatrixOperation
+
+	The operations are called with each block and the result to 
+	accumulate it into, e.g. add_to and subtract_from.
 */
 template<class VectorOperation, class MatrixOperation>
 struct BlockWiseAccumulateSensorTransform : public SensorTransform {
@@ -381,24 +502,28 @@ struct BlockWiseAccumulateSensorTransform : public SensorTransform {
 	#endif
 
 	virtual void update(const FloatVector &resource_value) {
-		m_Operand->update(resource_value);
-		FloatVector tmp_result = m_Operand->result();
-		FloatMatrix tmp_jacobian = m_Operand->task_jacobian();
+		m_Operand->update_if_changed(resource_value, m_UpdateVersion);
+		const FloatVector &result = m_Operand->result();
 
 		m_Result = m_InitVector;
-		m_TaskJacobian = m_InitMatrix;
 		
 		for (unsigned int i = 0, n = m_Operand->task_dim(); i < n; i += m_Blocksize) {
 			CBF_DEBUG("i " << i);
 			CBF_DEBUG("vector");
-			m_Result = m_VectorOperation(
-							m_Result, tmp_result.segment(i, m_Blocksize));
+			m_VectorOperation(result.segment(i, m_Blocksize), m_Result);
+		}
+
+		defer_jacobian(resource_value);
+	}
 
+	virtual void update_jacobian(const FloatVector &resource_value) {
+		const FloatMatrix &jacobian = m_Operand->task_jacobian();
+
+		m_TaskJacobian = m_InitMatrix;
+		
+		for (unsigned int i = 0, n = m_Operand->task_dim(); i < n; i += m_Blocksize) {
 			CBF_DEBUG("matrix");
-			m_TaskJacobian = m_MatrixOperation(
-								m_TaskJacobian,
-								tmp_jacobian.block(i, 0, m_Blocksize, tmp_jacobian.cols())
-								);
+			m_MatrixOperation(jacobian.middleRows(i, m_Blocksize), m_TaskJacobian);
 		}
 	}
 
@@ -462,28 +587,19 @@ struct GenericSensorTransform : public SensorTransform {
 
 	virtual void update(const FloatVector &resource_value) {
 		m_Result = m_VectorOperation(resource_value);
-		m_TaskJacobian = m_MatrixOperation(resource_value);
+		defer_jacobian(resource_value);
 	}	
 
+	virtual void update_jacobian(const FloatVector &resource_value) {
+		m_TaskJacobian = m_MatrixOperation(resource_value);
+	}
+
 	protected:
 		VectorOperation m_VectorOperation;
 		MatrixOperation m_MatrixOperation;
 };
 
 
-/**
-	A simple functor that implements a multiplication operation
-	where first and second result types may vary, but the result
-	is of the first type..
-*/
-template<typename T, typename U> 
-struct multiplies { 
-	typedef T first_argument_type;
-	typedef U second_argument_type;
-	typedef T result_type;
-	T operator()(T const& t, U const& u) const { return t * u; } 
-};
-
 
 template<class T, class U>
 struct constant {
@@ -495,13 +611,13 @@ struct constant {
 };
 
 typedef ApplySensorTransform<
-	std::negate<FloatVector>,
-	std::negate<FloatMatrix>
+	negate,
+	negate
 > NegateOperationSensorTransform;
 
 typedef ApplySensorTransform<
-	std::binder2nd<multiplies<FloatVector, double> >,
-	std::binder2nd<multiplies<FloatMatrix, double> >
+	multiply_by,
+	multiply_by
 > MultiplyOperationSensorTransform;
 
 #if 0
@@ -512,13 +628,13 @@ typedef BlockWiseInnerProductSensorTransform<
 #endif
 
 typedef BlockWiseAccumulateSensorTransform<
-	std::plus<FloatVector>,
-	std::plus<FloatMatrix>
+	add_to,
+	add_to
 > BlockWiseSumSensorTransform;
 
 typedef BlockWiseAccumulateSensorTransform<
-	std::minus<FloatVector>,
-	std::minus<FloatMatrix>
+	subtract_from,
+	subtract_from
 > BlockWiseDifferenceSensorTransform;
 
 } // namespace
@@ -57,12 +57,34 @@ namespace CBF {
 		virtual void update(const FloatVector &resource_value, const FloatMatrix &task_jacobian);
 	
 		virtual void exec(const FloatVector &input, FloatVector &result) {
-			result = m_InverseTaskJacobian * input;
+			result.noalias() = m_InverseTaskJacobian * input;
 		}
 
 		void init(unsigned int task_dim, unsigned int resource_dim) {
 			m_InverseTaskJacobian = FloatMatrix((int) resource_dim, (int) task_dim);
 		}	
+
+		virtual const PseudoInverseWorkspace *decomposition() const {
+			return m_Workspace.has_svd() ? &m_Workspace : 0;
+		}
+
+		/**
+			@brief Select the decomposition used for the pseudo inverse. 
+			All solvers but DampedLeastSquaresSolver are supported.
+		*/
+		void set_solver(PseudoInverseSolver solver) {
+			if (solver == DampedLeastSquaresSolver)
+				CBF_THROW_RUNTIME_ERROR("GenericEffectorTransform: DampedLeastSquaresSolver needs a damping constant, use a DampedGenericEffectorTransform");
+
+			m_Workspace.m_Solver = solver;
+		}
+
+		PseudoInverseSolver solver() const {
+			return m_Workspace.m_Solver;
+		}
+
+		protected:
+			PseudoInverseWorkspace m_Workspace;
 	};
 	
 	typedef boost::shared_ptr<GenericEffectorTransform> GenericEffectorTransformPtr;
@@ -82,7 +104,7 @@ namespace CBF {
 		}
 	
 		virtual void exec(const FloatVector &input, FloatVector &result) {
-			result = m_InverseTaskJacobian * input;
+			result.noalias() = m_InverseTaskJacobian * input;
 		}
 
 
@@ -99,8 +121,29 @@ namespace CBF {
 			return m_DampingConstant;
 		}
 
+		virtual const PseudoInverseWorkspace *decomposition() const {
+			return m_Workspace.has_svd() ? &m_Workspace : 0;
+		}
+
+		/**
+			@brief Select the decomposition used for the damped pseudo inverse. 
+			Supported are the SVD based solvers (including WarmStartedSVDSolver) 
+			and DampedLeastSquaresSolver.
+		*/
+		void set_solver(PseudoInverseSolver solver) {
+			if (solver != JacobiSVDSolver && solver != BDCSVDSolver && solver != WarmStartedSVDSolver && solver != DampedLeastSquaresSolver)
+				CBF_THROW_RUNTIME_ERROR("DampedGenericEffectorTransform: Solver " << solver << " can not compute a damped pseudo inverse");
+
+			m_Workspace.m_Solver = solver;
+		}
+
+		PseudoInverseSolver solver() const {
+			return m_Workspace.m_Solver;
+		}
+
 		protected:
 			Float m_DampingConstant;
+			PseudoInverseWorkspace m_Workspace;
 	};
 	
 	typedef boost::shared_ptr<DampedGenericEffectorTransform> DampedGenericEffectorTransformPtr;
@@ -120,7 +163,7 @@ namespace CBF {
 		}
 
 		virtual void exec(const FloatVector &input, FloatVector &result) {
-			result = m_InverseTaskJacobian * input;
+			result.noalias() = m_InverseTaskJacobian * input;
 		}
 
 
@@ -137,8 +180,29 @@ namespace CBF {
 			return m_Threshold;
 		}
 
+		virtual const PseudoInverseWorkspace *decomposition() const {
+			return m_Workspace.has_svd() ? &m_Workspace : 0;
+		}
+
+		/**
+			@brief Select the decomposition used for the pseudo inverse. 
+			Only the SVD based solvers (including WarmStartedSVDSolver) are 
+			supported.
+		*/
+		void set_solver(PseudoInverseSolver solver) {
+			if (solver != JacobiSVDSolver && solver != BDCSVDSolver && solver != WarmStartedSVDSolver)
+				CBF_THROW_RUNTIME_ERROR("ThresholdGenericEffectorTransform: Solver " << solver << " does not provide singular values");
+
+			m_Workspace.m_Solver = solver;
+		}
+
+		PseudoInverseSolver solver() const {
+			return m_Workspace.m_Solver;
+		}
+
 		protected:
 			Float m_Threshold;
+			PseudoInverseWorkspace m_Workspace;
 	};
 
 	typedef boost::shared_ptr<ThresholdGenericEffectorTransform> ThresholdGenericEffectorTransformPtr;
@@ -169,19 +233,19 @@ namespace CBF {
 	
 		virtual void update(const FloatVector &resource_value, const FloatMatrix &task_jacobian) {
 			CBF_DEBUG("update padded");
-			pseudo_inverse(task_jacobian, m_InverseTaskJacobian);
+			pseudo_inverse(task_jacobian, m_InverseTaskJacobian, m_Workspace);
 
 			m_PaddedTaskJacobian.block(0, 0, task_jacobian.rows(), task_jacobian.cols())
 					= task_jacobian;
 			CBF_DEBUG("padded jacobian: " << m_PaddedTaskJacobian);
 
-			pseudo_inverse(m_PaddedTaskJacobian, m_PaddedInverseTaskJacobian);
+			pseudo_inverse(m_PaddedTaskJacobian, m_PaddedInverseTaskJacobian, m_PaddedWorkspace);
 		}
 	
 		virtual void exec(const FloatVector &input, FloatVector &result) {
-			FloatVector res = m_PaddedInverseTaskJacobian * input;
-			CBF_DEBUG("padded result: " << res);
-			result = res.segment(0, m_InverseTaskJacobian.rows());
+			m_PaddedResult.noalias() = m_PaddedInverseTaskJacobian * input;
+			CBF_DEBUG("padded result: " << m_PaddedResult);
+			result = m_PaddedResult.segment(0, m_InverseTaskJacobian.rows());
 		}
 
 		void init(unsigned int task_dim, unsigned int resource_dim, FloatVector diagonal) {
@@ -196,13 +260,21 @@ namespace CBF {
 			}
 
 			m_PaddedInverseTaskJacobian = FloatMatrix((int) resource_dim + task_dim, (int) task_dim);
+			m_PaddedResult = FloatVector((int) resource_dim + task_dim);
 			m_InverseTaskJacobian = FloatMatrix((int) resource_dim, (int) task_dim);
 		}	
 
+		virtual const PseudoInverseWorkspace *decomposition() const {
+			return &m_Workspace;
+		}
+
 
 		protected:
 			FloatMatrix m_PaddedTaskJacobian;
 			FloatMatrix m_PaddedInverseTaskJacobian;
+			FloatVector m_PaddedResult;
+			PseudoInverseWorkspace m_Workspace;
+			PseudoInverseWorkspace m_PaddedWorkspace;
 	};
 	
 	typedef boost::shared_ptr<PaddedEffectorTransform> PaddedEffectorTransformPtr;
@@ -82,6 +82,15 @@ namespace CBF {
 			//! nothing to do as the jacobian is constant and computed during construction time
 			m_Result = resource_value;
 		}
+
+		virtual void update_batch(
+			const FloatMatrix &resource_values,
+			FloatMatrix &results,
+			FloatMatrix &task_jacobians
+		) {
+			results = resource_values;
+			task_jacobians = m_TaskJacobian.replicate(1, resource_values.cols());
+		}
 	
 		virtual void init(unsigned int dim) {
 			m_TaskJacobian = FloatMatrix::Identity(dim, dim);
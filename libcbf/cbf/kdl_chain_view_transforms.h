@@ -31,7 +31,7 @@ struct KDLChainViewSensorTransform : public SensorTransform {
 	virtual void update(const FloatVector &res) {
 		CBF_DEBUG("pose size: " << m_ChainView->pose().size());
 		CBF_DEBUG("res size: " << res.size());
-		m_Operand->update(res);
+		m_Operand->update_if_changed(res, m_UpdateVersion);
 		std::copy(res.data(), res.data() + res.size(), m_ChainView->pose().begin());
 		m_ChainView->update();
 	}
@@ -68,7 +68,7 @@ struct KDLTreeViewSensorTransform : public SensorTransform {
 	virtual void update(const FloatVector &res) {
 		CBF_DEBUG("pose size: " << m_TreeView->pose().size());
 		CBF_DEBUG("res size: " << res.size());
-		m_Operand->update(res);
+		m_Operand->update_if_changed(res, m_UpdateVersion);
 		std::copy(res.data(), res.data() + res.size(), m_TreeView->pose().begin());
 		m_TreeView->update();
 	}
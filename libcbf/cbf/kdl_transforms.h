@@ -33,6 +33,8 @@
 #include <cbf/namespace.h>
 #include <cbf/effector_transform.h>
 
+#include <boost/thread/mutex.hpp>
+
 //! Forward declarations for stuff from KDL namespace that's only
 //! used by way of references
 namespace KDL {
@@ -40,6 +42,8 @@ namespace KDL {
 	class Chain;
 	class JntArray;
 	class Frame;
+	class Twist;
+	class Segment;
 	class Jacobian;
 	class ChainJntToJacSolver;
 	class TreeJntToJacSolver;
@@ -57,12 +61,220 @@ namespace CBFSchema {
 	class KDLChainAxisAngleSensorTransform;
 	class KDLTreePositionSensorTransform;
 	class KDLTreeAxisAngleSensorTransform;
+	class KDLChainKinematics;
+	class KDLTreeKinematics;
 
 	class ChainBase;
 	class TreeBase;
 }
 
 namespace CBF {
+
+	/**
+		@brief Forward kinematics and jacobian of a KDL chain, computed at most 
+		once per set of joint values.
+
+		Several sensor transforms over the same chain (e.g. a position and an 
+		axis angle transform combined by a CompositeSensorTransform) can share 
+		one instance, so that the solvers run only once per cycle and each 
+		transform just picks its rows. In XML an instance is shared by giving 
+		it a Name and referring to it with ReferencedObjectName.
+
+		Transforms sharing an instance may be updated in parallel (e.g. by a 
+		CompositeSensorTransform with Threads or by subordinate controllers 
+		on a thread pool), so computing and reading the results requires 
+		holding a Lock on mutex() from before the update until the results 
+		are copied. All these functions take the lock as an argument.
+	*/
+	struct KDLChainKinematics : public Object {
+		//! To be held on mutex() while computing and reading the results
+		typedef boost::mutex::scoped_lock Lock;
+
+		KDLChainKinematics(boost::shared_ptr<KDL::Chain> chain);
+
+		//! This constructor is only implemented when XSD support is enabled
+		KDLChainKinematics(const CBFSchema::KDLChainKinematics &xml_instance, ObjectNamespacePtr object_namespace);
+
+		boost::mutex &mutex() { return m_Mutex; }
+
+		/**
+			@brief Compute frame() for the joint values, unless the last call 
+			already did for the same values.
+
+			The values are identified by the Resource::version() they were 
+			read from. With a version of 0 (unknown, e.g. outside 
+			SensorTransform::update_if_changed()) they are compared instead.
+		*/
+		void update(const Lock &lock, const FloatVector &resource_value, unsigned long resource_version);
+
+		//! Compute jacobian() for the joint values, like update() at most once per set of values
+		void update_jacobian(const Lock &lock, const FloatVector &resource_value, unsigned long resource_version);
+
+		const KDL::Frame &frame(const Lock &lock) const { check(lock); return *m_Frame; }
+		const KDL::Jacobian &jacobian(const Lock &lock) const { check(lock); return *m_Jacobian; }
+
+		boost::shared_ptr<KDL::Chain> chain() { return m_Chain; }
+
+		unsigned int resource_dim() const;
+
+		//! How often update() actually ran the position solver
+		unsigned long computations() const { return m_Computations; }
+
+		//! How often update_jacobian() actually ran the jacobian solver
+		unsigned long jacobian_computations() const { return m_JacobianComputations; }
+
+		protected:
+			void init_solvers();
+
+			//! Throws unless lock holds m_Mutex
+			void check(const Lock &lock) const;
+
+			boost::shared_ptr<KDL::Chain> m_Chain;
+			boost::shared_ptr<KDL::ChainJntToJacSolver> m_JacSolver;
+			boost::shared_ptr<KDL::ChainFkSolverPos_recursive> m_FKSolver;
+
+			boost::shared_ptr<KDL::JntArray> m_JntArray;
+			boost::shared_ptr<KDL::Frame> m_Frame;
+			boost::shared_ptr<KDL::Jacobian> m_Jacobian;
+
+			//! The joint values frame() and jacobian() were computed for
+			FloatVector m_ResourceValue;
+			FloatVector m_JacobianResourceValue;
+
+			//! Their resource versions, 0 if unknown
+			unsigned long m_Version;
+			unsigned long m_JacobianVersion;
+
+			bool m_Computed;
+			bool m_JacobianComputed;
+			unsigned long m_Computations;
+			unsigned long m_JacobianComputations;
+
+			boost::mutex m_Mutex;
+	};
+
+	typedef boost::shared_ptr<KDLChainKinematics> KDLChainKinematicsPtr;
+
+
+	/**
+		@brief Forward kinematics and jacobians of a set of segments of a KDL 
+		tree, computed at most once per set of joint values.
+
+		The tree counterpart of KDLChainKinematics. Each sharing transform 
+		adds the segments it needs with add_segment().
+
+		Instead of running the KDL tree solvers once per segment, which 
+		walks from each segment to the root through the string keyed segment 
+		map, add_segment() flattens the paths from the root to the added 
+		segments into arrays ordered parents first. update() then computes 
+		the frame of each segment on these paths exactly once, so e.g. the 
+		palm of a hand is not recomputed for each fingertip, and 
+		update_jacobian() the joint twists, assembling the jacobians from 
+		them. The results 
+		are the same as the ones of KDL::TreeFkSolverPos_recursive and 
+		KDL::TreeJntToJacSolver.
+
+		Like KDLChainKinematics, the results are computed and read with a 
+		Lock held on mutex().
+	*/
+	struct KDLTreeKinematics : public Object {
+		typedef boost::mutex::scoped_lock Lock;
+
+		KDLTreeKinematics(boost::shared_ptr<KDL::Tree> tree);
+
+		//! This constructor is only implemented when XSD support is enabled
+		KDLTreeKinematics(const CBFSchema::KDLTreeKinematics &xml_instance, ObjectNamespacePtr object_namespace);
+
+		boost::mutex &mutex() { return m_Mutex; }
+
+		/**
+			@brief Make update() compute the segment and return the index to 
+			pass to frame() and jacobian(). Segments already added keep their index.
+		*/
+		unsigned int add_segment(const std::string &segment_name);
+
+		//! Compute the frames of all added segments, see KDLChainKinematics::update()
+		void update(const Lock &lock, const FloatVector &resource_value, unsigned long resource_version);
+
+		//! Compute the jacobians of all added segments (and the frames, if update() did not)
+		void update_jacobian(const Lock &lock, const FloatVector &resource_value, unsigned long resource_version);
+
+		const KDL::Frame &frame(const Lock &lock, unsigned int segment) const { 
+			check(lock); 
+			return *m_NodeFrames[m_SegmentNodes[segment]]; 
+		}
+
+		const KDL::Jacobian &jacobian(const Lock &lock, unsigned int segment) const { 
+			check(lock); 
+			return *m_Jacobians[segment]; 
+		}
+
+		boost::shared_ptr<KDL::Tree> tree() { return m_Tree; }
+
+		unsigned int resource_dim() const;
+
+		unsigned long computations() const { return m_Computations; }
+
+		unsigned long jacobian_computations() const { return m_JacobianComputations; }
+
+		protected:
+			void init();
+
+			//! Throws unless lock holds m_Mutex
+			void check(const Lock &lock) const;
+
+			//! The frames of all nodes, with m_Mutex held
+			void update_frames(const FloatVector &resource_value, unsigned long resource_version);
+
+			//! Appends the nodes missing on the path from the root to the segment, returns its node
+			unsigned int add_path(const std::string &segment_name);
+
+			boost::shared_ptr<KDL::Tree> m_Tree;
+
+			//! The segments on the paths to the added segments, parents before children
+			std::vector<boost::shared_ptr<KDL::Segment> > m_NodeSegments;
+
+			//! Index of the parent node, -1 for children of the root
+			std::vector<int> m_NodeParents;
+
+			//! Index of the joint in the resource vector, -1 for fixed joints
+			std::vector<int> m_NodeJoints;
+
+			//! Intermediate result: the frame of each node's tip in the root frame
+			std::vector<boost::shared_ptr<KDL::Frame> > m_NodeFrames;
+
+			//! Intermediate result: the unit twist of each node's joint in the 
+			//! root frame, with the node's tip as reference point
+			std::vector<boost::shared_ptr<KDL::Twist> > m_NodeTwists;
+
+			//! Only used while adding segments
+			std::map<std::string, unsigned int> m_NodeIndices;
+
+			std::vector<std::string> m_SegmentNames;
+
+			//! The node of each added segment
+			std::vector<unsigned int> m_SegmentNodes;
+
+			//! The nodes with a joint on the path to each added segment
+			std::vector<std::vector<unsigned int> > m_SegmentJointNodes;
+
+			std::vector<boost::shared_ptr<KDL::Jacobian> > m_Jacobians;
+
+			FloatVector m_ResourceValue;
+
+			//! The resource version of m_ResourceValue, 0 if unknown
+			unsigned long m_Version;
+
+			bool m_Computed;
+			bool m_JacobianComputed;
+			unsigned long m_Computations;
+			unsigned long m_JacobianComputations;
+
+			boost::mutex m_Mutex;
+	};
+
+	typedef boost::shared_ptr<KDLTreeKinematics> KDLTreeKinematicsPtr;
+
 	
 	/**
 		@brief Abstract base class for KDL based transform classes.
@@ -76,25 +288,43 @@ namespace CBF {
 	struct BaseKDLChainSensorTransform : public SensorTransform {
 		protected:
 			boost::shared_ptr<KDL::Chain> m_Chain;
-			boost::shared_ptr<KDL::ChainJntToJacSolver> m_JacSolver;
-			boost::shared_ptr<KDL::ChainFkSolverPos_recursive> m_FKSolver;
-			boost::shared_ptr<KDL::ChainFkSolverVel_recursive> m_FKVelSolver;
-	
-			//! Intermediate result
-			boost::shared_ptr<KDL::Frame> m_Frame;
-	
-			//! Intermediate result
-			boost::shared_ptr<KDL::Jacobian> m_Jacobian;
+
+			//! Possibly shared with other transforms over the same chain
+			KDLChainKinematicsPtr m_Kinematics;
+
+			/**
+				@brief Our own kinematics for update_batch(), so batches of 
+				transforms sharing m_Kinematics can run in parallel without 
+				overwriting each other's results
+			*/
+			KDLChainKinematicsPtr m_BatchKinematics;
+
+			//! The resource version of the last update(), for the deferred update_jacobian()
+			unsigned long m_KinematicsVersion;
+
+			//! Copy the current results of kinematics into column i of update_batch()'s results
+			virtual void store_batch_column(
+				const KDLChainKinematics &kinematics, 
+				const KDLChainKinematics::Lock &lock, 
+				unsigned int i, 
+				FloatMatrix &results, 
+				FloatMatrix &task_jacobians
+			) = 0;
 
 		public:
 			//! constructor, initializes all members
 			BaseKDLChainSensorTransform(
 				boost::shared_ptr<KDL::Chain> chain
 			);
+
+			//! Use the (possibly shared) kinematics instead of solving on our own
+			BaseKDLChainSensorTransform(
+				KDLChainKinematicsPtr kinematics
+			);
 	
 			//! This constructor is only implemented when XSD support is enabled
 			BaseKDLChainSensorTransform(
-				const CBFSchema::ChainBase &xml_chain_instance, 
+				KDLChainKinematicsPtr kinematics,
 				const CBFSchema::SensorTransform &xml_st_instance,
 				ObjectNamespacePtr object_namespace
 			);
@@ -102,13 +332,23 @@ namespace CBF {
 			//! resource_dim is always the number of joints in the chain
 			virtual unsigned int resource_dim() const;
 
-			//! initialize all members
-			virtual void init_solvers();
-	
-			//! compute m_Frame and m_Jacobian from current joint values
-			void compute(const FloatVector &resource_value);
+			//! compute the frame of m_Kinematics from current joint values, lock being held on its mutex()
+			void compute(const KDLChainKinematics::Lock &lock, const FloatVector &resource_value);
+
+			/**
+				@brief Runs m_BatchKinematics for each column and lets the 
+				subclass pick its rows via store_batch_column(), without 
+				touching result() and task_jacobian()
+			*/
+			virtual void update_batch(
+				const FloatMatrix &resource_values, 
+				FloatMatrix &results, 
+				FloatMatrix &task_jacobians
+			);
 
 			boost::shared_ptr<KDL::Chain> chain() { return m_Chain; }
+
+			KDLChainKinematicsPtr kinematics() { return m_Kinematics; }
 	};
 	
 	
@@ -125,9 +365,24 @@ namespace CBF {
 			boost::shared_ptr<KDL::Chain> chain
 		);
 
+		KDLChainPoseSensorTransform(
+			KDLChainKinematicsPtr kinematics
+		);
+
 		virtual unsigned int task_dim() const { return 6u; }
 
 		virtual void update(const FloatVector &resource_value);
+
+		virtual void update_jacobian(const FloatVector &resource_value);
+
+		protected:
+			virtual void store_batch_column(
+				const KDLChainKinematics &kinematics, 
+				const KDLChainKinematics::Lock &lock, 
+				unsigned int i, 
+				FloatMatrix &results, 
+				FloatMatrix &task_jacobians
+			);
 	};
 	typedef boost::shared_ptr<KDLChainPoseSensorTransform> KDLChainPoseSensorTransformPtr;
 
@@ -145,9 +400,24 @@ namespace CBF {
 			boost::shared_ptr<KDL::Chain> chain
 		);
 
+		KDLChainPositionSensorTransform(
+			KDLChainKinematicsPtr kinematics
+		);
+
 		virtual unsigned int task_dim() const { return 3u; }
 
 		virtual void update(const FloatVector &resource_value);
+
+		virtual void update_jacobian(const FloatVector &resource_value);
+
+		protected:
+			virtual void store_batch_column(
+				const KDLChainKinematics &kinematics, 
+				const KDLChainKinematics::Lock &lock, 
+				unsigned int i, 
+				FloatMatrix &results, 
+				FloatMatrix &task_jacobians
+			);
 	};
 	typedef boost::shared_ptr<KDLChainPositionSensorTransform> KDLChainPositionSensorTransformPtr;
 	
@@ -161,10 +431,25 @@ namespace CBF {
 		KDLChainAxisAngleSensorTransform(
 			boost::shared_ptr<KDL::Chain> chain
 		);
+
+		KDLChainAxisAngleSensorTransform(
+			KDLChainKinematicsPtr kinematics
+		);
 		
 		virtual unsigned int task_dim() const { return 3u; }
 
 		virtual void update(const FloatVector &resource_value);
+
+		virtual void update_jacobian(const FloatVector &resource_value);
+
+		protected:
+			virtual void store_batch_column(
+				const KDLChainKinematics &kinematics, 
+				const KDLChainKinematics::Lock &lock, 
+				unsigned int i, 
+				FloatMatrix &results, 
+				FloatMatrix &task_jacobians
+			);
 	};
 	
 	typedef boost::shared_ptr<KDLChainAxisAngleSensorTransform> KDLChainAxisAngleSensorTransformPtr;	
@@ -190,20 +475,38 @@ namespace CBF {
 			unsigned int m_ResourceDim;
 
 			boost::shared_ptr<KDL::Tree> m_Tree;
-			boost::shared_ptr<KDL::TreeJntToJacSolver> m_JacSolver;
-			boost::shared_ptr<KDL::TreeFkSolverPos_recursive> m_FKSolver;
-			boost::shared_ptr<KDL::TreeFkSolverVel_wdls> m_FKVelSolver;
-	
-			FloatMatrix m_Twists;
-	
-			//! Intermediate result
-			std::vector<boost::shared_ptr<KDL::Frame> > m_Frames;
-	
-			//! Intermediate result
-			std::vector<boost::shared_ptr<KDL::Jacobian> > m_Jacobians;
+
+			//! Possibly shared with other transforms over the same tree
+			KDLTreeKinematicsPtr m_Kinematics;
 
 			//! The segment identifiers for which to solve the FK
 			std::vector<std::string> m_SegmentNames;
+
+			//! The index of each of the m_SegmentNames in m_Kinematics
+			std::vector<unsigned int> m_Segments;
+
+			//! Our own kinematics for update_batch(), see BaseKDLChainSensorTransform
+			KDLTreeKinematicsPtr m_BatchKinematics;
+
+			//! The index of each of the m_SegmentNames in m_BatchKinematics
+			std::vector<unsigned int> m_BatchSegments;
+
+			//! The resource version of the last update(), for the deferred update_jacobian()
+			unsigned long m_KinematicsVersion;
+
+			/**
+				@brief Copy the current results of kinematics into column i of 
+				update_batch()'s results, segments being the indices of 
+				m_SegmentNames in kinematics
+			*/
+			virtual void store_batch_column(
+				const KDLTreeKinematics &kinematics, 
+				const KDLTreeKinematics::Lock &lock, 
+				const std::vector<unsigned int> &segments, 
+				unsigned int i, 
+				FloatMatrix &results, 
+				FloatMatrix &task_jacobians
+			) = 0;
 	
 		public:
 			/**
@@ -215,10 +518,16 @@ namespace CBF {
 				boost::shared_ptr<KDL::Tree> tree, 
 				const std::vector<std::string> &segment_names
 			);
+
+			//! Use the (possibly shared) kinematics instead of solving on our own
+			BaseKDLTreeSensorTransform(
+				KDLTreeKinematicsPtr kinematics, 
+				const std::vector<std::string> &segment_names
+			);
 	
 			//! This constructor is only implemented when XSD support is enabled..
 			BaseKDLTreeSensorTransform(
-				const CBFSchema::TreeBase &xml_tree_instance, 
+				KDLTreeKinematicsPtr kinematics,
 				const CBFSchema::SensorTransform &xml_st_instance, 
 				ObjectNamespacePtr object_namespace
 			);
@@ -230,16 +539,26 @@ namespace CBF {
 			virtual unsigned int resource_dim() const ;
 
 			/**
-				Call this function once m_Tree is set to a valid tree..
+				Call this function once m_Kinematics and m_SegmentNames are set..
 			*/
 			virtual void init_solvers();
 	
 			/**
-				This reads the current resource values and updates the KDL::Jacobian matrix..
+				This computes the frames of m_Kinematics for the current resource values, 
+				lock being held on its mutex() until the subclass has read them..
 			*/
-			virtual void update(const FloatVector &resource_value);
+			void compute(const KDLTreeKinematics::Lock &lock, const FloatVector &resource_value);
+
+			//! See BaseKDLChainSensorTransform::update_batch()
+			virtual void update_batch(
+				const FloatMatrix &resource_values, 
+				FloatMatrix &results, 
+				FloatMatrix &task_jacobians
+			);
 
 			boost::shared_ptr<KDL::Tree> tree() { return m_Tree; }
+
+			KDLTreeKinematicsPtr kinematics() { return m_Kinematics; }
 	};
 	
 	
@@ -258,9 +577,26 @@ namespace CBF {
 			std::vector<std::string> segment_names
 		);
 
+		KDLTreePositionSensorTransform(
+			KDLTreeKinematicsPtr kinematics, 
+			std::vector<std::string> segment_names
+		);
+
 		virtual unsigned int task_dim() const { return 3u * m_SegmentNames.size(); }
 
 		virtual void update(const FloatVector &resource_value);
+
+		virtual void update_jacobian(const FloatVector &resource_value);
+
+		protected:
+			virtual void store_batch_column(
+				const KDLTreeKinematics &kinematics, 
+				const KDLTreeKinematics::Lock &lock, 
+				const std::vector<unsigned int> &segments, 
+				unsigned int i, 
+				FloatMatrix &results, 
+				FloatMatrix &task_jacobians
+			);
 	};
 	
 	typedef boost::shared_ptr<KDLTreePositionSensorTransform> KDLTreePositionSensorTransformPtr;
@@ -284,11 +620,28 @@ namespace CBF {
 			std::vector<std::string> segment_names
 		);
 
+		KDLTreeAxisAngleSensorTransform(
+			KDLTreeKinematicsPtr kinematics, 
+			std::vector<std::string> segment_names
+		);
+
 		virtual unsigned int task_dim() const { 
 			return 3u * m_SegmentNames.size(); 
 		}
 
 		virtual void update(const FloatVector &resource_value);
+
+		virtual void update_jacobian(const FloatVector &resource_value);
+
+		protected:
+			virtual void store_batch_column(
+				const KDLTreeKinematics &kinematics, 
+				const KDLTreeKinematics::Lock &lock, 
+				const std::vector<unsigned int> &segments, 
+				unsigned int i, 
+				FloatMatrix &results, 
+				FloatMatrix &task_jacobians
+			);
 	};
 	
 	typedef boost::shared_ptr<
@@ -39,7 +39,17 @@ struct LinearSensorTransform : public SensorTransform {
 	LinearSensorTransform (const CBFSchema::LinearSensorTransform &xml_instance, ObjectNamespacePtr object_namespace);
 
 	void update(const FloatVector &resource_value) {
-		m_Result = m_CoefficientMatrix * resource_value;
+		m_Result.noalias() = m_CoefficientMatrix * resource_value;
+	}
+
+	//! One matrix product for all columns, the jacobian is constant
+	virtual void update_batch(
+		const FloatMatrix &resource_values,
+		FloatMatrix &results,
+		FloatMatrix &task_jacobians
+	) {
+		results.noalias() = m_CoefficientMatrix * resource_values;
+		task_jacobians = m_TaskJacobian.replicate(1, resource_values.cols());
 	}
 
 	LinearSensorTransform(const FloatMatrix &coefficient_matrix) 
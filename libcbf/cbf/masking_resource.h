@@ -33,6 +33,7 @@ struct MaskingResource : public Resource {
 				throw std::runtime_error("Index out of bounds");
 
 		m_Result = FloatVector(m_Indexes.size());
+		m_MaskedVersion = 0;
 	}
 	
 	virtual void update() {
@@ -40,6 +41,11 @@ struct MaskingResource : public Resource {
 
 		for (unsigned int i = 0, len = m_Indexes.size(); i < len; ++i)
 			m_Result[i] = m_Resource->get()[m_Indexes[i]];
+
+		//! Our value changed only if the masked one did
+		if (m_Resource->version() == 0 || m_Resource->version() != m_MaskedVersion)
+			bump_version();
+		m_MaskedVersion = m_Resource->version();
 	}
 
 	virtual void set(const FloatVector &arg) { }
@@ -63,6 +69,9 @@ struct MaskingResource : public Resource {
 		ResourcePtr m_Resource;
 		FloatVector m_Result;
 		std::vector<unsigned int> m_Indexes;
+
+		//! The version of m_Resource m_Result was read from
+		unsigned long m_MaskedVersion;
 };
 
 } // namespace
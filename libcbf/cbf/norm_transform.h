@@ -37,9 +37,13 @@ struct NormSensorTransform : public SensorTransform {
 	}
 
 	virtual void update(const FloatVector &resource_value) {
-		m_Transform->update(resource_value);
+		m_Transform->update_if_changed(resource_value, m_UpdateVersion);
 		m_Result[0] = m_Transform->result().norm();
 
+		defer_jacobian(resource_value);
+	}
+
+	virtual void update_jacobian(const FloatVector &resource_value) {
 		FloatVector res2 = (1.0/m_Result[0])
 								* (m_Transform->result()).transpose()
 								* m_Transform->task_jacobian();
@@ -53,7 +53,8 @@ struct Potential : public Object {
 		Float max_gradient_step_norm = 0.1
 	) :
 		Object("Potential"),
-		m_MaxGradientStepNorm(max_gradient_step_norm)
+		m_MaxGradientStepNorm(max_gradient_step_norm),
+		m_ReferencesVersion(0)
 	{
 	}
 
@@ -90,7 +91,31 @@ struct Potential : public Object {
 		const FloatVector &input
 	) = 0;
 
+	/**
+		@brief Calls gradient() for references of the given 
+		Reference::version().
+
+		Potentials keeping an index of the references (see 
+		ReferenceIndex) then only rebuild it when the version changed, 
+		instead of checking the references for changes. A version of 0 
+		is unknown.
+	*/
+	void gradient_for_version(
+		FloatVector &result, 
+		const std::vector<FloatVector > &references, 
+		const FloatVector &input,
+		unsigned long references_version
+	) {
+		m_ReferencesVersion = references_version;
+		gradient(result, references, input);
+		m_ReferencesVersion = 0;
+	}
+
 	virtual unsigned int dim() const = 0;
+
+	protected:
+		//! The references' version during a gradient_for_version(), 0 otherwise
+		unsigned long m_ReferencesVersion;
 };
 
 typedef boost::shared_ptr<Potential> PotentialPtr;
@@ -37,6 +37,8 @@
 #include <cbf/sensor_transform.h>
 #include <cbf/combination_strategy.h>
 #include <cbf/namespace.h>
+#include <cbf/profiling.h>
+#include <cbf/thread_pool.h>
 
 namespace CBFSchema { 
 	class PrimitiveController; 
@@ -56,6 +58,26 @@ namespace CBF {
 		friend class TaskSpaceDistanceThreshold;
 		friend class ResourceStepNormThreshold;
 
+		/**
+			@brief How the combined steps of the subordinate controllers 
+			get projected into the nullspace of the task jacobian J.
+
+			Both compute (1 - J# J) x, they only differ in cost.
+		*/
+		enum NullspaceProjection {
+			//! Form the resource_dim x resource_dim matrix J# J and apply it
+			ExplicitProjector,
+			//! Compute x - J# (J x) with two matrix vector products (the default)
+			MatrixVectorProjection,
+			/**
+				Compute x - V diag(s s#) V^T x reusing the SVD J = U diag(s) V^T 
+				retained by the effector transform (see EffectorTransform::decomposition()). 
+				Falls back to MatrixVectorProjection for effector transforms 
+				that do not provide one
+			*/
+			DecompositionProjection
+		};
+
 		SubordinateController(const CBFSchema::SubordinateController &xml_instance, ObjectNamespacePtr object_namespace);
 
 		/**
@@ -176,6 +198,32 @@ namespace CBF {
 				{ return m_CombinationStrategy; }
 	
 			Float coefficient();
+
+			std::vector<ConvergenceCriterionPtr> &convergence_criteria()
+				{ return m_ConvergenceCriteria; }
+
+			NullspaceProjection nullspace_projection() const
+				{ return m_NullspaceProjection; }
+
+			void set_nullspace_projection(NullspaceProjection projection)
+				{ m_NullspaceProjection = projection; }
+
+			/**
+				@brief Update the subordinate controllers in parallel on the 
+				given pool (or sequentially again, if it is null, the default).
+
+				The subordinate controllers only read the shared resource, 
+				but must not share any other component (reference, effector 
+				transforms, ...) with each other, except for sensor transforms, 
+				see SensorTransform::update_if_changed(). Their results are combined in the same 
+				order as in the sequential case, so the result is identical.
+				Several controllers can share one pool.
+			*/
+			void set_thread_pool(ThreadPoolPtr thread_pool)
+				{ m_ThreadPool = thread_pool; }
+
+			ThreadPoolPtr thread_pool() 
+				{ return m_ThreadPool; }
 	
 		
 			/** Compute a resource update step.
@@ -199,7 +247,26 @@ namespace CBF {
 
 			virtual void check_dimensions() const;
 
+			/**
+				@brief Size all buffers used by update() for the current 
+				resource and task dimensions (recursing into the 
+				subordinate controllers). 
+
+				After this has been called the steady state update() does not
+				allocate memory itself (the components used might, though).
+				This needs the master's resource, so it is called by 
+				PrimitiveController::init().
+			*/
+			virtual void init_buffers();
+
 		protected:
+			/**
+				@brief Update the subordinate controllers (on the m_ThreadPool, 
+				if there is one) and gather their results into 
+				m_SubordinateResourceSteps
+			*/
+			void update_subordinate_controllers();
+
 			//! overall resource update, including those from subordinates
 			FloatVector m_Result;
 
@@ -213,8 +280,41 @@ namespace CBF {
 			FloatVector m_ResourceStep;
 	
 			FloatVector m_CombinedResults;
+
+			NullspaceProjection m_NullspaceProjection;
+
+			//! Scratch buffers for the nullspace projection
+			FloatVector m_ProjectedCombinedResults;
+			FloatVector m_TaskSpaceCombinedResults;
+			FloatVector m_SingularSpaceCombinedResults;
+
 			std::vector<FloatVector> m_SubordinateResourceSteps;
-			std::vector<FloatVector> m_References;
+
+			ThreadPoolPtr m_ThreadPool;
+
+			#ifdef CBF_PROFILING
+				//! The parts of update() that get their own histogram
+				enum ProfiledCall {
+					UpdateCall,
+					ResourceUpdateCall,
+					ReferenceUpdateCall,
+					SensorTransformUpdateCall,
+					EffectorTransformUpdateCall,
+					PotentialGradientCall,
+					EffectorTransformExecCall,
+					CombinationCall,
+					NullspaceProjectionCall,
+					ProfiledCalls
+				};
+
+				/**
+					Looked up by init_buffers() under "<object name>.<call>" for 
+					each timed object, see cycle_time_histogram(), e.g.
+					"Controller.update" or "KDLChainPositionSensorTransform.update".
+					The resource update is only timed by the PrimitiveController.
+				*/
+				CycleTimeHistogram *m_CycleTimeHistograms[ProfiledCalls];
+			#endif
 	};
 
 
@@ -0,0 +1,366 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#ifndef CBF_PRIMITIVE_CONTROLLER_N_HH
+#define CBF_PRIMITIVE_CONTROLLER_N_HH
+
+#include <cbf/config.h>
+#include <cbf/types.h>
+#include <cbf/exceptions.h>
+#include <cbf/primitive_controller.h>
+#include <cbf/effector_transform.h>
+#include <cbf/utilities.h>
+
+#include <Eigen/Core>
+#include <Eigen/SVD>
+
+#include <vector>
+
+namespace CBF {
+
+	/**
+		@brief The fixed size Eigen types used by the compile time
+		dimensioned controller chain.
+	*/
+	template <int TaskDim, int ResourceDim>
+	struct FixedSizeTypes {
+		enum { MinDim = TaskDim < ResourceDim ? TaskDim : ResourceDim };
+
+		typedef Eigen::Matrix<Float, TaskDim, 1> TaskVector;
+		typedef Eigen::Matrix<Float, ResourceDim, 1> ResourceVector;
+		typedef Eigen::Matrix<Float, MinDim, 1> SingularValuesVector;
+		typedef Eigen::Matrix<Float, TaskDim, ResourceDim> TaskJacobian;
+		typedef Eigen::Matrix<Float, ResourceDim, TaskDim> InverseTaskJacobian;
+		typedef Eigen::Matrix<Float, ResourceDim, ResourceDim> ResourceMatrix;
+	};
+
+	/**
+		@brief Pseudo inverse based effector transform for a compile time
+		known task and resource dimension.
+
+		The SVD and all intermediate results live in fixed size storage.
+		With a damping constant of 0 this behaves like the
+		GenericEffectorTransform, otherwise like the 
+		DampedGenericEffectorTransform, both with the JacobiSVDSolver.
+	*/
+	template <int TaskDim, int ResourceDim>
+	struct GenericEffectorTransformN : public EffectorTransform {
+		typedef FixedSizeTypes<TaskDim, ResourceDim> Types;
+
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+		GenericEffectorTransformN(Float damping_constant = 0) :
+			m_DampingConstant(damping_constant)
+		{
+			m_InverseTaskJacobian = FloatMatrix::Zero(ResourceDim, TaskDim);
+			m_FixedInverseTaskJacobian.setZero();
+		}
+
+		virtual void update(const FloatVector &resource_value, const FloatMatrix &task_jacobian) {
+			if (task_jacobian.rows() != TaskDim || task_jacobian.cols() != ResourceDim)
+				CBF_THROW_RUNTIME_ERROR("Task jacobian dimension mismatch: " << task_jacobian.rows() << "x" << task_jacobian.cols() << " is not equal to " << TaskDim << "x" << ResourceDim);
+
+			m_Jacobian = task_jacobian;
+			m_SVD.compute(m_Jacobian, Eigen::ComputeFullU | Eigen::ComputeFullV);
+
+			const typename Types::SingularValuesVector &s = m_SVD.singularValues();
+			for (int i = 0; i < Types::MinDim; ++i) {
+				if (m_DampingConstant > 0)
+					m_InverseSingularValues[i] = s[i] / (m_DampingConstant + s[i] * s[i]);
+				else
+					m_InverseSingularValues[i] = (fabs(s[i]) > pseudo_inverse_rank_threshold) ? 1.0 / s[i] : 0.0;
+			}
+
+			m_FixedInverseTaskJacobian.noalias() = 
+				m_SVD.matrixV().template leftCols<Types::MinDim>() 
+				* m_InverseSingularValues.asDiagonal() 
+				* m_SVD.matrixU().template leftCols<Types::MinDim>().transpose();
+
+			//! Same size, so this does not reallocate
+			m_InverseTaskJacobian = m_FixedInverseTaskJacobian;
+		}
+
+		virtual void exec(const FloatVector &input, FloatVector &result) {
+			result.resize(ResourceDim);
+			Eigen::Map<typename Types::ResourceVector>(result.data()).noalias() = 
+				m_FixedInverseTaskJacobian * Eigen::Map<const typename Types::TaskVector>(input.data());
+		}
+
+		//! The inverse task jacobian in fixed size storage
+		const typename Types::InverseTaskJacobian &fixed_inverse_task_jacobian() const {
+			return m_FixedInverseTaskJacobian;
+		}
+
+		/**
+			@brief The fixed size SVD of the last task jacobian, the 
+			counterpart of decomposition() for PrimitiveControllerN's 
+			DecompositionProjection
+		*/
+		const Eigen::JacobiSVD<typename Types::TaskJacobian> &fixed_decomposition() const {
+			return m_SVD;
+		}
+
+		//! The inverted singular values belonging to fixed_decomposition()
+		const typename Types::SingularValuesVector &fixed_inverse_singular_values() const {
+			return m_InverseSingularValues;
+		}
+
+		Float damping_constant() const { return m_DampingConstant; }
+
+		protected:
+			Float m_DampingConstant;
+			typename Types::TaskJacobian m_Jacobian;
+			typename Types::InverseTaskJacobian m_FixedInverseTaskJacobian;
+			typename Types::SingularValuesVector m_InverseSingularValues;
+			Eigen::JacobiSVD<typename Types::TaskJacobian> m_SVD;
+	};
+
+
+	/**
+		@brief A PrimitiveController for a compile time known task and 
+		resource dimension, e.g. PrimitiveControllerN<3, 7> for the 
+		position of a 7 DOF arm.
+
+		The components keep their usual (dynamically sized) interfaces,
+		but all the arithmetic done by the controller itself (nullspace 
+		projection, combination of the steps) uses fixed size types. 
+		Use it together with GenericEffectorTransformN to also get a 
+		fixed size pseudo inverse. The steps are the same as the ones of 
+		a PrimitiveController with the same components (up to rounding), 
+		including the profiling and all NullspaceProjection variants.
+
+		The constructors throw if the dimensions of the components do not
+		match TaskDim and ResourceDim.
+	*/
+	template <int TaskDim, int ResourceDim>
+	struct PrimitiveControllerN : public PrimitiveController {
+		typedef FixedSizeTypes<TaskDim, ResourceDim> Types;
+
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+		PrimitiveControllerN(
+			Float coefficient,
+			std::vector<ConvergenceCriterionPtr> convergence_criteria,
+			ReferencePtr reference,
+			PotentialPtr potential,
+			SensorTransformPtr sensor_transform,
+			EffectorTransformPtr effector_transform,
+			std::vector<SubordinateControllerPtr> subordinate_controllers,
+			CombinationStrategyPtr combination_strategy,
+			ResourcePtr resource
+		) :
+			PrimitiveController(
+				coefficient,
+				convergence_criteria,
+				reference,
+				potential,
+				sensor_transform,
+				effector_transform,
+				subordinate_controllers,
+				combination_strategy,
+				resource
+			)
+		{
+			check_fixed_dimensions();
+			init_fixed_effector_transform();
+		}
+
+		/**
+			@brief Take over the components of an existing controller, 
+			optionally exchanging the effector transform.
+
+			The subordinate controllers are reparented to the new controller,
+			so the old one must not be used afterwards.
+		*/
+		PrimitiveControllerN(
+			PrimitiveController &controller,
+			EffectorTransformPtr effector_transform = EffectorTransformPtr()
+		) :
+			PrimitiveController(
+				controller.coefficient(),
+				controller.convergence_criteria(),
+				controller.reference(),
+				controller.potential(),
+				controller.sensor_transform(),
+				effector_transform.get() ? effector_transform : controller.effector_transform(),
+				controller.subordinate_controllers(),
+				controller.combination_strategy(),
+				controller.resource()
+			)
+		{
+			m_Name = controller.name();
+			m_NullspaceProjection = controller.nullspace_projection();
+			m_ThreadPool = controller.thread_pool();
+			check_fixed_dimensions();
+			init_fixed_effector_transform();
+
+			//! Once more under the taken over name, for the profiling histograms
+			init_buffers();
+		}
+
+		//! The same cycle as PrimitiveController::update(), see there
+		virtual void update() {
+			{
+				CBF_PROFILE_SCOPE(m_CycleTimeHistograms[ResourceUpdateCall]);
+				m_Resource->update();
+			}
+
+			CBF_PROFILE_SCOPE(m_CycleTimeHistograms[UpdateCall]);
+
+			{
+				CBF_PROFILE_SCOPE(m_CycleTimeHistograms[ReferenceUpdateCall]);
+				m_Reference->update();
+			}
+
+			const std::vector<FloatVector> &references = m_Reference->get();
+
+			{
+				CBF_PROFILE_SCOPE(m_CycleTimeHistograms[SensorTransformUpdateCall]);
+				m_SensorTransform->update_if_changed(m_Resource->get(), m_Resource->version());
+			}
+
+			{
+				CBF_PROFILE_SCOPE(m_CycleTimeHistograms[EffectorTransformUpdateCall]);
+				m_EffectorTransform->update(m_Resource->get(), m_SensorTransform->task_jacobian());
+			}
+
+			m_CurrentTaskPosition = m_SensorTransform->result();
+
+			if (references.size() != 0) {
+				{
+					CBF_PROFILE_SCOPE(m_CycleTimeHistograms[PotentialGradientCall]);
+					m_Potential->gradient_for_version(m_GradientStep, references, m_CurrentTaskPosition, m_Reference->version());
+				}
+
+				CBF_PROFILE_SCOPE(m_CycleTimeHistograms[EffectorTransformExecCall]);
+				m_EffectorTransform->exec(m_GradientStep, m_ResourceStep);
+			} else {
+				m_ResourceStep.setZero();
+			}
+
+			update_subordinate_controllers();
+
+			m_CombinedResults.setZero();
+
+			{
+				CBF_PROFILE_SCOPE(m_CycleTimeHistograms[CombinationCall]);
+				m_CombinationStrategy->exec(m_CombinedResults, m_SubordinateResourceSteps);
+			}
+
+			//! result = step * coefficient + (1 - J# J) combined
+			typename Types::ResourceVector combined = 
+				Eigen::Map<const typename Types::ResourceVector>(m_CombinedResults.data());
+
+			{
+				CBF_PROFILE_SCOPE(m_CycleTimeHistograms[NullspaceProjectionCall]);
+				project_into_nullspace(combined);
+			}
+
+			Eigen::Map<typename Types::ResourceVector>(m_Result.data()) = 
+				Eigen::Map<const typename Types::ResourceVector>(m_ResourceStep.data()) * m_Coefficient 
+				+ combined;
+		}
+
+		protected:
+			void check_fixed_dimensions() const {
+				if (m_SensorTransform->task_dim() != TaskDim)
+					CBF_THROW_RUNTIME_ERROR(m_Name << ": Sensor Transform task dimension " << m_SensorTransform->task_dim() << " is not equal to " << TaskDim);
+
+				if (m_Resource->dim() != ResourceDim)
+					CBF_THROW_RUNTIME_ERROR(m_Name << ": Resource dimension " << m_Resource->dim() << " is not equal to " << ResourceDim);
+			}
+
+			//! The effector transform, if it is a GenericEffectorTransformN, for the DecompositionProjection
+			void init_fixed_effector_transform() {
+				m_FixedEffectorTransform = 
+					dynamic_cast<GenericEffectorTransformN<TaskDim, ResourceDim>*>(m_EffectorTransform.get());
+			}
+
+			//! combined -= J# J combined
+			void project_into_nullspace(typename Types::ResourceVector &combined) {
+				const PseudoInverseWorkspace *decomposition = 0;
+
+				if (m_NullspaceProjection == DecompositionProjection) {
+					//! J# J = V diag(s) diag(s#) V^T, like in PrimitiveController::update()
+					if (m_FixedEffectorTransform) {
+						const Eigen::JacobiSVD<typename Types::TaskJacobian> &svd = 
+							m_FixedEffectorTransform->fixed_decomposition();
+
+						typename Types::SingularValuesVector singular_space;
+						singular_space.noalias() = 
+							svd.matrixV().template leftCols<Types::MinDim>().transpose() * combined;
+						singular_space.array() *= 
+							svd.singularValues().array() 
+							* m_FixedEffectorTransform->fixed_inverse_singular_values().array();
+						combined.noalias() -= svd.matrixV().template leftCols<Types::MinDim>() * singular_space;
+						return;
+					}
+
+					decomposition = m_EffectorTransform->decomposition();
+				}
+
+				if (decomposition) {
+					m_SingularSpaceCombinedResults.noalias() = 
+						decomposition->matrix_v().transpose() * combined;
+					m_SingularSpaceCombinedResults.array() *= 
+						decomposition->singular_values().array() 
+						* decomposition->inverse_singular_values().array();
+					combined.noalias() -= decomposition->matrix_v() * m_SingularSpaceCombinedResults;
+					return;
+				}
+
+				m_Jacobian = Eigen::Map<const typename Types::TaskJacobian>(
+					m_SensorTransform->task_jacobian().data());
+				m_InverseJacobian = Eigen::Map<const typename Types::InverseTaskJacobian>(
+					m_EffectorTransform->inverse_task_jacobian().data());
+
+				if (m_NullspaceProjection == ExplicitProjector) {
+					m_Projector.noalias() = m_InverseJacobian * m_Jacobian;
+					combined -= m_Projector * combined;
+				} else {
+					combined -= m_InverseJacobian * (m_Jacobian * combined);
+				}
+			}
+
+			typename Types::TaskJacobian m_Jacobian;
+			typename Types::InverseTaskJacobian m_InverseJacobian;
+			typename Types::ResourceMatrix m_Projector;
+
+			//! Not owned, m_EffectorTransform if it is a GenericEffectorTransformN
+			GenericEffectorTransformN<TaskDim, ResourceDim> *m_FixedEffectorTransform;
+	};
+
+	/**
+		@brief Returns a PrimitiveControllerN taking over the components 
+		of the controller if its dimensions match one of the precompiled
+		specializations (task dimension 3 or 6, resource dimension 6 or 7). 
+
+		A GenericEffectorTransform or DampedGenericEffectorTransform is 
+		replaced by the equivalent GenericEffectorTransformN. Otherwise 
+		the controller is returned unchanged.
+
+		Controllers from XML only go through this with FixedSize set, 
+		the PrimitiveController stays the default.
+	*/
+	PrimitiveControllerPtr make_fixed_size_controller(PrimitiveControllerPtr controller);
+
+} // namespace
+
+#endif
@@ -59,18 +59,28 @@ namespace CBF {
 		PrimitiveControllerPtr m_PrimitiveController;
 	
 		FloatVector m_Result;
+
+		//! The version of the controlled resource m_Result was computed for
+		unsigned long m_ControlledVersion;
 	
 		PrimitiveControllerResource(PrimitiveControllerPtr controller) :
-			m_PrimitiveController(controller)
+			m_PrimitiveController(controller),
+			m_ControlledVersion(0)
 		{
 		}
 	
 		public:
 			virtual void update() {
-				m_PrimitiveController->resource()->update();
-				m_PrimitiveController->sensor_transform()->update(
-					m_PrimitiveController->resource()->get());
+				ResourcePtr resource = m_PrimitiveController->resource();
+				resource->update();
+				m_PrimitiveController->sensor_transform()->update_if_changed(
+					resource->get(), resource->version());
 				m_Result = m_PrimitiveController->sensor_transform()->result();
+
+				//! Our value changed only if the controlled resource did
+				if (resource->version() == 0 || resource->version() != m_ControlledVersion)
+					bump_version();
+				m_ControlledVersion = resource->version();
 			}
 	
 			virtual const FloatVector &get() {
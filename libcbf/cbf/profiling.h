@@ -0,0 +1,140 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#ifndef CBF_PROFILING_HH
+#define CBF_PROFILING_HH
+
+#include <cbf/config.h>
+
+#include <time.h>
+
+#include <iostream>
+#include <map>
+#include <string>
+
+namespace CBF {
+
+/**
+	@brief Distribution of the durations of one instrumented call
+
+	Durations are counted in power of two buckets of nanoseconds, i.e.
+	bucket i holds the durations in [2^i, 2^(i+1)) ns. Recording a sample
+	does not allocate, so histograms can be filled from the control loop.
+
+	All members are read and written atomically, so several threads may 
+	record into the same histogram (e.g. a transform shared by controllers 
+	on a thread pool) while another one reads it. A reader may see a 
+	sample counted in some members but not yet in others.
+*/
+struct CycleTimeHistogram {
+	enum { Buckets = 40 };
+
+	CycleTimeHistogram() { reset(); }
+
+	//! Copies the members one by one, see above
+	CycleTimeHistogram(const CycleTimeHistogram &other) { *this = other; }
+	CycleTimeHistogram &operator=(const CycleTimeHistogram &other);
+
+	void record(unsigned long long nanoseconds);
+
+	void reset();
+
+	unsigned long long samples() const { return __atomic_load_n(&m_Samples, __ATOMIC_RELAXED); }
+
+	//! All durations in nanoseconds
+	double mean() const;
+	double min() const { return samples() ? __atomic_load_n(&m_Min, __ATOMIC_RELAXED) : 0; }
+	double max() const { return samples() ? __atomic_load_n(&m_Max, __ATOMIC_RELAXED) : 0; }
+
+	/**
+		@brief Upper bound of the bucket holding the q-quantile (e.g. 0.99)
+	*/
+	double quantile(double q) const;
+
+	unsigned long long m_Counts[Buckets];
+	unsigned long long m_Samples;
+	unsigned long long m_Total;
+	unsigned long long m_Min;
+	unsigned long long m_Max;
+};
+
+/**
+	@brief Returns the histogram registered under the name for the owner 
+	(the timed object), creating it if necessary.
+
+	Each owner gets its own histogram, so objects of the same name (e.g. 
+	all the ones built without XML, which carry their base class name) 
+	are told apart. The first owner's histogram is listed under the name, 
+	the ones of later owners under "name#2", "name#3" and so on. Without 
+	an owner the histogram listed under the name is returned, so it is 
+	shared with everyone else doing that (and with its first owner).
+
+	The returned pointer stays valid for the lifetime of the program, so
+	objects look their histograms up once (e.g. when their children are set
+	or their buffers are initialized) and not in the control loop. Lookups
+	are synchronized, and looking up the same name and owner again returns 
+	the same histogram.
+*/
+CycleTimeHistogram *cycle_time_histogram(const std::string &name, const void *owner = 0);
+
+//! A snapshot of all histograms, keyed by name
+std::map<std::string, CycleTimeHistogram> cycle_time_histograms();
+
+void reset_cycle_time_histograms();
+
+//! One line per histogram with samples, mean, median, p99 and max in microseconds
+void print_cycle_time_histograms(std::ostream &out = std::cout);
+
+inline unsigned long long cycle_time_now() {
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return 1000000000ULL * t.tv_sec + t.tv_nsec;
+}
+
+/**
+	@brief Records the time from construction to destruction into a histogram
+*/
+struct ScopedCycleTimer {
+	ScopedCycleTimer(CycleTimeHistogram *histogram) :
+		m_Histogram(histogram),
+		m_Start(cycle_time_now())
+	{ }
+
+	~ScopedCycleTimer() {
+		if (m_Histogram) m_Histogram->record(cycle_time_now() - m_Start);
+	}
+
+	CycleTimeHistogram *m_Histogram;
+	unsigned long long m_Start;
+};
+
+} // namespace
+
+/**
+	Times the rest of the enclosing block into the given histogram when CBF is
+	configured with CBF_PROFILING, and compiles to nothing otherwise. Use at
+	most once per block.
+*/
+#ifdef CBF_PROFILING
+	#define CBF_PROFILE_SCOPE(histogram) CBF::ScopedCycleTimer cbf_scoped_cycle_timer(histogram)
+#else
+	#define CBF_PROFILE_SCOPE(histogram)
+#endif
+
+#endif
@@ -25,6 +25,11 @@
 #include <cbf/effector_transform.h>
 #include <cbf/potential.h>
 
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
 namespace CBFSchema {
 	class PythonPotential;
 	class PythonSensorTransform;
@@ -37,6 +42,10 @@ namespace CBF {
 		start the interpreter.
 	*/
 	struct PythonInterpreter;
+
+	//! The compiled script and its namespace, only defined in python_wrap.cc
+	struct PythonPotentialScript;
+	struct PythonSensorTransformScript;
 	
 	struct PythonPotential;
 	typedef boost::shared_ptr<PythonPotential> PythonPotentialPtr;
@@ -45,14 +54,16 @@ namespace CBF {
 	/**
 		@brief A potential class that calls a python script to do the heavy lifting.
 	
-		This class is probably not thread-safe. Do not use two instances of the same
-		python script..
+		Each instance runs its scripts in a namespace of its own. The GIL is 
+		only held while a script runs, so other threads can use Python in 
+		between.
 	
-		\todo Implement m_InitScript and m_FiniScript support..
+		\todo Implement m_FiniScript support..
 	
-		The exec() implementation of this function executes the m_ExecScript using the 
+		The gradient() implementation of this function executes the m_ExecScript using the 
 		python interpreter. See the PythonPotential::m_ExecScript documentation for "calling
-		conventions".
+		conventions". The script is compiled once, on the first call (and again 
+		if it was changed), after running m_InitScript once in its namespace.
 	
 		Keep in mind that python is very sensitive to whitespaces, thus
 		there exists a method to "sanitize" scripts which is useful when
@@ -64,12 +75,7 @@ namespace CBF {
 		&lt;Dimension&gt; 3 &lt;/Dimension&gt;
 		&lt;ExecScript&gt;
 		#---
-		import scipy as S
-		import scipy.linalg as L
-		ref = S.array(references[0])
-		inp = S.array(input)
-		res = 0.1 * (ref - inp)
-		result = list(res)
+		result[:] = 0.1 * (references[0] - input)
 		#---
 		&lt;/ExecScript&gt;
 		&lt;/Potential&gt;
@@ -111,14 +117,28 @@ namespace CBF {
 	
 			/**
 				The m_ExecCode member has to contain a script that expects
-				a list of lists of floats named "references" which holds the references,
-				a list of floats named "input" which holds the input, and
-				writes a list of floats called "result" which holds
-				the result.
+				a list of arrays named "references" which holds the references,
+				an array named "input" which holds the input, and
+				writes the result into the array called "result", e.g.
+				result[:] = 0.1 * (references[0] - input).
+
+				The arrays are NumPy arrays (or, if NumPy is not available, 
+				memoryviews of doubles) viewing CBF's buffers, so nothing is 
+				converted element by element. Scripts assigning a list of 
+				floats to "result" instead still work, at the cost of the 
+				conversion.
 			*/
 			std::string m_ExecScript;
 	
 			std::string m_FiniScript;
+
+		protected:
+			boost::shared_ptr<PythonPotentialScript> m_Script;
+
+			//! The buffers the script's arrays view
+			std::vector<FloatVector> m_References;
+			FloatVector m_Input;
+			FloatVector m_Gradient;
 	};
 	
 	struct PythonSensorTransform;
@@ -128,16 +148,16 @@ namespace CBF {
 	/**
 		@brief A SensorTransform that calls a python script to do the heavy lifting.
 	
-		This class is probably not thread-safe. Do not use two instances of the same
-		python script..
-	
+		Like PythonPotential, each instance has a namespace of its own and 
+		the script is compiled once.
+
 		Please note the comments for PythonPotential regarding the sanitizing of python
 		scripts.
 	
 		See the PythonSensorTransform::m_ExecScript documentation for conventions about
 		naming the arguments and results..
 	
-		\todo Implement m_InitScript and m_FiniScript support..
+		\todo Implement m_FiniScript support..
 	*/
 	struct PythonSensorTransform : public SensorTransform {
 		protected:
@@ -160,14 +180,23 @@ namespace CBF {
 	
 			/**
 				The m_ExecCode member has to contain a script that expects
-				a list of floats named "resource" which holds the current
-				resource values, and writes a list of floats called "result" which holds
-				the result and a list of list of floats called "jacobian" which
-				holds the current jacobian matrix.
+				an array named "resource" which holds the current
+				resource values, and writes the result into the array "result" 
+				and the current jacobian matrix into the task_dim x resource_dim 
+				array "jacobian" (e.g. jacobian[i, j] = ...), see 
+				PythonPotential::m_ExecScript. Assigning a list of floats 
+				to "result" and a list of lists of floats to "jacobian" still 
+				works, too.
 			*/
 			std::string m_ExecScript;
 	
 			std::string m_FiniScript;
+
+		protected:
+			boost::shared_ptr<PythonSensorTransformScript> m_Script;
+
+			//! The buffer "jacobian" views, Python's arrays are row major
+			Eigen::Matrix<Float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> m_Jacobian;
 	};
 } // namespace
 
@@ -2,7 +2,7 @@
 #define CBF_QT_REFERENCE_HH
 
 #include <cbf/config.h>
-#include <cbf/reference.h>
+#include <cbf/reference_channel.h>
 #include <cbf/types.h>
 #include <cbf/namespace.h>
 
@@ -18,6 +18,8 @@
 #include <QDoubleSpinBox>
 #include <QLabel>
 #include <QCheckBox>
+#include <QObject>
+#include <QTimerEvent>
 
 namespace CBFSchema {
 	class QtReference;
@@ -25,8 +27,15 @@ namespace CBFSchema {
 
 namespace CBF {
 
-/** @brief A Reference that can be set from a GUI window */
-struct QtReference : public Reference {
+/**
+	@brief A Reference that can be set from a GUI window
+
+	The controls are read in the GUI thread, every m_PollInterval
+	milliseconds of its event loop, and changes are handed to update()
+	through the channel. So the control loop may run in another thread
+	and never waits for the GUI.
+*/
+struct QtReference : public ChannelReference {
 	struct Control {
 		Control() : control_name("Control") { }
 		std::string control_name;
@@ -36,7 +45,23 @@ struct QtReference : public Reference {
 		Float initial_value;
 	};
 
-	QtReference(const std::vector<Control> &controls, bool active = false, std::string window_title = "CBF:QtReference") {
+	/**
+		Polls the controls from the thread owning the widget. A timer
+		event, as Qt signals would need the meta object compiler
+	*/
+	struct Poller : public QObject {
+		Poller(QtReference *reference) : m_Reference(reference) { }
+
+		protected:
+			virtual void timerEvent(QTimerEvent *) { m_Reference->publish_values(); }
+
+			QtReference *m_Reference;
+	};
+
+	QtReference(const std::vector<Control> &controls, bool active = false, std::string window_title = "CBF:QtReference") :
+		ChannelReference(controls.size()),
+		m_Poller(this)
+	{
 		init(controls, active, window_title);
 	}
 
@@ -75,35 +100,53 @@ struct QtReference : public Reference {
 
 		m_Widget.show();
 
-		m_References.resize(1);
-		m_Values.resize(controls.size());
+		m_PollInterval = 10;
+		m_Published = false;
+		publish_values();
+		m_Poller.startTimer(m_PollInterval);
 	}
 
-	virtual void update() {
+	/**
+		@brief Publishes the values of the controls if they or the active
+		state changed. Called in the GUI thread
+	*/
+	void publish_values() {
+		const bool active = m_ActiveCheckBox->isChecked();
+
+		bool changed = !m_Published || (active != m_PublishedActive);
 		for (unsigned int i = 0; i < m_Values.size(); ++i) {
-			m_Values[i] = m_SpinBoxes[i]->value();
+			const Float value = m_SpinBoxes[i]->value();
+			changed |= (value != m_Values[i]);
+			m_Values[i] = value;
 		}
-		m_References[0] = m_Values;
-	}
 
-	virtual unsigned int dim() {
-		return m_Values.size();
-	}
+		if (!changed)
+			return;
 
-	virtual std::vector<FloatVector> &get() {
-		if (m_ActiveCheckBox->isChecked()) {
-			return m_References;
-		}
-		return m_EmptyReferenceVector;		
+		if (active)
+			publish(m_Values);
+		else
+			withdraw();
+
+		m_Published = true;
+		m_PublishedActive = active;
 	}
 
 	QCheckBox *m_ActiveCheckBox;
+
+	//! The values of the controls, only accessed in the GUI thread
 	FloatVector m_Values;
 	QWidget m_Widget;
 
-	std::vector<FloatVector> m_EmptyReferenceVector;
-
 	std::vector<QDoubleSpinBox*> m_SpinBoxes;
+
+	Poller m_Poller;
+
+	//! In milliseconds
+	int m_PollInterval;
+
+	bool m_Published;
+	bool m_PublishedActive;
 };
 
 typedef boost::shared_ptr<QtReference> QtReferencePtr;
@@ -44,7 +44,7 @@ namespace CBF {
 		QtSensorTransform(const CBFSchema::QtSensorTransform &xml_instance, ObjectNamespacePtr object_namespace);
 
 		virtual void update(const FloatVector &resource_value) {
-			m_Operand->update(resource_value);
+			m_Operand->update_if_changed(resource_value, m_UpdateVersion);
 
 			for (unsigned int i = 0; i < m_Labels.size(); ++i) {
 				m_Labels[i]->setNum(m_Operand->result()[i]);
@@ -38,7 +38,7 @@ namespace CBF {
 	/** @brief: Base class for all types of references */
 	struct Reference : public Object {
 
-		Reference() : Object("Reference") { }
+		Reference() : Object("Reference"), m_Version(0) { }
 
 		Reference(const CBFSchema::Reference &xml_instance, ObjectNamespacePtr object_namespace);
 	
@@ -60,12 +60,29 @@ namespace CBF {
 			the task variable lives in).
 		*/
 		virtual std::vector<FloatVector> &get() { return m_References; }
+
+		/**
+			@brief Identifies the current references
+
+			Like Resource::version(), this changes whenever the references 
+			may have changed, so potentials can keep data derived from them
+			(see ReferenceIndex and Potential::gradient_for_version()). 
+			Changes made through get() are not noticed. A reference not 
+			keeping versions stays at 0, and a ReferenceIndex then compares
+			all its references on every query.
+		*/
+		unsigned long version() const { return __atomic_load_n(&m_Version, __ATOMIC_RELAXED); }
 	
 		virtual ~Reference() { }
 
 		protected:
+			//! To be called by subclasses whenever the references may have changed
+			void bump_version();
+
 			/** This member gets updated by update() */
 			std::vector<FloatVector> m_References;
+
+			unsigned long m_Version;
 	};
 	
 	
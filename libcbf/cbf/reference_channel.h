@@ -0,0 +1,154 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#ifndef CBF_REFERENCE_CHANNEL_HH
+#define CBF_REFERENCE_CHANNEL_HH
+
+#include <cbf/config.h>
+#include <cbf/types.h>
+#include <cbf/reference.h>
+#include <cbf/namespace.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+namespace CBF {
+
+	/**
+		@brief Hands reference values from one producer thread (e.g. a
+		middleware callback) to one consumer thread (the control loop)
+		without locks.
+
+		A triple buffer of preallocated vectors: the producer writes the
+		back buffer and swaps it with the middle one, the consumer swaps
+		its front buffer with the middle one if that holds a newer value.
+		Both sides take a bounded number of steps and never wait for the
+		other, and neither allocates. Values published in between two
+		fetch() calls are skipped, only the latest one is seen.
+
+		There has to be at most one producer and one consumer at a time,
+		several producer threads have to serialize their calls themselves.
+		Besides a value, the producer can publish that there is no
+		reference (withdraw()).
+
+		The swaps use the GCC atomic builtins (also provided by clang).
+	*/
+	struct ReferenceChannel {
+		ReferenceChannel(unsigned int dim);
+
+		unsigned int dim() const { return m_Dim; }
+
+		/**
+			@brief Producer side: the buffer to write the next value into
+			in place, followed by publish()
+		*/
+		FloatVector &back() { return m_Values[m_Back]; }
+
+		//! Producer side: makes the back buffer's value the latest one
+		void publish();
+
+		//! Producer side: copies value into the back buffer and publishes it
+		void publish(const FloatVector &value);
+
+		//! Producer side: publishes that there is no reference
+		void withdraw();
+
+		/**
+			@brief Consumer side: takes the latest published value, if there
+			is one newer than the current one, and returns whether there was
+		*/
+		bool fetch();
+
+		//! Consumer side: whether the current value is a reference, not a withdraw()
+		bool valid() const { return m_Valid[m_Front]; }
+
+		//! Consumer side: the current value
+		const FloatVector &value() const { return m_Values[m_Front]; }
+
+		protected:
+			//! Set in m_Middle when it holds a value the consumer has not seen
+			enum { Fresh = 4, IndexMask = 3 };
+
+			//! Producer side: swaps the back buffer with the middle one
+			void swap_back();
+
+			unsigned int m_Dim;
+
+			FloatVector m_Values[3];
+			bool m_Valid[3];
+
+			//! Only touched by the producer
+			unsigned int m_Back;
+
+			//! Only touched by the consumer
+			unsigned int m_Front;
+
+			//! The buffer in between, and Fresh. Only accessed atomically
+			unsigned int m_Middle;
+
+		private:
+			ReferenceChannel(const ReferenceChannel &);
+			ReferenceChannel &operator=(const ReferenceChannel &);
+	};
+
+	typedef boost::shared_ptr<ReferenceChannel> ReferenceChannelPtr;
+
+
+	/**
+		@brief A reference fed by another thread through a ReferenceChannel
+
+		Sources like network callbacks or GUIs call publish() (or withdraw())
+		from their own thread, and update() in the control thread picks up
+		the latest value without waiting for them. Until the first value
+		arrives, and after withdraw(), get() returns no references.
+	*/
+	struct ChannelReference : public Reference {
+		ChannelReference(unsigned int dim);
+
+		ChannelReference(const CBFSchema::Reference &xml_instance, ObjectNamespacePtr object_namespace, unsigned int dim);
+
+		//! Takes the latest published value, without locking or allocating once there was a value
+		virtual void update();
+
+		virtual unsigned int dim() { return m_Channel.dim(); }
+
+		virtual std::vector<FloatVector> &get() {
+			return m_HasReference ? m_References : m_NoReferences;
+		}
+
+		//! Called by the producer thread. Throws if value has the wrong dimension
+		void publish(const FloatVector &value) { m_Channel.publish(value); }
+
+		//! Called by the producer thread
+		void withdraw() { m_Channel.withdraw(); }
+
+		protected:
+			ReferenceChannel m_Channel;
+
+			bool m_HasReference;
+
+			std::vector<FloatVector> m_NoReferences;
+	};
+
+	typedef boost::shared_ptr<ChannelReference> ChannelReferencePtr;
+
+} // namespace
+
+#endif
@@ -0,0 +1,142 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#ifndef CBF_REFERENCE_INDEX_HH
+#define CBF_REFERENCE_INDEX_HH
+
+#include <cbf/config.h>
+#include <cbf/types.h>
+
+#include <vector>
+
+namespace CBF {
+
+	/**
+		@brief Finds the reference closest to the input in sub-linear time,
+		for potentials getting many references (e.g. sets of grasp poses).
+
+		The references are mapped to points whose Euclidean distance orders
+		them like the potential's distance() does, and put into a k-d tree:
+
+		- Euclidean: the references themselves (SquarePotential,
+		  ExpressionPotential)
+		- Direction: the normalized references, as the angle between two
+		  directions grows with their distance on the unit sphere
+		  (AxisPotential)
+		- Rotation: the unit quaternions of axis angle references, each
+		  as q and -q, as the angle of the rotation between two of them
+		  grows with the distance to the closer one of q and -q
+		  (AxisAnglePotential)
+
+		closest() rebuilds the tree when the references changed. Given a
+		nonzero Reference::version(), that is when the version changed,
+		otherwise the references are compared with a copy kept from the
+		last build. That comparison is linear in the number of references
+		times their dimension and happens on every query, so references
+		used with many candidates should keep versions (DummyReference
+		and CompositeReference over versioned references do). Queries do
+		not allocate.
+	*/
+	struct ReferenceIndex {
+		enum Metric {
+			Euclidean,
+			Direction,
+			Rotation
+		};
+
+		ReferenceIndex(Metric metric = Euclidean, unsigned int threshold = 32) :
+			m_Threshold(threshold),
+			m_Metric(metric),
+			m_Version(0),
+			m_Builds(0)
+		{
+		}
+
+		/**
+			@brief Whether potentials should use the index for this many
+			references instead of trying each one
+
+			For few references the linear scan is faster. A threshold of 0
+			disables the index, e.g. for potentials overriding distance().
+		*/
+		bool applies(unsigned int num_references) const {
+			return m_Threshold != 0 && num_references >= m_Threshold;
+		}
+
+		/**
+			@brief The index of the reference closest to input
+
+			references must not be empty. version is the references'
+			Reference::version(), or 0 if unknown.
+		*/
+		unsigned int closest(
+			const std::vector<FloatVector> &references,
+			const FloatVector &input,
+			unsigned long version = 0
+		);
+
+		//! How often the tree was built, e.g. to check it is not rebuilt each cycle
+		unsigned int builds() const { return m_Builds; }
+
+		unsigned int m_Threshold;
+
+		protected:
+			struct Node {
+				//! The node's points are the columns [begin, end) of m_Points
+				unsigned int begin, end;
+
+				//! 0 for leaves, the left child always follows its parent
+				unsigned int right;
+
+				unsigned int axis;
+				Float split;
+			};
+
+			bool changed(const std::vector<FloatVector> &references, unsigned long version) const;
+
+			void build(const std::vector<FloatVector> &references);
+
+			unsigned int build_node(unsigned int begin, unsigned int end, std::vector<unsigned int> &order);
+
+			//! Maps a reference or input to its point
+			void map(const FloatVector &v, FloatVector &point) const;
+
+			Metric m_Metric;
+
+			unsigned long m_Version;
+
+			unsigned int m_Builds;
+
+			//! The references of the last build, one per column
+			FloatMatrix m_References;
+
+			//! The points, reordered so the points of each node are adjacent
+			FloatMatrix m_Points;
+
+			//! The reference of each column of m_Points
+			std::vector<unsigned int> m_ReferenceIndices;
+
+			std::vector<Node> m_Nodes;
+
+			FloatVector m_Query;
+	};
+
+} // namespace
+
+#endif
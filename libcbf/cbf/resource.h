@@ -44,7 +44,7 @@ namespace CBF {
 	*/
 	
 	struct Resource : public Object {
-		Resource() : Object("Resource") { }
+		Resource() : Object("Resource"), m_Version(0) { }
 
 		Resource(const CBFSchema::Resource &xml_instance, ObjectNamespacePtr object_namespace);
 
@@ -82,6 +82,24 @@ namespace CBF {
 			returns the n.
 		*/
 		virtual unsigned int dim() = 0;
+
+		/**
+			@brief Identifies the current value of the resource
+
+			Changes whenever the value may have changed, i.e. in add() and 
+			set() and in update() if it reads the value anew. Versions are 
+			unique among all resources, so a SensorTransform can compare the
+			version it was last updated for, see 
+			SensorTransform::update_if_changed(). A resource not keeping 
+			versions stays at 0.
+		*/
+		unsigned long version() const { return __atomic_load_n(&m_Version, __ATOMIC_RELAXED); }
+
+		protected:
+			//! To be called by subclasses whenever the value may have changed
+			void bump_version();
+
+			unsigned long m_Version;
 	};
 
 	typedef boost::shared_ptr<Resource> ResourcePtr;
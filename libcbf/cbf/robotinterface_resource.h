@@ -136,6 +136,7 @@ namespace CBF {
 			boost::recursive_mutex::scoped_lock lock(m_ResultMutex);
 	
 			m_Result = m_LastPose;		
+			bump_version();
 		}
 	
 		virtual void add(const FloatVector &arg) {
@@ -29,6 +29,7 @@
 #include <cbf/namespace.h>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <vector>
 #include <string>
@@ -72,7 +73,10 @@ namespace CBF {
 	struct SensorTransform : public Object {
 		SensorTransform()	:
 			Object("SensorTransform"),
-			m_DefaultComponentName("A task space variable")
+			m_DefaultComponentName("A task space variable"),
+			m_ResourceVersion(0),
+			m_UpdateVersion(0),
+			m_JacobianPending(false)
 		{
 	
 		}
@@ -114,9 +118,82 @@ namespace CBF {
 			computations whose results will consequently be used by 
 			different methods, e.g. the jacobian given that it depends 
 			on the current resource value.
+
+			Transforms whose jacobian is expensive may only compute the 
+			result here and leave the jacobian to update_jacobian(), see 
+			there.
 		*/
 		virtual void update(const FloatVector &resource_value) = 0;
+
+		/**
+			@brief The jacobian phase of update(), for transforms computing 
+			the task jacobian lazily.
+
+			Such transforms compute only result() in update() and call 
+			defer_jacobian() there. The first task_jacobian() call after that
+			calls this function with the same resource value, so consumers 
+			only reading result() (e.g. PrimitiveControllerResource, the 
+			convergence criteria or monitoring) never pay for the jacobian. 
+			Transforms combining others should compute their operands' 
+			jacobians here as well, not in update().
+
+			The default does nothing, for transforms computing the jacobian 
+			in update().
+		*/
+		virtual void update_jacobian(const FloatVector &resource_value) { }
+
+		/**
+			@brief Calls update() unless the last call to this function
+			already did for the same Resource::version().
+
+			This way a transform shared by several controllers or operators
+			is evaluated once per resource value. A version of 0 always 
+			updates. Transforms combining other transforms pass 
+			m_UpdateVersion on to them, so the whole tree is skipped.
+
+			Calls are serialized, so controllers updated in parallel (e.g. 
+			subordinates on a thread pool) can share a transform as long as 
+			they read the same resource version.
+
+			Calling update() directly in between is not noticed, so callers 
+			doing that on a shared transform should pass 0.
+		*/
+		void update_if_changed(const FloatVector &resource_value, unsigned long resource_version) {
+			boost::mutex::scoped_lock lock(m_UpdateMutex);
+
+			if (resource_version != 0 && resource_version == m_ResourceVersion)
+				return;
+
+			m_ResourceVersion = 0;
+			m_UpdateVersion = resource_version;
+			update(resource_value);
+			m_UpdateVersion = 0;
+			m_ResourceVersion = resource_version;
+		}
 	
+		/**
+			@brief Evaluate the transform for many resource values at once, 
+			e.g. for sampling based redundancy resolution or workspace analysis.
+
+			Each column of resource_values (resource_dim() x n) is one set 
+			of resource values. Column i of results (task_dim() x n) becomes 
+			the result for column i and columns [i * resource_dim(), 
+			(i + 1) * resource_dim()) of task_jacobians (task_dim() x 
+			n * resource_dim()) its task jacobian, so that, with the default
+			column major storage, each jacobian is contiguous. Both are 
+			resized as needed.
+
+			The default implementation calls update() for each column, 
+			leaving result() and task_jacobian() at those of the last one. 
+			Subclasses may override it with something faster, which need 
+			not touch result() and task_jacobian() at all.
+		*/
+		virtual void update_batch(
+			const FloatMatrix &resource_values, 
+			FloatMatrix &results, 
+			FloatMatrix &task_jacobians
+		);
+
 		/**
 			@brief Return a reference to the result calculated in the 
 			update() function.
@@ -131,9 +208,23 @@ namespace CBF {
 			controller to construct the nullspace projector.
 	
 			May only be called after a call to update() to update the internal
-			matrices.
+			matrices. Runs update_jacobian() if update() deferred it. Only the 
+			first of concurrent callers does, the others wait for it.
 		*/
-		virtual const FloatMatrix &task_jacobian() const { return m_TaskJacobian; }
+		virtual const FloatMatrix &task_jacobian() const { 
+			if (__atomic_load_n(&m_JacobianPending, __ATOMIC_ACQUIRE)) {
+				//! Logically const, the jacobian belongs to the last update()
+				SensorTransform &self = const_cast<SensorTransform&>(*this);
+				boost::mutex::scoped_lock lock(self.m_JacobianMutex);
+
+				if (m_JacobianPending) {
+					self.update_jacobian(m_ResourceValue);
+					__atomic_store_n(&self.m_JacobianPending, false, __ATOMIC_RELEASE);
+				}
+			}
+
+			return m_TaskJacobian; 
+		}
 	
 
 		/**
@@ -171,6 +262,30 @@ namespace CBF {
 			std::vector<std::string> m_ComponentNames;
 
 			std::string m_DefaultComponentName;
+
+			//! The resource version the result was computed for, 0 if unknown
+			unsigned long m_ResourceVersion;
+
+			//! The resource version during an update_if_changed(), 0 otherwise
+			unsigned long m_UpdateVersion;
+
+			/**
+				@brief To be called by update() instead of computing the 
+				jacobian, see update_jacobian()
+			*/
+			void defer_jacobian(const FloatVector &resource_value) {
+				m_ResourceValue = resource_value;
+				__atomic_store_n(&m_JacobianPending, true, __ATOMIC_RELEASE);
+			}
+
+			//! Whether task_jacobian() has to call update_jacobian() first
+			bool m_JacobianPending;
+
+			//! Serializes update_if_changed()
+			boost::mutex m_UpdateMutex;
+
+			//! Serializes the deferred update_jacobian() in task_jacobian()
+			boost::mutex m_JacobianMutex;
 	};
 
 	typedef boost::shared_ptr<SensorTransform> SensorTransformPtr;
@@ -222,9 +337,8 @@ namespace CBF {
 		}
 
 		virtual void update(const FloatVector &resource_value) {
-			m_Operand->update(resource_value);
+			m_Operand->update_if_changed(resource_value, m_UpdateVersion);
 			m_Result = m_Operand->result();
-			m_TaskJacobian = m_Operand->task_jacobian();
 
 			CBF_DEBUG(m_Result.size());
 
@@ -236,7 +350,19 @@ namespace CBF {
 				CBF_DEBUG((unsigned int)(current_row / m_Blocksize));
 
 				m_Result[current_row] *= m_Factors[(unsigned int)(current_row / m_Blocksize)];
+			}
+
+			defer_jacobian(resource_value);
+		}
+
+		virtual void update_jacobian(const FloatVector &resource_value) {
+			m_TaskJacobian = m_Operand->task_jacobian();
 
+			for (
+				unsigned int current_row = 0, max_row = task_dim(); 
+				current_row < max_row; 
+				++current_row
+			) {
 				for (unsigned int i = 0, imax = resource_dim(); i < imax; ++i) {
 					m_TaskJacobian(current_row, i) *= m_Factors[(unsigned int)(current_row / m_Blocksize)];
 				}
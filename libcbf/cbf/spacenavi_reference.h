@@ -28,38 +28,46 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 
-#include <cbf/reference.h>
+#include <cbf/reference_channel.h>
 #include <cbf/types.h>
 
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
 namespace CBFSchema { class SpaceNaviReference; }
 
 namespace CBF {
 	
-	/** @brief: A reference that takes its information from a SpaceMouse */
-	struct SpaceNaviReference : public Reference {
+	/**
+		@brief: A reference that takes its information from a SpaceMouse
+
+		The device is read in a thread of its own, which publishes the
+		latest motion to the control thread through the channel.
+	*/
+	struct SpaceNaviReference : public ChannelReference {
 		SpaceNaviReference(const CBFSchema::SpaceNaviReference &xml_instance,
 								 ObjectNamespacePtr object_namespace);
 	
-		SpaceNaviReference()
+		SpaceNaviReference() :
+			ChannelReference(6u)
 		{
 			init();
 		}
 
 		virtual ~SpaceNaviReference();
 	
-		virtual void update();
-
-		virtual unsigned int dim() {
-			return 6u;
-		}
-	
 		/**
 			@brief Utility function for the constructor.
 		*/
 		void init();
 
 		protected:
+			//! The reading thread, until it is interrupted
+			void read_events();
+
 			void *m_Device;
+
+			boost::shared_ptr<boost::thread> m_Thread;
 	};
 	
 } // namespace
@@ -26,6 +26,7 @@
 #include <cbf/types.h>
 #include <cbf/utilities.h>
 #include <cbf/potential.h>
+#include <cbf/reference_index.h>
 #include <cbf/config.h>
 #include <cbf/namespace.h>
 
@@ -45,6 +46,12 @@ struct SquarePotential : public Potential {
 
 	unsigned int m_Dim;
 
+	/**
+		Finds the closest of many references, see ReferenceIndex. Set its 
+		m_Threshold to 0 when overriding distance().
+	*/
+	ReferenceIndex m_ReferenceIndex;
+
 	SquarePotential(unsigned int dim = 1, Float coefficient = 1.) :
 		m_Coefficient(coefficient),
 		m_Dim(dim)
@@ -56,7 +63,8 @@ struct SquarePotential : public Potential {
 	}
 
 	virtual Float distance(const FloatVector &v1, const FloatVector &v2) {
-		return (norm(v1 - v2));
+		//! Taking the norm of the expression avoids materializing v1 - v2
+		return (v1 - v2).norm();
 	}
 
 	virtual unsigned int dim() const {
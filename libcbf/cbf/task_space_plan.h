@@ -1,17 +1,33 @@
 #ifndef CBF_TASK_SPACE_PLAN_HH
 #define CBF_TASK_SPACE_PLAN_HH
 
+#include <cbf/config.h>
+#include <cbf/types.h>
 #include <cbf/reference.h>
+#include <cbf/namespace.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+namespace CBFSchema { class JerkLimitedTaskSpacePlan; }
 
 namespace CBF {
 
 /**
-	A TaskSpacePlan is a wrapper around a reference which 
+	A TaskSpacePlan is a wrapper around a reference which
 	plans smooth trajectories and updates the task space
 	reference at each cycle
 */
 struct TaskSpacePlan : public Reference {
-	/** 
+	TaskSpacePlan() { }
+
+	TaskSpacePlan(const CBFSchema::Reference &xml_instance, ObjectNamespacePtr object_namespace) :
+		Reference(xml_instance, object_namespace)
+	{
+	}
+
+	/**
 		This is the wrapped reference..
 	*/
 	ReferencePtr m_Reference;
@@ -30,7 +46,124 @@ struct TaskSpacePlan : public Reference {
 	virtual void update() { }
 };
 
+typedef boost::shared_ptr<TaskSpacePlan> TaskSpacePlanPtr;
+
+
+/**
+	@brief An online trajectory generator leading from the current state
+	to the wrapped reference within velocity, acceleration and jerk limits.
+
+	Each dimension gets up to seven segments of constant jerk: a jerk
+	limited change to a peak velocity, cruising at it and a jerk limited
+	stop at the target. The peak velocity is found by a fixed number of
+	bisection steps, so replanning takes bounded time. The dimensions
+	are planned independently and may arrive at different times.
+
+	Each update() advances the plan by m_CycleTime and replans first if
+	the wrapped reference's (first) value changed, starting from the
+	current position, velocity and acceleration, so the reference stays
+	smooth when the target moves. Evaluating the plan is a constant
+	number of operations per cycle, done for all dimensions at once.
+
+	With a SquarePotential of coefficient 1 and a large
+	MaxGradientStepNorm the controller then follows the planned
+	reference, so the step norm clamp no longer shapes the motion.
+
+	The plan starts at rest at the first target, unless reset() gives it
+	the current task space position.
+*/
+struct JerkLimitedTaskSpacePlan : public TaskSpacePlan {
+	JerkLimitedTaskSpacePlan(const CBFSchema::JerkLimitedTaskSpacePlan &xml_instance, ObjectNamespacePtr object_namespace);
+
+	/**
+		The limits are per dimension and have to be positive. cycle_time
+		is the time between two update() calls.
+	*/
+	JerkLimitedTaskSpacePlan(
+		ReferencePtr reference,
+		const FloatVector &max_velocity,
+		const FloatVector &max_acceleration,
+		const FloatVector &max_jerk,
+		Float cycle_time
+	);
+
+	//! Replans to the wrapped reference's current (first) value
+	virtual void set_new_reference();
+
+	/**
+		@brief Updates the wrapped reference, replans if it changed and
+		advances the plan by one cycle
+	*/
+	virtual void update();
+
+	virtual unsigned int dim() { return m_Reference->dim(); }
+
+	/**
+		@brief Continue from this state, e.g. the current task space
+		position, replanning to the current target
+
+		A velocity that cannot be taken back below the maximum velocity
+		before the jerk limited acceleration reaches 0 overshoots it.
+	*/
+	void reset(const FloatVector &position);
+
+	void reset(const FloatVector &position, const FloatVector &velocity, const FloatVector &acceleration);
+
+	const FloatVector &position() const { return m_Position; }
+
+	const FloatVector &velocity() const { return m_Velocity; }
+
+	const FloatVector &acceleration() const { return m_Acceleration; }
+
+	//! The time until the last dimension arrives at the target
+	Float remaining_time() const;
+
+	//! Whether all dimensions arrived at the target
+	bool reached() const;
+
+	FloatVector m_MaxVelocity;
+	FloatVector m_MaxAcceleration;
+	FloatVector m_MaxJerk;
+
+	Float m_CycleTime;
+
+	protected:
+		enum { NumSegments = 7 };
+
+		void init();
+
+		//! Plans the segments of dimension i from the current state
+		void plan(unsigned int i);
+
+		//! The wrapped reference's value the plan leads to
+		FloatVector m_Target;
+
+		unsigned long m_TargetVersion;
+
+		bool m_HasState;
+
+		//! Duration and jerk of each segment, one column per dimension
+		FloatMatrix m_Durations;
+		FloatMatrix m_Jerks;
+
+		//! The current segment of each dimension, NumSegments once arrived
+		std::vector<unsigned int> m_Segments;
+
+		//! The time since the current segment started
+		FloatVector m_SegmentTime;
+
+		//! The state at the start of the current segment
+		FloatVector m_SegmentPosition;
+		FloatVector m_SegmentVelocity;
+		FloatVector m_SegmentAcceleration;
+		FloatVector m_SegmentJerk;
+
+		FloatVector m_Position;
+		FloatVector m_Velocity;
+		FloatVector m_Acceleration;
+};
 
+typedef boost::shared_ptr<JerkLimitedTaskSpacePlan> JerkLimitedTaskSpacePlanPtr;
 
 } // namespace
 
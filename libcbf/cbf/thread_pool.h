@@ -0,0 +1,100 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#ifndef CBF_THREAD_POOL_HH
+#define CBF_THREAD_POOL_HH
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <string>
+#include <vector>
+
+namespace CBF {
+
+/**
+	@brief A batch of independent jobs, identified by their index
+*/
+struct ParallelTask {
+	virtual ~ParallelTask() { }
+
+	//! Called exactly once for each index of the batch, from any thread
+	virtual void run(unsigned int index) = 0;
+};
+
+/**
+	@brief A fixed set of worker threads, created once and reused for each
+	batch handed to run(), so there is no thread creation in the control loop.
+
+	The thread calling run() works on the batch, too, so a pool with n
+	worker threads evaluates up to n + 1 jobs at once.
+*/
+struct ThreadPool {
+	ThreadPool(unsigned int threads);
+
+	//! Stops and joins the worker threads
+	~ThreadPool();
+
+	/**
+		@brief Runs task.run(i) for i in [0, count) and returns when all
+		of them are done.
+
+		If the pool is already busy with another batch (e.g. when run() is
+		called from within a job), the jobs run sequentially in the calling
+		thread instead. The first exception thrown by a job is rethrown as
+		std::runtime_error after the whole batch is done.
+	*/
+	void run(ParallelTask &task, unsigned int count);
+
+	unsigned int threads() const { return m_Threads.size(); }
+
+	protected:
+		void work();
+
+		//! Runs jobs of the current batch until there are none left. Expects m_Mutex to be held
+		void work_on_batch(boost::unique_lock<boost::mutex> &lock);
+
+		std::vector<boost::shared_ptr<boost::thread> > m_Threads;
+
+		//! Held by the thread running a batch, so batches do not overlap
+		boost::mutex m_BatchMutex;
+
+		//! Protects all of the batch state below
+		boost::mutex m_Mutex;
+		boost::condition_variable m_BatchStarted;
+		boost::condition_variable m_BatchFinished;
+
+		ParallelTask *m_Task;
+		unsigned int m_Count;
+		unsigned int m_NextIndex;
+		unsigned int m_Finished;
+		unsigned long m_Batch;
+		bool m_Stop;
+
+		bool m_Failed;
+		std::string m_Error;
+};
+
+typedef boost::shared_ptr<ThreadPool> ThreadPoolPtr;
+
+} // namespace
+
+#endif
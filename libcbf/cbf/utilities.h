@@ -26,11 +26,21 @@
 #include <cbf/types.h>
 #include <cbf/namespace.h>
 
+#include <Eigen/SVD>
+#include <Eigen/Cholesky>
+#include <Eigen/QR>
+
+#if EIGEN_VERSION_AT_LEAST(3,3,0)
+	//! BDCSVD and CompleteOrthogonalDecomposition are only available from Eigen 3.3 on
+	#define CBF_HAVE_EIGEN_3_3
+#endif
+
 #include <boost/shared_ptr.hpp>
 
 #include <cmath>
 
 #include <iostream>
+#include <string>
 
 namespace KDL {
 	class Chain;
@@ -69,10 +79,228 @@ const Float slerp_threshold = 0.001;
 */
 FloatVector &slerp(const FloatVector &start, const FloatVector &end, Float step, FloatVector &result);
 
+/**
+	@brief The decompositions the pseudo inverse functions below can use.
+
+	Not every solver can realize every inversion rule: the SVD based ones
+	work for all of them, DampedLeastSquaresSolver only for 
+	damped_pseudo_inverse(), CompleteOrthogonalDecompositionSolver and 
+	QRSolver only for pseudo_inverse(). The functions throw a 
+	std::runtime_error when called with an unsupported solver.
+*/
+enum PseudoInverseSolver {
+	//! Eigen::JacobiSVD (the default)
+	JacobiSVDSolver,
+	//! Eigen::BDCSVD, faster than JacobiSVD for bigger matrices (needs Eigen 3.3)
+	BDCSVDSolver,
+	//! Cholesky decomposition of m m^T + damping_constant * 1
+	DampedLeastSquaresSolver,
+	//! Eigen::CompleteOrthogonalDecomposition (needs Eigen 3.3)
+	CompleteOrthogonalDecompositionSolver,
+	//! Minimum norm solution from a column pivoting Householder QR of m^T
+	QRSolver,
+	//! WarmStartedSVD, for matrices that change little from call to call
+	WarmStartedSVDSolver
+};
+
+/**
+	@brief Returns the solver with the given name (which is the 
+	enumerator's name without the "Solver" suffix, e.g. "BDCSVD").
+	Throws if there is no such solver or it is not available with the 
+	Eigen version CBF was built against.
+*/
+PseudoInverseSolver pseudo_inverse_solver(const std::string &name);
+
+/**
+	@brief A thin SVD m = U diag(s) V^T that starts from the left singular 
+	vectors of the previous compute() call.
+
+	For m with at most as many rows as columns, the columns of m^T U_prev 
+	span the row space of m (as long as U_prev did not rotate away too 
+	far). With the QR decomposition m^T U_prev = Q R it is m = U_prev R^T Q^T,
+	so only the small, nearly diagonal R^T needs to be decomposed by Jacobi
+	rotations, which converge in very few sweeps in this case.
+
+	If the off diagonal part of R exceeds drift_tolerance (relative to the 
+	norm of R), if m has more rows than columns, if its size changed, or 
+	after refresh_interval warm started calls, the full JacobiSVD is computed 
+	instead. 
+
+	The interface follows Eigen::JacobiSVD as far as used by the pseudo 
+	inverse functions below. Like the JacobiSVD, compute() does not 
+	allocate when called again with a matrix of the same size (and the
+	same options), as long as m has fewer than 48 rows (more make Eigen 
+	apply the Householder reflections blockwise, which allocates).
+*/
+struct WarmStartedSVD {
+	WarmStartedSVD(Float drift_tolerance = 0.1, unsigned int refresh_interval = 1000) :
+		m_DriftTolerance(drift_tolerance),
+		m_RefreshInterval(refresh_interval),
+		m_WarmStarts(0),
+		m_FullDecompositions(0),
+		m_WarmStartsSinceRefresh(0),
+		m_Columns(0)
+	{ }
+
+	/**
+		@brief Decomposes m. V is computed thin or full as asked for by the
+		Eigen::ComputeThinV or Eigen::ComputeFullV option, or not at all. U
+		is always computed since the next warm start needs it (full with
+		Eigen::ComputeFullU, else thin, which is the same unless m has more 
+		rows than columns).
+	*/
+	WarmStartedSVD &compute(
+		const FloatMatrix &m, 
+		unsigned int computation_options = Eigen::ComputeThinU | Eigen::ComputeThinV
+	);
+
+	const FloatVector &singularValues() const { return m_SingularValues; }
+	const FloatMatrix &matrixU() const { return m_U; }
+	const FloatMatrix &matrixV() const { return m_V; }
+	int nonzeroSingularValues() const { return m_NonzeroSingularValues; }
+
+	//! The number of compute() calls that were warm started
+	unsigned int warm_starts() const { return m_WarmStarts; }
+
+	//! The number of compute() calls that needed the full decomposition
+	unsigned int full_decompositions() const { return m_FullDecompositions; }
+
+	protected:
+		Float m_DriftTolerance;
+		unsigned int m_RefreshInterval;
+		unsigned int m_WarmStarts;
+		unsigned int m_FullDecompositions;
+		unsigned int m_WarmStartsSinceRefresh;
+		int m_NonzeroSingularValues;
+
+		//! The number of columns of the last decomposed matrix
+		int m_Columns;
+
+		FloatVector m_SingularValues;
+		FloatMatrix m_U;
+		FloatMatrix m_V;
+
+		//! Scratch storage for the warm started path
+		FloatMatrix m_PreviousU;
+		FloatMatrix m_Projected;
+		FloatMatrix m_RTransposed;
+
+		//! Q of the QR decomposition, as many columns as V needs
+		FloatMatrix m_Q;
+
+		//! For applying Q without a temporary
+		FloatVector m_Workspace;
+
+		Eigen::HouseholderQR<FloatMatrix> m_QR;
+		Eigen::JacobiSVD<FloatMatrix> m_SmallSVD;
+
+		Eigen::JacobiSVD<FloatMatrix> m_FullSVD;
+};
+
+/**
+	@brief Scratch storage for the pseudo inverse functions below.
+
+	With JacobiSVDSolver, WarmStartedSVDSolver, DampedLeastSquaresSolver
+	and QRSolver the overloads taking a workspace do not allocate heap 
+	memory as long as they are called repeatedly with matrices of the same
+	size, with fewer than 48 rows (see WarmStartedSVD). BDCSVDSolver and 
+	CompleteOrthogonalDecompositionSolver allocate on every call (Eigen's 
+	BDCSVD and CompleteOrthogonalDecomposition::pseudoInverse() use 
+	temporaries), so they do not suit a loop that must not allocate. Keep
+	one workspace per matrix that gets inverted each cycle (e.g. as a 
+	member of an EffectorTransform).
+
+	After a call with one of the SVD based solvers the workspace also 
+	holds the (thin) decomposition m = U diag(s) V^T of the inverted 
+	matrix, so others can reuse it instead of decomposing m again.
+*/
+struct PseudoInverseWorkspace {
+	PseudoInverseWorkspace(PseudoInverseSolver solver = JacobiSVDSolver) : 
+		m_Solver(solver), 
+		m_Rank(0) 
+	{ }
+
+	PseudoInverseSolver m_Solver;
+
+	Eigen::JacobiSVD<FloatMatrix> m_SVD;
+
+	#ifdef CBF_HAVE_EIGEN_3_3
+		Eigen::BDCSVD<FloatMatrix> m_BDCSVD;
+		Eigen::CompleteOrthogonalDecomposition<FloatMatrix> m_COD;
+	#endif
+
+	Eigen::LLT<FloatMatrix> m_LLT;
+	Eigen::ColPivHouseholderQR<FloatMatrix> m_QR;
+	WarmStartedSVD m_WarmStartedSVD;
+
+	//! The inverted singular values
+	FloatVector m_InverseSingularValues;
+
+	//! Holds V * diag(inverted singular values)
+	FloatMatrix m_ScaledV;
+
+	//! Holds m m^T + damping for the DampedLeastSquaresSolver
+	FloatMatrix m_Gram;
+
+	//! Intermediate results of the non SVD solvers
+	FloatMatrix m_Scratch;
+
+	//! For applying the Householder reflections of the QRSolver without a temporary
+	FloatVector m_HouseholderWorkspace;
+
+	//! Number of singular values (or pivots for the non SVD solvers) above pseudo_inverse_rank_threshold
+	unsigned int m_Rank;
+
+	//! Whether the last call computed a SVD, i.e. whether the accessors below are valid
+	bool has_svd() const { 
+		return m_Solver == JacobiSVDSolver || m_Solver == BDCSVDSolver || m_Solver == WarmStartedSVDSolver; 
+	}
+
+	const FloatVector &singular_values() const { 
+		if (m_Solver == WarmStartedSVDSolver) return m_WarmStartedSVD.singularValues();
+		#ifdef CBF_HAVE_EIGEN_3_3
+			if (m_Solver == BDCSVDSolver) return m_BDCSVD.singularValues();
+		#endif
+		return m_SVD.singularValues(); 
+	}
+
+	const FloatMatrix &matrix_u() const { 
+		if (m_Solver == WarmStartedSVDSolver) return m_WarmStartedSVD.matrixU();
+		#ifdef CBF_HAVE_EIGEN_3_3
+			if (m_Solver == BDCSVDSolver) return m_BDCSVD.matrixU();
+		#endif
+		return m_SVD.matrixU(); 
+	}
+
+	const FloatMatrix &matrix_v() const { 
+		if (m_Solver == WarmStartedSVDSolver) return m_WarmStartedSVD.matrixV();
+		#ifdef CBF_HAVE_EIGEN_3_3
+			if (m_Solver == BDCSVDSolver) return m_BDCSVD.matrixV();
+		#endif
+		return m_SVD.matrixV(); 
+	}
+
+	const FloatVector &inverse_singular_values() const { return m_InverseSingularValues; }
+	unsigned int rank() const { return m_Rank; }
+
+	/**
+		@brief The product of the singular values, i.e. sqrt(det(m m^T))
+		for a matrix with more columns than rows (Yoshikawa's measure
+		when m is a task jacobian)
+	*/
+	Float manipulability() const { return singular_values().prod(); }
+};
+
+//! Singular values below this are treated as zero by pseudo_inverse() and PseudoInverseWorkspace::rank()
+const Float pseudo_inverse_rank_threshold = 0.001;
+
 //! Calculate pseudo inverse of matrix m writing result. m must have more columns than rows.
 Float pseudo_inverse(const FloatMatrix &m, FloatMatrix &result);
+Float pseudo_inverse(const FloatMatrix &m, FloatMatrix &result, PseudoInverseWorkspace &workspace);
 Float damped_pseudo_inverse(const FloatMatrix &m, FloatMatrix &result, Float damping_constant = 0.001);
+Float damped_pseudo_inverse(const FloatMatrix &m, FloatMatrix &result, PseudoInverseWorkspace &workspace, Float damping_constant = 0.001);
 Float threshold_pseudo_inverse(const FloatMatrix &m, FloatMatrix &result, const Float threshold);
+Float threshold_pseudo_inverse(const FloatMatrix &m, FloatMatrix &result, PseudoInverseWorkspace &workspace, const Float threshold);
 
 /** 
 	A function to create a CBF::FloatMatrix from a KDL::Jacobian. The argument m is
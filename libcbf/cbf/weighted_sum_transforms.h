@@ -70,16 +70,24 @@ struct WeightedSumSensorTransform : public SensorTransform {
 		assert(m_Transforms.size() == m_Weights.size());
 
 		for (unsigned int i = 0; i < m_Transforms.size(); ++i) {
-			m_Transforms[i]->update(resource_value);
+			m_Transforms[i]->update_if_changed(resource_value, m_UpdateVersion);
 		}
 
-		m_TaskJacobian = FloatMatrix::Zero(m_Transforms[0]->task_dim(), m_Transforms[0]->resource_dim());
 		m_Result = FloatVector::Zero(m_Transforms[0]->task_dim());
 
 		for (unsigned int i = 0; i < m_Transforms.size(); ++i) {
-			m_TaskJacobian += m_Weights[i] * m_Transforms[i]->task_jacobian();
 			m_Result += m_Weights[i] * m_Transforms[i]->result();
 		}
+
+		defer_jacobian(resource_value);
+	}
+
+	void update_jacobian(const FloatVector &resource_value) {
+		m_TaskJacobian = FloatMatrix::Zero(m_Transforms[0]->task_dim(), m_Transforms[0]->resource_dim());
+
+		for (unsigned int i = 0; i < m_Transforms.size(); ++i) {
+			m_TaskJacobian += m_Weights[i] * m_Transforms[i]->task_jacobian();
+		}
 	}
 
 	// As both sensor transforms are required to have the same resource dimensionality, it does not matter
@@ -23,15 +23,14 @@
 
 #include <cbf/config.h>
 
-#include <cbf/reference.h>
+#include <cbf/reference_channel.h>
 #include <cbf/types.h>
 #include <cbf/exceptions.h>
 #include <cbf/debug_macros.h>
 #include <cbf/namespace.h>
 
 
-#include <IceUtil/Monitor.h> 
-#include <IceUtil/RecMutex.h>
+#include <boost/thread/mutex.hpp>
 
 #include <string>
 #include <memory>
@@ -52,9 +51,11 @@ namespace CBF {
 	XCFMemory. This can be used to set the reference of a controller.
 
 	The Reference listens for an XCFMemoryReferenceVector with the specified
-	ReferenceName on the MemoryServer referenced by the URL.
+	ReferenceName on the MemoryServer referenced by the URL. The documents
+	are parsed in the XCFMemory thread and handed to the control thread
+	through the ChannelReference's channel, so update() never waits for it.
 */
-struct XCFMemoryReference : public Reference {
+struct XCFMemoryReference : public ChannelReference {
 
 	/**
 		@brief Creates an XCFMemoryReference from an xml-instance.
@@ -79,16 +80,6 @@ struct XCFMemoryReference : public Reference {
 							 const std::string &reference_name, 
 							 unsigned int dim = 1);
 
-	/** 
-		@brief update is a noop in this case as updates are handled asynchronously 
-	*/
-	virtual void update();
-
-	/**
-		@brief Returns the dimension of the reference.
-	*/
-	virtual unsigned int dim() { return m_Dim; }
-
 	/**
 		@brief Sets the reference. Expects a memory::interface::Event, that holds an
 		XCFMemoryReferenceVector-document.
@@ -97,17 +88,11 @@ struct XCFMemoryReference : public Reference {
 
 	protected:
 
-	/** 
-		@brief This member is used as a protected resource to transfer the
-		reference values from the XCFMemory thread to the thread of
-		the main.
-	*/
-	FloatVector m_TempReference;
-
 	/**
-		@brief The mutex-lock that is used for the thread syncronization.
+		@brief Serializes the XCFMemory callbacks, which publish into the
+		channel. The control thread never takes it.
 	*/
-	IceUtil::Monitor<IceUtil::RecMutex> m_ReferenceMonitor;
+	boost::mutex m_EventMutex;
 	
 	/**
 		@brief: The pointer to the XCFMemory server.
@@ -119,11 +104,6 @@ struct XCFMemoryReference : public Reference {
 	*/
 	std::string m_ReferenceName;
 
-	/**
-		@brief The dimension of the Reference
-	*/
-	unsigned int m_Dim;
-
 	/**
 		@brief Utility function for the constructor.
 	*/
@@ -88,6 +88,7 @@ struct XCFMemoryResource : public Resource {
 	virtual void add(const FloatVector &arg){
 		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_ResourceMonitor);
 		m_Resource -> add(arg);
+		take_on_version();
 	}
 
 	/**
@@ -105,6 +106,16 @@ struct XCFMemoryResource : public Resource {
 		*/
 		void init();
 
+		/**
+			@brief Changes our version when the wrapped resource's changed,
+			like MaskingResource. To be called with m_ResourceMonitor locked.
+		*/
+		void take_on_version() {
+			if (m_Resource -> version() == 0 || m_Resource -> version() != m_WrappedVersion)
+				bump_version();
+			m_WrappedVersion = m_Resource -> version();
+		}
+
 
 		/**
 			@brief This function will be called by the active_memory. It reads the vector from
@@ -162,6 +173,11 @@ struct XCFMemoryResource : public Resource {
 		*/
 		ResourcePtr m_Resource;
 
+		/**
+			@brief: The version of m_Resource our version was taken on for.
+		*/
+		unsigned long m_WrappedVersion;
+
 
 		/**
 			@brief: Points to the 'Vector' element of 
@@ -1,7 +1,7 @@
 #ifndef CBF_XCF_VECTOR_REFERENCE_HH
 #define CBF_XCF_VECTOR_REFERENCE_HH
 
-#include <cbf/reference.h>
+#include <cbf/reference_channel.h>
 #include <cbf/types.h>
 #include <cbf/exceptions.h>
 #include <cbf/debug_macros.h>
@@ -11,10 +11,9 @@
 
 
 #include <xcf/ServerComponent.hpp>
-#include <IceUtil/Monitor.h> 
-#include <IceUtil/RecMutex.h>
 
 #include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <string>
 #include <memory>
@@ -33,22 +32,27 @@ namespace CBF {
 
 	See the test examples test/cbf_test_xcf_vector_resource_client.cc
 	to see how to remotely call this method
+
+	The values go from the XCF server thread to the control thread and
+	back through channels, so update() never waits for the server.
 */
-struct XCFVectorReference : public Reference {
+struct XCFVectorReference : public ChannelReference {
 	XCFVectorReference(const CBFSchema::XCFVectorReference &xml_instance, ObjectNamespacePtr object_namespace);
 
 	XCF::ServerPtr m_XCFServer;
-	unsigned int m_Dim;
 
-	/** 
-		This member is used as a protected resource to transfer the
-		reference values from the XCF server thread to the thread of
-		the main
+	/**
+		The current reference, published by update() for
+		get_current_task_position_xcf()
 	*/
-	FloatVector m_TempReference;
-	FloatVector m_CurrentReferencePosition;
+	ReferenceChannel m_CurrentReferenceChannel;
 
-	IceUtil::Monitor<IceUtil::RecMutex> m_ReferenceMonitor;
+	/**
+		Serializes the methods called by the XCF server, which are the
+		producer of the reference channel and the consumer of
+		m_CurrentReferenceChannel. The control thread never takes it.
+	*/
+	boost::mutex m_CallMutex;
 
 	/**
 		Creates an XCFReference registering the server named server_name
@@ -59,8 +63,9 @@ struct XCFVectorReference : public Reference {
 	XCFVectorReference
 		(const std::string &server_name, unsigned int dim = 1) 
 		: 
+		ChannelReference(dim),
 		m_XCFServer(XCF::Server::create(server_name)), 
-		m_Dim(dim)
+		m_CurrentReferenceChannel(dim)
 	{ 	
 		init();
 	}
@@ -101,27 +106,25 @@ struct XCFVectorReference : public Reference {
 		m_XCFServer->run(true);
 	}
 
-	/** update is a noop in this case as updates are handled asynchronously */
+	/** Takes the latest value set over the network, without waiting for the server */
 	virtual void update()  {
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_ReferenceMonitor); 
-		if (m_TempReference.size() == m_Dim) {
-			m_References.resize(1);
-			m_References[0] = m_TempReference;
-		}
-		if(m_References.size()>0){
+		const unsigned long version = m_Version;
+		ChannelReference::update();
+		if (m_Version != version && m_HasReference) {
 			CBF_DEBUG("saving current task poisition");
-			m_CurrentReferencePosition = m_References[0];
+			m_CurrentReferenceChannel.publish(m_References[0]);
 		}
 	}
 
-	virtual unsigned int dim() { return m_Dim; }
-
 	virtual void get_current_task_position_xcf(std::string &xml_in, std::string &xml_out) {
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_ReferenceMonitor); 
-		
+		boost::mutex::scoped_lock lock(m_CallMutex);
+		m_CurrentReferenceChannel.fetch();
+
 		std::stringstream vector_string;
 
-		vector_string << m_CurrentReferencePosition;
+		//! Empty until there was a reference, as before
+		if (m_CurrentReferenceChannel.valid())
+			vector_string << m_CurrentReferenceChannel.value();
 
 		CBFSchema::EigenVector v(vector_string.str());
 
@@ -153,7 +156,7 @@ struct XCFVectorReference : public Reference {
 	*/
 	virtual void set_reference_from_xcf(std::string &xml_in, std::string &xml_out) {
 		CBF_DEBUG("in");
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_ReferenceMonitor); 
+		boost::mutex::scoped_lock lock(m_CallMutex);
 		CBF_DEBUG("locked");
 		CBF_DEBUG("doc: " << xml_in);
 		std::istringstream s(xml_in);
@@ -161,16 +164,18 @@ struct XCFVectorReference : public Reference {
 		std::auto_ptr<CBFSchema::Vector> v = CBFSchema::Vector_(s, xml_schema::flags::dont_validate);
 
 		CBF_DEBUG("create vector");
-		m_TempReference = *XMLFactory<FloatVector>::instance()->create(
+		const FloatVector vector = *XMLFactory<FloatVector>::instance()->create(
 			*v, ObjectNamespacePtr(new ObjectNamespace)
 		);
 
 		CBF_DEBUG("vector created");
-		if (m_TempReference.size() != dim()) {
+		if (vector.size() != dim()) {
 			CBF_DEBUG("meeeh!!!");
 			CBF_THROW_RUNTIME_ERROR("Dimensions of xml vector not matching the dimension of this reference");
 		}
 
+		publish(vector);
+
 		CBF_DEBUG("out");
 	}
 };
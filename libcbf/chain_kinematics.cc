@@ -0,0 +1,512 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#include <cbf/chain_kinematics.h>
+#include <cbf/debug_macros.h>
+#include <cbf/exceptions.h>
+#include <cbf/utilities.h>
+#include <cbf/xml_object_factory.h>
+
+#ifdef CBF_HAVE_KDL
+	#include <kdl/chain.hpp>
+	#include <kdl/segment.hpp>
+	#include <kdl/joint.hpp>
+	#include <kdl/frames.hpp>
+#endif
+
+#include <Eigen/Geometry>
+
+#include <cmath>
+
+namespace CBF {
+
+	namespace {
+		//! [v]x, i.e. cross_matrix(v) * w == v.cross(w)
+		inline Matrix3 cross_matrix(const Vector3 &v) {
+			Matrix3 m;
+			m << 0, -v[2], v[1],
+			     v[2], 0, -v[0],
+			     -v[1], v[0], 0;
+			return m;
+		}
+
+		const Float axis_epsilon = 1e-12;
+
+		#ifdef CBF_HAVE_KDL
+			/**
+				Whether add_segment() with these arguments moves like the KDL
+				segment at joint value q. It does not for joints KDL scales.
+			*/
+			bool same_pose(
+				const KDL::Segment &segment,
+				ChainKinematics::JointType type,
+				const Vector3 &axis,
+				const Vector3 &joint_origin,
+				const Matrix3 &tip_rotation,
+				const Vector3 &tip_translation,
+				Float q
+			) {
+				Matrix3 rotation = Matrix3::Identity();
+				Vector3 translation = joint_origin;
+				if (type == ChainKinematics::RotationalJoint)
+					rotation = Eigen::AngleAxis<Float>(q, axis.normalized()).toRotationMatrix();
+				if (type == ChainKinematics::TranslationalJoint)
+					translation += q * axis.normalized();
+
+				const KDL::Frame expected = segment.pose(q);
+				const Vector3 position = translation + rotation * tip_translation;
+				const Matrix3 orientation = rotation * tip_rotation;
+
+				const Float epsilon = 1e-9;
+				for (unsigned int row = 0; row < 3; ++row) {
+					if (std::fabs(position[row] - expected.p[row]) > epsilon * (1 + position.norm()))
+						return false;
+					for (unsigned int col = 0; col < 3; ++col)
+						if (std::fabs(orientation(row, col) - expected.M(row, col)) > epsilon)
+							return false;
+				}
+
+				return true;
+			}
+		#endif
+	}
+
+	ChainKinematics::ChainKinematics() :
+		Object("ChainKinematics")
+	{
+		init();
+	}
+
+	void ChainKinematics::init() {
+		//! The base link, leading to the first joint
+		m_LinkRotations = Matrix3::Identity();
+		m_LinkTranslations = Vector3::Zero();
+		m_Axes.resize(3, 0);
+		m_JointTypes.clear();
+		m_AxisIndices.clear();
+
+		m_JointAxes.resize(3, 0);
+		m_JointOrigins.resize(3, 0);
+		m_Rotation.setIdentity();
+		m_Position.setZero();
+		m_Jacobian = FloatMatrix::Zero(6, 0);
+		m_ResourceValue = FloatVector::Zero(0);
+		m_Computed = false;
+		m_JacobianComputed = false;
+		m_Computations = 0;
+		m_JacobianComputations = 0;
+	}
+
+	void ChainKinematics::add_segment(
+		JointType type,
+		const Vector3 &axis,
+		const Vector3 &joint_origin,
+		const Matrix3 &tip_rotation,
+		const Vector3 &tip_translation
+	) {
+		boost::mutex::scoped_lock lock(m_Mutex);
+
+		const unsigned int joints = m_JointTypes.size();
+
+		//! The last link leads to the joint origin..
+		m_LinkTranslations.col(joints) += m_LinkRotations.middleCols<3>(3 * joints) * joint_origin;
+
+		if (type != FixedJoint) {
+			if (axis.norm() < axis_epsilon)
+				CBF_THROW_RUNTIME_ERROR("Joint without axis");
+
+			m_JointTypes.push_back(type);
+
+			m_Axes.conservativeResize(3, joints + 1);
+			m_Axes.col(joints) = axis.normalized();
+
+			int axis_index = -1;
+			for (unsigned int i = 0; i < 3; ++i)
+				if (m_Axes.col(joints) == Vector3::Unit(i)) axis_index = i;
+			m_AxisIndices.push_back(axis_index);
+
+			//! ..and a new link starts at the moving frame of the joint
+			m_LinkRotations.conservativeResize(3, 3 * (joints + 2));
+			m_LinkRotations.middleCols<3>(3 * (joints + 1)) = Matrix3::Identity();
+			m_LinkTranslations.conservativeResize(3, joints + 2);
+			m_LinkTranslations.col(joints + 1) = Vector3::Zero();
+		}
+
+		//! The tip is appended to the last link
+		const unsigned int link = m_JointTypes.size();
+		m_LinkTranslations.col(link) += m_LinkRotations.middleCols<3>(3 * link) * tip_translation;
+		m_LinkRotations.middleCols<3>(3 * link) = m_LinkRotations.middleCols<3>(3 * link) * tip_rotation;
+
+		m_JointAxes.resize(3, resource_dim());
+		m_JointOrigins.resize(3, resource_dim());
+		m_Jacobian = FloatMatrix::Zero(6, resource_dim());
+		m_ResourceValue = FloatVector::Zero(resource_dim());
+		m_Computed = false;
+		m_JacobianComputed = false;
+	}
+
+	void ChainKinematics::update(const FloatVector &resource_value) {
+		boost::mutex::scoped_lock lock(m_Mutex);
+
+		if (m_Computed && resource_value == m_ResourceValue)
+			return;
+
+		update_frames(resource_value);
+	}
+
+	void ChainKinematics::update_jacobian(const FloatVector &resource_value) {
+		boost::mutex::scoped_lock lock(m_Mutex);
+
+		if (!m_Computed || resource_value != m_ResourceValue)
+			update_frames(resource_value);
+
+		if (m_JacobianComputed)
+			return;
+
+		//! The joint axes and origins are left over from update_frames()
+		for (unsigned int i = 0; i < m_JointTypes.size(); ++i) {
+			if (m_JointTypes[i] == TranslationalJoint) {
+				m_Jacobian.block<3, 1>(0, i) = m_JointAxes.col(i);
+				m_Jacobian.block<3, 1>(3, i).setZero();
+			} else {
+				m_Jacobian.block<3, 1>(0, i) = m_JointAxes.col(i).cross(m_Position - m_JointOrigins.col(i));
+				m_Jacobian.block<3, 1>(3, i) = m_JointAxes.col(i);
+			}
+		}
+
+		m_JacobianComputed = true;
+		++m_JacobianComputations;
+	}
+
+	void ChainKinematics::update_frames(const FloatVector &resource_value) {
+		m_ResourceValue = resource_value;
+
+		const unsigned int joints = m_JointTypes.size();
+
+		Matrix3 rotation = m_LinkRotations.leftCols<3>();
+		Vector3 position = m_LinkTranslations.col(0);
+
+		for (unsigned int i = 0; i < joints; ++i) {
+			const Float q = resource_value[i];
+			const int axis_index = m_AxisIndices[i];
+
+			//! The joint axis in the base frame
+			const Vector3 axis = (axis_index == -1) ? Vector3(rotation * m_Axes.col(i)) : Vector3(rotation.col(axis_index));
+
+			m_JointAxes.col(i) = axis;
+			m_JointOrigins.col(i) = position;
+
+			if (m_JointTypes[i] == TranslationalJoint) {
+				position += q * axis;
+			} else {
+				const Float c = std::cos(q);
+				const Float s = std::sin(q);
+
+				if (axis_index != -1) {
+					//! Rotating about a coordinate axis only mixes the other two columns
+					const int j = (axis_index + 1) % 3;
+					const int k = (axis_index + 2) % 3;
+					const Vector3 column_j = rotation.col(j);
+					rotation.col(j) = c * column_j + s * rotation.col(k);
+					rotation.col(k) = c * rotation.col(k) - s * column_j;
+				} else {
+					//! rotation * Rot(a, q) with z = rotation * a is
+					//! c * rotation + (1 - c) * z * a^T + s * [z]x * rotation
+					rotation =
+						c * rotation
+						+ (1 - c) * axis * m_Axes.col(i).transpose()
+						+ s * cross_matrix(axis) * rotation;
+				}
+			}
+
+			position += rotation * m_LinkTranslations.col(i + 1);
+			rotation = rotation * m_LinkRotations.middleCols<3>(3 * (i + 1));
+		}
+
+		m_Rotation = rotation;
+		m_Position = position;
+
+		m_Computed = true;
+		m_JacobianComputed = false;
+		++m_Computations;
+	}
+
+	Vector3 ChainKinematics::axis_angle() const {
+		//! The same as KDL::Rotation::GetRot()
+		const Matrix3 &m = m_Rotation;
+		const Float cos_angle = (m.trace() - 1) / 2.0;
+		const Float epsilon = 1e-6;
+
+		if (cos_angle > 1 - epsilon * epsilon / 2)
+			return Vector3::Zero();
+
+		if (cos_angle < -1 + epsilon * epsilon / 2) {
+			//! 180 degrees, the axis is read from the diagonal
+			Float x = std::sqrt((m(0, 0) + 1.0) / 2);
+			Float y = std::sqrt((m(1, 1) + 1.0) / 2);
+			Float z = std::sqrt((m(2, 2) + 1.0) / 2);
+			if (m(0, 2) < 0) x = -x;
+			if (m(2, 1) < 0) y = -y;
+			if (x * y * m(0, 1) < 0) x = -x;
+			return M_PI * Vector3(x, y, z);
+		}
+
+		const Vector3 axis(m(2, 1) - m(1, 2), m(0, 2) - m(2, 0), m(1, 0) - m(0, 1));
+		const Float norm = axis.norm();
+		return std::atan2(norm / 2, cos_angle) / norm * axis;
+	}
+
+	#ifdef CBF_HAVE_KDL
+		ChainKinematics::ChainKinematics(const KDL::Chain &chain) :
+			Object("ChainKinematics")
+		{
+			init();
+			add_chain(chain);
+		}
+
+		void ChainKinematics::add_chain(const KDL::Chain &chain) {
+			for (unsigned int i = 0; i < chain.getNrOfSegments(); ++i) {
+				const KDL::Segment &segment = chain.getSegment(i);
+				const KDL::Joint &joint = segment.getJoint();
+
+				JointType type = FixedJoint;
+				switch (joint.getType()) {
+					case KDL::Joint::None:
+						break;
+					case KDL::Joint::TransAxis:
+					case KDL::Joint::TransX:
+					case KDL::Joint::TransY:
+					case KDL::Joint::TransZ:
+						type = TranslationalJoint;
+						break;
+					default:
+						type = RotationalJoint;
+				}
+
+				const KDL::Vector axis = joint.JointAxis();
+				const KDL::Vector origin = joint.JointOrigin();
+
+				//! KDL keeps the tip frame to itself, the joint's pose at 0 (its offset) goes into ours
+				const KDL::Frame tip = KDL::Frame(-origin) * segment.pose(0);
+
+				Matrix3 tip_rotation;
+				for (unsigned int row = 0; row < 3; ++row)
+					for (unsigned int col = 0; col < 3; ++col)
+						tip_rotation(row, col) = tip.M(row, col);
+
+				const Vector3 native_axis = (type == FixedJoint) ? Vector3::UnitZ() : Vector3(axis.x(), axis.y(), axis.z());
+				const Vector3 joint_origin(origin.x(), origin.y(), origin.z());
+				const Vector3 tip_translation(tip.p.x(), tip.p.y(), tip.p.z());
+
+				//! KDL hides a joint's scale, so check how the segment moves
+				if (
+					!same_pose(segment, type, native_axis, joint_origin, tip_rotation, tip_translation, 1) ||
+					!same_pose(segment, type, native_axis, joint_origin, tip_rotation, tip_translation, -1)
+				) {
+					CBF_THROW_RUNTIME_ERROR(
+						"Segment " << i << " (" << segment.getName() << ") does not move like a unit joint, "
+						"joints with a scale are not supported by ChainKinematics"
+					);
+				}
+
+				add_segment(type, native_axis, joint_origin, tip_rotation, tip_translation);
+			}
+		}
+	#endif
+
+
+	BaseChainSensorTransform::BaseChainSensorTransform(ChainKinematicsPtr kinematics) :
+		m_Kinematics(kinematics)
+	{
+
+	}
+
+	void BaseChainSensorTransform::update_batch(
+		const FloatMatrix &resource_values, 
+		FloatMatrix &results, 
+		FloatMatrix &task_jacobians
+	) {
+		const unsigned int dim = resource_dim();
+		results.resize(task_dim(), resource_values.cols());
+		task_jacobians.resize(task_dim(), resource_values.cols() * dim);
+
+		FloatVector resource_value(dim);
+		for (unsigned int i = 0; i < resource_values.cols(); ++i) {
+			resource_value = resource_values.col(i);
+			m_Kinematics->update(resource_value);
+			m_Kinematics->update_jacobian(resource_value);
+			store_batch_column(i, results, task_jacobians);
+		}
+	}
+
+
+	ChainPositionSensorTransform::ChainPositionSensorTransform(ChainKinematicsPtr kinematics) :
+		BaseChainSensorTransform(kinematics)
+	{
+		m_Result = FloatVector::Zero(task_dim());
+		m_TaskJacobian = FloatMatrix::Zero(task_dim(), resource_dim());
+	}
+
+	void ChainPositionSensorTransform::update(const FloatVector &resource_value) {
+		m_Kinematics->update(resource_value);
+		m_Result = m_Kinematics->position();
+
+		defer_jacobian(resource_value);
+	}
+
+	void ChainPositionSensorTransform::update_jacobian(const FloatVector &resource_value) {
+		m_Kinematics->update_jacobian(resource_value);
+		m_TaskJacobian = m_Kinematics->jacobian().topRows<3>();
+	}
+
+	void ChainPositionSensorTransform::store_batch_column(unsigned int i, FloatMatrix &results, FloatMatrix &task_jacobians) {
+		results.col(i) = m_Kinematics->position();
+		task_jacobians.middleCols(i * resource_dim(), resource_dim()) = m_Kinematics->jacobian().topRows<3>();
+	}
+
+
+	ChainAxisAngleSensorTransform::ChainAxisAngleSensorTransform(ChainKinematicsPtr kinematics) :
+		BaseChainSensorTransform(kinematics)
+	{
+		m_Result = FloatVector::Zero(task_dim());
+		m_TaskJacobian = FloatMatrix::Zero(task_dim(), resource_dim());
+	}
+
+	void ChainAxisAngleSensorTransform::update(const FloatVector &resource_value) {
+		m_Kinematics->update(resource_value);
+		m_Result = m_Kinematics->axis_angle();
+
+		defer_jacobian(resource_value);
+	}
+
+	void ChainAxisAngleSensorTransform::update_jacobian(const FloatVector &resource_value) {
+		m_Kinematics->update_jacobian(resource_value);
+		m_TaskJacobian = m_Kinematics->jacobian().bottomRows<3>();
+	}
+
+	void ChainAxisAngleSensorTransform::store_batch_column(unsigned int i, FloatMatrix &results, FloatMatrix &task_jacobians) {
+		results.col(i) = m_Kinematics->axis_angle();
+		task_jacobians.middleCols(i * resource_dim(), resource_dim()) = m_Kinematics->jacobian().bottomRows<3>();
+	}
+
+
+	ChainPoseSensorTransform::ChainPoseSensorTransform(ChainKinematicsPtr kinematics) :
+		BaseChainSensorTransform(kinematics)
+	{
+		m_Result = FloatVector::Zero(task_dim());
+		m_TaskJacobian = FloatMatrix::Zero(task_dim(), resource_dim());
+	}
+
+	void ChainPoseSensorTransform::update(const FloatVector &resource_value) {
+		m_Kinematics->update(resource_value);
+		m_Result.head<3>() = m_Kinematics->position();
+		m_Result.tail<3>() = m_Kinematics->axis_angle();
+
+		defer_jacobian(resource_value);
+	}
+
+	void ChainPoseSensorTransform::update_jacobian(const FloatVector &resource_value) {
+		m_Kinematics->update_jacobian(resource_value);
+		m_TaskJacobian = m_Kinematics->jacobian();
+	}
+
+	void ChainPoseSensorTransform::store_batch_column(unsigned int i, FloatMatrix &results, FloatMatrix &task_jacobians) {
+		results.block<3, 1>(0, i) = m_Kinematics->position();
+		results.block<3, 1>(3, i) = m_Kinematics->axis_angle();
+		task_jacobians.middleCols(i * resource_dim(), resource_dim()) = m_Kinematics->jacobian();
+	}
+
+
+	#if defined(CBF_HAVE_XSD) && defined(CBF_HAVE_KDL)
+		ChainKinematics::ChainKinematics(const CBFSchema::ChainKinematics &xml_instance, ObjectNamespacePtr object_namespace) :
+			Object(xml_instance, object_namespace)
+		{
+			init();
+			add_chain(*create_chain(xml_instance.Chain(), object_namespace));
+		}
+
+		BaseChainSensorTransform::BaseChainSensorTransform(
+			ChainKinematicsPtr kinematics,
+			const CBFSchema::SensorTransform &xml_instance,
+			ObjectNamespacePtr object_namespace
+		) :
+			SensorTransform(xml_instance, object_namespace),
+			m_Kinematics(kinematics)
+		{
+
+		}
+
+		/**
+			Either the (possibly referenced) Kinematics given in the transform
+			or one of its own over the given Chain
+		*/
+		template<class TransformType>
+		ChainKinematicsPtr create_native_chain_kinematics(const TransformType &xml_instance, ObjectNamespacePtr object_namespace) {
+			if (xml_instance.Kinematics().present())
+				return XMLObjectFactory::instance()->create<ChainKinematics>(*xml_instance.Kinematics(), object_namespace);
+
+			if (!xml_instance.Chain().present())
+				CBF_THROW_RUNTIME_ERROR("Neither Chain nor Kinematics given");
+
+			return ChainKinematicsPtr(new ChainKinematics(*create_chain(*xml_instance.Chain(), object_namespace)));
+		}
+
+		ChainPositionSensorTransform::ChainPositionSensorTransform(const CBFSchema::ChainPositionSensorTransform &xml_instance, ObjectNamespacePtr object_namespace) :
+			BaseChainSensorTransform(create_native_chain_kinematics(xml_instance, object_namespace), xml_instance, object_namespace)
+		{
+			m_Result = FloatVector::Zero(task_dim());
+			m_TaskJacobian = FloatMatrix::Zero(task_dim(), resource_dim());
+		}
+
+		ChainAxisAngleSensorTransform::ChainAxisAngleSensorTransform(const CBFSchema::ChainAxisAngleSensorTransform &xml_instance, ObjectNamespacePtr object_namespace) :
+			BaseChainSensorTransform(create_native_chain_kinematics(xml_instance, object_namespace), xml_instance, object_namespace)
+		{
+			m_Result = FloatVector::Zero(task_dim());
+			m_TaskJacobian = FloatMatrix::Zero(task_dim(), resource_dim());
+		}
+
+		ChainPoseSensorTransform::ChainPoseSensorTransform(const CBFSchema::ChainPoseSensorTransform &xml_instance, ObjectNamespacePtr object_namespace) :
+			BaseChainSensorTransform(create_native_chain_kinematics(xml_instance, object_namespace), xml_instance, object_namespace)
+		{
+			m_Result = FloatVector::Zero(task_dim());
+			m_TaskJacobian = FloatMatrix::Zero(task_dim(), resource_dim());
+		}
+
+		static XMLDerivedFactory<
+			ChainKinematics,
+			CBFSchema::ChainKinematics
+		> x1;
+
+		static XMLDerivedFactory<
+			ChainPositionSensorTransform,
+			CBFSchema::ChainPositionSensorTransform
+		> x2;
+
+		static XMLDerivedFactory<
+			ChainAxisAngleSensorTransform,
+			CBFSchema::ChainAxisAngleSensorTransform
+		> x3;
+
+		static XMLDerivedFactory<
+			ChainPoseSensorTransform,
+			CBFSchema::ChainPoseSensorTransform
+		> x4;
+	#endif
+
+} // namespace
@@ -31,35 +31,137 @@ namespace CBF {
 		unsigned int total_resource_dim = m_SensorTransforms[0]->resource_dim();
 
 		unsigned int total_task_dim = 0;
-		for (unsigned int i = 0; i < m_SensorTransforms.size(); ++i)
+		m_TaskOffsets.clear();
+		for (unsigned int i = 0; i < m_SensorTransforms.size(); ++i) {
+			m_TaskOffsets.push_back(total_task_dim);
 			total_task_dim += m_SensorTransforms[i]->task_dim();
+		}
 
 		m_TaskJacobian = FloatMatrix::Zero(total_task_dim, total_resource_dim);
+
+		#ifdef CBF_PROFILING
+			m_CycleTimeHistograms.clear();
+			for (unsigned int i = 0; i < m_SensorTransforms.size(); ++i)
+				m_CycleTimeHistograms.push_back(cycle_time_histogram(m_SensorTransforms[i]->name() + ".update", m_SensorTransforms[i].get()));
+		#endif
+
 		CBF_DEBUG("task_dim " << task_dim());
 		m_Result = FloatVector::Zero(task_dim());
 		CBF_DEBUG("m_Result " << m_Result);
 	}
 
+	struct CompositeSensorTransform::TransformUpdate : public ParallelTask {
+		TransformUpdate(CompositeSensorTransform &composite, const FloatVector &resource_value, bool jacobian) :
+			m_Composite(composite), m_ResourceValue(resource_value), m_Jacobian(jacobian) { }
+
+		virtual void run(unsigned int index) {
+			if (m_Jacobian)
+				m_Composite.update_transform_jacobian(index);
+			else
+				m_Composite.update_transform(index, m_ResourceValue);
+		}
+
+		CompositeSensorTransform &m_Composite;
+		const FloatVector &m_ResourceValue;
+		bool m_Jacobian;
+	};
+
+	void CompositeSensorTransform::update_transform(unsigned int i, const FloatVector &resource_value) {
+		//! Make the subordinate transform update its state..
+		{
+			CBF_PROFILE_SCOPE(m_CycleTimeHistograms[i]);
+			m_SensorTransforms[i]->update_if_changed(resource_value, m_UpdateVersion);
+		}
+
+		//! ..and copy its part of the total result. The blocks of the 
+		//! transforms are disjoint, so they can do this concurrently
+		const FloatVector &result = m_SensorTransforms[i]->result();
+		CBF_DEBUG("range: " << m_TaskOffsets[i] << " " << m_TaskOffsets[i] + result.size());
+
+		m_Result.segment(m_TaskOffsets[i], result.size()) = result;
+	}
+
+	void CompositeSensorTransform::update_transform_jacobian(unsigned int i) {
+		const FloatMatrix &task_jacobian = m_SensorTransforms[i]->task_jacobian();
+		m_TaskJacobian.middleRows(m_TaskOffsets[i], task_jacobian.rows()) = task_jacobian;
+	}
+
 	void CompositeSensorTransform::update(const FloatVector &resource_value) {
-		unsigned int current_task_pos = 0;
-		for (unsigned int i = 0; i < m_SensorTransforms.size(); ++i) {
-			//! Make all subordinate transforms update their state..
-			m_SensorTransforms[i]->update(resource_value);
-	
-			//! Assemble total jacobian..
-			CBF_DEBUG("range: " << current_task_pos << " "
-					<< current_task_pos + m_SensorTransforms[i]->task_jacobian().rows());
+		if (m_ThreadPool.get() != 0) {
+			TransformUpdate task(*this, resource_value, false);
+			m_ThreadPool->run(task, m_SensorTransforms.size());
+		} else {
+			for (unsigned int i = 0; i < m_SensorTransforms.size(); ++i)
+				update_transform(i, resource_value);
+		}
 
-			m_TaskJacobian.block(current_task_pos, 0,
-					m_SensorTransforms[i] -> task_jacobian().rows(), resource_dim())
-					= m_SensorTransforms[i] -> task_jacobian();
+		defer_jacobian(resource_value);
+	}
 
-			m_Result.segment(current_task_pos,
-					m_SensorTransforms[i]->task_jacobian().rows()) = m_SensorTransforms[i]->result();
-	
-			current_task_pos += m_SensorTransforms[i]->task_jacobian().rows();
+	void CompositeSensorTransform::update_jacobian(const FloatVector &resource_value) {
+		//! The transforms' lazy jacobians get computed in parallel, too
+		if (m_ThreadPool.get() != 0) {
+			TransformUpdate task(*this, resource_value, true);
+			m_ThreadPool->run(task, m_SensorTransforms.size());
+		} else {
+			for (unsigned int i = 0; i < m_SensorTransforms.size(); ++i)
+				update_transform_jacobian(i);
 		}
+	}
 	
+	struct CompositeSensorTransform::TransformBatchUpdate : public ParallelTask {
+		TransformBatchUpdate(
+			CompositeSensorTransform &composite, 
+			const FloatMatrix &resource_values, 
+			FloatMatrix &results, 
+			FloatMatrix &task_jacobians
+		) :
+			m_Composite(composite), 
+			m_ResourceValues(resource_values), 
+			m_Results(results), 
+			m_TaskJacobians(task_jacobians),
+			m_TransformResults(composite.m_SensorTransforms.size()),
+			m_TransformTaskJacobians(composite.m_SensorTransforms.size())
+		{ }
+
+		virtual void run(unsigned int index) {
+			m_Composite.m_SensorTransforms[index]->update_batch(
+				m_ResourceValues, 
+				m_TransformResults[index], 
+				m_TransformTaskJacobians[index]
+			);
+
+			//! The rows of the transforms are disjoint, also in the stacked jacobians
+			const unsigned int offset = m_Composite.m_TaskOffsets[index];
+			const unsigned int rows = m_TransformResults[index].rows();
+			m_Results.middleRows(offset, rows) = m_TransformResults[index];
+			m_TaskJacobians.middleRows(offset, rows) = m_TransformTaskJacobians[index];
+		}
+
+		CompositeSensorTransform &m_Composite;
+		const FloatMatrix &m_ResourceValues;
+		FloatMatrix &m_Results;
+		FloatMatrix &m_TaskJacobians;
+		std::vector<FloatMatrix> m_TransformResults;
+		std::vector<FloatMatrix> m_TransformTaskJacobians;
+	};
+
+	void CompositeSensorTransform::update_batch(
+		const FloatMatrix &resource_values, 
+		FloatMatrix &results, 
+		FloatMatrix &task_jacobians
+	) {
+		results.resize(task_dim(), resource_values.cols());
+		task_jacobians.resize(task_dim(), resource_values.cols() * resource_dim());
+
+		TransformBatchUpdate task(*this, resource_values, results, task_jacobians);
+
+		if (m_ThreadPool.get() != 0) {
+			m_ThreadPool->run(task, m_SensorTransforms.size());
+		} else {
+			for (unsigned int i = 0; i < m_SensorTransforms.size(); ++i)
+				task.run(i);
+		}
 	}
 	
 	#ifdef CBF_HAVE_XSD
@@ -83,6 +185,9 @@ namespace CBF {
 			}
 		
 			set_transforms(transforms);
+
+			if (xml_instance.Threads().present() && *xml_instance.Threads() > 1)
+				m_ThreadPool = ThreadPoolPtr(new ThreadPool(*xml_instance.Threads() - 1));
 		}
 		
 		static XMLDerivedFactory<CompositeSensorTransform, CBFSchema::CompositeSensorTransform> x;
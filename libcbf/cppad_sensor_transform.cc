@@ -1,3 +1,90 @@
 #include <cbf/cppad_sensor_transform.h>
+#include <cbf/exceptions.h>
 
+namespace CBF {
 
+	CppADSensorTransform::CppADSensorTransform(
+		const CppAD::ADFun<Float> &fun, 
+		unsigned int task_dim, 
+		unsigned int resource_dim,
+		bool sparse
+	) :
+		m_Sparse(sparse),
+		m_Forward(resource_dim <= task_dim)
+	{
+		if (fun.Domain() != resource_dim || fun.Range() != task_dim)
+			CBF_THROW_RUNTIME_ERROR("Function dimensions do not match task_dim and resource_dim");
+
+		m_Func = fun;
+		m_Result = FloatVector::Zero(task_dim);
+		m_TaskJacobian = FloatMatrix::Zero(task_dim, resource_dim);
+		m_Direction = FloatVector::Zero(m_Forward ? resource_dim : task_dim);
+
+		if (!m_Sparse)
+			return;
+
+		m_Func.optimize();
+
+		//! Propagate the identity through the cheaper direction, 
+		//! both give the task_dim x resource_dim pattern
+		const unsigned int q = m_Forward ? resource_dim : task_dim;
+		std::vector<bool> identity(q * q, false);
+		for (unsigned int i = 0; i < q; ++i)
+			identity[i * q + i] = true;
+
+		if (m_Forward)
+			m_Pattern = m_Func.ForSparseJac(q, identity);
+		else
+			m_Pattern = m_Func.RevSparseJac(q, identity);
+
+		for (unsigned int row = 0; row < task_dim; ++row) {
+			for (unsigned int col = 0; col < resource_dim; ++col) {
+				if (m_Pattern[row * resource_dim + col]) {
+					m_Rows.push_back(row);
+					m_Cols.push_back(col);
+				}
+			}
+		}
+
+		m_Values = FloatVector::Zero(m_Rows.size());
+	}
+
+	void CppADSensorTransform::update(const FloatVector &resource_value) {
+		m_Result = m_Func.Forward(0, resource_value);
+		defer_jacobian(resource_value);
+	}
+
+	void CppADSensorTransform::update_jacobian(const FloatVector &resource_value) {
+		if (m_Sparse) {
+			if (m_Rows.empty())
+				return;
+
+			//! Entries outside the pattern stay zero from the constructor
+			if (m_Forward)
+				m_Func.SparseJacobianForward(resource_value, m_Pattern, m_Rows, m_Cols, m_Values, m_Work);
+			else
+				m_Func.SparseJacobianReverse(resource_value, m_Pattern, m_Rows, m_Cols, m_Values, m_Work);
+
+			for (unsigned int i = 0; i < m_Rows.size(); ++i)
+				m_TaskJacobian(m_Rows[i], m_Cols[i]) = m_Values[i];
+
+			return;
+		}
+
+		//! The zero order Taylor coefficients are still those of update()
+		if (m_Forward) {
+			for (unsigned int col = 0; col < m_Direction.size(); ++col) {
+				m_Direction[col] = 1.0;
+				m_TaskJacobian.col(col) = m_Func.Forward(1, m_Direction);
+				m_Direction[col] = 0.0;
+			}
+		} else {
+			for (unsigned int row = 0; row < m_Direction.size(); ++row) {
+				m_Direction[row] = 1.0;
+				m_TaskJacobian.row(row) = m_Func.Reverse(1, m_Direction).transpose();
+				m_Direction[row] = 0.0;
+			}
+		}
+	}
+
+} // namespace
@@ -0,0 +1,192 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#include <cbf/cycle_pacer.h>
+#include <cbf/exceptions.h>
+#include <cbf/debug_macros.h>
+
+#include <algorithm>
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+namespace CBF {
+
+	namespace {
+		void sleep_until(unsigned long long deadline) {
+			timespec t;
+			t.tv_sec = deadline / 1000000000ULL;
+			t.tv_nsec = deadline % 1000000000ULL;
+
+			//! Restarting after a signal is fine with an absolute deadline
+			while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, 0) == EINTR) { }
+		}
+	}
+
+	CyclePacer::CyclePacer(unsigned long long period, OverrunPolicy policy, const std::string &name) :
+		m_PeriodHistogram(cycle_time_histogram(name + ".period", this)),
+		m_JitterHistogram(cycle_time_histogram(name + ".jitter", this)),
+		m_OverrunHistogram(cycle_time_histogram(name + ".overrun", this)),
+		m_Period(period),
+		m_Policy(policy),
+		m_Deadline(0),
+		m_LastWakeUp(0),
+		m_Overruns(0),
+		m_Jitter(0),
+		m_LastPeriod(0),
+		m_MaxPeriod(0),
+		m_MaxJitter(0),
+		m_MaxOverrun(0)
+	{
+		if (period == 0)
+			CBF_THROW_RUNTIME_ERROR("The period has to be positive");
+	}
+
+	void CyclePacer::start() {
+		m_LastWakeUp = cycle_time_now();
+		m_Deadline = m_LastWakeUp + m_Period;
+		m_Overruns = 0;
+		m_Jitter = 0;
+		m_LastPeriod = 0;
+		m_MaxPeriod = 0;
+		m_MaxJitter = 0;
+		m_MaxOverrun = 0;
+	}
+
+	unsigned int CyclePacer::wait() {
+		const unsigned long long now = cycle_time_now();
+		unsigned int missed = 0;
+
+		if (now > m_Deadline) {
+			//! The deadlines in (m_Deadline - m_Period, now] passed during the cycle
+			missed = (now - m_Deadline) / m_Period + 1;
+			++m_Overruns;
+			m_MaxOverrun = std::max(m_MaxOverrun, now - m_Deadline);
+			m_OverrunHistogram->record(now - m_Deadline);
+			CBF_DEBUG("overrun by " << now - m_Deadline << " ns, " << missed << " deadlines missed");
+
+			if (m_Policy == Skip)
+				m_Deadline += missed * m_Period;
+		}
+
+		//! With CatchUp the deadline may have passed, then the next cycle starts right away
+		if (m_Deadline > now)
+			sleep_until(m_Deadline);
+
+		const unsigned long long wake_up = cycle_time_now();
+
+		m_Jitter = (wake_up > m_Deadline) ? wake_up - m_Deadline : 0;
+		m_LastPeriod = wake_up - m_LastWakeUp;
+		m_MaxJitter = std::max(m_MaxJitter, m_Jitter);
+		m_MaxPeriod = std::max(m_MaxPeriod, m_LastPeriod);
+		m_JitterHistogram->record(m_Jitter);
+		m_PeriodHistogram->record(m_LastPeriod);
+
+		m_LastWakeUp = wake_up;
+		m_Deadline += m_Period;
+
+		return missed;
+	}
+
+	namespace {
+		void lock_memory() {
+			if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+				CBF_THROW_RUNTIME_ERROR("Could not lock the memory: " << strerror(errno));
+		}
+	}
+
+	void setup_real_time(const RealTimeOptions &options) {
+		if (options.lock_memory)
+			lock_memory();
+
+		if (options.cpu >= 0) {
+			#ifdef __linux__
+				cpu_set_t cpus;
+				CPU_ZERO(&cpus);
+				CPU_SET(options.cpu, &cpus);
+
+				const int error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+				if (error != 0)
+					CBF_THROW_RUNTIME_ERROR("Could not pin the thread to CPU " << options.cpu << ": " << strerror(error));
+			#else
+				CBF_THROW_RUNTIME_ERROR("Pinning threads to CPUs is only supported on Linux");
+			#endif
+		}
+
+		if (options.priority > 0) {
+			sched_param parameters;
+			parameters.sched_priority = options.priority;
+
+			const int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters);
+			if (error != 0)
+				CBF_THROW_RUNTIME_ERROR("Could not set SCHED_FIFO priority " << options.priority << ": " << strerror(error));
+		}
+	}
+
+	ScopedRealTime::ScopedRealTime(const RealTimeOptions &options) :
+		m_Options(options),
+		m_LockedMemory(false)
+	{
+		int error = pthread_getschedparam(pthread_self(), &m_Policy, &m_Parameters);
+		if (error != 0)
+			CBF_THROW_RUNTIME_ERROR("Could not get the scheduling policy: " << strerror(error));
+
+		#ifdef __linux__
+			error = pthread_getaffinity_np(pthread_self(), sizeof(m_CPUs), &m_CPUs);
+			if (error != 0)
+				CBF_THROW_RUNTIME_ERROR("Could not get the CPU affinity: " << strerror(error));
+		#endif
+
+		try {
+			//! Locked here to know whether restore() has to unlock
+			if (options.lock_memory) {
+				lock_memory();
+				m_LockedMemory = true;
+			}
+
+			RealTimeOptions thread_options = options;
+			thread_options.lock_memory = false;
+			setup_real_time(thread_options);
+		} catch (...) {
+			restore();
+			throw;
+		}
+	}
+
+	void ScopedRealTime::restore() {
+		//! Only what setup_real_time() changed, failures are ignored like in any destructor
+		if (m_Options.priority > 0)
+			pthread_setschedparam(pthread_self(), m_Policy, &m_Parameters);
+
+		#ifdef __linux__
+			if (m_Options.cpu >= 0)
+				pthread_setaffinity_np(pthread_self(), sizeof(m_CPUs), &m_CPUs);
+		#endif
+
+		if (m_LockedMemory) {
+			munlockall();
+			m_LockedMemory = false;
+		}
+	}
+
+} // namespace
@@ -62,6 +62,8 @@ namespace CBF {
 
 			m_References.push_back(tmp);
 		}
+
+		bump_version();
 	}
 
 	static XMLDerivedFactory<DummyReference, CBFSchema::DummyReference> x;
@@ -33,6 +33,7 @@
 namespace CBF {
 	void DummyResource::add(const FloatVector &arg) {
 		m_Variables += arg;
+		bump_version();
 		CBF_DEBUG("current values " << m_Variables.transpose());
 	}
 
@@ -49,6 +50,7 @@ namespace CBF {
 					xml_instance.Vector(), object_namespace
 				)
 			;
+			bump_version();
 
 			CBF_DEBUG("current values: " << m_Variables);
 		
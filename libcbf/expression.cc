@@ -0,0 +1,483 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#include <cbf/expression.h>
+#include <cbf/exceptions.h>
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+
+namespace CBF {
+
+	typedef ExpressionProgram::OpCode OpCode;
+	typedef ExpressionProgram::Instruction Instruction;
+
+	//! Whether the instruction reads register b, too
+	static bool is_binary(OpCode op) {
+		return op >= ExpressionProgram::Add && op <= ExpressionProgram::Atan2;
+	}
+
+	//! Whether the instruction reads registers at all
+	static bool has_operands(OpCode op) {
+		return op != ExpressionProgram::Constant && op != ExpressionProgram::Input;
+	}
+
+	static Float apply(OpCode op, Float a, Float b) {
+		switch (op) {
+			case ExpressionProgram::Add: return a + b;
+			case ExpressionProgram::Subtract: return a - b;
+			case ExpressionProgram::Multiply: return a * b;
+			case ExpressionProgram::Divide: return a / b;
+			case ExpressionProgram::Power: return std::pow(a, b);
+			case ExpressionProgram::Atan2: return std::atan2(a, b);
+			case ExpressionProgram::Negate: return -a;
+			case ExpressionProgram::Sin: return std::sin(a);
+			case ExpressionProgram::Cos: return std::cos(a);
+			case ExpressionProgram::Tan: return std::tan(a);
+			case ExpressionProgram::Asin: return std::asin(a);
+			case ExpressionProgram::Acos: return std::acos(a);
+			case ExpressionProgram::Atan: return std::atan(a);
+			case ExpressionProgram::Exp: return std::exp(a);
+			case ExpressionProgram::Log: return std::log(a);
+			case ExpressionProgram::Sqrt: return std::sqrt(a);
+			case ExpressionProgram::Abs: return std::fabs(a);
+			default: return 0;
+		}
+	}
+
+	//! The partial derivatives of an instruction's value by its operands
+	static void partials(OpCode op, Float a, Float b, Float value, Float &da, Float &db) {
+		db = 0;
+		switch (op) {
+			case ExpressionProgram::Add: da = 1; db = 1; break;
+			case ExpressionProgram::Subtract: da = 1; db = -1; break;
+			case ExpressionProgram::Multiply: da = b; db = a; break;
+			case ExpressionProgram::Divide: da = 1 / b; db = -value / b; break;
+			//! db is only used when the exponent is not constant
+			case ExpressionProgram::Power: da = b * std::pow(a, b - 1); db = value * std::log(a); break;
+			case ExpressionProgram::Atan2: da = b / (a * a + b * b); db = -a / (a * a + b * b); break;
+			case ExpressionProgram::Negate: da = -1; break;
+			case ExpressionProgram::Sin: da = std::cos(a); break;
+			case ExpressionProgram::Cos: da = -std::sin(a); break;
+			case ExpressionProgram::Tan: da = 1 + value * value; break;
+			case ExpressionProgram::Asin: da = 1 / std::sqrt(1 - a * a); break;
+			case ExpressionProgram::Acos: da = -1 / std::sqrt(1 - a * a); break;
+			case ExpressionProgram::Atan: da = 1 / (1 + a * a); break;
+			case ExpressionProgram::Exp: da = value; break;
+			case ExpressionProgram::Log: da = 1 / a; break;
+			case ExpressionProgram::Sqrt: da = 0.5 / value; break;
+			case ExpressionProgram::Abs: da = (a < 0) ? -1 : 1; break;
+			default: da = 0;
+		}
+	}
+
+
+	/**
+		A recursive descent parser emitting the instructions of the
+		program while it goes, following the grammar
+
+		<PRE>
+		sum     := product (('+' | '-') product)*
+		product := unary (('*' | '/') unary)*
+		unary   := ('-' | '+') unary | power
+		power   := primary ('^' unary)?
+		primary := number | name | name '[' index ']' | name '(' sum (',' sum)* ')' | '(' sum ')'
+		</PRE>
+	*/
+	struct ExpressionCompiler {
+		ExpressionCompiler(ExpressionProgram &program, const std::vector<ExpressionProgram::Variable> &variables) :
+			m_Program(program),
+			m_Variables(variables)
+		{
+			unsigned int offset = 0;
+			for (unsigned int i = 0; i < variables.size(); ++i) {
+				m_Offsets.push_back(offset);
+				offset += variables[i].second;
+			}
+			m_Program.m_InputDim = offset;
+		}
+
+		//! Returns the register holding the expression's value
+		unsigned int compile(const std::string &expression, unsigned int index) {
+			m_Text = expression;
+			m_Position = 0;
+			m_Index = index;
+
+			unsigned int result = parse_sum();
+
+			skip_whitespace();
+			if (m_Position != m_Text.size())
+				fail("Unexpected character");
+
+			return result;
+		}
+
+		//! Drop the instructions no output depends on, e.g. folded constants
+		void eliminate_dead_code() {
+			std::vector<Instruction> &instructions = m_Program.m_Instructions;
+
+			std::vector<char> used(instructions.size(), 0);
+			for (unsigned int i = 0; i < m_Program.m_Outputs.size(); ++i)
+				used[m_Program.m_Outputs[i]] = 1;
+
+			for (int i = instructions.size() - 1; i >= 0; --i) {
+				if (used[i] && has_operands(instructions[i].op))
+					used[instructions[i].a] = used[instructions[i].b] = 1;
+			}
+
+			std::vector<unsigned int> registers(instructions.size(), 0);
+			std::vector<Instruction> kept;
+			for (unsigned int i = 0; i < instructions.size(); ++i) {
+				if (!used[i]) continue;
+
+				Instruction instruction = instructions[i];
+				if (has_operands(instruction.op)) {
+					instruction.a = registers[instruction.a];
+					instruction.b = registers[instruction.b];
+				}
+				registers[i] = kept.size();
+				kept.push_back(instruction);
+			}
+
+			instructions = kept;
+			for (unsigned int i = 0; i < m_Program.m_Outputs.size(); ++i)
+				m_Program.m_Outputs[i] = registers[m_Program.m_Outputs[i]];
+		}
+
+		protected:
+			void fail(const std::string &message) {
+				CBF_THROW_RUNTIME_ERROR(
+					"Expression " << m_Index << ", column " << m_Position + 1 << ": "
+					<< message << " in \"" << m_Text << "\""
+				);
+			}
+
+			void skip_whitespace() {
+				while (m_Position < m_Text.size() && std::isspace(m_Text[m_Position]))
+					++m_Position;
+			}
+
+			bool accept(char c) {
+				skip_whitespace();
+				if (m_Position < m_Text.size() && m_Text[m_Position] == c) {
+					++m_Position;
+					return true;
+				}
+				return false;
+			}
+
+			void expect(char c) {
+				if (!accept(c))
+					fail(std::string("Expected '") + c + "'");
+			}
+
+			unsigned int emit_constant(Float value) {
+				std::map<Float, unsigned int>::const_iterator it = m_Constants.find(value);
+				if (it != m_Constants.end())
+					return it->second;
+
+				Instruction instruction = { ExpressionProgram::Constant, 0, 0, value };
+				m_Program.m_Instructions.push_back(instruction);
+				return m_Constants[value] = m_Program.m_Instructions.size() - 1;
+			}
+
+			/**
+				Folds operations on constants and reuses the register of an
+				identical earlier operation. Unary operations read a twice.
+			*/
+			unsigned int emit(OpCode op, unsigned int a, unsigned int b) {
+				std::vector<Instruction> &instructions = m_Program.m_Instructions;
+
+				if (op == ExpressionProgram::Input) {
+					b = a;
+				} else {
+					if (!is_binary(op)) b = a;
+
+					if (
+						instructions[a].op == ExpressionProgram::Constant &&
+						instructions[b].op == ExpressionProgram::Constant
+					)
+						return emit_constant(apply(op, instructions[a].value, instructions[b].value));
+
+					if ((op == ExpressionProgram::Add || op == ExpressionProgram::Multiply) && a > b)
+						std::swap(a, b);
+				}
+
+				const std::pair<int, std::pair<unsigned int, unsigned int> > key(op, std::make_pair(a, b));
+				std::map<std::pair<int, std::pair<unsigned int, unsigned int> >, unsigned int>::const_iterator it =
+					m_Operations.find(key);
+				if (it != m_Operations.end())
+					return it->second;
+
+				Instruction instruction = { op, a, b, 0 };
+				instructions.push_back(instruction);
+				return m_Operations[key] = instructions.size() - 1;
+			}
+
+			unsigned int parse_sum() {
+				unsigned int result = parse_product();
+				for (;;) {
+					if (accept('+'))
+						result = emit(ExpressionProgram::Add, result, parse_product());
+					else if (accept('-'))
+						result = emit(ExpressionProgram::Subtract, result, parse_product());
+					else
+						return result;
+				}
+			}
+
+			unsigned int parse_product() {
+				unsigned int result = parse_unary();
+				for (;;) {
+					if (accept('*'))
+						result = emit(ExpressionProgram::Multiply, result, parse_unary());
+					else if (accept('/'))
+						result = emit(ExpressionProgram::Divide, result, parse_unary());
+					else
+						return result;
+				}
+			}
+
+			unsigned int parse_unary() {
+				if (accept('-'))
+					return emit(ExpressionProgram::Negate, parse_unary(), 0);
+				if (accept('+'))
+					return parse_unary();
+				return parse_power();
+			}
+
+			unsigned int parse_power() {
+				unsigned int base = parse_primary();
+				if (accept('^'))
+					return emit(ExpressionProgram::Power, base, parse_unary());
+				return base;
+			}
+
+			unsigned int parse_primary() {
+				skip_whitespace();
+				if (m_Position == m_Text.size())
+					fail("Unexpected end");
+
+				if (accept('(')) {
+					unsigned int result = parse_sum();
+					expect(')');
+					return result;
+				}
+
+				const char c = m_Text[m_Position];
+				if (std::isdigit(c) || c == '.') {
+					char *end;
+					Float value = std::strtod(m_Text.c_str() + m_Position, &end);
+					m_Position = end - m_Text.c_str();
+					return emit_constant(value);
+				}
+
+				if (!std::isalpha(c) && c != '_')
+					fail("Unexpected character");
+
+				const size_t start = m_Position;
+				while (m_Position < m_Text.size() && (std::isalnum(m_Text[m_Position]) || m_Text[m_Position] == '_'))
+					++m_Position;
+				const std::string name = m_Text.substr(start, m_Position - start);
+
+				if (accept('('))
+					return parse_call(name);
+
+				for (unsigned int i = 0; i < m_Variables.size(); ++i) {
+					if (m_Variables[i].first != name) continue;
+
+					unsigned int index = 0;
+					if (accept('[')) {
+						skip_whitespace();
+						if (m_Position == m_Text.size() || !std::isdigit(m_Text[m_Position]))
+							fail("Expected an index");
+						char *end;
+						index = std::strtoul(m_Text.c_str() + m_Position, &end, 10);
+						m_Position = end - m_Text.c_str();
+						expect(']');
+					} else if (m_Variables[i].second != 1) {
+						fail("Expected an index into " + name);
+					}
+
+					if (index >= m_Variables[i].second)
+						fail("Index out of range");
+
+					return emit(ExpressionProgram::Input, m_Offsets[i] + index, 0);
+				}
+
+				if (name == "pi") return emit_constant(M_PI);
+				if (name == "e") return emit_constant(M_E);
+
+				fail("Unknown name " + name);
+				return 0;
+			}
+
+			unsigned int parse_call(const std::string &name) {
+				std::vector<unsigned int> arguments;
+				if (!accept(')')) {
+					do {
+						arguments.push_back(parse_sum());
+					} while (accept(','));
+					expect(')');
+				}
+
+				static const struct { const char *name; OpCode op; } functions[] = {
+					{ "pow", ExpressionProgram::Power },
+					{ "atan2", ExpressionProgram::Atan2 },
+					{ "sin", ExpressionProgram::Sin },
+					{ "cos", ExpressionProgram::Cos },
+					{ "tan", ExpressionProgram::Tan },
+					{ "asin", ExpressionProgram::Asin },
+					{ "acos", ExpressionProgram::Acos },
+					{ "atan", ExpressionProgram::Atan },
+					{ "exp", ExpressionProgram::Exp },
+					{ "log", ExpressionProgram::Log },
+					{ "sqrt", ExpressionProgram::Sqrt },
+					{ "abs", ExpressionProgram::Abs }
+				};
+
+				for (unsigned int i = 0; i < sizeof(functions) / sizeof(functions[0]); ++i) {
+					if (name != functions[i].name) continue;
+
+					const unsigned int arity = is_binary(functions[i].op) ? 2 : 1;
+					if (arguments.size() != arity)
+						fail("Wrong number of arguments to " + name);
+
+					return emit(functions[i].op, arguments[0], arguments[arity - 1]);
+				}
+
+				fail("Unknown function " + name);
+				return 0;
+			}
+
+			ExpressionProgram &m_Program;
+			const std::vector<ExpressionProgram::Variable> &m_Variables;
+
+			//! The index of each variable's first element in the inputs
+			std::vector<unsigned int> m_Offsets;
+
+			std::string m_Text;
+			size_t m_Position;
+			unsigned int m_Index;
+
+			std::map<Float, unsigned int> m_Constants;
+			std::map<std::pair<int, std::pair<unsigned int, unsigned int> >, unsigned int> m_Operations;
+	};
+
+
+	ExpressionProgram::ExpressionProgram(
+		const std::vector<std::string> &expressions,
+		const std::vector<Variable> &variables
+	) :
+		m_InputDim(0)
+	{
+		ExpressionCompiler compiler(*this, variables);
+
+		for (unsigned int i = 0; i < expressions.size(); ++i)
+			m_Outputs.push_back(compiler.compile(expressions[i], i));
+
+		compiler.eliminate_dead_code();
+
+		m_Values = FloatVector::Zero(m_Instructions.size());
+		m_Tangents = FloatMatrix::Zero(0, m_Instructions.size());
+		m_Active.resize(m_Instructions.size(), 0);
+	}
+
+	void ExpressionProgram::evaluate(const FloatVector &input, FloatVector &result) {
+		for (unsigned int i = 0; i < m_Instructions.size(); ++i) {
+			const Instruction &instruction = m_Instructions[i];
+			switch (instruction.op) {
+				case Constant:
+					m_Values[i] = instruction.value;
+					break;
+				case Input:
+					m_Values[i] = input[instruction.a];
+					break;
+				default:
+					m_Values[i] = apply(instruction.op, m_Values[instruction.a], m_Values[instruction.b]);
+			}
+		}
+
+		for (unsigned int i = 0; i < m_Outputs.size(); ++i)
+			result[i] = m_Values[m_Outputs[i]];
+	}
+
+	void ExpressionProgram::evaluate(
+		const FloatVector &input,
+		FloatVector &result,
+		FloatMatrix &jacobian,
+		unsigned int tangent_dim
+	) {
+		evaluate(input, result);
+
+		//! Only the first call for a tangent_dim allocates
+		if (m_Tangents.rows() != (int)tangent_dim)
+			m_Tangents.resize(tangent_dim, m_Instructions.size());
+
+		for (unsigned int i = 0; i < m_Instructions.size(); ++i) {
+			const Instruction &instruction = m_Instructions[i];
+
+			switch (instruction.op) {
+				case Constant:
+					m_Active[i] = 0;
+					break;
+				case Input:
+					m_Active[i] = (instruction.a < tangent_dim);
+					if (m_Active[i]) {
+						m_Tangents.col(i).setZero();
+						m_Tangents(instruction.a, i) = 1;
+					}
+					break;
+				default: {
+					const bool active_a = m_Active[instruction.a];
+					const bool active_b = is_binary(instruction.op) && m_Active[instruction.b];
+					m_Active[i] = active_a || active_b;
+					if (!m_Active[i]) break;
+
+					Float da, db;
+					partials(
+						instruction.op,
+						m_Values[instruction.a],
+						m_Values[instruction.b],
+						m_Values[i],
+						da,
+						db
+					);
+
+					if (active_a && active_b)
+						m_Tangents.col(i) = da * m_Tangents.col(instruction.a) + db * m_Tangents.col(instruction.b);
+					else if (active_a)
+						m_Tangents.col(i) = da * m_Tangents.col(instruction.a);
+					else
+						m_Tangents.col(i) = db * m_Tangents.col(instruction.b);
+				}
+			}
+		}
+
+		for (unsigned int i = 0; i < m_Outputs.size(); ++i) {
+			if (m_Active[m_Outputs[i]])
+				jacobian.row(i) = m_Tangents.col(m_Outputs[i]).transpose();
+			else
+				jacobian.row(i).setZero();
+		}
+	}
+
+} // namespace
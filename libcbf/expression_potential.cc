@@ -0,0 +1,100 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#include <cbf/expression_potential.h>
+#include <cbf/xml_object_factory.h>
+#include <cbf/xml_factory.h>
+
+#include <limits>
+
+namespace CBF {
+
+	ExpressionPotential::ExpressionPotential(const std::string &expression, unsigned int dim, Float coefficient) :
+		m_Coefficient(coefficient),
+		m_Dim(dim)
+	{
+		init(expression);
+	}
+
+	void ExpressionPotential::init(const std::string &expression) {
+		std::vector<ExpressionProgram::Variable> variables;
+		variables.push_back(ExpressionProgram::Variable("x", m_Dim));
+		variables.push_back(ExpressionProgram::Variable("r", m_Dim));
+
+		m_Program = ExpressionProgram(std::vector<std::string>(1, expression), variables);
+
+		m_Input = FloatVector::Zero(2 * m_Dim);
+		m_Value = FloatVector::Zero(1);
+		m_Gradient = FloatMatrix::Zero(1, m_Dim);
+	}
+
+	Float ExpressionPotential::value(const FloatVector &reference, const FloatVector &input) {
+		m_Input.head(m_Dim) = input;
+		m_Input.tail(m_Dim) = reference;
+		m_Program.evaluate(m_Input, m_Value);
+		return m_Value[0];
+	}
+
+	void ExpressionPotential::gradient (
+		FloatVector &result,
+		const std::vector<FloatVector > &references,
+		const FloatVector &input
+	) {
+		//! Like SquarePotential, head for the closest reference
+		unsigned int min_index = 0;
+
+		if (m_ReferenceIndex.applies(references.size())) {
+			min_index = m_ReferenceIndex.closest(references, input, m_ReferencesVersion);
+		} else {
+			Float min_dist = std::numeric_limits<Float>::max();
+
+			for (unsigned int i = 0; i < references.size(); ++i) {
+				Float dist = distance(input, references[i]);
+				if (dist < min_dist) {
+					min_index = i;
+					min_dist = dist;
+				}
+			}
+		}
+
+		//! Only the derivatives by x are needed, so r is not a tangent input
+		m_Input.head(m_Dim) = input;
+		m_Input.tail(m_Dim) = references[min_index];
+		m_Program.evaluate(m_Input, m_Value, m_Gradient, m_Dim);
+
+		result = -m_Coefficient * m_Gradient.row(0).transpose();
+		Float result_norm = norm(result);
+
+		if (result_norm >= m_MaxGradientStepNorm)
+			result *= m_MaxGradientStepNorm/result_norm;
+	}
+
+	#ifdef CBF_HAVE_XSD
+		ExpressionPotential::ExpressionPotential(const CBFSchema::ExpressionPotential &xml_instance, ObjectNamespacePtr object_namespace) :
+			Potential(xml_instance, object_namespace),
+			m_Coefficient(xml_instance.Coefficient()),
+			m_Dim(xml_instance.Dimension())
+		{
+			init(xml_instance.Expression());
+		}
+
+		static XMLDerivedFactory<ExpressionPotential, CBFSchema::ExpressionPotential> x;
+	#endif
+
+} // namespace
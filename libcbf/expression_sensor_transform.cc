@@ -0,0 +1,70 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#include <cbf/expression_sensor_transform.h>
+#include <cbf/xml_object_factory.h>
+
+namespace CBF {
+
+	ExpressionSensorTransform::ExpressionSensorTransform(
+		const std::vector<std::string> &expressions, 
+		unsigned int resource_dim
+	) {
+		init(expressions, resource_dim);
+	}
+
+	void ExpressionSensorTransform::init(const std::vector<std::string> &expressions, unsigned int resource_dim) {
+		m_Program = ExpressionProgram(
+			expressions, 
+			std::vector<ExpressionProgram::Variable>(1, ExpressionProgram::Variable("x", resource_dim))
+		);
+
+		m_Result = FloatVector::Zero(task_dim());
+		m_TaskJacobian = FloatMatrix::Zero(task_dim(), resource_dim);
+	}
+
+	void ExpressionSensorTransform::update(const FloatVector &resource_value) {
+		m_Program.evaluate(resource_value, m_Result);
+		defer_jacobian(resource_value);
+	}
+
+	void ExpressionSensorTransform::update_jacobian(const FloatVector &resource_value) {
+		m_Program.evaluate(resource_value, m_Result, m_TaskJacobian, resource_dim());
+	}
+
+	#ifdef CBF_HAVE_XSD
+		ExpressionSensorTransform::ExpressionSensorTransform(
+			const CBFSchema::ExpressionSensorTransform &xml_instance, 
+			ObjectNamespacePtr object_namespace
+		) :
+			SensorTransform(xml_instance, object_namespace)
+		{
+			std::vector<std::string> expressions;
+
+			CBFSchema::ExpressionSensorTransform::Expression_const_iterator it;
+			for (it = xml_instance.Expression().begin(); it != xml_instance.Expression().end(); ++it)
+				expressions.push_back(*it);
+
+			init(expressions, xml_instance.ResourceDimension());
+		}
+
+		static XMLDerivedFactory<ExpressionSensorTransform, CBFSchema::ExpressionSensorTransform> x;
+	#endif
+
+} // namespace
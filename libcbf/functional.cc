@@ -6,23 +6,13 @@ namespace CBF {
 
 #ifdef CBF_HAVE_XSD
 	template<> template<> ApplySensorTransform<
-		std::binder2nd<multiplies<FloatVector, double> >,
-		std::binder2nd<multiplies<FloatMatrix, double> >
+		multiply_by,
+		multiply_by
 	>::ApplySensorTransform(
 			const CBFSchema::MultiplyOperationSensorTransform &xml_instance, ObjectNamespacePtr object_namespace
 	) :
-		m_VectorOperation(
-			std::bind2nd(
-				multiplies<FloatVector, double>(),
-				xml_instance.Factor()
-			)
-		),
-		m_MatrixOperation(
-			std::bind2nd(
-				multiplies<FloatMatrix, double>(),
-				xml_instance.Factor()
-			)
-		) 
+		m_VectorOperation(xml_instance.Factor()),
+		m_MatrixOperation(xml_instance.Factor())
 	{ 
 		CBF_DEBUG("MultiplyOperationSensorTransform");
 		m_Operand = XMLObjectFactory::instance()->create<SensorTransform>(xml_instance.Operand(), object_namespace);
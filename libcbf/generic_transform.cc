@@ -28,15 +28,15 @@ namespace CBF {
 
 
 void GenericEffectorTransform::update(const FloatVector &resource_value, const FloatMatrix &task_jacobian) {
-	pseudo_inverse(task_jacobian, m_InverseTaskJacobian);
+	pseudo_inverse(task_jacobian, m_InverseTaskJacobian, m_Workspace);
 }
 
 void DampedGenericEffectorTransform::update(const FloatVector &resource_value, const FloatMatrix &task_jacobian) {
-	damped_pseudo_inverse(task_jacobian, m_InverseTaskJacobian, m_DampingConstant);
+	damped_pseudo_inverse(task_jacobian, m_InverseTaskJacobian, m_Workspace, m_DampingConstant);
 }
 
 void ThresholdGenericEffectorTransform::update(const FloatVector &resource_value, const FloatMatrix &task_jacobian) {
-	threshold_pseudo_inverse(task_jacobian, m_InverseTaskJacobian, m_Threshold);
+	threshold_pseudo_inverse(task_jacobian, m_InverseTaskJacobian, m_Workspace, m_Threshold);
 }
 
 #ifdef CBF_HAVE_XSD
@@ -46,6 +46,9 @@ void ThresholdGenericEffectorTransform::update(const FloatVector &resource_value
 		EffectorTransform(xml_instance, object_namespace)
 	{
 		init(xml_instance.TaskDimension(), xml_instance.ResourceDimension());
+
+		if (xml_instance.Solver().present())
+			set_solver(pseudo_inverse_solver(*xml_instance.Solver()));
 	}
 
 	DampedGenericEffectorTransform::DampedGenericEffectorTransform(
@@ -58,6 +61,9 @@ void ThresholdGenericEffectorTransform::update(const FloatVector &resource_value
 			xml_instance.ResourceDimension(),
 			xml_instance.DampingConstant()
 		);
+
+		if (xml_instance.Solver().present())
+			set_solver(pseudo_inverse_solver(*xml_instance.Solver()));
 	}
 
 	ThresholdGenericEffectorTransform::ThresholdGenericEffectorTransform(
@@ -70,6 +76,9 @@ void ThresholdGenericEffectorTransform::update(const FloatVector &resource_value
 			xml_instance.ResourceDimension(),
 			xml_instance.Threshold()
 		);
+
+		if (xml_instance.Solver().present())
+			set_solver(pseudo_inverse_solver(*xml_instance.Solver()));
 	}
 
 	PaddedEffectorTransform::PaddedEffectorTransform(
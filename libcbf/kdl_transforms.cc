@@ -38,33 +38,285 @@
 #include <kdl/jntarrayvel.hpp>
 
 namespace CBF {
-	
-	
-	BaseKDLChainSensorTransform::BaseKDLChainSensorTransform(boost::shared_ptr<KDL::Chain> chain) :
-	   m_Chain(chain),
-	   m_Frame(new KDL::Frame)
+
+	namespace {
+		/**
+			Whether the joint values of the last computation can be reused, 
+			by their resource versions if known or else by value
+		*/
+		bool unchanged(
+			const FloatVector &value, 
+			unsigned long version, 
+			const FloatVector &new_value, 
+			unsigned long new_version
+		) {
+			if (new_version != 0)
+				return new_version == version;
+
+			return new_value == value;
+		}
+	}
+
+	KDLChainKinematics::KDLChainKinematics(boost::shared_ptr<KDL::Chain> chain) :
+		Object("KDLChainKinematics"),
+		m_Chain(chain)
 	{
 		init_solvers();
 	}
-	
-	void BaseKDLChainSensorTransform::init_solvers() {
+
+	void KDLChainKinematics::init_solvers() {
 		m_JacSolver.reset(new KDL::ChainJntToJacSolver(*m_Chain));
 		m_FKSolver.reset(new KDL::ChainFkSolverPos_recursive(*m_Chain));
+		m_JntArray.reset(new KDL::JntArray(resource_dim()));
+		m_Frame.reset(new KDL::Frame);
 		m_Jacobian.reset(new KDL::Jacobian(resource_dim()));
+		m_ResourceValue = FloatVector::Zero(resource_dim());
+		m_JacobianResourceValue = FloatVector::Zero(resource_dim());
+		m_Version = 0;
+		m_JacobianVersion = 0;
+		m_Computed = false;
+		m_JacobianComputed = false;
+		m_Computations = 0;
+		m_JacobianComputations = 0;
+	}
+
+	void KDLChainKinematics::check(const Lock &lock) const {
+		if (lock.mutex() != &m_Mutex || !lock.owns_lock())
+			CBF_THROW_RUNTIME_ERROR("The kinematics' mutex has to be locked");
+	}
+
+	void KDLChainKinematics::update(const Lock &lock, const FloatVector &resource_value, unsigned long resource_version) {
+		check(lock);
+
+		if (m_Computed && unchanged(m_ResourceValue, m_Version, resource_value, resource_version))
+			return;
+
+		m_ResourceValue = resource_value;
+		m_Version = resource_version;
+		m_JntArray->data = resource_value;
+
+		m_FKSolver->JntToCart(*m_JntArray, *m_Frame);
+
+		m_Computed = true;
+		++m_Computations;
+	}
+
+	void KDLChainKinematics::update_jacobian(const Lock &lock, const FloatVector &resource_value, unsigned long resource_version) {
+		check(lock);
+
+		if (m_JacobianComputed && unchanged(m_JacobianResourceValue, m_JacobianVersion, resource_value, resource_version))
+			return;
+
+		m_JacobianResourceValue = resource_value;
+		m_JacobianVersion = resource_version;
+		m_JntArray->data = resource_value;
+
+		m_JacSolver->JntToJac(*m_JntArray, *m_Jacobian);
+
+		m_JacobianComputed = true;
+		++m_JacobianComputations;
+	}
+
+	unsigned int KDLChainKinematics::resource_dim() const {
+		return m_Chain->getNrOfJoints();
 	}
+
+
+	KDLTreeKinematics::KDLTreeKinematics(boost::shared_ptr<KDL::Tree> tree) :
+		Object("KDLTreeKinematics"),
+		m_Tree(tree)
+	{
+		init();
+	}
+
+	void KDLTreeKinematics::init() {
+		CBF_DEBUG("nr of joints: " << m_Tree->getNrOfJoints());
+
+		m_ResourceValue = FloatVector::Zero(resource_dim());
+		m_Version = 0;
+		m_Computed = false;
+		m_JacobianComputed = false;
+		m_Computations = 0;
+		m_JacobianComputations = 0;
+	}
+
+	unsigned int KDLTreeKinematics::add_path(const std::string &segment_name) {
+		std::map<std::string, unsigned int>::const_iterator node = m_NodeIndices.find(segment_name);
+		if (node != m_NodeIndices.end())
+			return node->second;
+
+		KDL::SegmentMap::const_iterator element = m_Tree->getSegment(segment_name);
+		KDL::SegmentMap::const_iterator root = m_Tree->getRootSegment();
+
+		//! The parent's node has to come first
+		int parent = -1;
+		if (element->second.parent != root)
+			parent = add_path(element->second.parent->first);
+
+		const KDL::Segment &segment = element->second.segment;
+
+		m_NodeSegments.push_back(boost::shared_ptr<KDL::Segment>(new KDL::Segment(segment)));
+		m_NodeParents.push_back(parent);
+		m_NodeJoints.push_back(segment.getJoint().getType() == KDL::Joint::None ? -1 : (int)element->second.q_nr);
+		m_NodeFrames.push_back(boost::shared_ptr<KDL::Frame>(new KDL::Frame));
+		m_NodeTwists.push_back(boost::shared_ptr<KDL::Twist>(new KDL::Twist));
+
+		return m_NodeIndices[segment_name] = m_NodeSegments.size() - 1;
+	}
+
+	unsigned int KDLTreeKinematics::add_segment(const std::string &segment_name) {
+		boost::mutex::scoped_lock lock(m_Mutex);
+
+		for (unsigned int i = 0; i < m_SegmentNames.size(); ++i)
+			if (m_SegmentNames[i] == segment_name) return i;
+
+		if (m_Tree->getSegments().find(segment_name) == m_Tree->getSegments().end())
+			CBF_THROW_RUNTIME_ERROR("The tree has no segment with name: " << segment_name);
+
+		unsigned int node = add_path(segment_name);
+
+		std::vector<unsigned int> joint_nodes;
+		for (int i = node; i != -1; i = m_NodeParents[i])
+			if (m_NodeJoints[i] != -1) joint_nodes.push_back(i);
+
+		m_SegmentNames.push_back(segment_name);
+		m_SegmentNodes.push_back(node);
+		m_SegmentJointNodes.push_back(joint_nodes);
+		m_Jacobians.push_back(boost::shared_ptr<KDL::Jacobian>(new KDL::Jacobian(m_Tree->getNrOfJoints())));
+		m_Jacobians.back()->data.setZero();
+
+		//! The new segment has not been computed yet
+		m_Computed = false;
+
+		return m_SegmentNames.size() - 1;
+	}
+
+	void KDLTreeKinematics::check(const Lock &lock) const {
+		if (lock.mutex() != &m_Mutex || !lock.owns_lock())
+			CBF_THROW_RUNTIME_ERROR("The kinematics' mutex has to be locked");
+	}
+
+	void KDLTreeKinematics::update(const Lock &lock, const FloatVector &resource_value, unsigned long resource_version) {
+		check(lock);
+
+		if (m_Computed && unchanged(m_ResourceValue, m_Version, resource_value, resource_version))
+			return;
+
+		update_frames(resource_value, resource_version);
+	}
+
+	void KDLTreeKinematics::update_frames(const FloatVector &resource_value, unsigned long resource_version) {
+		CBF_DEBUG(resource_value);
+		m_ResourceValue = resource_value;
+		m_Version = resource_version;
+
+		//! Parents come first, so their frames are always ready
+		for (unsigned int i = 0; i < m_NodeSegments.size(); ++i) {
+			const KDL::Segment &segment = *m_NodeSegments[i];
+			const int joint = m_NodeJoints[i];
+			const double q = (joint == -1) ? 0.0 : resource_value[joint];
+
+			if (m_NodeParents[i] == -1)
+				*m_NodeFrames[i] = segment.pose(q);
+			else
+				*m_NodeFrames[i] = *m_NodeFrames[m_NodeParents[i]] * segment.pose(q);
+		}
+
+		m_Computed = true;
+		m_JacobianComputed = false;
+		++m_Computations;
+	}
+
+	void KDLTreeKinematics::update_jacobian(const Lock &lock, const FloatVector &resource_value, unsigned long resource_version) {
+		check(lock);
+
+		if (!m_Computed || !unchanged(m_ResourceValue, m_Version, resource_value, resource_version))
+			update_frames(resource_value, resource_version);
+
+		if (m_JacobianComputed)
+			return;
+
+		for (unsigned int i = 0; i < m_NodeSegments.size(); ++i) {
+			const int joint = m_NodeJoints[i];
+			if (joint == -1) continue;
+
+			const KDL::Twist twist = m_NodeSegments[i]->twist(resource_value[joint], 1.0);
+			if (m_NodeParents[i] == -1)
+				*m_NodeTwists[i] = twist;
+			else
+				*m_NodeTwists[i] = m_NodeFrames[m_NodeParents[i]]->M * twist;
+		}
+
+		//! Columns of joints not on a segment's path stay zero
+		for (unsigned int i = 0; i < m_SegmentNames.size(); ++i) {
+			const KDL::Vector &tip = m_NodeFrames[m_SegmentNodes[i]]->p;
+			const std::vector<unsigned int> &joint_nodes = m_SegmentJointNodes[i];
+
+			for (unsigned int j = 0; j < joint_nodes.size(); ++j) {
+				const unsigned int node = joint_nodes[j];
+				m_Jacobians[i]->setColumn(
+					m_NodeJoints[node], 
+					m_NodeTwists[node]->RefPoint(tip - m_NodeFrames[node]->p)
+				);
+			}
+		}
+
+		m_JacobianComputed = true;
+		++m_JacobianComputations;
+	}
+
+	unsigned int KDLTreeKinematics::resource_dim() const {
+		return m_Tree->getNrOfJoints();
+	}
+
 	
-	void BaseKDLChainSensorTransform::compute(const FloatVector &resource_value) {
-		KDL::JntArray jnt_array(resource_dim());
-		jnt_array.data = resource_value;
+	BaseKDLChainSensorTransform::BaseKDLChainSensorTransform(boost::shared_ptr<KDL::Chain> chain) :
+	   m_Chain(chain),
+	   m_Kinematics(new KDLChainKinematics(chain)),
+	   m_KinematicsVersion(0)
+	{
 
-		m_JacSolver->JntToJac(jnt_array, *m_Jacobian);
-		m_FKSolver->JntToCart(jnt_array, *m_Frame);
+	}
+
+	BaseKDLChainSensorTransform::BaseKDLChainSensorTransform(KDLChainKinematicsPtr kinematics) :
+	   m_Chain(kinematics->chain()),
+	   m_Kinematics(kinematics),
+	   m_KinematicsVersion(0)
+	{
+
+	}
+	
+	void BaseKDLChainSensorTransform::compute(const KDLChainKinematics::Lock &lock, const FloatVector &resource_value) {
+		m_Kinematics->update(lock, resource_value, m_UpdateVersion);
+		m_KinematicsVersion = m_UpdateVersion;
 	}
 
 	unsigned int BaseKDLChainSensorTransform::resource_dim() const {
 		return m_Chain->getNrOfJoints();
 	}
 
+	void BaseKDLChainSensorTransform::update_batch(
+		const FloatMatrix &resource_values, 
+		FloatMatrix &results, 
+		FloatMatrix &task_jacobians
+	) {
+		const unsigned int dim = resource_dim();
+		results.resize(task_dim(), resource_values.cols());
+		task_jacobians.resize(task_dim(), resource_values.cols() * dim);
+
+		if (m_BatchKinematics.get() == 0)
+			m_BatchKinematics.reset(new KDLChainKinematics(m_Chain));
+
+		FloatVector resource_value(dim);
+		for (unsigned int i = 0; i < resource_values.cols(); ++i) {
+			resource_value = resource_values.col(i);
+			KDLChainKinematics::Lock lock(m_BatchKinematics->mutex());
+			m_BatchKinematics->update(lock, resource_value, 0);
+			m_BatchKinematics->update_jacobian(lock, resource_value, 0);
+			store_batch_column(*m_BatchKinematics, lock, i, results, task_jacobians);
+		}
+	}
+
 
 	KDLChainPoseSensorTransform::KDLChainPoseSensorTransform(boost::shared_ptr<KDL::Chain> chain) :
 		BaseKDLChainSensorTransform(chain)
@@ -73,14 +325,43 @@ namespace CBF {
 		m_TaskJacobian = FloatMatrix(task_dim(), resource_dim());
 	}
 
+	KDLChainPoseSensorTransform::KDLChainPoseSensorTransform(KDLChainKinematicsPtr kinematics) :
+		BaseKDLChainSensorTransform(kinematics)
+	{
+		m_Result = FloatVector(task_dim());
+		m_TaskJacobian = FloatMatrix(task_dim(), resource_dim());
+	}
+
 	void KDLChainPoseSensorTransform::update(const FloatVector &resource_value) {
-		BaseKDLChainSensorTransform::compute(resource_value);
+		KDLChainKinematics::Lock lock(m_Kinematics->mutex());
+		BaseKDLChainSensorTransform::compute(lock, resource_value);
 
-		m_TaskJacobian = m_Jacobian->data;
-		m_Result.head(3) = Eigen::Map<Eigen::Vector3d>(m_Frame->p.data);
-		const KDL::Vector &axis = m_Frame->M.GetRot();
+		const KDL::Frame &frame = m_Kinematics->frame(lock);
+		m_Result.head(3) = Eigen::Map<const Eigen::Vector3d>(frame.p.data);
+		const KDL::Vector &axis = frame.M.GetRot();
 		m_Result.tail(3) = Eigen::Map<const Eigen::Vector3d>(axis.data);
 
+		defer_jacobian(resource_value);
+	}
+
+	void KDLChainPoseSensorTransform::update_jacobian(const FloatVector &resource_value) {
+		KDLChainKinematics::Lock lock(m_Kinematics->mutex());
+		m_Kinematics->update_jacobian(lock, resource_value, m_KinematicsVersion);
+		m_TaskJacobian = m_Kinematics->jacobian(lock).data;
+	}
+
+	void KDLChainPoseSensorTransform::store_batch_column(
+		const KDLChainKinematics &kinematics, 
+		const KDLChainKinematics::Lock &lock, 
+		unsigned int i, 
+		FloatMatrix &results, 
+		FloatMatrix &task_jacobians
+	) {
+		const KDL::Frame &frame = kinematics.frame(lock);
+		const KDL::Vector &axis = frame.M.GetRot();
+		results.block<3, 1>(0, i) = Eigen::Map<const Eigen::Vector3d>(frame.p.data);
+		results.block<3, 1>(3, i) = Eigen::Map<const Eigen::Vector3d>(axis.data);
+		task_jacobians.middleCols(i * resource_dim(), resource_dim()) = kinematics.jacobian(lock).data;
 	}
 
 
@@ -91,12 +372,37 @@ namespace CBF {
 		m_Result = FloatVector(task_dim());
 		m_TaskJacobian = FloatMatrix(task_dim(), resource_dim());
 	}
+
+	KDLChainPositionSensorTransform::KDLChainPositionSensorTransform(KDLChainKinematicsPtr kinematics) :
+		BaseKDLChainSensorTransform(kinematics)
+	{
+		m_Result = FloatVector(task_dim());
+		m_TaskJacobian = FloatMatrix(task_dim(), resource_dim());
+	}
 	
 	void KDLChainPositionSensorTransform::update(const FloatVector &resource_value) {
-		BaseKDLChainSensorTransform::compute(resource_value);
+		KDLChainKinematics::Lock lock(m_Kinematics->mutex());
+		BaseKDLChainSensorTransform::compute(lock, resource_value);
+
+		m_Result = Eigen::Map<const Eigen::Vector3d>(m_Kinematics->frame(lock).p.data);
+		defer_jacobian(resource_value);
+	}
+
+	void KDLChainPositionSensorTransform::update_jacobian(const FloatVector &resource_value) {
+		KDLChainKinematics::Lock lock(m_Kinematics->mutex());
+		m_Kinematics->update_jacobian(lock, resource_value, m_KinematicsVersion);
+		m_TaskJacobian = m_Kinematics->jacobian(lock).data.topRows<3>();
+	}
 
-		m_TaskJacobian = m_Jacobian->data.topRows<3>();
-		m_Result = Eigen::Map<Eigen::Vector3d>(m_Frame->p.data);
+	void KDLChainPositionSensorTransform::store_batch_column(
+		const KDLChainKinematics &kinematics, 
+		const KDLChainKinematics::Lock &lock, 
+		unsigned int i, 
+		FloatMatrix &results, 
+		FloatMatrix &task_jacobians
+	) {
+		results.col(i) = Eigen::Map<const Eigen::Vector3d>(kinematics.frame(lock).p.data);
+		task_jacobians.middleCols(i * resource_dim(), resource_dim()) = kinematics.jacobian(lock).data.topRows<3>();
 	}
 
 
@@ -106,13 +412,38 @@ namespace CBF {
 	{
 		m_Result = FloatVector(task_dim());
 	}
+
+	KDLChainAxisAngleSensorTransform::KDLChainAxisAngleSensorTransform(KDLChainKinematicsPtr kinematics) :
+		BaseKDLChainSensorTransform(kinematics)
+	{
+		m_Result = FloatVector(task_dim());
+	}
 	
 	void KDLChainAxisAngleSensorTransform::update(const FloatVector &resource_value) {
-		BaseKDLChainSensorTransform::compute(resource_value);
+		KDLChainKinematics::Lock lock(m_Kinematics->mutex());
+		BaseKDLChainSensorTransform::compute(lock, resource_value);
 	
-		m_TaskJacobian = m_Jacobian->data.bottomRows<3>();
-		const KDL::Vector &axis = m_Frame->M.GetRot();
+		const KDL::Vector &axis = m_Kinematics->frame(lock).M.GetRot();
 		m_Result = Eigen::Map<const Eigen::Vector3d>(axis.data);
+		defer_jacobian(resource_value);
+	}
+
+	void KDLChainAxisAngleSensorTransform::update_jacobian(const FloatVector &resource_value) {
+		KDLChainKinematics::Lock lock(m_Kinematics->mutex());
+		m_Kinematics->update_jacobian(lock, resource_value, m_KinematicsVersion);
+		m_TaskJacobian = m_Kinematics->jacobian(lock).data.bottomRows<3>();
+	}
+
+	void KDLChainAxisAngleSensorTransform::store_batch_column(
+		const KDLChainKinematics &kinematics, 
+		const KDLChainKinematics::Lock &lock, 
+		unsigned int i, 
+		FloatMatrix &results, 
+		FloatMatrix &task_jacobians
+	) {
+		const KDL::Vector &axis = kinematics.frame(lock).M.GetRot();
+		results.col(i) = Eigen::Map<const Eigen::Vector3d>(axis.data);
+		task_jacobians.middleCols(i * resource_dim(), resource_dim()) = kinematics.jacobian(lock).data.bottomRows<3>();
 	}
 
 
@@ -121,49 +452,65 @@ namespace CBF {
 		const std::vector<std::string> &segment_names
 	) :
 		m_Tree(tree),
-		m_SegmentNames(segment_names)
+		m_Kinematics(new KDLTreeKinematics(tree)),
+		m_SegmentNames(segment_names),
+		m_KinematicsVersion(0)
 	{
 		init_solvers();
 	}
-	
-	void BaseKDLTreeSensorTransform::init_solvers() {
-	
-		m_Twists = FloatMatrix(6, m_Tree->getNrOfJoints());
-		CBF_DEBUG("nr of joints: " << m_Tree->getNrOfJoints());
-	
-		m_JacSolver = boost::shared_ptr<KDL::TreeJntToJacSolver>(
-			new KDL::TreeJntToJacSolver(*m_Tree)
-		);
-	
-		m_FKSolver = boost::shared_ptr<KDL::TreeFkSolverPos_recursive>(
-			new KDL::TreeFkSolverPos_recursive(*m_Tree)
-		);
-
-		for (unsigned int i = 0; i < m_SegmentNames.size(); ++i) {
-			if (m_Tree->getSegments().find(m_SegmentNames[i]) == m_Tree->getSegments().end())
-				CBF_THROW_RUNTIME_ERROR("The tree has no segment with name: " << m_SegmentNames[i]);
 
-			m_Jacobians.push_back(boost::shared_ptr<KDL::Jacobian>(new KDL::Jacobian(m_Tree->getNrOfJoints())));
-			m_Frames.push_back(boost::shared_ptr<KDL::Frame>(new KDL::Frame));
-		}
+	BaseKDLTreeSensorTransform::BaseKDLTreeSensorTransform(
+		KDLTreeKinematicsPtr kinematics,
+		const std::vector<std::string> &segment_names
+	) :
+		m_Tree(kinematics->tree()),
+		m_Kinematics(kinematics),
+		m_SegmentNames(segment_names),
+		m_KinematicsVersion(0)
+	{
+		init_solvers();
 	}
 	
-	void BaseKDLTreeSensorTransform::update(const FloatVector &resource_value) {
-		KDL::JntArray jnt_array(resource_dim());
-	
-		CBF_DEBUG(resource_value);
-		jnt_array.data = resource_value;
-
-		for (unsigned int i = 0; i < m_SegmentNames.size(); ++i) {
-			m_JacSolver->JntToJac(jnt_array, *(m_Jacobians[i]), m_SegmentNames[i]);
-			m_FKSolver->JntToCart(jnt_array, *(m_Frames[i]), m_SegmentNames[i]);
-		}
+	void BaseKDLTreeSensorTransform::init_solvers() {
+		m_Segments.clear();
+		for (unsigned int i = 0; i < m_SegmentNames.size(); ++i)
+			m_Segments.push_back(m_Kinematics->add_segment(m_SegmentNames[i]));
+	}
 	
+	void BaseKDLTreeSensorTransform::compute(const KDLTreeKinematics::Lock &lock, const FloatVector &resource_value) {
+		m_Kinematics->update(lock, resource_value, m_UpdateVersion);
+		m_KinematicsVersion = m_UpdateVersion;
 	}
 	
 	unsigned int BaseKDLTreeSensorTransform::resource_dim() const {
 		return m_Tree->getNrOfJoints();
 	}
+
+	void BaseKDLTreeSensorTransform::update_batch(
+		const FloatMatrix &resource_values, 
+		FloatMatrix &results, 
+		FloatMatrix &task_jacobians
+	) {
+		const unsigned int dim = resource_dim();
+		results.resize(task_dim(), resource_values.cols());
+		task_jacobians.resize(task_dim(), resource_values.cols() * dim);
+
+		if (m_BatchKinematics.get() == 0) {
+			m_BatchKinematics.reset(new KDLTreeKinematics(m_Tree));
+			m_BatchSegments.clear();
+			for (unsigned int i = 0; i < m_SegmentNames.size(); ++i)
+				m_BatchSegments.push_back(m_BatchKinematics->add_segment(m_SegmentNames[i]));
+		}
+
+		FloatVector resource_value(dim);
+		for (unsigned int i = 0; i < resource_values.cols(); ++i) {
+			resource_value = resource_values.col(i);
+			KDLTreeKinematics::Lock lock(m_BatchKinematics->mutex());
+			m_BatchKinematics->update(lock, resource_value, 0);
+			m_BatchKinematics->update_jacobian(lock, resource_value, 0);
+			store_batch_column(*m_BatchKinematics, lock, m_BatchSegments, i, results, task_jacobians);
+		}
+	}
 	
 
 	KDLTreePositionSensorTransform::KDLTreePositionSensorTransform(
@@ -185,17 +532,55 @@ namespace CBF {
 
 
 
+	KDLTreePositionSensorTransform::KDLTreePositionSensorTransform(
+		KDLTreeKinematicsPtr kinematics, 
+		std::vector<std::string> segment_names
+	) : 
+		BaseKDLTreeSensorTransform(kinematics, segment_names)
+	{
+		m_TaskDim = 3*segment_names.size();
+		m_ResourceDim = m_Tree->getNrOfJoints();
+		m_Result = FloatVector(m_TaskDim);
+		m_TaskJacobian = FloatMatrix(m_TaskDim, m_ResourceDim);
+	}
+
+
 	void KDLTreePositionSensorTransform::update(const FloatVector &resource_value) {
-		BaseKDLTreeSensorTransform::update(resource_value);
+		KDLTreeKinematics::Lock lock(m_Kinematics->mutex());
+		BaseKDLTreeSensorTransform::compute(lock, resource_value);
 
 		unsigned int total_row = 0;
 		for (unsigned int i = 0, len = m_SegmentNames.size(); i < len; ++i, total_row+=3) {
-			m_TaskJacobian.block(total_row,0, 3,resource_dim()) = m_Jacobians[i]->data.topRows<3>();
-			m_Result.segment(total_row,3) = Eigen::Map<Eigen::Vector3d>(m_Frames[i]->p.data);
+			m_Result.segment(total_row,3) = Eigen::Map<const Eigen::Vector3d>(m_Kinematics->frame(lock, m_Segments[i]).p.data);
+		}
+		defer_jacobian(resource_value);
+	}
+
+	void KDLTreePositionSensorTransform::update_jacobian(const FloatVector &resource_value) {
+		KDLTreeKinematics::Lock lock(m_Kinematics->mutex());
+		m_Kinematics->update_jacobian(lock, resource_value, m_KinematicsVersion);
+
+		unsigned int total_row = 0;
+		for (unsigned int i = 0, len = m_SegmentNames.size(); i < len; ++i, total_row+=3) {
+			m_TaskJacobian.block(total_row,0, 3,resource_dim()) = m_Kinematics->jacobian(lock, m_Segments[i]).data.topRows<3>();
 		}
 		CBF_DEBUG("TaskJacobian " << std::endl << m_TaskJacobian);
 	}
 
+	void KDLTreePositionSensorTransform::store_batch_column(
+		const KDLTreeKinematics &kinematics, 
+		const KDLTreeKinematics::Lock &lock, 
+		const std::vector<unsigned int> &segments, 
+		unsigned int i, 
+		FloatMatrix &results, 
+		FloatMatrix &task_jacobians
+	) {
+		for (unsigned int j = 0; j < segments.size(); ++j) {
+			results.block<3, 1>(3 * j, i) = Eigen::Map<const Eigen::Vector3d>(kinematics.frame(lock, segments[j]).p.data);
+			task_jacobians.block(3 * j, i * resource_dim(), 3, resource_dim()) = kinematics.jacobian(lock, segments[j]).data.topRows<3>();
+		}
+	}
+
 
 
 
@@ -212,33 +597,119 @@ namespace CBF {
 	}
 
 
+	KDLTreeAxisAngleSensorTransform::KDLTreeAxisAngleSensorTransform(
+		KDLTreeKinematicsPtr kinematics, 
+		std::vector<std::string> segment_names
+	) : 
+		BaseKDLTreeSensorTransform(kinematics, segment_names)
+	{
+		m_TaskDim = 3*segment_names.size();
+		m_ResourceDim = m_Tree->getNrOfJoints();
+		m_Result = FloatVector(m_TaskDim);
+		m_TaskJacobian = FloatMatrix(m_TaskDim, m_ResourceDim);
+	}
+
+
 	void KDLTreeAxisAngleSensorTransform::update(const FloatVector &resource_value) {
-		BaseKDLTreeSensorTransform::update(resource_value);
+		KDLTreeKinematics::Lock lock(m_Kinematics->mutex());
+		BaseKDLTreeSensorTransform::compute(lock, resource_value);
 
 		unsigned int total_row = 0;
 		for (unsigned int i = 0, len = m_SegmentNames.size(); i < len; ++i, total_row+=3) {
-			m_TaskJacobian.block(total_row,0, 3,resource_dim()) = m_Jacobians[i]->data.bottomRows<3>();
-			const KDL::Vector &axis = m_Frames[i]->M.GetRot();
+			const KDL::Vector &axis = m_Kinematics->frame(lock, m_Segments[i]).M.GetRot();
 			m_Result.segment(total_row,3) = Eigen::Map<const Eigen::Vector3d>(axis.data);
 		}
+		defer_jacobian(resource_value);
+	}
+
+	void KDLTreeAxisAngleSensorTransform::update_jacobian(const FloatVector &resource_value) {
+		KDLTreeKinematics::Lock lock(m_Kinematics->mutex());
+		m_Kinematics->update_jacobian(lock, resource_value, m_KinematicsVersion);
+
+		unsigned int total_row = 0;
+		for (unsigned int i = 0, len = m_SegmentNames.size(); i < len; ++i, total_row+=3) {
+			m_TaskJacobian.block(total_row,0, 3,resource_dim()) = m_Kinematics->jacobian(lock, m_Segments[i]).data.bottomRows<3>();
+		}
 		CBF_DEBUG("TaskJacobian: " << std::endl << m_TaskJacobian);
 	}
 
+	void KDLTreeAxisAngleSensorTransform::store_batch_column(
+		const KDLTreeKinematics &kinematics, 
+		const KDLTreeKinematics::Lock &lock, 
+		const std::vector<unsigned int> &segments, 
+		unsigned int i, 
+		FloatMatrix &results, 
+		FloatMatrix &task_jacobians
+	) {
+		for (unsigned int j = 0; j < segments.size(); ++j) {
+			const KDL::Vector &axis = kinematics.frame(lock, segments[j]).M.GetRot();
+			results.block<3, 1>(3 * j, i) = Eigen::Map<const Eigen::Vector3d>(axis.data);
+			task_jacobians.block(3 * j, i * resource_dim(), 3, resource_dim()) = kinematics.jacobian(lock, segments[j]).data.bottomRows<3>();
+		}
+	}
+
 
 
 	#ifdef CBF_HAVE_XSD
-		BaseKDLChainSensorTransform::BaseKDLChainSensorTransform(const CBFSchema::ChainBase &xml_instance, const CBFSchema::SensorTransform &xml_st_instance, ObjectNamespacePtr object_namespace) :
+		KDLChainKinematics::KDLChainKinematics(const CBFSchema::KDLChainKinematics &xml_instance, ObjectNamespacePtr object_namespace) :
+			Object(xml_instance, object_namespace)
+		{
+			m_Chain = create_chain(xml_instance.Chain(), object_namespace);
+			init_solvers();
+		}
+
+		KDLTreeKinematics::KDLTreeKinematics(const CBFSchema::KDLTreeKinematics &xml_instance, ObjectNamespacePtr object_namespace) :
+			Object(xml_instance, object_namespace)
+		{
+			m_Tree = 
+				XMLObjectFactory::instance()->create<ForeignObject<KDL::Tree> >(
+					xml_instance.Tree(), object_namespace
+				)->m_Object
+			;
+			init();
+		}
+
+		/**
+			Either the (possibly referenced) Kinematics given in the transform 
+			or one of its own over the given Chain
+		*/
+		template<class TransformType>
+		KDLChainKinematicsPtr create_chain_kinematics(const TransformType &xml_instance, ObjectNamespacePtr object_namespace) {
+			if (xml_instance.Kinematics().present())
+				return XMLObjectFactory::instance()->create<KDLChainKinematics>(*xml_instance.Kinematics(), object_namespace);
+
+			if (!xml_instance.Chain().present())
+				CBF_THROW_RUNTIME_ERROR("Neither Chain nor Kinematics given");
+
+			return KDLChainKinematicsPtr(new KDLChainKinematics(create_chain(*xml_instance.Chain(), object_namespace)));
+		}
+
+		template<class TransformType>
+		KDLTreeKinematicsPtr create_tree_kinematics(const TransformType &xml_instance, ObjectNamespacePtr object_namespace) {
+			if (xml_instance.Kinematics().present())
+				return XMLObjectFactory::instance()->create<KDLTreeKinematics>(*xml_instance.Kinematics(), object_namespace);
+
+			if (!xml_instance.Tree().present())
+				CBF_THROW_RUNTIME_ERROR("Neither Tree nor Kinematics given");
+
+			return KDLTreeKinematicsPtr(new KDLTreeKinematics(
+				XMLObjectFactory::instance()->create<ForeignObject<KDL::Tree> >(
+					*xml_instance.Tree(), object_namespace
+				)->m_Object
+			));
+		}
+
+		BaseKDLChainSensorTransform::BaseKDLChainSensorTransform(KDLChainKinematicsPtr kinematics, const CBFSchema::SensorTransform &xml_st_instance, ObjectNamespacePtr object_namespace) :
 			SensorTransform(xml_st_instance, object_namespace),
-			m_Frame(new KDL::Frame),
-			m_Jacobian(new KDL::Jacobian)
+			m_Chain(kinematics->chain()),
+			m_Kinematics(kinematics),
+			m_KinematicsVersion(0)
 		{
 			CBF_DEBUG("[KDLChainSensorTransform(const KDLChainSensorTransformType &xml_instance)]: yay!");
-			m_Chain = create_chain(xml_instance, object_namespace);		
-			init_solvers();
 		}
 		
 		KDLChainPositionSensorTransform::KDLChainPositionSensorTransform(const CBFSchema::KDLChainPositionSensorTransform &xml_instance, ObjectNamespacePtr object_namespace) :
-			BaseKDLChainSensorTransform(xml_instance.Chain(), xml_instance, object_namespace)
+			BaseKDLChainSensorTransform(create_chain_kinematics(xml_instance, object_namespace), xml_instance, object_namespace)
 		{
 			//! TODO: recheck this function to make sure it works in all cases..
 		
@@ -248,7 +719,7 @@ namespace CBF {
 		KDLChainAxisAngleSensorTransform::KDLChainAxisAngleSensorTransform(
 			const CBFSchema::KDLChainAxisAngleSensorTransform &xml_instance, ObjectNamespacePtr object_namespace
 		) :
-			BaseKDLChainSensorTransform(xml_instance.Chain(), xml_instance, object_namespace)
+			BaseKDLChainSensorTransform(create_chain_kinematics(xml_instance, object_namespace), xml_instance, object_namespace)
 		{
 			//! TODO: recheck this function to make sure it works in all cases..
 		
@@ -256,23 +727,17 @@ namespace CBF {
 		}
 
 
-		BaseKDLTreeSensorTransform::BaseKDLTreeSensorTransform(const CBFSchema::TreeBase &xml_instance, const CBFSchema::SensorTransform &xml_st_instance, ObjectNamespacePtr object_namespace) :
-			SensorTransform(xml_st_instance, object_namespace)
+		BaseKDLTreeSensorTransform::BaseKDLTreeSensorTransform(KDLTreeKinematicsPtr kinematics, const CBFSchema::SensorTransform &xml_st_instance, ObjectNamespacePtr object_namespace) :
+			SensorTransform(xml_st_instance, object_namespace),
+			m_Tree(kinematics->tree()),
+			m_Kinematics(kinematics),
+			m_KinematicsVersion(0)
 		{
 			CBF_DEBUG("[KDLTreeSensorTransform(const KDLTreeSensorTransformType &xml_instance)]: yay!");
-
-			m_Tree = 
-				XMLObjectFactory::instance()->create<ForeignObject<KDL::Tree> >(
-					xml_instance, object_namespace
-				)->m_Object
-			;
-
-			CBF_DEBUG("tree created");
-
 		}
 		
 		KDLTreePositionSensorTransform::KDLTreePositionSensorTransform(const CBFSchema::KDLTreePositionSensorTransform &xml_instance, ObjectNamespacePtr object_namespace) :
-			BaseKDLTreeSensorTransform(xml_instance.Tree(), xml_instance, object_namespace)
+			BaseKDLTreeSensorTransform(create_tree_kinematics(xml_instance, object_namespace), xml_instance, object_namespace)
 		{
 
 			for (
@@ -298,7 +763,7 @@ namespace CBF {
 		KDLTreeAxisAngleSensorTransform::KDLTreeAxisAngleSensorTransform(
 			const CBFSchema::KDLTreeAxisAngleSensorTransform &xml_instance, ObjectNamespacePtr object_namespace
 		) :
-			BaseKDLTreeSensorTransform(xml_instance.Tree(), xml_instance, object_namespace)
+			BaseKDLTreeSensorTransform(create_tree_kinematics(xml_instance, object_namespace), xml_instance, object_namespace)
 		{
 			for (
 				CBFSchema::KDLTreeAxisAngleSensorTransform::SegmentName_const_iterator it = xml_instance.SegmentName().begin();
@@ -320,6 +785,16 @@ namespace CBF {
 
 		}
 
+		static XMLDerivedFactory<
+			KDLChainKinematics, 
+			CBFSchema::KDLChainKinematics
+		> x5;
+
+		static XMLDerivedFactory<
+			KDLTreeKinematics, 
+			CBFSchema::KDLTreeKinematics
+		> x6;
+
 		static XMLDerivedFactory<
 			KDLChainPositionSensorTransform, 
 			CBFSchema::KDLChainPositionSensorTransform
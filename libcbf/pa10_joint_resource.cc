@@ -30,10 +30,12 @@ namespace CBF {
 	
 	void PA10JointResource::set(const FloatVector &in) {
 		m_CurrentPosture = in;
+		bump_version();
 	}
 	
 	void PA10JointResource::add(const FloatVector &in) {
 		m_CurrentPosture += in;
+		bump_version();
 	}
 	
 	
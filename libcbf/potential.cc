@@ -27,7 +27,8 @@ namespace CBF {
 #ifdef CBF_HAVE_XSD
 
 	Potential::Potential(const CBFSchema::Potential &xml_instance, ObjectNamespacePtr object_namespace) :
-		Object(xml_instance, object_namespace)
+		Object(xml_instance, object_namespace),
+		m_ReferencesVersion(0)
 	{
 		CBF_DEBUG("Constructor");
 		m_MaxGradientStepNorm = xml_instance.MaxGradientStepNorm();
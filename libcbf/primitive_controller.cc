@@ -26,13 +26,29 @@
 #include <cbf/exceptions.h>
 #include <cbf/xml_factory.h>
 #include <cbf/xml_object_factory.h>
+#include <cbf/utilities.h>
 
 #include <vector>
 #include <iostream>
+#include <algorithm>
 #include <cassert>
 
 
 namespace CBF {
+	namespace {
+		//! The job for the ThreadPool: update the i-th subordinate controller
+		struct SubordinateControllerUpdate : public ParallelTask {
+			SubordinateControllerUpdate(std::vector<SubordinateControllerPtr> &controllers) :
+				m_Controllers(controllers) { }
+
+			virtual void run(unsigned int index) {
+				m_Controllers[index]->update();
+			}
+
+			std::vector<SubordinateControllerPtr> &m_Controllers;
+		};
+	}
+
 	SubordinateController::SubordinateController(
 		Float alpha,
 		std::vector<ConvergenceCriterionPtr> convergence_criteria,
@@ -69,6 +85,7 @@ namespace CBF {
 		CombinationStrategyPtr combination_strategy
 	) {
 		m_Master = NULL;
+		m_NullspaceProjection = MatrixVectorProjection;
 		m_Coefficient = coefficient;
 		m_ConvergenceCriteria = convergence_criteria;
 		m_Reference = reference;
@@ -93,6 +110,7 @@ namespace CBF {
 		m_Resource = resource;
 
 		check_dimensions();
+		init_buffers();
 	}
 
 	PrimitiveController::PrimitiveController(
@@ -142,12 +160,57 @@ namespace CBF {
 		}
 	}	
 
+	void SubordinateController::init_buffers() {
+		unsigned int resource_dim = resource()->dim();
+		unsigned int task_dim = m_SensorTransform->task_dim();
+
+		m_Result = FloatVector::Zero(resource_dim);
+		m_ResourceStep = FloatVector::Zero(resource_dim);
+		m_CombinedResults = FloatVector::Zero(resource_dim);
+		m_ProjectedCombinedResults = FloatVector::Zero(resource_dim);
+		m_InvJacobianTimesJacobian = FloatMatrix::Zero(resource_dim, resource_dim);
+
+		m_CurrentTaskPosition = FloatVector::Zero(task_dim);
+		m_GradientStep = FloatVector::Zero(task_dim);
+		m_TaskSpaceCombinedResults = FloatVector::Zero(task_dim);
+		m_SingularSpaceCombinedResults = FloatVector::Zero(std::min(task_dim, resource_dim));
+
+		m_SubordinateResourceSteps.assign(
+			m_SubordinateControllers.size(), 
+			FloatVector::Zero(resource_dim)
+		);
+
+		#ifdef CBF_PROFILING
+			m_CycleTimeHistograms[UpdateCall] = cycle_time_histogram(m_Name + ".update", this);
+			m_CycleTimeHistograms[ResourceUpdateCall] = cycle_time_histogram(resource()->name() + ".update", resource().get());
+			m_CycleTimeHistograms[ReferenceUpdateCall] = cycle_time_histogram(m_Reference->name() + ".update", m_Reference.get());
+			m_CycleTimeHistograms[SensorTransformUpdateCall] = cycle_time_histogram(m_SensorTransform->name() + ".update", m_SensorTransform.get());
+			m_CycleTimeHistograms[EffectorTransformUpdateCall] = cycle_time_histogram(m_EffectorTransform->name() + ".update", m_EffectorTransform.get());
+			m_CycleTimeHistograms[PotentialGradientCall] = cycle_time_histogram(m_Potential->name() + ".gradient", m_Potential.get());
+			m_CycleTimeHistograms[EffectorTransformExecCall] = cycle_time_histogram(m_EffectorTransform->name() + ".exec", m_EffectorTransform.get());
+			m_CycleTimeHistograms[CombinationCall] = cycle_time_histogram(m_CombinationStrategy->name() + ".exec", m_CombinationStrategy.get());
+			m_CycleTimeHistograms[NullspaceProjectionCall] = cycle_time_histogram(m_Name + ".nullspace_projection", this);
+		#endif
+
+		for(std::vector<SubordinateControllerPtr>::iterator it = m_SubordinateControllers.begin(),
+		    end = m_SubordinateControllers.end(); it != end; ++it) {
+			(*it)->init_buffers();
+		}
+	}
+
+	Float SubordinateController::coefficient() {
+		return m_Coefficient;
+	}
+
 	ResourcePtr SubordinateController::resource() { 
 		return m_Master->resource(); 
 	}	
 
 	void PrimitiveController::update() {
-		m_Resource->update();
+		{
+			CBF_PROFILE_SCOPE(m_CycleTimeHistograms[ResourceUpdateCall]);
+			m_Resource->update();
+		}
 		SubordinateController::update();
 	}	
 	
@@ -161,31 +224,47 @@ namespace CBF {
 
 		assert(m_Reference->dim() == m_Potential->dim());
 
-		m_Reference->update();
+		CBF_PROFILE_SCOPE(m_CycleTimeHistograms[UpdateCall]);
 
-		m_References = m_Reference->get();
+		{
+			CBF_PROFILE_SCOPE(m_CycleTimeHistograms[ReferenceUpdateCall]);
+			m_Reference->update();
+		}
+
+		//! No copy here, the references stay owned by the Reference
+		const std::vector<FloatVector> &references = m_Reference->get();
 
 		//! Fill vector with data from sensor transform
-		m_SensorTransform->update(resource()->get());
+		{
+			CBF_PROFILE_SCOPE(m_CycleTimeHistograms[SensorTransformUpdateCall]);
+			m_SensorTransform->update_if_changed(resource()->get(), resource()->version());
+		}
 		CBF_DEBUG("jacobian: " << std::endl << m_SensorTransform->task_jacobian());
 
-		m_EffectorTransform->update(resource()->get(), m_SensorTransform->task_jacobian());
+		{
+			CBF_PROFILE_SCOPE(m_CycleTimeHistograms[EffectorTransformUpdateCall]);
+			m_EffectorTransform->update(resource()->get(), m_SensorTransform->task_jacobian());
+		}
 		CBF_DEBUG("inv. jacobian: " << std::endl << m_EffectorTransform->inverse_task_jacobian());
 	
 		m_CurrentTaskPosition = m_SensorTransform->result();
 		CBF_DEBUG("currentTaskPosition: " << m_CurrentTaskPosition.transpose());
 	
-		if (m_References.size() != 0) {	
+		if (references.size() != 0) {	
 			CBF_DEBUG("have reference!");
 			//! then we do the gradient step
-			m_Potential->gradient(m_GradientStep, m_References, m_CurrentTaskPosition);
+			{
+				CBF_PROFILE_SCOPE(m_CycleTimeHistograms[PotentialGradientCall]);
+				m_Potential->gradient_for_version(m_GradientStep, references, m_CurrentTaskPosition, m_Reference->version());
+			}
 			CBF_DEBUG("gradientStep: " << m_GradientStep.transpose());
  
 			//! Map gradient step into resource step via exec:
 			CBF_DEBUG("calling m_EffectorTransform->exec(): Type is: " << CBF_UNMANGLE(*m_EffectorTransform.get()));
+			CBF_PROFILE_SCOPE(m_CycleTimeHistograms[EffectorTransformExecCall]);
 			m_EffectorTransform->exec(m_GradientStep, m_ResourceStep);
 		} else {
-			m_ResourceStep = FloatVector::Zero(resource()->dim());
+			m_ResourceStep.setZero(resource()->dim());
 		}
 	
 		CBF_DEBUG("resourceStep: " << m_ResourceStep.transpose());
@@ -194,29 +273,69 @@ namespace CBF {
 		//! effector transformed gradient steps.
 		m_SubordinateResourceSteps.resize(m_SubordinateControllers.size());
 	
-		for (unsigned int i = 0; i < m_SubordinateControllers.size(); ++i) {
-			m_SubordinateControllers[i]->update();
-			m_SubordinateResourceSteps[i] = m_SubordinateControllers[i]->result();
-		}
+		update_subordinate_controllers();
 	
-		m_CombinedResults = FloatVector::Zero(resource()->dim());
+		m_CombinedResults.setZero(resource()->dim());
 	
-		m_CombinationStrategy->exec(m_CombinedResults, m_SubordinateResourceSteps);
+		{
+			CBF_PROFILE_SCOPE(m_CycleTimeHistograms[CombinationCall]);
+			m_CombinationStrategy->exec(m_CombinedResults, m_SubordinateResourceSteps);
+		}
 	
 		//! finally the results of all subordinate controllers are projected
 		//! into our nullspace.For this we need the task jacobian and its inverse. 
 		//! We get these from the effector transforms.
-		m_InvJacobianTimesJacobian = m_EffectorTransform->inverse_task_jacobian()
-				* m_SensorTransform->task_jacobian();
-	
-		//! The projector is (1 - J# J), so this is result = result - (J# J result)
-		//! which can be expressed as result -= ...
-		m_CombinedResults -= m_InvJacobianTimesJacobian * m_CombinedResults;
+		const FloatMatrix &task_jacobian = m_SensorTransform->task_jacobian();
+		const FloatMatrix &inverse_task_jacobian = m_EffectorTransform->inverse_task_jacobian();
+
+		{
+			CBF_PROFILE_SCOPE(m_CycleTimeHistograms[NullspaceProjectionCall]);
+
+			//! The projector is (1 - J# J), so this is result = result - (J# J result)
+			//! which can be expressed as result -= ...
+			const PseudoInverseWorkspace *decomposition = 0;
+			if (m_NullspaceProjection == DecompositionProjection)
+				decomposition = m_EffectorTransform->decomposition();
+
+			if (decomposition) {
+				//! J# J = V diag(s) diag(s#) V^T, as U^T U = 1 for the thin U
+				m_SingularSpaceCombinedResults.noalias() = 
+					decomposition->matrix_v().transpose() * m_CombinedResults;
+				m_SingularSpaceCombinedResults.array() *= 
+					decomposition->singular_values().array() 
+					* decomposition->inverse_singular_values().array();
+				m_ProjectedCombinedResults.noalias() = 
+					decomposition->matrix_v() * m_SingularSpaceCombinedResults;
+			} else if (m_NullspaceProjection == ExplicitProjector) {
+				m_InvJacobianTimesJacobian.noalias() = inverse_task_jacobian * task_jacobian;
+				m_ProjectedCombinedResults.noalias() = m_InvJacobianTimesJacobian * m_CombinedResults;
+			} else {
+				//! J# (J result) never forms the resource_dim x resource_dim matrix
+				m_TaskSpaceCombinedResults.noalias() = task_jacobian * m_CombinedResults;
+				m_ProjectedCombinedResults.noalias() = inverse_task_jacobian * m_TaskSpaceCombinedResults;
+			}
+			m_CombinedResults -= m_ProjectedCombinedResults;
+		}
 		CBF_DEBUG("resourceStep(NS): " << m_CombinedResults.transpose());
 	
 		m_Result = (m_ResourceStep * m_Coefficient) + m_CombinedResults;
 	}
 	
+	void SubordinateController::update_subordinate_controllers() {
+		if (m_ThreadPool.get() != 0) {
+			SubordinateControllerUpdate task(m_SubordinateControllers);
+			m_ThreadPool->run(task, m_SubordinateControllers.size());
+		} else {
+			for (unsigned int i = 0; i < m_SubordinateControllers.size(); ++i)
+				m_SubordinateControllers[i]->update();
+		}
+
+		//! Gathered in a fixed order, so the combination does not depend on
+		//! the order the subordinate controllers finished in
+		for (unsigned int i = 0; i < m_SubordinateControllers.size(); ++i)
+			m_SubordinateResourceSteps[i] = m_SubordinateControllers[i]->result();
+	}
+
 	bool PrimitiveController::step() {
 		update();
 		action();
@@ -335,6 +454,22 @@ namespace CBF {
 				subordinate_controllers,
 				combination_strategy
 			);
+
+			if (xml_instance.NullspaceProjection().present()) {
+				const std::string &projection = *xml_instance.NullspaceProjection();
+
+				if (projection == "ExplicitProjector")
+					m_NullspaceProjection = ExplicitProjector;
+				else if (projection == "MatrixVectorProjection")
+					m_NullspaceProjection = MatrixVectorProjection;
+				else if (projection == "DecompositionProjection")
+					m_NullspaceProjection = DecompositionProjection;
+				else
+					CBF_THROW_RUNTIME_ERROR(m_Name << ": Unknown nullspace projection: " << projection);
+			}
+
+			if (xml_instance.SubordinateThreads().present() && *xml_instance.SubordinateThreads() > 1)
+				m_ThreadPool = ThreadPoolPtr(new ThreadPool(*xml_instance.SubordinateThreads() - 1));
 		}
 
 		PrimitiveController::PrimitiveController(const CBFSchema::PrimitiveController &xml_instance, ObjectNamespacePtr object_namespace) :
@@ -345,7 +480,7 @@ namespace CBF {
 		}
 
 
-		static XMLDerivedFactory<PrimitiveController, ::CBFSchema::PrimitiveController> x;
+		//! PrimitiveControllers are created by the factory in primitive_controller_n.cc
 		static XMLDerivedFactory<SubordinateController, ::CBFSchema::SubordinateController> x2;
 		
 	#endif
@@ -0,0 +1,124 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#include <cbf/primitive_controller_n.h>
+#include <cbf/generic_transform.h>
+#include <cbf/debug_macros.h>
+#include <cbf/xml_object_factory.h>
+
+#include <typeinfo>
+
+namespace CBF {
+
+	template struct GenericEffectorTransformN<3, 6>;
+	template struct GenericEffectorTransformN<3, 7>;
+	template struct GenericEffectorTransformN<6, 6>;
+	template struct GenericEffectorTransformN<6, 7>;
+
+	template struct PrimitiveControllerN<3, 6>;
+	template struct PrimitiveControllerN<3, 7>;
+	template struct PrimitiveControllerN<6, 6>;
+	template struct PrimitiveControllerN<6, 7>;
+
+	/**
+		Creates the fixed size controller if the dimensions match, 
+		otherwise returns a null pointer
+	*/
+	template <int TaskDim, int ResourceDim>
+	static PrimitiveControllerPtr try_fixed_size_controller(PrimitiveControllerPtr controller) {
+		if (
+			controller->sensor_transform()->task_dim() != TaskDim || 
+			controller->resource()->dim() != ResourceDim
+		) return PrimitiveControllerPtr();
+
+		EffectorTransformPtr effector_transform;
+		EffectorTransform &e = *controller->effector_transform();
+
+		//! Only the default JacobiSVD solver has a fixed size equivalent
+		if (
+			typeid(e) == typeid(GenericEffectorTransform) &&
+			static_cast<GenericEffectorTransform&>(e).solver() == JacobiSVDSolver
+		) {
+			effector_transform = EffectorTransformPtr(
+				new GenericEffectorTransformN<TaskDim, ResourceDim>());
+		}
+
+		if (
+			typeid(e) == typeid(DampedGenericEffectorTransform) &&
+			static_cast<DampedGenericEffectorTransform&>(e).solver() == JacobiSVDSolver
+		) {
+			effector_transform = EffectorTransformPtr(
+				new GenericEffectorTransformN<TaskDim, ResourceDim>(
+					static_cast<DampedGenericEffectorTransform&>(e).getDampingConstant()));
+		}
+
+		CBF_DEBUG("using PrimitiveControllerN<" << TaskDim << ", " << ResourceDim << ">");
+		return PrimitiveControllerPtr(
+			new PrimitiveControllerN<TaskDim, ResourceDim>(*controller, effector_transform));
+	}
+
+	PrimitiveControllerPtr make_fixed_size_controller(PrimitiveControllerPtr controller) {
+		PrimitiveControllerPtr p;
+
+		if ((p = try_fixed_size_controller<3, 6>(controller)).get()) return p;
+		if ((p = try_fixed_size_controller<3, 7>(controller)).get()) return p;
+		if ((p = try_fixed_size_controller<6, 6>(controller)).get()) return p;
+		if ((p = try_fixed_size_controller<6, 7>(controller)).get()) return p;
+
+		return controller;
+	}
+
+	#ifdef CBF_HAVE_XSD
+		/**
+			@brief Creates PrimitiveControllers from CBFSchema::PrimitiveController 
+			instances, picking a precompiled PrimitiveControllerN specialization 
+			when FixedSize is set and the dimensions match
+		*/
+		struct PrimitiveControllerFactory : public XMLDerivedFactoryBase {
+			PrimitiveControllerFactory() {
+				XMLObjectFactory::instance()->m_DerivedFactories[
+					std::string(typeid(CBFSchema::PrimitiveController).name())
+				] = this; 
+			}
+
+			virtual boost::shared_ptr<Object> create(
+				const CBFSchema::Object &xml_instance, 
+				ObjectNamespacePtr object_namespace
+			) {
+				const CBFSchema::PrimitiveController* r = 
+					dynamic_cast<const CBFSchema::PrimitiveController*>(&xml_instance);
+
+				if (!r) 
+					return boost::shared_ptr<Object>();
+
+				PrimitiveControllerPtr p(new PrimitiveController(*r, object_namespace));
+
+				if (r->FixedSize().present() && *r->FixedSize())
+					p = make_fixed_size_controller(p);
+
+				object_namespace->register_object(p->name(), p);
+				return p;
+			}
+		};
+
+		static PrimitiveControllerFactory x;
+	#endif
+} // namespace
+
@@ -30,7 +30,8 @@ namespace CBF {
 		PrimitiveControllerResource::PrimitiveControllerResource(
 			const CBFSchema::PrimitiveControllerResource &xml_instance,
 			ObjectNamespacePtr object_namespace) :
-			Resource(xml_instance, object_namespace)
+			Resource(xml_instance, object_namespace),
+			m_ControlledVersion(0)
 		{
 			m_PrimitiveController = XMLObjectFactory::instance()->create<PrimitiveController>
 				(xml_instance.PrimitiveController(), object_namespace);
@@ -0,0 +1,185 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#include <cbf/profiling.h>
+
+#include <boost/thread/mutex.hpp>
+
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+namespace CBF {
+
+namespace {
+	inline unsigned long long load(const unsigned long long &value) {
+		return __atomic_load_n(&value, __ATOMIC_RELAXED);
+	}
+
+	inline void store(unsigned long long &value, unsigned long long new_value) {
+		__atomic_store_n(&value, new_value, __ATOMIC_RELAXED);
+	}
+}
+
+CycleTimeHistogram &CycleTimeHistogram::operator=(const CycleTimeHistogram &other) {
+	for (unsigned int i = 0; i < Buckets; ++i)
+		store(m_Counts[i], load(other.m_Counts[i]));
+
+	store(m_Samples, load(other.m_Samples));
+	store(m_Total, load(other.m_Total));
+	store(m_Min, load(other.m_Min));
+	store(m_Max, load(other.m_Max));
+	return *this;
+}
+
+void CycleTimeHistogram::record(unsigned long long nanoseconds) {
+	unsigned int bucket = 0;
+	while (bucket + 1 < Buckets && (nanoseconds >> (bucket + 1)) != 0)
+		++bucket;
+
+	__atomic_add_fetch(&m_Counts[bucket], 1, __ATOMIC_RELAXED);
+
+	//! Retries only if another thread changed the bound in between
+	unsigned long long min = load(m_Min);
+	while (nanoseconds < min && !__atomic_compare_exchange_n(&m_Min, &min, nanoseconds, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) { }
+
+	unsigned long long max = load(m_Max);
+	while (nanoseconds > max && !__atomic_compare_exchange_n(&m_Max, &max, nanoseconds, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) { }
+
+	__atomic_add_fetch(&m_Total, nanoseconds, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&m_Samples, 1, __ATOMIC_RELAXED);
+}
+
+void CycleTimeHistogram::reset() {
+	for (unsigned int i = 0; i < Buckets; ++i)
+		store(m_Counts[i], 0);
+
+	store(m_Samples, 0);
+	store(m_Total, 0);
+
+	//! So that the first sample is both
+	store(m_Min, ~0ULL);
+	store(m_Max, 0);
+}
+
+double CycleTimeHistogram::mean() const {
+	const unsigned long long samples = load(m_Samples);
+	return samples ? (double)load(m_Total) / samples : 0;
+}
+
+double CycleTimeHistogram::quantile(double q) const {
+	const unsigned long long samples = load(m_Samples);
+	if (samples == 0) return 0;
+
+	const double max = load(m_Max);
+	unsigned long long seen = 0;
+	for (unsigned int i = 0; i < Buckets; ++i) {
+		seen += load(m_Counts[i]);
+		if (seen >= q * samples) {
+			//! The bucket bound can overshoot the largest sample actually seen
+			double bound = (double)(2ULL << i);
+			return bound < max ? bound : max;
+		}
+	}
+	return max;
+}
+
+namespace {
+	struct HistogramRegistry {
+		boost::mutex m_Mutex;
+
+		//! By the names they are listed under
+		std::map<std::string, CycleTimeHistogram> m_Histograms;
+
+		//! Those with an owner, by name and owner
+		std::map<std::pair<std::string, const void*>, CycleTimeHistogram*> m_Owned;
+
+		//! The number of owners of each name
+		std::map<std::string, unsigned int> m_Owners;
+	};
+
+	//! A function local static, so histograms can be looked up during static initialization
+	HistogramRegistry &histogram_registry() {
+		static HistogramRegistry registry;
+		return registry;
+	}
+}
+
+CycleTimeHistogram *cycle_time_histogram(const std::string &name, const void *owner) {
+	HistogramRegistry &registry = histogram_registry();
+	boost::mutex::scoped_lock lock(registry.m_Mutex);
+
+	//! std::map never moves its elements, so the pointers stay valid
+	if (owner == 0)
+		return &registry.m_Histograms[name];
+
+	CycleTimeHistogram *&histogram = registry.m_Owned[std::make_pair(name, owner)];
+	if (histogram) 
+		return histogram;
+
+	std::stringstream listed_name;
+	listed_name << name;
+
+	const unsigned int owners = ++registry.m_Owners[name];
+	if (owners > 1)
+		listed_name << "#" << owners;
+
+	return histogram = &registry.m_Histograms[listed_name.str()];
+}
+
+std::map<std::string, CycleTimeHistogram> cycle_time_histograms() {
+	HistogramRegistry &registry = histogram_registry();
+	boost::mutex::scoped_lock lock(registry.m_Mutex);
+	return registry.m_Histograms;
+}
+
+void reset_cycle_time_histograms() {
+	HistogramRegistry &registry = histogram_registry();
+	boost::mutex::scoped_lock lock(registry.m_Mutex);
+
+	std::map<std::string, CycleTimeHistogram> &histograms = registry.m_Histograms;
+	for (std::map<std::string, CycleTimeHistogram>::iterator it = histograms.begin(); it != histograms.end(); ++it)
+		it->second.reset();
+}
+
+void print_cycle_time_histograms(std::ostream &out) {
+	//! A snapshot, so the output is not written with the registry locked
+	const std::map<std::string, CycleTimeHistogram> registry = cycle_time_histograms();
+
+	out << std::setw(48) << std::left << "node" << std::right
+		<< std::setw(12) << "samples"
+		<< std::setw(12) << "mean/us"
+		<< std::setw(12) << "median/us"
+		<< std::setw(12) << "p99/us"
+		<< std::setw(12) << "max/us" << std::endl;
+
+	for (std::map<std::string, CycleTimeHistogram>::const_iterator it = registry.begin(); it != registry.end(); ++it) {
+		const CycleTimeHistogram &h = it->second;
+		if (h.samples() == 0) continue;
+
+		out << std::setw(48) << std::left << it->first << std::right
+			<< std::setw(12) << h.samples()
+			<< std::setw(12) << 1e-3 * h.mean()
+			<< std::setw(12) << 1e-3 * h.quantile(0.5)
+			<< std::setw(12) << 1e-3 * h.quantile(0.99)
+			<< std::setw(12) << 1e-3 * h.max() << std::endl;
+	}
+}
+
+} // namespace
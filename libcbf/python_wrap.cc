@@ -21,6 +21,7 @@
 #include <cbf/python_wrap.h>
 #include <cbf/debug_macros.h>
 #include <cbf/xml_object_factory.h>
+#include <cbf/exceptions.h>
 
 #include <string>
 
@@ -52,14 +53,44 @@ namespace CBF {
 		}
 	}
 	
+	//! Holds the GIL during its lifetime
+	struct PythonLock {
+		PyGILState_STATE m_State;
+	
+		PythonLock() : m_State(PyGILState_Ensure()) { }
+	
+		~PythonLock() { PyGILState_Release(m_State); }
+	};
+	
 	struct Helper {
 		bp::object m_MainModule;
 	
-		Helper() {
+		//! numpy.frombuffer, None if NumPy is not available
+		bp::object m_FromBuffer;
+		bool m_NumPyChecked;
+	
+		Helper() : m_NumPyChecked(false) {
+			//! Loaded into a running interpreter, which owns the GIL
+			if (Py_IsInitialized()) {
+				PythonLock lock;
+				m_MainModule = main_module();
+				return;
+			}
+	
 			CBF_DEBUG("Py_Initialize");
 			Py_InitializeEx(0);
+	#if PY_VERSION_HEX < 0x03070000
+			PyEval_InitThreads();
+	#endif
+	
+			m_MainModule = main_module();
+	
+			//! The scripts take the GIL only while they run, see PythonLock
+			PyEval_SaveThread();
+		}
 	
-			m_MainModule = bp::object((
+		static bp::object main_module() {
+			return bp::object((
 				bp::handle<>(
 					bp::borrowed(PyImport_AddModule("__main__"))
 				)
@@ -76,7 +107,122 @@ namespace CBF {
 		static Helper m_Helper;
 	};
 	
-	Helper PythonInterpreter::m_Helper = Helper();
+	Helper PythonInterpreter::m_Helper;
+	
+	//! The scripts hold Python objects, so they need the GIL to be destroyed
+	struct PythonScriptDeleter {
+		template <class T> void operator()(T *script) const {
+			PythonLock lock;
+			delete script;
+		}
+	};
+	
+	/**
+		A rows x cols (or just rows long if cols is 0) NumPy array of 
+		doubles using the memory at data. Without NumPy this is a 
+		memoryview cast to doubles instead.
+	*/
+	bp::object array_view(Float *data, unsigned int rows, unsigned int cols = 0) {
+		Helper &helper = PythonInterpreter::m_Helper;
+		if (!helper.m_NumPyChecked) {
+			helper.m_NumPyChecked = true;
+			try {
+				helper.m_FromBuffer = bp::import("numpy").attr("frombuffer");
+			} catch (bp::error_already_set &) {
+				CBF_DEBUG("NumPy not available, using memoryviews");
+				PyErr_Clear();
+			}
+		}
+	
+		const Py_ssize_t size = rows * (cols ? cols : 1) * sizeof(Float);
+	#if PY_MAJOR_VERSION >= 3
+		bp::object buffer((bp::handle<>(
+			PyMemoryView_FromMemory(reinterpret_cast<char*>(data), size, PyBUF_WRITE)
+		)));
+	#else
+		bp::object buffer((bp::handle<>(PyBuffer_FromReadWriteMemory(data, size))));
+	#endif
+	
+		if (helper.m_FromBuffer.ptr() != Py_None) {
+			bp::object array = helper.m_FromBuffer(buffer, "d");
+			if (cols)
+				return array.attr("reshape")(rows, cols);
+			return array;
+		}
+	
+	#if PY_MAJOR_VERSION >= 3
+		if (cols)
+			return buffer.attr("cast")("d", bp::make_tuple(rows, cols));
+		return buffer.attr("cast")("d");
+	#else
+		CBF_THROW_RUNTIME_ERROR("The Python wrappers need NumPy with Python 2");
+	#endif
+	}
+	
+	//! Copies the numbers of a sequence a script assigned instead of writing the array
+	void copy_sequence(const bp::object &sequence, Float *data, unsigned int size) {
+		if (bp::len(sequence) != size)
+			CBF_THROW_RUNTIME_ERROR("Script result has " << bp::len(sequence) << " elements instead of " << size);
+	
+		for (unsigned int i = 0; i < size; ++i)
+			data[i] = bp::extract<Float>(sequence[i]);
+	}
+	
+	/**
+		The compiled ExecScript and the namespace it runs in. The InitScript
+		runs once in that namespace when the script is compiled.
+	*/
+	struct PythonScript {
+		std::string m_Source;
+		bp::object m_Code;
+		bp::dict m_Namespace;
+	
+		PythonScript(const std::string &init_script, const std::string &exec_script) :
+			m_Source(exec_script)
+		{
+			m_Namespace["__builtins__"] = bp::object(bp::handle<>(bp::borrowed(PyEval_GetBuiltins())));
+	
+			if (!init_script.empty())
+				run(compile(init_script, "InitScript"));
+	
+			m_Code = compile(exec_script, "ExecScript");
+		}
+	
+		static bp::object compile(const std::string &script, const char *name) {
+			return bp::object(bp::handle<>(Py_CompileString(script.c_str(), name, Py_file_input)));
+		}
+	
+		void run(const bp::object &code) {
+	#if PY_MAJOR_VERSION >= 3
+			PyObject *code_object = code.ptr();
+	#else
+			PyCodeObject *code_object = reinterpret_cast<PyCodeObject*>(code.ptr());
+	#endif
+			bp::handle<> ignored((PyEval_EvalCode(
+				code_object,
+				m_Namespace.ptr(),
+				m_Namespace.ptr())
+			));
+		}
+	};
+	
+	struct PythonPotentialScript : public PythonScript {
+		PythonPotentialScript(const std::string &init_script, const std::string &exec_script) :
+			PythonScript(init_script, exec_script) { }
+	
+		bp::list m_References;
+		bp::object m_Input;
+		bp::object m_Result;
+	};
+	
+	struct PythonSensorTransformScript : public PythonScript {
+		PythonSensorTransformScript(const std::string &init_script, const std::string &exec_script) :
+			PythonScript(init_script, exec_script) { }
+	
+		bp::object m_Resource;
+		bp::object m_Result;
+		bp::object m_Jacobian;
+	};
 	
 	PythonPotential::PythonPotential(unsigned int dim) :
 		m_Interpreter(PythonInterpreter()),
@@ -93,48 +239,53 @@ namespace CBF {
 		const std::vector<FloatVector > &references, 
 		const FloatVector &input
 	) {
+		PythonLock lock;
+	
 		try {
+			//! Compile the script on the first call and whenever it was changed
+			if (m_Script.get() == 0 || m_Script->m_Source != m_ExecScript)
+				m_Script.reset(new PythonPotentialScript(m_InitScript, m_ExecScript), PythonScriptDeleter());
 	
-			//! Get access to main context...
-			bp::object main_namespace = m_Interpreter.m_Helper.m_MainModule.attr("__dict__");
-		
-			//! Setup references...
-			CBF_DEBUG("references[0]: " << references[0]);
-			bp::list refs;
-			for (unsigned int i = 0; i < references.size(); ++i) {
-				bp::list ref;
-				for (unsigned int j = 0; j < references[i].size(); ++j)
-					ref.append(references[i][j]);
-				refs.append(ref);
+			PythonPotentialScript &script = *m_Script;
+	
+			//! The arrays view m_Input, m_Gradient and m_References, so they are only rebuilt when these are resized
+			if (script.m_Input.ptr() == Py_None || m_Input.size() != input.size()) {
+				m_Input.resize(input.size());
+				m_Gradient = FloatVector::Zero(input.size());
+				script.m_Input = array_view(m_Input.data(), m_Input.size());
+				script.m_Result = array_view(m_Gradient.data(), m_Gradient.size());
 			}
-		
-			main_namespace["references"] = refs;
-		
-			//! Setup input...
-			bp::list in;
-			for (unsigned int j = 0; j < input.size(); ++j)
-				in.append(input[j]);
-		
-			main_namespace["input"] = in;
-	
-			//! Call script...
-			//CBF_DEBUG(m_ExecScript);
-			bp::handle<> ignored((PyRun_String(
-				m_ExecScript.c_str(),
-				Py_file_input,
-				main_namespace.ptr(),
-				main_namespace.ptr())
-			));
+			m_Input = input;
 	
-			//! Extract output...
-			CBF_DEBUG("Extracting result");
-			bp::list res = bp::extract<bp::list>(main_namespace["result"]);
-		
-			result = CBF::FloatVector(input.size());
-		
-			for (unsigned int j = 0; j < input.size(); ++j)
-				result[j] = bp::extract<float>(res[j]);
-		
+			bool resized = ((unsigned int) bp::len(script.m_References) != references.size());
+			for (unsigned int i = 0; !resized && i < references.size(); ++i)
+				resized = (m_References[i].size() != references[i].size());
+	
+			if (resized) {
+				m_References = references;
+				script.m_References = bp::list();
+				for (unsigned int i = 0; i < m_References.size(); ++i)
+					script.m_References.append(array_view(m_References[i].data(), m_References[i].size()));
+			} else {
+				for (unsigned int i = 0; i < references.size(); ++i)
+					m_References[i] = references[i];
+			}
+	
+			//! The last call's script might have rebound the names
+			bp::dict &ns = script.m_Namespace;
+			ns["references"] = script.m_References;
+			ns["input"] = script.m_Input;
+			ns["result"] = script.m_Result;
+	
+			script.run(script.m_Code);
+	
+			bp::object res = ns["result"];
+			if (res.ptr() != script.m_Result.ptr()) {
+				CBF_DEBUG("Extracting result");
+				copy_sequence(res, m_Gradient.data(), m_Gradient.size());
+			}
+	
+			result = m_Gradient;
 			CBF_DEBUG("Result: " << result);
 		}
 		catch(...) {
@@ -159,49 +310,54 @@ namespace CBF {
 	}
 	
 	void PythonSensorTransform::update(const FloatVector &resource_value) {
+		if ((unsigned int) resource_value.size() != resource_dim())
+			CBF_THROW_RUNTIME_ERROR("Resource value has size " << resource_value.size() << " instead of " << resource_dim());
+	
+		//! Same size, so "resource" keeps viewing the right memory
 		m_ResourceValue = resource_value;
+	
+		PythonLock lock;
+	
 		try {
-			//! Get access to main context...
-			bp::object main_namespace = m_Interpreter.m_Helper.m_MainModule.attr("__dict__");
-		
-			//! Setup references...
-			CBF_DEBUG("resource value: " << m_ResourceValue);
-			bp::list res;
-			for (unsigned int i = 0; i < m_ResourceValue.size(); ++i) {
-				res.append(m_ResourceValue[i]);
+			//! Compile the script on the first call and whenever it was changed
+			if (m_Script.get() == 0 || m_Script->m_Source != m_ExecScript)
+				m_Script.reset(new PythonSensorTransformScript(m_InitScript, m_ExecScript), PythonScriptDeleter());
+	
+			PythonSensorTransformScript &script = *m_Script;
+	
+			if (script.m_Resource.ptr() == Py_None) {
+				m_Jacobian.resize(task_dim(), resource_dim());
+				script.m_Resource = array_view(m_ResourceValue.data(), resource_dim());
+				script.m_Result = array_view(m_Result.data(), task_dim());
+				script.m_Jacobian = array_view(m_Jacobian.data(), task_dim(), resource_dim());
 			}
-		
-			main_namespace["resource"] = res;
-		
-			//! Call script...
-			//CBF_DEBUG(m_ExecScript);
-			bp::handle<> ignored((PyRun_String(
-				m_ExecScript.c_str(),
-				Py_file_input,
-				main_namespace.ptr(),
-				main_namespace.ptr())
-			));
 	
-			//! Extract output...
-			CBF_DEBUG("Extracting result");
-			bp::list result = bp::extract<bp::list>(main_namespace["result"]);
-			assert(len(result) == task_dim());
-
-			for (unsigned int j = 0; j < task_dim(); ++j)
-				m_Result[j] = bp::extract<float>(result[j]);
-		
-			CBF_DEBUG("Extracting jacobian");
-			bp::list jacobian = bp::extract<bp::list>(main_namespace["jacobian"]);
-			assert(len(jacobian) == task_dim());
-			for (unsigned int i = 0; i < task_dim(); ++i) {
-				bp::list jac_row = bp::extract<bp::list>(jacobian[i]);
-				assert(len(jac_row) == resource_dim());
-	
-				for (unsigned int j = 0; j < resource_dim(); ++j) {
-					m_TaskJacobian(i,j) = bp::extract<float>(jac_row[j]);
-				}
+			//! The last call's script might have rebound the names
+			bp::dict &ns = script.m_Namespace;
+			ns["resource"] = script.m_Resource;
+			ns["result"] = script.m_Result;
+			ns["jacobian"] = script.m_Jacobian;
+	
+			script.run(script.m_Code);
+	
+			bp::object result = ns["result"];
+			if (result.ptr() != script.m_Result.ptr()) {
+				CBF_DEBUG("Extracting result");
+				copy_sequence(result, m_Result.data(), task_dim());
 			}
 	
+			bp::object jacobian = ns["jacobian"];
+			if (jacobian.ptr() != script.m_Jacobian.ptr()) {
+				CBF_DEBUG("Extracting jacobian");
+				if (bp::len(jacobian) != task_dim())
+					CBF_THROW_RUNTIME_ERROR("Script jacobian has " << bp::len(jacobian) << " rows instead of " << task_dim());
+	
+				for (unsigned int i = 0; i < task_dim(); ++i)
+					copy_sequence(jacobian[i], m_Jacobian.row(i).data(), resource_dim());
+			}
+	
+			m_TaskJacobian = m_Jacobian;
+	
 			CBF_DEBUG("m_Result: " << m_Result);
 			CBF_DEBUG("m_Jacobian: " << m_TaskJacobian);
 		}
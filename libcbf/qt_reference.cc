@@ -5,7 +5,8 @@ namespace CBF {
 
 #ifdef CBF_HAVE_XSD 
 	QtReference::QtReference(const CBFSchema::QtReference &xml_instance, ObjectNamespacePtr object_namespace) :
-		Reference(xml_instance, object_namespace)
+		ChannelReference(xml_instance, object_namespace, xml_instance.Control().size()),
+		m_Poller(this)
 	{
 		std::vector<Control> controls;
 		for(
@@ -24,9 +24,19 @@
 #include <cbf/xml_factory.h>
 
 namespace CBF {
+	namespace {
+		unsigned long last_version = 0;
+	}
+
+	void Reference::bump_version() {
+		//! Called in the control loop, so without taking a lock
+		__atomic_store_n(&m_Version, __atomic_add_fetch(&last_version, 1, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+	}
+
 #ifdef CBF_HAVE_XSD
 		Reference::Reference(const CBFSchema::Reference &xml_instance, ObjectNamespacePtr object_namespace) :
-			Object(xml_instance, object_namespace) 
+			Object(xml_instance, object_namespace),
+			m_Version(0)
 		{
 
 		}
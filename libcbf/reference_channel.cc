@@ -0,0 +1,107 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#include <cbf/reference_channel.h>
+#include <cbf/exceptions.h>
+#include <cbf/debug_macros.h>
+
+namespace CBF {
+
+	ReferenceChannel::ReferenceChannel(unsigned int dim) :
+		m_Dim(dim),
+		m_Back(0),
+		m_Front(1),
+		m_Middle(2)
+	{
+		for (unsigned int i = 0; i < 3; ++i) {
+			m_Values[i] = FloatVector::Zero(dim);
+			m_Valid[i] = false;
+		}
+	}
+
+	void ReferenceChannel::swap_back() {
+		//! Release the value written to the back buffer, acquire the one the consumer let go of
+		const unsigned int middle = __atomic_exchange_n(&m_Middle, m_Back | Fresh, __ATOMIC_ACQ_REL);
+		m_Back = middle & IndexMask;
+	}
+
+	void ReferenceChannel::publish() {
+		m_Valid[m_Back] = true;
+		swap_back();
+	}
+
+	void ReferenceChannel::publish(const FloatVector &value) {
+		if (value.size() != m_Dim)
+			CBF_THROW_RUNTIME_ERROR("Reference of dimension " << value.size() << " instead of " << m_Dim);
+
+		m_Values[m_Back] = value;
+		publish();
+	}
+
+	void ReferenceChannel::withdraw() {
+		m_Valid[m_Back] = false;
+		swap_back();
+	}
+
+	bool ReferenceChannel::fetch() {
+		if (!(__atomic_load_n(&m_Middle, __ATOMIC_RELAXED) & Fresh))
+			return false;
+
+		//! Only the consumer clears Fresh, so the value taken is a new one
+		const unsigned int middle = __atomic_exchange_n(&m_Middle, m_Front, __ATOMIC_ACQ_REL);
+		m_Front = middle & IndexMask;
+		return true;
+	}
+
+
+	ChannelReference::ChannelReference(unsigned int dim) :
+		m_Channel(dim),
+		m_HasReference(false)
+	{
+		m_References.assign(1, FloatVector::Zero(dim));
+	}
+
+	void ChannelReference::update() {
+		if (!m_Channel.fetch())
+			return;
+
+		m_HasReference = m_Channel.valid();
+		if (m_HasReference) {
+			m_References[0] = m_Channel.value();
+			CBF_DEBUG("new reference: " << m_References[0].transpose());
+		}
+
+		bump_version();
+	}
+
+	#ifdef CBF_HAVE_XSD
+		ChannelReference::ChannelReference(
+			const CBFSchema::Reference &xml_instance,
+			ObjectNamespacePtr object_namespace,
+			unsigned int dim
+		) :
+			Reference(xml_instance, object_namespace),
+			m_Channel(dim),
+			m_HasReference(false)
+		{
+			m_References.assign(1, FloatVector::Zero(dim));
+		}
+	#endif
+
+} // namespace
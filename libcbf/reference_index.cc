@@ -0,0 +1,229 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#include <cbf/reference_index.h>
+#include <cbf/quaternion.h>
+#include <cbf/exceptions.h>
+#include <cbf/debug_macros.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace CBF {
+
+	namespace {
+		//! Leaves are scanned linearly
+		const unsigned int leaf_size = 8;
+
+		//! Enough for any tree of median split nodes
+		const unsigned int max_depth = 64;
+
+		struct AxisLess {
+			const FloatMatrix &m_Points;
+			unsigned int m_Axis;
+
+			AxisLess(const FloatMatrix &points, unsigned int axis) : m_Points(points), m_Axis(axis) { }
+
+			bool operator()(unsigned int a, unsigned int b) const {
+				return m_Points(m_Axis, a) < m_Points(m_Axis, b);
+			}
+		};
+	}
+
+	void ReferenceIndex::map(const FloatVector &v, FloatVector &point) const {
+		switch (m_Metric) {
+			case Euclidean:
+				point = v;
+				break;
+
+			case Direction:
+				point = v;
+				point.normalize();
+				break;
+
+			case Rotation: {
+				if (v.size() != 3)
+					CBF_THROW_RUNTIME_ERROR("Rotation references have to be axis angle 3-vectors");
+
+				Quaternion q;
+				q.from_axis_angle3(v);
+				point.resize(4);
+				point << q.w, q.x, q.y, q.z;
+				break;
+			}
+		}
+	}
+
+	bool ReferenceIndex::changed(const std::vector<FloatVector> &references, unsigned long version) const {
+		if (m_Nodes.empty() || references.size() != (unsigned int) m_References.cols())
+			return true;
+
+		if (version != 0)
+			return version != m_Version;
+
+		for (unsigned int i = 0; i < references.size(); ++i) {
+			if (references[i].size() != m_References.rows() || references[i] != m_References.col(i))
+				return true;
+		}
+
+		return false;
+	}
+
+	void ReferenceIndex::build(const std::vector<FloatVector> &references) {
+		const unsigned int dim = references[0].size();
+		const unsigned int copies = (m_Metric == Rotation) ? 2 : 1;
+
+		m_References.resize(dim, references.size());
+		for (unsigned int i = 0; i < references.size(); ++i) {
+			if (references[i].size() != dim)
+				CBF_THROW_RUNTIME_ERROR("References of different dimensions");
+			m_References.col(i) = references[i];
+		}
+
+		//! Unordered first, build_node() sorts the order
+		FloatVector point;
+		map(references[0], point);
+		FloatMatrix points(point.size(), copies * references.size());
+		std::vector<unsigned int> order(points.cols());
+
+		for (unsigned int i = 0; i < references.size(); ++i) {
+			map(references[i], point);
+			points.col(copies * i) = point;
+			if (m_Metric == Rotation)
+				points.col(copies * i + 1) = -point;
+		}
+
+		for (unsigned int i = 0; i < order.size(); ++i)
+			order[i] = i;
+
+		m_Points.swap(points);
+		m_Nodes.clear();
+		build_node(0, order.size(), order);
+
+		//! Store the points in tree order
+		points.resize(m_Points.rows(), m_Points.cols());
+		m_ReferenceIndices.resize(order.size());
+		for (unsigned int i = 0; i < order.size(); ++i) {
+			points.col(i) = m_Points.col(order[i]);
+			m_ReferenceIndices[i] = order[i] / copies;
+		}
+		m_Points.swap(points);
+
+		m_Query.resize(m_Points.rows());
+		++m_Builds;
+	}
+
+	unsigned int ReferenceIndex::build_node(unsigned int begin, unsigned int end, std::vector<unsigned int> &order) {
+		const unsigned int index = m_Nodes.size();
+		m_Nodes.push_back(Node());
+		m_Nodes[index].begin = begin;
+		m_Nodes[index].end = end;
+		m_Nodes[index].right = 0;
+		m_Nodes[index].axis = 0;
+		m_Nodes[index].split = 0;
+
+		if (end - begin <= leaf_size)
+			return index;
+
+		//! Split the axis along which the points spread the most at the median
+		FloatVector min = m_Points.col(order[begin]), max = min;
+		for (unsigned int i = begin + 1; i < end; ++i) {
+			min = min.cwiseMin(m_Points.col(order[i]));
+			max = max.cwiseMax(m_Points.col(order[i]));
+		}
+
+		unsigned int axis;
+		(max - min).maxCoeff(&axis);
+
+		const unsigned int middle = begin + (end - begin) / 2;
+		std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, AxisLess(m_Points, axis));
+
+		m_Nodes[index].axis = axis;
+		m_Nodes[index].split = m_Points(axis, order[middle]);
+
+		build_node(begin, middle, order);
+		const unsigned int right = build_node(middle, end, order);
+		m_Nodes[index].right = right;
+
+		return index;
+	}
+
+	unsigned int ReferenceIndex::closest(
+		const std::vector<FloatVector> &references,
+		const FloatVector &input,
+		unsigned long version
+	) {
+		if (references.empty())
+			CBF_THROW_RUNTIME_ERROR("No references");
+
+		if (changed(references, version)) {
+			CBF_DEBUG("rebuilding the index of " << references.size() << " references");
+			build(references);
+		}
+		m_Version = version;
+
+		map(input, m_Query);
+		if (m_Query.size() != m_Points.rows())
+			CBF_THROW_RUNTIME_ERROR("Input and references of different dimensions");
+
+		Float best_distance = std::numeric_limits<Float>::max();
+		unsigned int best_point = 0;
+
+		//! Nodes still to visit, with a lower bound of their points' squared distances
+		unsigned int stack[max_depth + 1];
+		Float bounds[max_depth + 1];
+		unsigned int size = 0;
+
+		stack[size] = 0;
+		bounds[size++] = 0;
+
+		while (size != 0) {
+			--size;
+			if (bounds[size] >= best_distance)
+				continue;
+
+			const Node &node = m_Nodes[stack[size]];
+			const Float bound = bounds[size];
+
+			if (node.right == 0) {
+				for (unsigned int i = node.begin; i < node.end; ++i) {
+					const Float distance = (m_Points.col(i) - m_Query).squaredNorm();
+					if (distance < best_distance) {
+						best_distance = distance;
+						best_point = i;
+					}
+				}
+				continue;
+			}
+
+			//! The near side goes on top, so it is visited first
+			const Float difference = m_Query[node.axis] - node.split;
+			const unsigned int left = stack[size] + 1;
+
+			stack[size] = (difference < 0) ? node.right : left;
+			bounds[size++] = std::max(bound, difference * difference);
+
+			stack[size] = (difference < 0) ? left : node.right;
+			bounds[size++] = bound;
+		}
+
+		return m_ReferenceIndices[best_point];
+	}
+
+} // namespace
@@ -25,9 +25,19 @@
 
 namespace CBF {
 
+	namespace {
+		unsigned long last_version = 0;
+	}
+
+	void Resource::bump_version() {
+		//! Called in the control loop, so without taking a lock
+		__atomic_store_n(&m_Version, __atomic_add_fetch(&last_version, 1, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+	}
+
 #ifdef CBF_HAVE_XSD
 		Resource::Resource(const CBFSchema::Resource &xml_instance, ObjectNamespacePtr object_namespace) :
-			Object(xml_instance, object_namespace) {
+			Object(xml_instance, object_namespace),
+			m_Version(0) {
 
 		}
 
@@ -29,13 +29,39 @@
 #include <iostream>
 
 namespace CBF {
+
+	void SensorTransform::update_batch(
+		const FloatMatrix &resource_values, 
+		FloatMatrix &results, 
+		FloatMatrix &task_jacobians
+	) {
+		const unsigned int n = resource_values.cols();
+		const unsigned int dim = resource_dim();
+
+		results.resize(task_dim(), n);
+		task_jacobians.resize(task_dim(), n * dim);
+
+		//! result() no longer belongs to any resource version
+		m_ResourceVersion = 0;
+
+		FloatVector resource_value(dim);
+		for (unsigned int i = 0; i < n; ++i) {
+			resource_value = resource_values.col(i);
+			update(resource_value);
+			results.col(i) = result();
+			task_jacobians.middleCols(i * dim, dim) = task_jacobian();
+		}
+	}
 	
 	#ifdef CBF_HAVE_XSD
 		SensorTransform::SensorTransform(
 			const CBFSchema::SensorTransform &xml_instance, 
 			ObjectNamespacePtr object_namespace
 		) :
-			Object(xml_instance, object_namespace)
+			Object(xml_instance, object_namespace),
+			m_ResourceVersion(0),
+			m_UpdateVersion(0),
+			m_JacobianPending(false)
 		{
 			for (
 				CBFSchema::SensorTransform::ComponentName_sequence::const_iterator it 
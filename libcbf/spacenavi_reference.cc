@@ -24,58 +24,70 @@
 #include <cbf/xml_object_factory.h>
 #include <spacenavi.h>
 
+#include <boost/bind.hpp>
+
 namespace CBF {
 
 #ifdef CBF_HAVE_XSD
 SpaceNaviReference::SpaceNaviReference(
 	const CBFSchema::SpaceNaviReference &xml_instance,
 	ObjectNamespacePtr object_namespace) : 
-	Reference(xml_instance, object_namespace) 
+	ChannelReference(xml_instance, object_namespace, 6u)
 {
 	init();
 }
 
+static XMLDerivedFactory<SpaceNaviReference, CBFSchema::SpaceNaviReference> x;
+#endif
+
 void SpaceNaviReference::init() 
 {
-	m_References.push_back(FloatVector(6));
 	m_Device = snavi_open(NULL, O_NONBLOCK);
 	if (m_Device == 0)
 		throw std::runtime_error("Could not open SpaceMouse device"); 
 	// turn on LED
 	snavi_set_led (m_Device, 1);
 
-	m_References.resize(1);
-	m_References[0] = FloatVector(6);
+	m_Thread.reset(new boost::thread(boost::bind(&SpaceNaviReference::read_events, this)));
 }
 
 SpaceNaviReference::~SpaceNaviReference() 
 {
+	if (m_Thread) {
+		m_Thread->interrupt();
+		m_Thread->join();
+	}
+
 	if (m_Device) {
 		snavi_set_led (m_Device, 0);
 		snavi_close (m_Device);
 	}
 }
-void SpaceNaviReference::update() 
+
+void SpaceNaviReference::read_events() 
 {
 	snavi_event_t e;
-	/** get all events from the queue */
-	while(snavi_get_event(m_Device, &e) >= 0) {
-		if (e.type == MotionEvent) {
-			FloatVector tmp;
-			// TODO accumulate axes values
-			tmp << e.axes[0], e.axes[1], e.axes[2], e.axes[3], e.axes[4], e.axes[5];
-			m_References[0] = tmp;
+	try {
+		while (true) {
+			/** get all events from the queue */
+			bool moved = false;
+			while(snavi_get_event(m_Device, &e) >= 0) {
+				if (e.type == MotionEvent) {
+					// TODO accumulate axes values
+					FloatVector &axes = m_Channel.back();
+					for (unsigned int i = 0; i < 6; ++i)
+						axes[i] = e.axes[i];
+					moved = true;
+				}
+			}
+
+			if (moved)
+				m_Channel.publish();
+
+			boost::this_thread::sleep(boost::posix_time::milliseconds(1));
 		}
-	}
+	} catch (boost::thread_interrupted &) { }
 }
 
-static XMLDerivedFactory<SpaceNaviReference, CBFSchema::SpaceNaviReference> x;
-
-#endif
-
 } // namespace
 
-
-
-
-
@@ -30,14 +30,19 @@ namespace CBF {
 		const FloatVector &input
 	) {
 		// First we find the closest reference vector
-		Float min_dist = std::numeric_limits<Float>::max();
 		unsigned int min_index = 0;
 
-		for (unsigned int i = 0; i < references.size(); ++i) {
-			Float dist = distance(input, references[i]);
-			if (dist < min_dist) {
-				min_index = i;
-				min_dist = dist;
+		if (m_ReferenceIndex.applies(references.size())) {
+			min_index = m_ReferenceIndex.closest(references, input, m_ReferencesVersion);
+		} else {
+			Float min_dist = std::numeric_limits<Float>::max();
+
+			for (unsigned int i = 0; i < references.size(); ++i) {
+				Float dist = distance(input, references[i]);
+				if (dist < min_dist) {
+					min_index = i;
+					min_dist = dist;
+				}
 			}
 		}
 
@@ -1,2 +1,345 @@
 #include <cbf/task_space_plan.h>
+#include <cbf/exceptions.h>
+#include <cbf/debug_macros.h>
+#include <cbf/xml_object_factory.h>
+#include <cbf/foreign_object.h>
 
+#include <algorithm>
+#include <cmath>
+
+namespace CBF {
+
+	namespace {
+		//! Bisection steps when searching the peak velocity, this bounds the time replanning takes
+		const unsigned int bisection_steps = 64;
+
+		//! Applies the jerk j for the time t
+		void integrate(Float &p, Float &v, Float &a, Float j, Float t) {
+			p += t * (v + t * (a / 2 + t * j / 6));
+			v += t * (a + t * j / 2);
+			a += t * j;
+		}
+
+		/**
+			Three segments changing the velocity from v0 at acceleration a0
+			to v1 at acceleration 0: jerk to the peak acceleration, hold it
+			(if it had to be limited) and jerk back to 0.
+		*/
+		void velocity_change(
+			Float v0, Float a0, Float v1,
+			Float max_acceleration, Float max_jerk,
+			Float *durations, Float *jerks
+		) {
+			//! The velocity reached by just taking the acceleration back to 0
+			const Float v_zero = v0 + a0 * std::fabs(a0) / (2 * max_jerk);
+			const Float s = (v1 >= v_zero) ? 1 : -1;
+
+			Float peak = std::sqrt(std::max(Float(0), s * max_jerk * (v1 - v0) + a0 * a0 / 2));
+			const bool limited = (peak > max_acceleration);
+			if (limited)
+				peak = max_acceleration;
+
+			jerks[0] = (s * peak >= a0) ? max_jerk : -max_jerk;
+			durations[0] = std::fabs(s * peak - a0) / max_jerk;
+
+			jerks[1] = 0;
+			durations[1] = 0;
+
+			jerks[2] = -s * max_jerk;
+			durations[2] = peak / max_jerk;
+
+			if (limited) {
+				const Float ramps = (a0 + s * peak) / 2 * durations[0] + s * peak / 2 * durations[2];
+				durations[1] = std::max(Float(0), (v1 - v0 - ramps) / (s * peak));
+			}
+		}
+
+		/**
+			Fills in the seven segments for going to the peak velocity and
+			stopping right away, and returns the distance covered
+		*/
+		Float stopping_distance(
+			Float v, Float a, Float peak,
+			Float max_acceleration, Float max_jerk,
+			Float *durations, Float *jerks
+		) {
+			velocity_change(v, a, peak, max_acceleration, max_jerk, durations, jerks);
+			durations[3] = 0;
+			jerks[3] = 0;
+			velocity_change(peak, 0, 0, max_acceleration, max_jerk, durations + 4, jerks + 4);
+
+			Float p = 0;
+			for (unsigned int i = 0; i < 7; ++i)
+				integrate(p, v, a, jerks[i], durations[i]);
+
+			return p;
+		}
+	}
+
+	JerkLimitedTaskSpacePlan::JerkLimitedTaskSpacePlan(
+		ReferencePtr reference,
+		const FloatVector &max_velocity,
+		const FloatVector &max_acceleration,
+		const FloatVector &max_jerk,
+		Float cycle_time
+	) :
+		m_MaxVelocity(max_velocity),
+		m_MaxAcceleration(max_acceleration),
+		m_MaxJerk(max_jerk),
+		m_CycleTime(cycle_time)
+	{
+		m_Reference = reference;
+		init();
+	}
+
+	void JerkLimitedTaskSpacePlan::init() {
+		const unsigned int dim = m_Reference->dim();
+
+		if (
+			m_MaxVelocity.size() != dim ||
+			m_MaxAcceleration.size() != dim ||
+			m_MaxJerk.size() != dim
+		)
+			CBF_THROW_RUNTIME_ERROR("The limits need " << dim << " dimensions");
+
+		if (
+			(m_MaxVelocity.array() <= 0).any() ||
+			(m_MaxAcceleration.array() <= 0).any() ||
+			(m_MaxJerk.array() <= 0).any() ||
+			m_CycleTime <= 0
+		)
+			CBF_THROW_RUNTIME_ERROR("The limits and the cycle time have to be positive");
+
+		m_TargetVersion = 0;
+		m_HasState = false;
+
+		m_Target = FloatVector::Zero(dim);
+		m_Durations = FloatMatrix::Zero(NumSegments, dim);
+		m_Jerks = FloatMatrix::Zero(NumSegments, dim);
+		m_Segments.assign(dim, (unsigned int) NumSegments);
+		m_SegmentTime = FloatVector::Zero(dim);
+		m_SegmentPosition = FloatVector::Zero(dim);
+		m_SegmentVelocity = FloatVector::Zero(dim);
+		m_SegmentAcceleration = FloatVector::Zero(dim);
+		m_SegmentJerk = FloatVector::Zero(dim);
+		m_Position = FloatVector::Zero(dim);
+		m_Velocity = FloatVector::Zero(dim);
+		m_Acceleration = FloatVector::Zero(dim);
+
+		//! No reference until there is a state to start from
+		m_References.clear();
+	}
+
+	void JerkLimitedTaskSpacePlan::plan(unsigned int i) {
+		const Float max_velocity = m_MaxVelocity[i];
+		const Float max_acceleration = m_MaxAcceleration[i];
+		const Float max_jerk = m_MaxJerk[i];
+
+		const Float v = m_Velocity[i], a = m_Acceleration[i];
+		const Float distance = m_Target[i] - m_Position[i];
+
+		//! The segments of dimension i are contiguous
+		Float *durations = &m_Durations(0, i);
+		Float *jerks = &m_Jerks(0, i);
+
+		//! Cruise at the maximum velocity if stopping right away falls short
+		Float covered = stopping_distance(v, a, max_velocity, max_acceleration, max_jerk, durations, jerks);
+		if (covered <= distance) {
+			durations[3] = (distance - covered) / max_velocity;
+		} else {
+			covered = stopping_distance(v, a, -max_velocity, max_acceleration, max_jerk, durations, jerks);
+			if (covered >= distance) {
+				durations[3] = (covered - distance) / max_velocity;
+			} else {
+				//! The distance covered grows with the peak velocity
+				Float low = -max_velocity, high = max_velocity;
+				for (unsigned int step = 0; step < bisection_steps; ++step) {
+					const Float peak = (low + high) / 2;
+					if (stopping_distance(v, a, peak, max_acceleration, max_jerk, durations, jerks) < distance)
+						low = peak;
+					else
+						high = peak;
+				}
+				stopping_distance(v, a, (low + high) / 2, max_acceleration, max_jerk, durations, jerks);
+			}
+		}
+
+		m_Segments[i] = 0;
+		m_SegmentTime[i] = 0;
+		m_SegmentPosition[i] = m_Position[i];
+		m_SegmentVelocity[i] = v;
+		m_SegmentAcceleration[i] = a;
+		m_SegmentJerk[i] = jerks[0];
+	}
+
+	void JerkLimitedTaskSpacePlan::set_new_reference() {
+		const std::vector<FloatVector> &references = m_Reference->get();
+		if (references.size() == 0)
+			return;
+
+		if (references[0].size() != m_Target.size())
+			CBF_THROW_RUNTIME_ERROR("Reference of dimension " << references[0].size() << " instead of " << m_Target.size());
+
+		m_Target = references[0];
+		m_TargetVersion = m_Reference->version();
+		CBF_DEBUG("new target: " << m_Target.transpose());
+
+		//! Without a state there is nothing to plan, start at rest at the target
+		if (!m_HasState) {
+			reset(m_Target);
+			return;
+		}
+
+		for (unsigned int i = 0; i < m_Target.size(); ++i)
+			plan(i);
+	}
+
+	void JerkLimitedTaskSpacePlan::reset(const FloatVector &position) {
+		reset(position, FloatVector::Zero(position.size()), FloatVector::Zero(position.size()));
+	}
+
+	void JerkLimitedTaskSpacePlan::reset(
+		const FloatVector &position,
+		const FloatVector &velocity,
+		const FloatVector &acceleration
+	) {
+		if (
+			position.size() != m_Target.size() ||
+			velocity.size() != m_Target.size() ||
+			acceleration.size() != m_Target.size()
+		)
+			CBF_THROW_RUNTIME_ERROR("State of the wrong dimension");
+
+		m_Position = position;
+		m_Velocity = velocity;
+		m_Acceleration = acceleration;
+
+		//! Keep heading for the known target, or stay here
+		if (!m_HasState) {
+			m_HasState = true;
+			if (m_Reference->get().size() != 0 && m_Reference->get()[0].size() == m_Target.size()) {
+				m_Target = m_Reference->get()[0];
+				m_TargetVersion = m_Reference->version();
+			} else {
+				m_Target = position;
+			}
+		}
+
+		for (unsigned int i = 0; i < m_Target.size(); ++i)
+			plan(i);
+
+		m_References.assign(1, m_Position);
+		bump_version();
+	}
+
+	void JerkLimitedTaskSpacePlan::update() {
+		m_Reference->update();
+
+		const std::vector<FloatVector> &references = m_Reference->get();
+		if (references.size() != 0) {
+			const unsigned long version = m_Reference->version();
+
+			if (!m_HasState)
+				set_new_reference();
+			else if (version == 0 || version != m_TargetVersion) {
+				if (references[0] != m_Target)
+					set_new_reference();
+				m_TargetVersion = version;
+			}
+		}
+
+		if (!m_HasState)
+			return;
+
+		//! Move on to the segment the cycle ends in, at most NumSegments times per plan
+		for (unsigned int i = 0; i < m_Target.size(); ++i) {
+			unsigned int &segment = m_Segments[i];
+			m_SegmentTime[i] += m_CycleTime;
+
+			while (segment < NumSegments && m_SegmentTime[i] >= m_Durations(segment, i)) {
+				const Float duration = m_Durations(segment, i);
+				integrate(m_SegmentPosition[i], m_SegmentVelocity[i], m_SegmentAcceleration[i], m_Jerks(segment, i), duration);
+				m_SegmentTime[i] -= duration;
+				++segment;
+			}
+
+			if (segment == NumSegments) {
+				//! Arrived, without the rounding errors of integrating the segments
+				m_SegmentTime[i] = 0;
+				m_SegmentPosition[i] = m_Target[i];
+				m_SegmentVelocity[i] = 0;
+				m_SegmentAcceleration[i] = 0;
+				m_SegmentJerk[i] = 0;
+			} else {
+				m_SegmentJerk[i] = m_Jerks(segment, i);
+			}
+		}
+
+		//! The same polynomial for all dimensions
+		const Eigen::ArrayWrapper<FloatVector> t(m_SegmentTime);
+		const Eigen::ArrayWrapper<FloatVector> p(m_SegmentPosition), v(m_SegmentVelocity);
+		const Eigen::ArrayWrapper<FloatVector> a(m_SegmentAcceleration), j(m_SegmentJerk);
+
+		m_Position.array() = p + t * (v + t * (a / 2 + t * j / 6));
+		m_Velocity.array() = v + t * (a + t * j / 2);
+		m_Acceleration.array() = a + t * j;
+
+		if (m_References[0] != m_Position) {
+			m_References[0] = m_Position;
+			bump_version();
+		}
+	}
+
+	Float JerkLimitedTaskSpacePlan::remaining_time() const {
+		Float remaining = 0;
+
+		for (unsigned int i = 0; i < m_Target.size(); ++i) {
+			Float time = -m_SegmentTime[i];
+			for (unsigned int segment = m_Segments[i]; segment < NumSegments; ++segment)
+				time += m_Durations(segment, i);
+			remaining = std::max(remaining, time);
+		}
+
+		return remaining;
+	}
+
+	bool JerkLimitedTaskSpacePlan::reached() const {
+		for (unsigned int i = 0; i < m_Segments.size(); ++i)
+			if (m_Segments[i] != NumSegments)
+				return false;
+
+		return true;
+	}
+
+	#ifdef CBF_HAVE_XSD
+		JerkLimitedTaskSpacePlan::JerkLimitedTaskSpacePlan(
+			const CBFSchema::JerkLimitedTaskSpacePlan &xml_instance,
+			ObjectNamespacePtr object_namespace
+		) :
+			TaskSpacePlan(xml_instance, object_namespace),
+			m_CycleTime(xml_instance.CycleTime())
+		{
+			m_Reference = XMLObjectFactory::instance()->create<Reference>(xml_instance.Reference1(), object_namespace);
+
+			m_MaxVelocity =
+				*XMLObjectFactory::instance()->create<ForeignObject<FloatVector> >(
+					xml_instance.MaxVelocity(), object_namespace
+				)->m_Object;
+
+			m_MaxAcceleration =
+				*XMLObjectFactory::instance()->create<ForeignObject<FloatVector> >(
+					xml_instance.MaxAcceleration(), object_namespace
+				)->m_Object;
+
+			m_MaxJerk =
+				*XMLObjectFactory::instance()->create<ForeignObject<FloatVector> >(
+					xml_instance.MaxJerk(), object_namespace
+				)->m_Object;
+
+			init();
+		}
+
+		static XMLDerivedFactory<JerkLimitedTaskSpacePlan, CBFSchema::JerkLimitedTaskSpacePlan> x;
+	#endif
+
+} // namespace
@@ -0,0 +1,128 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -*- mode: c-non-suck; -*- */
+
+#include <cbf/thread_pool.h>
+#include <cbf/exceptions.h>
+
+#include <boost/bind.hpp>
+
+#include <exception>
+
+namespace CBF {
+
+ThreadPool::ThreadPool(unsigned int threads) :
+	m_Task(0),
+	m_Count(0),
+	m_NextIndex(0),
+	m_Finished(0),
+	m_Batch(0),
+	m_Stop(false),
+	m_Failed(false)
+{
+	for (unsigned int i = 0; i < threads; ++i)
+		m_Threads.push_back(boost::shared_ptr<boost::thread>(
+			new boost::thread(boost::bind(&ThreadPool::work, this))
+		));
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		boost::unique_lock<boost::mutex> lock(m_Mutex);
+		m_Stop = true;
+	}
+	m_BatchStarted.notify_all();
+
+	for (unsigned int i = 0; i < m_Threads.size(); ++i)
+		m_Threads[i]->join();
+}
+
+void ThreadPool::run(ParallelTask &task, unsigned int count) {
+	boost::unique_lock<boost::mutex> batch(m_BatchMutex, boost::try_to_lock);
+
+	if (!batch.owns_lock() || m_Threads.empty() || count < 2) {
+		for (unsigned int i = 0; i < count; ++i)
+			task.run(i);
+		return;
+	}
+
+	boost::unique_lock<boost::mutex> lock(m_Mutex);
+	m_Task = &task;
+	m_Count = count;
+	m_NextIndex = 0;
+	m_Finished = 0;
+	m_Failed = false;
+	++m_Batch;
+	m_BatchStarted.notify_all();
+
+	work_on_batch(lock);
+
+	while (m_Finished < m_Count)
+		m_BatchFinished.wait(lock);
+
+	m_Task = 0;
+
+	if (m_Failed)
+		CBF_THROW_RUNTIME_ERROR("Parallel job failed: " << m_Error);
+}
+
+void ThreadPool::work() {
+	unsigned long batch = 0;
+
+	boost::unique_lock<boost::mutex> lock(m_Mutex);
+	while (true) {
+		while (!m_Stop && m_Batch == batch)
+			m_BatchStarted.wait(lock);
+
+		if (m_Stop) return;
+
+		batch = m_Batch;
+		work_on_batch(lock);
+	}
+}
+
+void ThreadPool::work_on_batch(boost::unique_lock<boost::mutex> &lock) {
+	while (m_NextIndex < m_Count) {
+		unsigned int index = m_NextIndex++;
+		ParallelTask *task = m_Task;
+
+		lock.unlock();
+		std::string error;
+		bool failed = false;
+		try {
+			task->run(index);
+		} catch (std::exception &e) {
+			failed = true;
+			error = e.what();
+		} catch (...) {
+			failed = true;
+			error = "unknown exception";
+		}
+		lock.lock();
+
+		if (failed && !m_Failed) {
+			m_Failed = true;
+			m_Error = error;
+		}
+
+		if (++m_Finished == m_Count)
+			m_BatchFinished.notify_all();
+	}
+}
+
+} // namespace
@@ -212,33 +212,238 @@ FloatMatrix &assign(FloatMatrix &m, const KDL::Frame &f) {
 
 
 #ifdef CBF_HAVE_EIGEN
-	template<typename CustomUnaryOp>
-	Float generic_pseudo_inverse(const FloatMatrix &M, FloatMatrix &result,
-										  const CustomUnaryOp& inverter) {
-		Eigen::JacobiSVD<FloatMatrix> svd = M.jacobiSvd(Eigen::ComputeThinV | Eigen::ComputeThinU);
-		FloatVector tmp = svd.singularValues();
+	PseudoInverseSolver pseudo_inverse_solver(const std::string &name) {
+		if (name == "JacobiSVD") return JacobiSVDSolver;
+		if (name == "DampedLeastSquares") return DampedLeastSquaresSolver;
+		if (name == "QR") return QRSolver;
+		if (name == "WarmStartedSVD") return WarmStartedSVDSolver;
+
+		#ifdef CBF_HAVE_EIGEN_3_3
+			if (name == "BDCSVD") return BDCSVDSolver;
+			if (name == "CompleteOrthogonalDecomposition") return CompleteOrthogonalDecompositionSolver;
+		#else
+			if (name == "BDCSVD" || name == "CompleteOrthogonalDecomposition")
+				CBF_THROW_RUNTIME_ERROR("[utilities]: pseudo_inverse_solver(): " << name << " needs Eigen 3.3");
+		#endif
+
+		CBF_THROW_RUNTIME_ERROR("[utilities]: pseudo_inverse_solver(): Unknown solver: " << name);
+		return JacobiSVDSolver;
+	}
+
+	WarmStartedSVD &WarmStartedSVD::compute(const FloatMatrix &m, unsigned int computation_options) {
+		const int rows = m.rows();
+		const int cols = m.cols();
+
+		const bool full_u = computation_options & Eigen::ComputeFullU;
+		const bool full_v = computation_options & Eigen::ComputeFullV;
+		const bool thin_v = computation_options & Eigen::ComputeThinV;
+
+		bool warm = 
+			rows <= cols &&
+			m_U.rows() == rows && m_U.cols() == rows && m_Columns == cols &&
+			m_WarmStartsSinceRefresh < m_RefreshInterval;
+
+		m_Columns = cols;
+
+		if (warm) {
+			//! m^T U_prev = Q R
+			m_Projected.noalias() = m.transpose() * m_U;
+			m_QR.compute(m_Projected);
+			m_RTransposed = m_QR.matrixQR().topRows(rows).triangularView<Eigen::Upper>().transpose();
+
+			//! The drift check: U_prev still diagonalizes m if R is nearly diagonal
+			Float norm = m_RTransposed.squaredNorm();
+			Float off_diagonal = norm - m_RTransposed.diagonal().squaredNorm();
+			warm = off_diagonal <= m_DriftTolerance * m_DriftTolerance * norm;
+		}
+
+		if (warm) {
+			//! m = U_prev R^T Q^T = (U_prev U_r) diag(s) (Q V_r)^T
+			m_SmallSVD.compute(m_RTransposed, Eigen::ComputeFullU | Eigen::ComputeFullV);
+
+			//! The full V continues with the complement of the row space, i.e. the rest of Q
+			m_Q.setIdentity(cols, full_v ? cols : rows);
+			m_QR.householderQ().applyThisOnTheLeft(m_Q, m_Workspace);
+
+			m_PreviousU = m_U;
+			m_U.noalias() = m_PreviousU * m_SmallSVD.matrixU();
+
+			if (full_v) {
+				m_V.resize(cols, cols);
+				m_V.leftCols(rows).noalias() = m_Q.leftCols(rows) * m_SmallSVD.matrixV();
+				m_V.rightCols(cols - rows) = m_Q.rightCols(cols - rows);
+			} else if (thin_v) {
+				m_V.noalias() = m_Q * m_SmallSVD.matrixV();
+			}
+
+			m_SingularValues = m_SmallSVD.singularValues();
+			m_NonzeroSingularValues = m_SmallSVD.nonzeroSingularValues();
+
+			++m_WarmStarts;
+			++m_WarmStartsSinceRefresh;
+		} else {
+			unsigned int options = full_u ? Eigen::ComputeFullU : Eigen::ComputeThinU;
+			if (full_v)
+				options |= Eigen::ComputeFullV;
+			else if (thin_v)
+				options |= Eigen::ComputeThinV;
+
+			m_FullSVD.compute(m, options);
+
+			m_U = m_FullSVD.matrixU();
+			if (full_v || thin_v)
+				m_V = m_FullSVD.matrixV();
+			m_SingularValues = m_FullSVD.singularValues();
+			m_NonzeroSingularValues = m_FullSVD.nonzeroSingularValues();
+
+			++m_FullDecompositions;
+			m_WarmStartsSinceRefresh = 0;
+		}
+
+		return *this;
+	}
+
+	template<typename SVD, typename CustomUnaryOp>
+	Float svd_pseudo_inverse(const FloatMatrix &M, FloatMatrix &result,
+	                         PseudoInverseWorkspace &workspace, SVD &svd,
+	                         const CustomUnaryOp& inverter) {
+		//! compute() only reallocates the decomposition if the size of M changed
+		svd.compute(M, Eigen::ComputeThinV | Eigen::ComputeThinU);
+		const FloatVector &tmp = svd.singularValues();
 		CBF_DEBUG("singularValues: " << tmp.transpose());
 	
 		//! Invert singular vectors
 		Float det = tmp.head(svd.nonzeroSingularValues()).prod();
-		FloatVector si = tmp.unaryExpr(inverter);
+		FloatVector &si = workspace.m_InverseSingularValues;
+		si = tmp.unaryExpr(inverter);
+
+		workspace.m_Rank = 0;
+		for (int i = 0; i < tmp.size(); ++i) {
+			if (tmp[i] > pseudo_inverse_rank_threshold) ++workspace.m_Rank;
+		}
 
 		CBF_DEBUG("det: " << det);
 		CBF_DEBUG("svd: " << si.transpose());
 	
-		result = (svd.matrixV() * si.asDiagonal()) * svd.matrixU().transpose();
+		workspace.m_ScaledV.noalias() = svd.matrixV() * si.asDiagonal();
+		result.noalias() = workspace.m_ScaledV * svd.matrixU().transpose();
 		return det;
 	}
 
+	template<typename CustomUnaryOp>
+	Float generic_pseudo_inverse(const FloatMatrix &M, FloatMatrix &result,
+										  PseudoInverseWorkspace &workspace,
+										  const CustomUnaryOp& inverter) {
+		switch (workspace.m_Solver) {
+			case JacobiSVDSolver:
+				return svd_pseudo_inverse(M, result, workspace, workspace.m_SVD, inverter);
+
+			#ifdef CBF_HAVE_EIGEN_3_3
+				case BDCSVDSolver:
+					return svd_pseudo_inverse(M, result, workspace, workspace.m_BDCSVD, inverter);
+			#endif
+
+			case WarmStartedSVDSolver:
+				return svd_pseudo_inverse(M, result, workspace, workspace.m_WarmStartedSVD, inverter);
+
+			default:
+				CBF_THROW_RUNTIME_ERROR("[utilities]: generic_pseudo_inverse(): Solver " << workspace.m_Solver << " can not invert the singular values");
+		}
+		return 0;
+	}
+
+	/**
+		J# = J^T (J J^T + damping_constant * 1)^-1, which is the same as the damped
+		inversion of the singular values. Returns sqrt(det(J J^T + damping_constant * 1)).
+	*/
+	Float damped_least_squares_pseudo_inverse(const FloatMatrix &M, FloatMatrix &result,
+	                                          PseudoInverseWorkspace &workspace, Float damping_constant) {
+		FloatMatrix &gram = workspace.m_Gram;
+		gram.noalias() = M * M.transpose();
+		gram.diagonal().array() += damping_constant;
+
+		workspace.m_LLT.compute(gram);
+		if (workspace.m_LLT.info() != Eigen::Success)
+			CBF_THROW_RUNTIME_ERROR("[utilities]: damped_least_squares_pseudo_inverse(): m m^T + damping is not positive definite");
+
+		//! gram is symmetric, so J#^T = gram^-1 J
+		workspace.m_Scratch = M;
+		workspace.m_LLT.solveInPlace(workspace.m_Scratch);
+		result = workspace.m_Scratch.transpose();
+
+		workspace.m_Rank = M.rows();
+		return workspace.m_LLT.matrixLLT().diagonal().prod();
+	}
+
+	#ifdef CBF_HAVE_EIGEN_3_3
+		Float complete_orthogonal_decomposition_pseudo_inverse(const FloatMatrix &M, FloatMatrix &result,
+		                                                       PseudoInverseWorkspace &workspace) {
+			Eigen::CompleteOrthogonalDecomposition<FloatMatrix> &cod = workspace.m_COD;
+			cod.compute(M);
+
+			//! Eigen's threshold is relative to the biggest pivot
+			if (cod.maxPivot() > 0)
+				cod.setThreshold(pseudo_inverse_rank_threshold / cod.maxPivot());
+
+			workspace.m_Rank = cod.rank();
+			result = cod.pseudoInverse();
+			return fabs(cod.matrixT().diagonal().head(workspace.m_Rank).prod());
+		}
+	#endif
+
+	/**
+		With J^T P = Q R the minimum norm pseudo inverse of a J with full row 
+		rank is Q R^-T P^T. For rank deficient J only the first rank() 
+		pivots are used.
+	*/
+	Float qr_pseudo_inverse(const FloatMatrix &M, FloatMatrix &result,
+	                        PseudoInverseWorkspace &workspace) {
+		Eigen::ColPivHouseholderQR<FloatMatrix> &qr = workspace.m_QR;
+		qr.compute(M.transpose());
+
+		if (qr.maxPivot() > 0)
+			qr.setThreshold(pseudo_inverse_rank_threshold / qr.maxPivot());
+
+		const int rank = qr.rank();
+		workspace.m_Rank = rank;
+
+		FloatMatrix &x = workspace.m_Scratch;
+		x.setZero(M.cols(), M.rows());
+		for (int i = 0; i < rank; ++i)
+			x(i, qr.colsPermutation().indices()[i]) = 1.0;
+
+		Eigen::Block<FloatMatrix> top = x.topRows(rank);
+		qr.matrixR().topLeftCorner(rank, rank).triangularView<Eigen::Upper>().transpose().solveInPlace(top);
+
+		qr.householderQ().applyThisOnTheLeft(x, workspace.m_HouseholderWorkspace);
+		result = x;
+
+		return fabs(qr.matrixR().diagonal().head(rank).prod());
+	}
+
 	Float simpleInverse(const Float s) {
-		static const double pseudo_inv_precision_threshold = 0.001;
-		if (fabs(s) > pseudo_inv_precision_threshold)
+		if (fabs(s) > pseudo_inverse_rank_threshold)
 			return 1.0 / s;
 		else
 			return 0.0;
 	}
+	Float pseudo_inverse(const FloatMatrix &M, FloatMatrix &result, PseudoInverseWorkspace &workspace) {
+		switch (workspace.m_Solver) {
+			#ifdef CBF_HAVE_EIGEN_3_3
+				case CompleteOrthogonalDecompositionSolver:
+					return complete_orthogonal_decomposition_pseudo_inverse(M, result, workspace);
+			#endif
+
+			case QRSolver:
+				return qr_pseudo_inverse(M, result, workspace);
+
+			default:
+				return generic_pseudo_inverse(M, result, workspace, std::ptr_fun(simpleInverse));
+		}
+	}
 	Float pseudo_inverse(const FloatMatrix &M, FloatMatrix &result) {
-		return generic_pseudo_inverse(M, result, std::ptr_fun(simpleInverse));
+		PseudoInverseWorkspace workspace;
+		return pseudo_inverse(M, result, workspace);
 	}
 
 	template<typename Scalar>
@@ -247,8 +452,15 @@ FloatMatrix &assign(FloatMatrix &m, const KDL::Frame &f) {
 		const Scalar operator()(const Scalar s) const { return s / (m_damping + s*s); }
 		Scalar m_damping;
 	};
+	Float damped_pseudo_inverse(const FloatMatrix &M, FloatMatrix &result, PseudoInverseWorkspace &workspace, Float damping_constant) {
+		if (workspace.m_Solver == DampedLeastSquaresSolver)
+			return damped_least_squares_pseudo_inverse(M, result, workspace, damping_constant);
+
+		return generic_pseudo_inverse(M, result, workspace, dampedInverse<Float>(damping_constant));
+	}
 	Float damped_pseudo_inverse(const FloatMatrix &M, FloatMatrix &result, Float damping_constant) {
-		return generic_pseudo_inverse(M, result, dampedInverse<Float>(damping_constant));
+		PseudoInverseWorkspace workspace;
+		return damped_pseudo_inverse(M, result, workspace, damping_constant);
 	}
 
 	struct thesholdInverse {
@@ -260,8 +472,12 @@ FloatMatrix &assign(FloatMatrix &m, const KDL::Frame &f) {
 		}
 		Float m_threshold;
 	};
+	Float threshold_pseudo_inverse(const FloatMatrix &M, FloatMatrix &result, PseudoInverseWorkspace &workspace, const Float threshold) {
+		return generic_pseudo_inverse(M, result, workspace, thesholdInverse(threshold));
+	}
 	Float threshold_pseudo_inverse(const FloatMatrix &M, FloatMatrix &result, const Float threshold) {
-		return generic_pseudo_inverse(M, result, thesholdInverse(threshold));
+		PseudoInverseWorkspace workspace;
+		return threshold_pseudo_inverse(M, result, workspace, threshold);
 	}
 #endif
 
@@ -35,9 +35,9 @@ namespace CBF {
 		XCFMemoryReference::XCFMemoryReference(const CBFSchema::XCFMemoryReference &xml_instance, 
 															ObjectNamespacePtr object_namespace)
 			:
+			ChannelReference(xml_instance.Dimension()),
 			m_MemoryInterface(mi::MemoryInterface::getInstance(xml_instance.URI())),
-			m_ReferenceName(xml_instance.ReferenceName()),
-			m_Dim(xml_instance.Dimension())
+			m_ReferenceName(xml_instance.ReferenceName())
 		{
 			init();
 		}
@@ -48,9 +48,9 @@ namespace CBF {
 	XCFMemoryReference::XCFMemoryReference
 		(const std::string &uri, const std::string &reference_name, unsigned int dim) 
 		: 
+		ChannelReference(dim),
 		m_MemoryInterface(mi::MemoryInterface::getInstance(uri)),
-		m_ReferenceName(reference_name),
-		m_Dim(dim)
+		m_ReferenceName(reference_name)
 	{ 	
 		init();
 	}
@@ -60,7 +60,7 @@ namespace CBF {
 		// This way the Dimension will be published.
 		CBF_DEBUG("creating info document");
 
-		CBFSchema::XCFMemoryReferenceInfo v(m_ReferenceName, m_Dim);
+		CBFSchema::XCFMemoryReferenceInfo v(m_ReferenceName, dim());
 
 		std::ostringstream s;
 		CBFSchema::XCFMemoryReferenceInfo_ (s, v);
@@ -85,17 +85,9 @@ namespace CBF {
 		CBF_DEBUG("XCFMemoryReference initialized");
 	}
 
-	void XCFMemoryReference::update()  {
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_ReferenceMonitor); 
-		if (m_TempReference.size() == m_Dim) {
-			m_References.resize(1);
-			m_References[0] = m_TempReference;
-		}
-	}
-
 	void XCFMemoryReference::set_reference(const memory::interface::Event &event) {
 		CBF_DEBUG("in");
-		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_ReferenceMonitor); 
+		boost::mutex::scoped_lock lock(m_EventMutex);
 		CBF_DEBUG("locked");
 
 		CBF_DEBUG("doc: " << event.getDocument());
@@ -107,18 +99,20 @@ namespace CBF {
 				CBFSchema::XCFMemoryReferenceVector_(s, xml_schema::flags::dont_validate);
 
 		CBF_DEBUG("create vector");
-		m_TempReference = 
+		const FloatVector vector =
 			*XMLObjectFactory::instance()->create<ForeignObject<FloatVector> >(
 				reference -> Vector(), ObjectNamespacePtr(new ObjectNamespace())
 			)->m_Object;
 
-		CBF_DEBUG("vector: " << m_TempReference);
+		CBF_DEBUG("vector: " << vector);
 
 		CBF_DEBUG("vector created");
-		if (m_TempReference.size() != dim()) {
+		if (vector.size() != dim()) {
 			CBF_DEBUG("meeeh!!!");
 			CBF_THROW_RUNTIME_ERROR("Dimensions of xml vector not matching the dimension of this reference");
 		}
+
+		publish(vector);
 	}
 } // namespace
 
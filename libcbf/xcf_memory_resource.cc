@@ -35,7 +35,8 @@ namespace CBF {
 			:
 			m_ResourceName(xml_instance.ResourceName()),
 			m_MemoryInterface(mi::MemoryInterface::getInstance(xml_instance.URI())),
-			m_Resource(XMLObjectFactory::instance() -> create<Resource>(xml_instance.Resource1(), object_namespace))
+			m_Resource(XMLObjectFactory::instance() -> create<Resource>(xml_instance.Resource1(), object_namespace)),
+			m_WrappedVersion(0)
 		{
 			init();
 		}
@@ -48,7 +49,8 @@ namespace CBF {
 	:
 	m_ResourceName(resource_name),
 	m_MemoryInterface(mi::MemoryInterface::getInstance(uri)),
-	m_Resource(resource)
+	m_Resource(resource),
+	m_WrappedVersion(0)
 	{
 		init();
 	}
@@ -70,6 +72,7 @@ namespace CBF {
 		IceUtil::Monitor<IceUtil::RecMutex>::Lock lock(m_ResourceMonitor);
 		//First call update on the wrapped resource.
 		m_Resource -> update();
+		take_on_version();
 
 		//Publish the new state of the resource.
 		CBF_DEBUG("getting vector from the wraped resource");
@@ -146,6 +149,7 @@ namespace CBF {
 		} else {
 			CBF_DEBUG("adding vector to resource");
 			m_Resource -> add(resourceVector);
+			take_on_version();
 		}
 		CBF_DEBUG("out");
 	}
@@ -53,7 +53,7 @@ namespace CBF {
 	}
 
 	void XCFMemorySensorTransform::update(const FloatVector &resource_value){
-		m_SensorTransform -> update(resource_value);
+		m_SensorTransform->update_if_changed(resource_value, m_UpdateVersion);
 		send();
 	}
 
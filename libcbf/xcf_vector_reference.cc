@@ -5,8 +5,9 @@ namespace CBF {
 
 #ifdef CBF_HAVE_XSD 
 	XCFVectorReference::XCFVectorReference(const CBFSchema::XCFVectorReference &xml_instance, ObjectNamespacePtr object_namespace) :
+		ChannelReference(xml_instance.Dimension()),
 		m_XCFServer(XCF::Server::create(xml_instance.ServerName())), 
-		m_Dim(xml_instance.Dimension())
+		m_CurrentReferenceChannel(xml_instance.Dimension())
 	{ 	
 		init();
 	}
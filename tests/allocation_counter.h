@@ -0,0 +1,60 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Counts the heap allocations of the tests checking that something
+	does not allocate: malloc(), calloc() and realloc() are replaced
+	by versions that count their calls while counting is true and
+	forward to glibc.
+
+	This defines these functions, so include it only from the one
+	source file of a test, and register the test with
+	add_allocation_test() in CMakeLists.txt.
+*/
+
+#ifndef CBF_TESTS_ALLOCATION_COUNTER_HH
+#define CBF_TESTS_ALLOCATION_COUNTER_HH
+
+#include <cstddef>
+
+extern "C" {
+	void *__libc_malloc(size_t size);
+	void *__libc_calloc(size_t num, size_t size);
+	void *__libc_realloc(void *ptr, size_t size);
+}
+
+static bool counting = false;
+static unsigned int num_allocations = 0;
+
+extern "C" {
+	void *malloc(size_t size) {
+		if (counting) ++num_allocations;
+		return __libc_malloc(size);
+	}
+
+	void *calloc(size_t num, size_t size) {
+		if (counting) ++num_allocations;
+		return __libc_calloc(num, size);
+	}
+
+	void *realloc(void *ptr, size_t size) {
+		if (counting) ++num_allocations;
+		return __libc_realloc(ptr, size);
+	}
+}
+
+#endif
@@ -0,0 +1,165 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks that updating the predefined functional sensor transforms
+	(BlockWiseSum, BlockWiseDifference, NegateOperation and
+	MultiplyOperation) and a BlockWiseApplySensorTransform with add
+	and subtract do not touch the heap, and that they still
+	compute the right thing. Allocations are counted with
+	allocation_counter.h.
+*/
+
+#include <cbf/functional.h>
+#include <cbf/linear_transform.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "allocation_counter.h"
+
+using namespace CBF;
+
+//! Counts the allocations of 100 updates and compares the last result with the expected one
+bool check(
+	const std::string &name,
+	SensorTransformPtr transform,
+	const FloatVector &resource_value,
+	const FloatVector &expected_result,
+	const FloatMatrix &expected_jacobian
+) {
+	//! The first update may still size the results
+	transform->update(resource_value);
+	transform->task_jacobian();
+
+	num_allocations = 0;
+	counting = true;
+	for (unsigned int i = 0; i < 100; ++i) {
+		transform->update(resource_value);
+		transform->task_jacobian();
+	}
+	counting = false;
+
+	if (num_allocations != 0) {
+		std::cerr << name << ": " << num_allocations << " allocations during 100 updates" << std::endl;
+		return false;
+	}
+
+	if (
+		(transform->result() - expected_result).norm() > 1e-12 ||
+		(transform->task_jacobian() - expected_jacobian).norm() > 1e-12
+	) {
+		std::cerr << name << ": wrong result" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+int main() {
+	srand(0);
+
+	const unsigned int blocksize = 3;
+	const unsigned int resource_dim = 4;
+
+	//! Two blocks of three
+	const FloatMatrix coefficients = FloatMatrix::Random(2 * blocksize, resource_dim);
+	SensorTransformPtr operand(new LinearSensorTransform(coefficients));
+
+	const FloatVector resource_value = FloatVector::Random(resource_dim);
+	operand->update(resource_value);
+	const FloatVector result = operand->result();
+	const FloatMatrix jacobian = operand->task_jacobian();
+
+	const FloatVector init_vector = FloatVector::Constant(blocksize, 0.5);
+	const FloatMatrix init_matrix = FloatMatrix::Constant(blocksize, resource_dim, 0.25);
+
+	bool ok = true;
+
+	ok &= check(
+		"BlockWiseSumSensorTransform",
+		SensorTransformPtr(new BlockWiseSumSensorTransform(
+			operand,
+			add_to(),
+			add_to(),
+			init_vector,
+			init_matrix,
+			blocksize
+		)),
+		resource_value,
+		init_vector + result.head(blocksize) + result.tail(blocksize),
+		init_matrix + jacobian.topRows(blocksize) + jacobian.bottomRows(blocksize)
+	);
+
+	ok &= check(
+		"BlockWiseDifferenceSensorTransform",
+		SensorTransformPtr(new BlockWiseDifferenceSensorTransform(
+			operand,
+			subtract_from(),
+			subtract_from(),
+			init_vector,
+			init_matrix,
+			blocksize
+		)),
+		resource_value,
+		init_vector - result.head(blocksize) - result.tail(blocksize),
+		init_matrix - jacobian.topRows(blocksize) - jacobian.bottomRows(blocksize)
+	);
+
+	ok &= check(
+		"NegateOperationSensorTransform",
+		SensorTransformPtr(new NegateOperationSensorTransform(
+			operand,
+			negate(),
+			negate()
+		)),
+		resource_value,
+		-result,
+		-jacobian
+	);
+
+	ok &= check(
+		"MultiplyOperationSensorTransform",
+		SensorTransformPtr(new MultiplyOperationSensorTransform(
+			operand,
+			multiply_by(1.5),
+			multiply_by(-2.0)
+		)),
+		resource_value,
+		1.5 * result,
+		-2.0 * jacobian
+	);
+
+	const FloatVector block_offset = FloatVector::Random(blocksize);
+	const FloatMatrix block_jacobian_offset = FloatMatrix::Random(blocksize, resource_dim);
+
+	ok &= check(
+		"BlockWiseApplySensorTransform with add",
+		SensorTransformPtr(make_BlockWiseApplySensorTransform(
+			operand,
+			add<FloatVector>(block_offset),
+			subtract<FloatMatrix>(block_jacobian_offset),
+			blocksize
+		)),
+		resource_value,
+		result + block_offset.replicate(2, 1),
+		jacobian - block_jacobian_offset.replicate(2, 1)
+	);
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,127 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks that the steady state PrimitiveController::step() does not 
+	touch the heap, with the default JacobiSVD and with the WarmStartedSVD
+	inverting the jacobian, counting allocations with allocation_counter.h.
+	Note that this only holds for builds 
+	with CBF_NDEBUG defined, as the debug output allocates.
+*/
+
+#include <cbf/primitive_controller.h>
+#include <cbf/linear_transform.h>
+#include <cbf/identity_transform.h>
+#include <cbf/generic_transform.h>
+#include <cbf/square_potential.h>
+#include <cbf/dummy_reference.h>
+#include <cbf/dummy_resource.h>
+#include <cbf/combination_strategy.h>
+#include <cbf/convergence_criterion.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "allocation_counter.h"
+
+using namespace CBF;
+
+bool check_step(PseudoInverseSolver solver, const std::string &name) {
+	const unsigned int resource_dim = 7;
+	const unsigned int task_dim = 3;
+
+	FloatMatrix m = FloatMatrix::Zero(task_dim, resource_dim);
+	for (unsigned int i = 0; i < task_dim; ++i) {
+		m(i, i) = 1.0;
+		m(i, i + task_dim) = 0.5;
+	}
+	//! const, so the coefficient matrix constructor gets picked
+	const FloatMatrix &coefficients = m;
+
+	DummyReferencePtr subordinate_reference(new DummyReference(1, resource_dim));
+	subordinate_reference->set_reference(FloatVector::Zero(resource_dim));
+
+	std::vector<SubordinateControllerPtr> subordinates;
+	subordinates.push_back(SubordinateControllerPtr(
+		new SubordinateController(
+			0.1,
+			std::vector<ConvergenceCriterionPtr>(),
+			subordinate_reference,
+			PotentialPtr(new SquarePotential(resource_dim)),
+			SensorTransformPtr(new IdentitySensorTransform(resource_dim)),
+			EffectorTransformPtr(new GenericEffectorTransform(resource_dim, resource_dim)),
+			std::vector<SubordinateControllerPtr>(),
+			CombinationStrategyPtr(new AddingStrategy)
+		)
+	));
+
+	DummyReferencePtr reference(new DummyReference(1, task_dim));
+	FloatVector target(task_dim);
+	target << 1.0, -0.5, 0.25;
+	reference->set_reference(target);
+
+	DummyResourcePtr resource(new DummyResource(FloatVector::Constant(resource_dim, 0.1)));
+
+	std::vector<ConvergenceCriterionPtr> criteria;
+	criteria.push_back(ConvergenceCriterionPtr(new TaskSpaceDistanceThreshold(0.0)));
+
+	DampedGenericEffectorTransformPtr effector_transform(new DampedGenericEffectorTransform(task_dim, resource_dim));
+	effector_transform->set_solver(solver);
+
+	PrimitiveControllerPtr controller(
+		new PrimitiveController(
+			1.0,
+			criteria,
+			reference,
+			PotentialPtr(new SquarePotential(task_dim)),
+			SensorTransformPtr(new LinearSensorTransform(coefficients)),
+			effector_transform,
+			subordinates,
+			CombinationStrategyPtr(new AddingStrategy),
+			resource
+		)
+	);
+
+	//! The first cycles may still size lazily allocated buffers
+	for (unsigned int i = 0; i < 10; ++i)
+		controller->step();
+
+	num_allocations = 0;
+	counting = true;
+	for (unsigned int i = 0; i < 100; ++i)
+		controller->step();
+	counting = false;
+
+	std::cout << name << ": allocations during 100 steps: " << num_allocations << std::endl;
+
+	if (num_allocations != 0) {
+		std::cerr << "PrimitiveController::step() allocated memory with the " << name << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+int main() {
+	bool ok = true;
+	ok &= check_step(JacobiSVDSolver, "JacobiSVD");
+	ok &= check_step(WarmStartedSVDSolver, "WarmStartedSVD");
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
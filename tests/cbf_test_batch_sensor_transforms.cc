@@ -0,0 +1,97 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks that SensorTransform::update_batch() gives the same results and
+	jacobians as calling update() for each column, for the linear and
+	identity transforms, the generic fallback and a CompositeSensorTransform
+	of them, sequentially and on a ThreadPool.
+*/
+
+#include <cbf/linear_transform.h>
+#include <cbf/identity_transform.h>
+#include <cbf/norm_transform.h>
+#include <cbf/composite_transform.h>
+#include <cbf/thread_pool.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace CBF;
+
+bool check(const std::string &name, SensorTransformPtr transform) {
+	const unsigned int n = 50;
+	const unsigned int dim = transform->resource_dim();
+	const FloatMatrix resource_values = FloatMatrix::Random(dim, n);
+
+	FloatMatrix results, task_jacobians;
+	transform->update_batch(resource_values, results, task_jacobians);
+
+	if (
+		results.rows() != (int) transform->task_dim() || results.cols() != (int) n ||
+		task_jacobians.rows() != (int) transform->task_dim() || task_jacobians.cols() != (int) (n * dim)
+	) {
+		std::cerr << name << ": wrong sizes" << std::endl;
+		return false;
+	}
+
+	for (unsigned int i = 0; i < n; ++i) {
+		transform->update(resource_values.col(i));
+
+		if (
+			(results.col(i) - transform->result()).norm() > 1e-12 ||
+			(task_jacobians.middleCols(i * dim, dim) - transform->task_jacobian()).norm() > 1e-12
+		) {
+			std::cerr << name << ": column " << i << " differs from update()" << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main() {
+	srand(0);
+	bool ok = true;
+
+	const unsigned int dim = 5;
+
+	SensorTransformPtr linear(new LinearSensorTransform(FloatMatrix::Random(3, dim)));
+	SensorTransformPtr identity(new IdentitySensorTransform(dim));
+
+	//! Has no batched implementation of its own
+	SensorTransformPtr norm(new NormSensorTransform(SensorTransformPtr(new IdentitySensorTransform(dim))));
+
+	ok &= check("LinearSensorTransform", linear);
+	ok &= check("IdentitySensorTransform", identity);
+	ok &= check("NormSensorTransform", norm);
+
+	std::vector<SensorTransformPtr> transforms;
+	transforms.push_back(linear);
+	transforms.push_back(identity);
+	transforms.push_back(norm);
+	CompositeSensorTransformPtr composite(new CompositeSensorTransform(transforms));
+
+	ok &= check("CompositeSensorTransform", composite);
+
+	composite->set_thread_pool(ThreadPoolPtr(new ThreadPool(2)));
+	ok &= check("CompositeSensorTransform on a ThreadPool", composite);
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
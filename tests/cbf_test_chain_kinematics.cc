@@ -0,0 +1,219 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks that the native ChainKinematics transforms compute the same
+	results and jacobians as the KDL chain transforms, for the 7 DOF arm
+	and for a chain of general rotational and translational axes, also
+	batched, and prints how long each takes. Joints with an offset have
+	to work as well, joints with a scale have to be rejected.
+*/
+
+#include <cbf/chain_kinematics.h>
+#include <cbf/kdl_transforms.h>
+
+#include <kdl/chain.hpp>
+#include <kdl/segment.hpp>
+#include <kdl/joint.hpp>
+#include <kdl/frames.hpp>
+
+#include <sys/time.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace CBF;
+
+boost::shared_ptr<KDL::Chain> create_arm() {
+	using namespace KDL;
+	boost::shared_ptr<Chain> chain(new Chain);
+
+	chain->addSegment(Segment(Joint(Joint::None), Frame(Rotation(), Vector(0.0, 0.0, 0.118))));
+	chain->addSegment(Segment(Joint(Joint::RotZ), Frame(Rotation::RotZ(M_PI), Vector(0.0, 0.0, 0.192))));
+	chain->addSegment(Segment(Joint(Joint::RotY), Frame(Rotation(), Vector(0.0, 0.0, 0.208))));
+	chain->addSegment(Segment(Joint(Joint::RotZ), Frame(Rotation::RotZ(M_PI), Vector(0.0, 0.0, 0.192))));
+	chain->addSegment(Segment(Joint(Joint::RotY), Frame(Rotation(), Vector(0.0, 0.0, 0.208))));
+	chain->addSegment(Segment(Joint(Joint::RotZ), Frame(Rotation::RotZ(M_PI), Vector(0.0, 0.0, 0.182))));
+	chain->addSegment(Segment(Joint(Joint::RotY), Frame(Rotation(), Vector(0.0, 0.0, 0.0))));
+	chain->addSegment(Segment(Joint(Joint::RotZ), Frame(Rotation::RotZ(-M_PI), Vector(0.0, 0.0, 0.12))));
+
+	return chain;
+}
+
+/**
+	A joint about or along the axis rotation * z is the same as a fixed
+	rotation, a joint about or along z and the inverse rotation. The KDL
+	chain takes the long way, the native one gets general axes.
+*/
+void create_general_chains(boost::shared_ptr<KDL::Chain> &kdl_chain, ChainKinematicsPtr &kinematics) {
+	using namespace KDL;
+	kdl_chain.reset(new Chain);
+	kinematics.reset(new ChainKinematics);
+
+	for (unsigned int i = 0; i < 6; ++i) {
+		const Rotation rotation = Rotation::RPY(0.3 + 0.2 * i, -0.5 + 0.1 * i, 0.7 * i);
+		const Frame tip(Rotation::RotX(0.1 * i), Vector(0.1, 0.02 * i, 0.2));
+		const bool translational = (i % 3 == 2);
+
+		kdl_chain->addSegment(Segment(Joint(Joint::None), Frame(rotation)));
+		kdl_chain->addSegment(Segment(
+			Joint(translational ? Joint::TransZ : Joint::RotZ),
+			Frame(rotation.Inverse()) * tip
+		));
+
+		const Vector axis = rotation * Vector(0.0, 0.0, 1.0);
+		Matrix3 tip_rotation;
+		for (unsigned int row = 0; row < 3; ++row)
+			for (unsigned int col = 0; col < 3; ++col)
+				tip_rotation(row, col) = tip.M(row, col);
+
+		kinematics->add_segment(
+			translational ? ChainKinematics::TranslationalJoint : ChainKinematics::RotationalJoint,
+			Vector3(axis.x(), axis.y(), axis.z()),
+			Vector3::Zero(),
+			tip_rotation,
+			Vector3(tip.p.x(), tip.p.y(), tip.p.z())
+		);
+	}
+}
+
+//! A rotational and a translational joint with offsets, and a third joint with the given scale
+boost::shared_ptr<KDL::Chain> create_offset_chain(double scale) {
+	using namespace KDL;
+	boost::shared_ptr<Chain> chain(new Chain);
+
+	chain->addSegment(Segment(Joint(Joint::RotZ, 1.0, 0.4), Frame(Rotation::RotX(0.3), Vector(0.0, 0.1, 0.2))));
+	chain->addSegment(Segment(Joint(Joint::TransY, 1.0, -0.2), Frame(Rotation::RotY(-0.5), Vector(0.1, 0.0, 0.3))));
+	chain->addSegment(Segment(Joint(Joint::RotX, scale), Frame(Rotation(), Vector(0.0, 0.0, 0.1))));
+
+	return chain;
+}
+
+double seconds() {
+	timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+//! Runs both transforms on the same random joint values
+bool compare(const std::string &name, SensorTransformPtr kdl, SensorTransformPtr native) {
+	const unsigned int cycles = 1000;
+	double kdl_time = 0, native_time = 0;
+
+	for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
+		FloatVector resource_value = 3.0 * FloatVector::Random(kdl->resource_dim());
+
+		double start = seconds();
+		kdl->update(resource_value);
+		kdl_time += seconds() - start;
+
+		start = seconds();
+		native->update(resource_value);
+		native_time += seconds() - start;
+
+		const Float result_error = (kdl->result() - native->result()).norm();
+		const Float jacobian_error = (kdl->task_jacobian() - native->task_jacobian()).norm();
+
+		if (result_error > 1e-10 || jacobian_error > 1e-10) {
+			std::cerr << name << " differs in cycle " << cycle
+				<< ", result error " << result_error << ", jacobian error " << jacobian_error << std::endl;
+			return false;
+		}
+	}
+
+	//! Both batched versions have to agree with update()
+	const FloatMatrix resource_values = FloatMatrix::Random(kdl->resource_dim(), 20);
+	FloatMatrix kdl_results, kdl_task_jacobians, native_results, native_task_jacobians;
+	kdl->update_batch(resource_values, kdl_results, kdl_task_jacobians);
+	native->update_batch(resource_values, native_results, native_task_jacobians);
+
+	for (unsigned int i = 0; i < resource_values.cols(); ++i) {
+		kdl->update(resource_values.col(i));
+		const unsigned int dim = kdl->resource_dim();
+
+		if (
+			(kdl_results.col(i) - kdl->result()).norm() > 1e-12 ||
+			(kdl_task_jacobians.middleCols(i * dim, dim) - kdl->task_jacobian()).norm() > 1e-12 ||
+			(native_results.col(i) - kdl->result()).norm() > 1e-10 ||
+			(native_task_jacobians.middleCols(i * dim, dim) - kdl->task_jacobian()).norm() > 1e-10
+		) {
+			std::cerr << name << " differs in batch column " << i << std::endl;
+			return false;
+		}
+	}
+
+	std::cout << name << std::endl;
+	std::cout << "  KDL:    " << 1e6 * kdl_time / cycles << " us" << std::endl;
+	std::cout << "  native: " << 1e6 * native_time / cycles << " us" << std::endl;
+
+	return true;
+}
+
+int main() {
+	srand(0);
+	bool ok = true;
+
+	boost::shared_ptr<KDL::Chain> arm = create_arm();
+
+	ok &= compare(
+		"arm position",
+		SensorTransformPtr(new KDLChainPositionSensorTransform(arm)),
+		SensorTransformPtr(new ChainPositionSensorTransform(ChainKinematicsPtr(new ChainKinematics(*arm)))));
+
+	ok &= compare(
+		"arm axis angle",
+		SensorTransformPtr(new KDLChainAxisAngleSensorTransform(arm)),
+		SensorTransformPtr(new ChainAxisAngleSensorTransform(ChainKinematicsPtr(new ChainKinematics(*arm)))));
+
+	ok &= compare(
+		"arm pose",
+		SensorTransformPtr(new KDLChainPoseSensorTransform(arm)),
+		SensorTransformPtr(new ChainPoseSensorTransform(ChainKinematicsPtr(new ChainKinematics(*arm)))));
+
+	boost::shared_ptr<KDL::Chain> general_chain;
+	ChainKinematicsPtr general_kinematics;
+	create_general_chains(general_chain, general_kinematics);
+
+	ok &= compare(
+		"general axes pose",
+		SensorTransformPtr(new KDLChainPoseSensorTransform(general_chain)),
+		SensorTransformPtr(new ChainPoseSensorTransform(general_kinematics)));
+
+	boost::shared_ptr<KDL::Chain> offset_chain = create_offset_chain(1.0);
+
+	ok &= compare(
+		"joint offsets pose",
+		SensorTransformPtr(new KDLChainPoseSensorTransform(offset_chain)),
+		SensorTransformPtr(new ChainPoseSensorTransform(ChainKinematicsPtr(new ChainKinematics(*offset_chain)))));
+
+	bool rejected = false;
+	try {
+		ChainKinematics scaled(*create_offset_chain(2.0));
+	} catch (const std::runtime_error &e) {
+		std::cout << "scaled joint: " << e.what() << std::endl;
+		rejected = true;
+	}
+
+	if (!rejected) {
+		std::cerr << "a scaled joint was accepted" << std::endl;
+		ok = false;
+	}
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
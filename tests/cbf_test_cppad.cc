@@ -7,9 +7,104 @@
 #include <cbf/combination_strategy.h>
 #include <cbf/generic_transform.h>
 
+#include <sys/time.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
 using namespace CBF;
 
+double seconds() {
+	timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+//! A chain of n links in the plane whose joint positions each depend on the angles before them
+CppAD::ADFun<Float> create_chain(unsigned int n) {
+	ADFloatVector x(n);
+	for (unsigned int i = 0; i < n; ++i) x[i] = 0.0;
+	CppAD::Independent(x);
+
+	ADFloatVector y(2 * n);
+	CppAD::AD<Float> angle = 0.0, px = 0.0, py = 0.0;
+	for (unsigned int i = 0; i < n; ++i) {
+		angle += x[i];
+		px += CppAD::cos(angle);
+		py += CppAD::sin(angle);
+		y[2 * i] = px;
+		y[2 * i + 1] = py;
+	}
+
+	return CppAD::ADFun<Float>(x, y);
+}
+
+//! Pairs of neighbouring inputs, so the jacobian is banded
+CppAD::ADFun<Float> create_banded(unsigned int n) {
+	ADFloatVector x(n);
+	for (unsigned int i = 0; i < n; ++i) x[i] = 0.0;
+	CppAD::Independent(x);
+
+	ADFloatVector y(n - 1);
+	for (unsigned int i = 0; i + 1 < n; ++i)
+		y[i] = CppAD::sin(x[i]) * x[i + 1] + x[i] * x[i];
+
+	return CppAD::ADFun<Float>(x, y);
+}
+
+//! Compares the dense and the sparse mode with CppAD's own Jacobian() and prints the timings
+bool compare(const std::string &name, CppAD::ADFun<Float> &f) {
+	CppADSensorTransform dense(f, f.Range(), f.Domain());
+	CppADSensorTransform sparse(f, f.Range(), f.Domain(), true);
+
+	const unsigned int cycles = 1000;
+	double jacobian_time = 0, dense_time = 0, sparse_time = 0;
+
+	for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
+		const FloatVector resource_value = FloatVector::Random(f.Domain());
+
+		//! What the transform did before: Jacobian() is row major
+		double start = seconds();
+		const FloatVector result = f.Forward(0, resource_value);
+		const FloatVector values = f.Jacobian(resource_value);
+		jacobian_time += seconds() - start;
+
+		FloatMatrix jacobian(f.Range(), f.Domain());
+		for (unsigned int row = 0; row < f.Range(); ++row)
+			for (unsigned int col = 0; col < f.Domain(); ++col)
+				jacobian(row, col) = values[row * f.Domain() + col];
+
+		start = seconds();
+		dense.update(resource_value);
+		dense.task_jacobian();
+		dense_time += seconds() - start;
+
+		start = seconds();
+		sparse.update(resource_value);
+		sparse.task_jacobian();
+		sparse_time += seconds() - start;
+
+		if (
+			(dense.result() - result).norm() > 1e-12 || (sparse.result() - result).norm() > 1e-12 ||
+			(dense.task_jacobian() - jacobian).norm() > 1e-12 || (sparse.task_jacobian() - jacobian).norm() > 1e-12
+		) {
+			std::cerr << name << " differs in cycle " << cycle << std::endl;
+			return false;
+		}
+	}
+
+	std::cout << name << " (" << sparse.nonzeros() << " of " << f.Range() * f.Domain() << " entries nonzero)" << std::endl;
+	std::cout << "  Jacobian(): " << 1e6 * jacobian_time / cycles << " us" << std::endl;
+	std::cout << "  dense:      " << 1e6 * dense_time / cycles << " us" << std::endl;
+	std::cout << "  sparse:     " << 1e6 * sparse_time / cycles << " us" << std::endl;
+
+	return true;
+}
+
 int main() {
+	srand(0);
+
 	ADFloatVector x(2);
 	x[0] = 0; x[1] = 1;
 	CppAD::Independent(x);
@@ -28,8 +123,10 @@ int main() {
 
 	std::cout << s->result() << std::endl;
 	std::cout << s->task_jacobian() << std::endl;
-	assert (s->result()(0) == 1.0);
-	assert (s->task_jacobian()(0,0) == 0.0 && s->task_jacobian()(0,1) == 5.0);
+	if (s->result()(0) != 1.0 || s->task_jacobian()(0,0) != 0.0 || s->task_jacobian()(0,1) != 5.0) {
+		std::cerr << "Wrong result or jacobian" << std::endl;
+		return EXIT_FAILURE;
+	}
 
 	PrimitiveControllerPtr c(new PrimitiveController(
 		0.1,
@@ -45,4 +142,15 @@ int main() {
 
 	for (unsigned int n = 0; n < 1000; ++n)
 		{ c->step(); }
+
+	bool ok = true;
+
+	//! More outputs than inputs uses forward sweeps, the other way round reverse ones
+	CppAD::ADFun<Float> chain = create_chain(10);
+	ok &= compare("planar chain", chain);
+
+	CppAD::ADFun<Float> banded = create_banded(40);
+	ok &= compare("banded", banded);
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
 }
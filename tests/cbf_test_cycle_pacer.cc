@@ -0,0 +1,210 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks that CyclePacer keeps a fixed rate without drifting when the
+	cycles take varying time, and how it recovers from an overrun with
+	either policy, that every pacer records into its own histograms and
+	that ScopedRealTime restores the thread's CPU affinity and unlocks the
+	memory it locked. Prints the
+	period, jitter and overrun histograms.
+*/
+
+#include <cbf/cycle_pacer.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace CBF;
+
+const unsigned long long millisecond = 1000000ULL;
+
+//! The deadlines are checked with this much slack, for loaded machines
+const unsigned long long tolerance = 3 * millisecond;
+
+void busy(unsigned long long nanoseconds) {
+	const unsigned long long end = cycle_time_now() + nanoseconds;
+	while (cycle_time_now() < end) { }
+}
+
+bool check(bool condition, const std::string &message) {
+	if (!condition) std::cerr << message << std::endl;
+	return condition;
+}
+
+bool check_fixed_rate() {
+	const unsigned long long period = 2 * millisecond;
+	const unsigned int cycles = 250;
+
+	CyclePacer pacer(period, CyclePacer::Skip, "fixed_rate");
+	const unsigned long long start = cycle_time_now();
+	pacer.start();
+
+	//! Skipped deadlines still count for the schedule
+	unsigned long long deadlines = cycles;
+
+	for (unsigned int i = 0; i < cycles; ++i) {
+		busy(rand() % millisecond);
+		deadlines += pacer.wait();
+	}
+
+	//! Sleeping a fixed time after each cycle would take half as long again
+	const unsigned long long elapsed = cycle_time_now() - start;
+	std::cout << "fixed rate: " << cycles << " cycles of " << period << " ns in " << elapsed << " ns, "
+		<< pacer.overruns() << " overruns" << std::endl;
+
+	bool ok = true;
+	ok &= check(elapsed >= deadlines * period, "faster than the period");
+	ok &= check(elapsed < deadlines * period + tolerance, "drifted");
+	ok &= check(pacer.overruns() < cycles / 10, "too many overruns");
+	ok &= check(pacer.m_PeriodHistogram->samples() == cycles, "wrong number of periods recorded");
+	return ok;
+}
+
+bool check_overrun(CyclePacer::OverrunPolicy policy, const std::string &name) {
+	const unsigned long long period = 10 * millisecond;
+
+	CyclePacer pacer(period, policy, name);
+	const unsigned long long start = cycle_time_now();
+	pacer.start();
+
+	//! Ends after the deadlines at 10 and 20 ms
+	busy(25 * millisecond);
+	const unsigned int missed = pacer.wait();
+	const unsigned long long first = cycle_time_now() - start;
+
+	bool ok = true;
+	ok &= check(missed == 2, name + ": did not miss two deadlines");
+	ok &= check(pacer.overruns() == 1, name + ": not one overrun");
+	ok &= check(pacer.m_OverrunHistogram->samples() == 1, name + ": overrun not recorded");
+	ok &= check(pacer.max_overrun() >= 15 * millisecond, name + ": largest overrun not kept");
+
+	if (policy == CyclePacer::Skip) {
+		//! Sleeps until the deadline at 30 ms, which is kept
+		ok &= check(first >= 30 * millisecond && first < 30 * millisecond + tolerance, name + ": did not skip to the next deadline");
+		pacer.wait();
+		const unsigned long long second = cycle_time_now() - start;
+		ok &= check(second >= 40 * millisecond && second < 40 * millisecond + tolerance, name + ": lost the schedule");
+	} else {
+		//! The cycle of the deadline at 20 ms runs right away, then the one at 30 ms is on time
+		ok &= check(first < 25 * millisecond + tolerance, name + ": slept after an overrun");
+		const unsigned int missed_again = pacer.wait();
+		const unsigned long long second = cycle_time_now() - start;
+		ok &= check(missed_again == 1 && second < 25 * millisecond + tolerance, name + ": did not catch up");
+		pacer.wait();
+		const unsigned long long third = cycle_time_now() - start;
+		ok &= check(third >= 30 * millisecond && third < 30 * millisecond + tolerance, name + ": lost the schedule");
+	}
+
+	return ok;
+}
+
+bool check_own_histograms() {
+	CyclePacer a(millisecond), b(millisecond);
+
+	bool ok = true;
+	ok &= check(a.m_PeriodHistogram != b.m_PeriodHistogram, "pacers share the period histogram");
+	ok &= check(a.m_JitterHistogram != b.m_JitterHistogram, "pacers share the jitter histogram");
+	ok &= check(a.m_OverrunHistogram != b.m_OverrunHistogram, "pacers share the overrun histogram");
+
+	a.start();
+	a.wait();
+	ok &= check(b.m_PeriodHistogram->samples() == 0, "recorded into another pacer's histogram");
+	ok &= check(a.max_period() >= millisecond, "largest period not kept");
+	return ok;
+}
+
+bool check_scoped_real_time() {
+	#ifdef __linux__
+		cpu_set_t before, pinned, after;
+		pthread_getaffinity_np(pthread_self(), sizeof(before), &before);
+
+		RealTimeOptions options;
+		options.cpu = 0;
+
+		{
+			ScopedRealTime real_time(options);
+			pthread_getaffinity_np(pthread_self(), sizeof(pinned), &pinned);
+		}
+		pthread_getaffinity_np(pthread_self(), sizeof(after), &after);
+
+		bool ok = true;
+		ok &= check(CPU_COUNT(&pinned) == 1 && CPU_ISSET(0, &pinned), "thread not pinned");
+		ok &= check(CPU_EQUAL(&before, &after), "CPU affinity not restored");
+		return ok;
+	#else
+		return true;
+	#endif
+}
+
+//! The process' locked memory in kB, from /proc/self/status
+unsigned long locked_memory() {
+	std::ifstream status("/proc/self/status");
+	std::string key;
+	unsigned long value = 0;
+	while (status >> key) {
+		if (key == "VmLck:") {
+			status >> value;
+			break;
+		}
+	}
+	return value;
+}
+
+bool check_memory_unlocked() {
+	#ifdef __linux__
+		RealTimeOptions options;
+		options.lock_memory = true;
+
+		unsigned long locked = 0;
+		try {
+			ScopedRealTime real_time(options);
+			locked = locked_memory();
+		} catch (std::runtime_error &e) {
+			std::cout << "Not checking memory locking: " << e.what() << std::endl;
+			return true;
+		}
+
+		bool ok = true;
+		ok &= check(locked > 0, "memory not locked");
+		ok &= check(locked_memory() == 0, "memory not unlocked");
+		return ok;
+	#else
+		return true;
+	#endif
+}
+
+int main() {
+	srand(0);
+	bool ok = true;
+
+	ok &= check_fixed_rate();
+	ok &= check_overrun(CyclePacer::Skip, "skip");
+	ok &= check_overrun(CyclePacer::CatchUp, "catch_up");
+
+	ok &= check(CyclePacer(millisecond).policy() == CyclePacer::Skip, "wrong default policy");
+	ok &= check_own_histograms();
+	ok &= check_scoped_real_time();
+	ok &= check_memory_unlocked();
+
+	print_cycle_time_histograms(std::cout);
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,215 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks the ExpressionSensorTransform and ExpressionPotential against
+	hand written results and finite differences, that constants are folded
+	and common subexpressions shared, that syntax errors are reported and
+	that updates do not touch the heap (counted with
+	allocation_counter.h).
+*/
+
+#include <cbf/expression_sensor_transform.h>
+#include <cbf/expression_potential.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "allocation_counter.h"
+
+using namespace CBF;
+
+ExpressionProgram compile(const std::string &expression, unsigned int dim) {
+	return ExpressionProgram(
+		std::vector<std::string>(1, expression),
+		std::vector<ExpressionProgram::Variable>(1, ExpressionProgram::Variable("x", dim))
+	);
+}
+
+bool check_planar_arm() {
+	std::vector<std::string> expressions;
+	expressions.push_back("cos(x[0]) + 0.5 * cos(x[0] + x[1])");
+	expressions.push_back("sin(x[0]) + 0.5 * sin(x[0] + x[1])");
+	ExpressionSensorTransform transform(expressions, 2);
+
+	FloatVector q(2);
+	q << 0.3, -1.1;
+	transform.update(q);
+
+	FloatVector result(2);
+	result << std::cos(q[0]) + 0.5 * std::cos(q[0] + q[1]), std::sin(q[0]) + 0.5 * std::sin(q[0] + q[1]);
+
+	FloatMatrix jacobian(2, 2);
+	jacobian <<
+		-std::sin(q[0]) - 0.5 * std::sin(q[0] + q[1]), -0.5 * std::sin(q[0] + q[1]),
+		std::cos(q[0]) + 0.5 * std::cos(q[0] + q[1]), 0.5 * std::cos(q[0] + q[1]);
+
+	if ((transform.result() - result).norm() > 1e-12 || (transform.task_jacobian() - jacobian).norm() > 1e-12) {
+		std::cerr << "planar arm: wrong result or jacobian" << std::endl;
+		return false;
+	}
+
+	if (transform.task_dim() != 2 || transform.resource_dim() != 2) {
+		std::cerr << "planar arm: wrong dimensions" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+//! All operators and functions against central differences
+bool check_finite_differences() {
+	std::vector<std::string> expressions;
+	expressions.push_back("x[0]^2 * x[1] - x[2] / x[0] + pow(x[1], x[2]) + 2^x[0]");
+	expressions.push_back("tan(x[0]) * exp(x[1]) + log(x[2]) * sqrt(x[1]) - -abs(x[0] - x[2])");
+	expressions.push_back("asin(x[0] / 2) + acos(x[1] / 3) + atan(x[2]) + atan2(x[0], x[1] * x[2])");
+	ExpressionSensorTransform transform(expressions, 3);
+
+	FloatVector q(3);
+	q << 0.4, 1.3, 0.7;
+	transform.update(q);
+	const FloatMatrix jacobian = transform.task_jacobian();
+
+	const Float h = 1e-6;
+	for (unsigned int i = 0; i < 3; ++i) {
+		FloatVector plus = q, minus = q;
+		plus[i] += h;
+		minus[i] -= h;
+
+		transform.update(plus);
+		const FloatVector result_plus = transform.result();
+		transform.update(minus);
+		const FloatVector result_minus = transform.result();
+
+		const FloatVector difference = (result_plus - result_minus) / (2 * h);
+		if ((difference - jacobian.col(i)).norm() > 1e-6) {
+			std::cerr << "finite differences: column " << i << " differs: "
+				<< difference.transpose() << " vs. " << jacobian.col(i).transpose() << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool check_compilation() {
+	bool ok = true;
+
+	//! Input, sin, the sum of the sines, the folded constant and the total
+	ExpressionProgram program = compile("2 * 3 + sin(x[0]) + sin(x[0])", 1);
+	if (program.size() != 5) {
+		std::cerr << "expected 5 instructions, got " << program.size() << std::endl;
+		ok = false;
+	}
+
+	//! Scalar variables need no index
+	ExpressionProgram scalar = compile("x * x - e^2 * pi", 1);
+	FloatVector input = FloatVector::Constant(1, 3.0), result(1);
+	scalar.evaluate(input, result);
+	if (std::fabs(result[0] - (9.0 - M_E * M_E * M_PI)) > 1e-12) {
+		std::cerr << "wrong scalar result " << result[0] << std::endl;
+		ok = false;
+	}
+
+	const char *invalid[] = { "sin(x[0]", "x[3]", "foo(x[0])", "x[0] +", "x", "y[0]", "atan2(x[0])", "x[0] x[1]" };
+	for (unsigned int i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+		try {
+			compile(invalid[i], 3);
+			std::cerr << "\"" << invalid[i] << "\" compiled" << std::endl;
+			ok = false;
+		} catch (std::runtime_error &e) { }
+	}
+
+	return ok;
+}
+
+bool check_potential() {
+	ExpressionPotential potential("0.5 * ((x[0] - r[0])^2 + 4 * (x[1] - r[1])^2)", 2);
+	potential.set_max_gradient_step_norm(100);
+
+	std::vector<FloatVector> references;
+	references.push_back(FloatVector::Constant(2, 5.0));
+	references.push_back(FloatVector::Constant(2, 1.0));
+
+	FloatVector input(2), result(2), expected(2);
+	input << 0.5, 0.25;
+	potential.gradient(result, references, input);
+
+	//! Towards the closer second reference
+	expected << 1.0 - 0.5, 4 * (1.0 - 0.25);
+	if ((result - expected).norm() > 1e-12) {
+		std::cerr << "potential: wrong gradient " << result.transpose() << std::endl;
+		return false;
+	}
+
+	if (std::fabs(potential.value(references[1], input) - 0.5 * (0.25 + 4 * 0.5625)) > 1e-12) {
+		std::cerr << "potential: wrong value" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool check_allocations() {
+	std::vector<std::string> expressions;
+	expressions.push_back("cos(x[0]) + 0.5 * cos(x[0] + x[1])");
+	expressions.push_back("sin(x[0]) + 0.5 * sin(x[0] + x[1])");
+	ExpressionSensorTransform transform(expressions, 2);
+
+	ExpressionPotential potential("0.5 * ((x[0] - r[0])^2 + (x[1] - r[1])^2)", 2);
+	std::vector<FloatVector> references(1, FloatVector::Zero(2));
+
+	FloatVector resource_value = FloatVector::Zero(2), gradient = FloatVector::Zero(2);
+
+	//! The first update may still size the registers
+	transform.update(resource_value);
+	transform.task_jacobian();
+	potential.gradient(gradient, references, resource_value);
+
+	num_allocations = 0;
+	counting = true;
+	for (unsigned int i = 0; i < 100; ++i) {
+		resource_value.array() += 0.01;
+		transform.update(resource_value);
+		transform.task_jacobian();
+		potential.gradient(gradient, references, resource_value);
+	}
+	counting = false;
+
+	if (num_allocations != 0) {
+		std::cerr << num_allocations << " allocations during 100 updates" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+int main() {
+	bool ok = true;
+
+	ok &= check_planar_arm();
+	ok &= check_finite_differences();
+	ok &= check_compilation();
+	ok &= check_potential();
+	ok &= check_allocations();
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
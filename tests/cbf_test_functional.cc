@@ -3,7 +3,6 @@
 #include <cbf/dummy_resource.h>
 
 #include <iostream>
-#include <functional>
 
 int main() {
 	CBF::SensorTransformPtr id(new CBF::IdentitySensorTransform(9));
@@ -17,8 +16,8 @@ int main() {
 	CBF::SensorTransformPtr s(
 		CBF::make_ApplySensorTransform(
 			id,
-			std::bind2nd(CBF::multiplies<CBF::FloatVector, double>(), 1.3),
-			std::bind2nd(CBF::multiplies<CBF::FloatMatrix, double>(), 1.4)
+			CBF::multiply_by(1.3),
+			CBF::multiply_by(1.4)
 		)
 	);
 
@@ -31,8 +30,8 @@ int main() {
 	CBF::SensorTransformPtr s2(
 		CBF::make_BlockWiseApplySensorTransform(
 			id,
-			std::bind2nd(CBF::multiplies<CBF::FloatVector, double>(), 1.3),
-			std::bind2nd(CBF::multiplies<CBF::FloatMatrix, double>(), 1.4),
+			CBF::multiply_by(1.3),
+			CBF::multiply_by(1.4),
 			3
 		)
 	);
@@ -46,8 +45,8 @@ int main() {
 	CBF::SensorTransformPtr s3(
 		new CBF::MultiplyOperationSensorTransform(
 			id, 
-			std::bind2nd(CBF::multiplies<CBF::FloatVector, double>(), 1.3),
-			std::bind2nd(CBF::multiplies<CBF::FloatMatrix, double>(), 1.4)
+			CBF::multiply_by(1.3),
+			CBF::multiply_by(1.4)
 		)
 	);
 
@@ -70,8 +69,8 @@ int main() {
 	CBF::SensorTransformPtr s4(
 		CBF::make_BlockWiseApplySensorTransform(
 			id,
-			std::bind2nd(std::plus<CBF::FloatVector>(), v),
-			std::bind2nd(std::plus<CBF::FloatMatrix>(), m),
+			CBF::add<CBF::FloatVector>(v),
+			CBF::add<CBF::FloatMatrix>(m),
 			3
 		)
 	);
@@ -89,8 +88,8 @@ int main() {
 		CBF::make_BlockWiseAccumulateSensorTransform
 		(
 			id,
-			std::plus<CBF::FloatVector>(),
-			std::plus<CBF::FloatMatrix>(),
+			CBF::add_to(),
+			CBF::add_to(),
 			CBF::FloatVector::Zero(3),
 			CBF::FloatMatrix::Zero(3,9),
 			3
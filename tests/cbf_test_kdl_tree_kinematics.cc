@@ -0,0 +1,213 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks that the single pass KDLTreeKinematics computes the same
+	fingertip frames and jacobians of a five finger hand as the KDL tree
+	solvers, that the batched tree transforms agree with update(), and 
+	prints how long each takes.
+*/
+
+#include <cbf/kdl_transforms.h>
+
+#include <kdl/tree.hpp>
+#include <kdl/chain.hpp>
+#include <kdl/segment.hpp>
+#include <kdl/joint.hpp>
+#include <kdl/frames.hpp>
+#include <kdl/jntarray.hpp>
+#include <kdl/jacobian.hpp>
+#include <kdl/treejnttojacsolver.hpp>
+#include <kdl/treefksolverpos_recursive.hpp>
+
+#include <sys/time.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace CBF;
+
+//! An arm with a palm and five fingers of three links each
+boost::shared_ptr<KDL::Tree> create_hand(std::vector<std::string> &fingertips) {
+	boost::shared_ptr<KDL::Tree> tree(new KDL::Tree("base"));
+
+	KDL::Chain arm;
+	for (unsigned int i = 0; i < 7; ++i) {
+		std::stringstream name;
+		name << "arm" << i;
+		arm.addSegment(KDL::Segment(
+			name.str(),
+			KDL::Joint(i % 2 ? KDL::Joint::RotY : KDL::Joint::RotZ),
+			KDL::Frame(KDL::Vector(0.0, 0.0, 0.2))
+		));
+	}
+	arm.addSegment(KDL::Segment("palm", KDL::Joint(KDL::Joint::None), KDL::Frame(KDL::Vector(0.0, 0.0, 0.1))));
+	tree->addChain(arm, "base");
+
+	for (unsigned int finger = 0; finger < 5; ++finger) {
+		KDL::Chain chain;
+		chain.addSegment(KDL::Segment(
+			"finger_base" + std::string(1, '0' + finger),
+			KDL::Joint(KDL::Joint::RotZ),
+			KDL::Frame(KDL::Rotation::RotZ(0.3 * finger), KDL::Vector(0.02 * finger, 0.01, 0.05))
+		));
+
+		for (unsigned int link = 0; link < 3; ++link) {
+			std::stringstream name;
+			name << "finger" << finger << "_" << link;
+			chain.addSegment(KDL::Segment(
+				name.str(),
+				KDL::Joint(KDL::Joint::RotX),
+				KDL::Frame(KDL::Vector(0.0, 0.0, 0.03))
+			));
+
+			if (link == 2) fingertips.push_back(name.str());
+		}
+
+		tree->addChain(chain, "palm");
+	}
+
+	return tree;
+}
+
+double seconds() {
+	timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+int main() {
+	srand(0);
+
+	std::vector<std::string> fingertips;
+	boost::shared_ptr<KDL::Tree> tree = create_hand(fingertips);
+
+	KDLTreeKinematics kinematics(tree);
+	for (unsigned int i = 0; i < fingertips.size(); ++i)
+		kinematics.add_segment(fingertips[i]);
+
+	KDL::TreeFkSolverPos_recursive fk_solver(*tree);
+	KDL::TreeJntToJacSolver jac_solver(*tree);
+
+	KDL::JntArray joints(tree->getNrOfJoints());
+	KDL::Frame frame;
+	KDL::Jacobian jacobian(tree->getNrOfJoints());
+
+	const unsigned int cycles = 1000;
+	double kdl_time = 0, single_pass_time = 0;
+
+	for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
+		FloatVector resource_value = FloatVector::Random(tree->getNrOfJoints());
+		joints.data = resource_value;
+
+		KDLTreeKinematics::Lock lock(kinematics.mutex());
+
+		double start = seconds();
+		kinematics.update(lock, resource_value, 0);
+		kinematics.update_jacobian(lock, resource_value, 0);
+		single_pass_time += seconds() - start;
+
+		for (unsigned int i = 0; i < fingertips.size(); ++i) {
+			start = seconds();
+			fk_solver.JntToCart(joints, frame, fingertips[i]);
+			jac_solver.JntToJac(joints, jacobian, fingertips[i]);
+			kdl_time += seconds() - start;
+
+			double frame_error = (kinematics.frame(lock, i).p - frame.p).Norm();
+			for (unsigned int row = 0; row < 3; ++row)
+				for (unsigned int col = 0; col < 3; ++col)
+					frame_error += std::abs(kinematics.frame(lock, i).M(row, col) - frame.M(row, col));
+
+			double jacobian_error = (kinematics.jacobian(lock, i).data - jacobian.data).norm();
+
+			if (frame_error > 1e-12 || jacobian_error > 1e-12) {
+				std::cerr << "Wrong kinematics of " << fingertips[i] << " in cycle " << cycle
+					<< ", frame error " << frame_error << ", jacobian error " << jacobian_error << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	//! The batched transforms must agree with update()
+	KDLTreePositionSensorTransform position(tree, fingertips);
+	KDLTreeAxisAngleSensorTransform axis_angle(KDLTreeKinematicsPtr(new KDLTreeKinematics(tree)), fingertips);
+	BaseKDLTreeSensorTransform *transforms[] = { &position, &axis_angle };
+
+	const unsigned int dim = tree->getNrOfJoints();
+	const FloatMatrix resource_values = FloatMatrix::Random(dim, 20);
+
+	for (unsigned int t = 0; t < 2; ++t) {
+		FloatMatrix results, task_jacobians;
+		transforms[t]->update_batch(resource_values, results, task_jacobians);
+
+		for (unsigned int i = 0; i < resource_values.cols(); ++i) {
+			transforms[t]->update(resource_values.col(i));
+
+			if (
+				(results.col(i) - transforms[t]->result()).norm() > 1e-12 ||
+				(task_jacobians.middleCols(i * dim, dim) - transforms[t]->task_jacobian()).norm() > 1e-12
+			) {
+				std::cerr << "Batched tree transform differs in column " << i << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	//! Known resource versions decide on their own, unknown ones (0) compare the values
+	{
+		KDLTreeKinematics versioned(tree);
+		versioned.add_segment(fingertips[0]);
+		KDLTreeKinematics::Lock lock(versioned.mutex());
+
+		const FloatVector first = FloatVector::Random(dim), second = FloatVector::Random(dim);
+		versioned.update(lock, first, 1);
+		versioned.update(lock, second, 1);
+		const unsigned long same_version = versioned.computations();
+		versioned.update(lock, second, 2);
+		versioned.update(lock, second, 0);
+		versioned.update(lock, first, 0);
+
+		if (same_version != 1 || versioned.computations() != 3) {
+			std::cerr << "Kinematics not keyed on the resource version: " 
+				<< versioned.computations() << " computations" << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		bool thrown = false;
+		KDLTreeKinematics other(tree);
+		try {
+			other.frame(lock, 0);
+		} catch (const std::exception &) {
+			thrown = true;
+		}
+
+		if (!thrown) {
+			std::cerr << "Read with the lock of another kinematics" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::cout << fingertips.size() << " fingertips, " << tree->getNrOfJoints() << " joints" << std::endl;
+	std::cout << "  KDL tree solvers:     " << 1e6 * kdl_time / cycles << " us" << std::endl;
+	std::cout << "  KDLTreeKinematics:    " << 1e6 * single_pass_time / cycles << " us" << std::endl;
+
+	return EXIT_SUCCESS;
+}
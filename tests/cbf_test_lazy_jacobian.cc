@@ -0,0 +1,179 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks that task jacobians are only computed when asked for, once per
+	update, also through CompositeSensorTransform (sequentially and on a
+	ThreadPool) and DifferenceSensorTransform, and that the lazily computed
+	jacobians are the right ones. Also runs a transform shared by parallel 
+	jobs, like subordinate controllers on a pool.
+*/
+
+#include <cbf/sensor_transform.h>
+#include <cbf/composite_transform.h>
+#include <cbf/difference_sensor_transform.h>
+#include <cbf/thread_pool.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace CBF;
+
+//! A linear transform counting how often its jacobian is computed
+struct CountingSensorTransform : public SensorTransform {
+	CountingSensorTransform(const FloatMatrix &matrix) :
+		m_Matrix(matrix),
+		m_JacobianComputations(0)
+	{
+		m_Result = FloatVector::Zero(matrix.rows());
+		m_TaskJacobian = FloatMatrix::Zero(matrix.rows(), matrix.cols());
+	}
+
+	virtual unsigned int task_dim() const { return m_Matrix.rows(); }
+	virtual unsigned int resource_dim() const { return m_Matrix.cols(); }
+
+	virtual void update(const FloatVector &resource_value) {
+		m_Result = m_Matrix * resource_value;
+		defer_jacobian(resource_value);
+	}
+
+	virtual void update_jacobian(const FloatVector &resource_value) {
+		m_TaskJacobian = m_Matrix;
+		++m_JacobianComputations;
+	}
+
+	FloatMatrix m_Matrix;
+	unsigned int m_JacobianComputations;
+};
+
+typedef boost::shared_ptr<CountingSensorTransform> CountingSensorTransformPtr;
+
+//! Like a subordinate controller reading its shared transform
+struct SharedUpdateTask : public ParallelTask {
+	SharedUpdateTask(SensorTransformPtr transform, unsigned int jobs) :
+		m_Transform(transform),
+		m_Jacobians(jobs),
+		m_Version(0)
+	{ }
+
+	virtual void run(unsigned int index) {
+		m_Transform->update_if_changed(m_ResourceValue, m_Version);
+		m_Jacobians[index] = m_Transform->task_jacobian();
+	}
+
+	SensorTransformPtr m_Transform;
+	std::vector<FloatMatrix> m_Jacobians;
+	FloatVector m_ResourceValue;
+	unsigned long m_Version;
+};
+
+bool check_count(const std::string &name, CountingSensorTransformPtr transform, unsigned int expected) {
+	if (transform->m_JacobianComputations != expected) {
+		std::cerr << name << ": " << transform->m_JacobianComputations 
+			<< " jacobian computations, expected " << expected << std::endl;
+		return false;
+	}
+	return true;
+}
+
+int main() {
+	srand(0);
+	bool ok = true;
+
+	const unsigned int dim = 4;
+	const FloatVector resource_value = FloatVector::Random(dim);
+
+	CountingSensorTransformPtr a(new CountingSensorTransform(FloatMatrix::Random(3, dim)));
+	CountingSensorTransformPtr b(new CountingSensorTransform(FloatMatrix::Random(3, dim)));
+
+	//! Only the result is used
+	for (unsigned int i = 0; i < 10; ++i) {
+		a->update(resource_value);
+		a->result();
+	}
+	ok &= check_count("result only", a, 0);
+
+	//! Asking repeatedly computes it once
+	a->task_jacobian();
+	a->task_jacobian();
+	ok &= check_count("task_jacobian", a, 1);
+
+	if (a->task_jacobian() != a->m_Matrix) {
+		std::cerr << "wrong jacobian" << std::endl;
+		ok = false;
+	}
+
+	//! Composites defer to their transforms
+	std::vector<SensorTransformPtr> transforms;
+	transforms.push_back(a);
+	transforms.push_back(b);
+	CompositeSensorTransformPtr composite(new CompositeSensorTransform(transforms));
+
+	for (unsigned int pool = 0; pool < 2; ++pool) {
+		if (pool) composite->set_thread_pool(ThreadPoolPtr(new ThreadPool(2)));
+
+		a->m_JacobianComputations = b->m_JacobianComputations = 0;
+		composite->update(resource_value);
+		ok &= check_count("composite result", a, 0);
+
+		composite->task_jacobian();
+		composite->task_jacobian();
+		ok &= check_count("composite jacobian", a, 1);
+		ok &= check_count("composite jacobian", b, 1);
+
+		if (composite->task_jacobian().topRows(3) != a->m_Matrix || composite->task_jacobian().bottomRows(3) != b->m_Matrix) {
+			std::cerr << "wrong composite jacobian" << std::endl;
+			ok = false;
+		}
+	}
+
+	DifferenceSensorTransform difference(a, b);
+
+	a->m_JacobianComputations = b->m_JacobianComputations = 0;
+	difference.update(resource_value);
+	ok &= check_count("difference result", a, 0);
+
+	if ((difference.task_jacobian() - (a->m_Matrix - b->m_Matrix)).norm() > 1e-12) {
+		std::cerr << "wrong difference jacobian" << std::endl;
+		ok = false;
+	}
+	ok &= check_count("difference jacobian", b, 1);
+
+	//! Each version is computed once, whichever job comes first
+	const unsigned int jobs = 4, versions = 100;
+	SharedUpdateTask task(a, jobs);
+	task.m_ResourceValue = resource_value;
+	ThreadPool pool(jobs - 1);
+
+	a->m_JacobianComputations = 0;
+	for (unsigned int version = 1; version <= versions; ++version) {
+		task.m_Version = version;
+		pool.run(task, jobs);
+
+		for (unsigned int i = 0; i < jobs; ++i) {
+			if (task.m_Jacobians[i] != a->m_Matrix) {
+				std::cerr << "wrong shared jacobian in job " << i << std::endl;
+				ok = false;
+			}
+		}
+	}
+	ok &= check_count("shared on a pool", a, versions);
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
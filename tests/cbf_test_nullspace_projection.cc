@@ -0,0 +1,149 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks that all SubordinateController::NullspaceProjection modes
+	give the same resource step for a redundant 40 DOF resource and
+	prints how long the update() takes with each of them.
+*/
+
+#include <cbf/primitive_controller.h>
+#include <cbf/linear_transform.h>
+#include <cbf/identity_transform.h>
+#include <cbf/generic_transform.h>
+#include <cbf/square_potential.h>
+#include <cbf/dummy_reference.h>
+#include <cbf/dummy_resource.h>
+#include <cbf/combination_strategy.h>
+#include <cbf/convergence_criterion.h>
+
+#include <sys/time.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace CBF;
+
+const unsigned int resource_dim = 40;
+const unsigned int task_dim = 6;
+
+PrimitiveControllerPtr create_controller(
+	const FloatMatrix &coefficients,
+	SubordinateController::NullspaceProjection projection
+) {
+	DummyReferencePtr subordinate_reference(new DummyReference(1, resource_dim));
+	subordinate_reference->set_reference(FloatVector::Constant(resource_dim, 0.5));
+
+	std::vector<SubordinateControllerPtr> subordinates;
+	subordinates.push_back(SubordinateControllerPtr(
+		new SubordinateController(
+			0.1,
+			std::vector<ConvergenceCriterionPtr>(),
+			subordinate_reference,
+			PotentialPtr(new SquarePotential(resource_dim)),
+			SensorTransformPtr(new IdentitySensorTransform(resource_dim)),
+			EffectorTransformPtr(new GenericEffectorTransform(resource_dim, resource_dim)),
+			std::vector<SubordinateControllerPtr>(),
+			CombinationStrategyPtr(new AddingStrategy)
+		)
+	));
+
+	DummyReferencePtr reference(new DummyReference(1, task_dim));
+	reference->set_reference(FloatVector::Constant(task_dim, 1.0));
+
+	PrimitiveControllerPtr controller(
+		new PrimitiveController(
+			1.0,
+			std::vector<ConvergenceCriterionPtr>(),
+			reference,
+			PotentialPtr(new SquarePotential(task_dim)),
+			SensorTransformPtr(new LinearSensorTransform(coefficients)),
+			EffectorTransformPtr(new DampedGenericEffectorTransform(task_dim, resource_dim)),
+			subordinates,
+			CombinationStrategyPtr(new AddingStrategy),
+			ResourcePtr(new DummyResource(FloatVector::Zero(resource_dim)))
+		)
+	);
+
+	controller->set_nullspace_projection(projection);
+	subordinates[0]->set_nullspace_projection(projection);
+
+	return controller;
+}
+
+double seconds() {
+	timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+int main() {
+	srand(0);
+	//! const, so the coefficient matrix constructor gets picked
+	const FloatMatrix coefficients = FloatMatrix::Random(task_dim, resource_dim);
+
+	PrimitiveControllerPtr explicit_controller =
+		create_controller(coefficients, SubordinateController::ExplicitProjector);
+
+	PrimitiveControllerPtr matrix_vector_controller =
+		create_controller(coefficients, SubordinateController::MatrixVectorProjection);
+
+	PrimitiveControllerPtr decomposition_controller =
+		create_controller(coefficients, SubordinateController::DecompositionProjection);
+
+	for (unsigned int i = 0; i < 10; ++i) {
+		explicit_controller->step();
+		matrix_vector_controller->step();
+		decomposition_controller->step();
+
+		Float difference = std::max(
+			(explicit_controller->result() - matrix_vector_controller->result()).norm(),
+			(explicit_controller->result() - decomposition_controller->result()).norm()
+		);
+
+		if (difference > 1e-10) {
+			std::cerr << "Projection results differ by " << difference << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	const unsigned int cycles = 10000;
+
+	double start = seconds();
+	for (unsigned int i = 0; i < cycles; ++i)
+		explicit_controller->update();
+	double explicit_time = seconds() - start;
+
+	start = seconds();
+	for (unsigned int i = 0; i < cycles; ++i)
+		matrix_vector_controller->update();
+	double matrix_vector_time = seconds() - start;
+
+	start = seconds();
+	for (unsigned int i = 0; i < cycles; ++i)
+		decomposition_controller->update();
+	double decomposition_time = seconds() - start;
+
+	std::cout << "update() with " << resource_dim << " DOF, task dimension " << task_dim << std::endl;
+	std::cout << "  ExplicitProjector:       " << 1e6 * explicit_time / cycles << " us" << std::endl;
+	std::cout << "  MatrixVectorProjection:  " << 1e6 * matrix_vector_time / cycles << " us" << std::endl;
+	std::cout << "  DecompositionProjection: " << 1e6 * decomposition_time / cycles << " us" << std::endl;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,172 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks that a controller updating its subordinate controllers on a
+	ThreadPool computes bitwise the same resource steps as the sequential
+	one, and prints how long the update() takes with each. The same for a
+	CompositeSensorTransform updating its transforms on a ThreadPool.
+*/
+
+#include <cbf/primitive_controller.h>
+#include <cbf/thread_pool.h>
+#include <cbf/linear_transform.h>
+#include <cbf/composite_transform.h>
+#include <cbf/generic_transform.h>
+#include <cbf/square_potential.h>
+#include <cbf/dummy_reference.h>
+#include <cbf/dummy_resource.h>
+#include <cbf/combination_strategy.h>
+#include <cbf/convergence_criterion.h>
+
+#include <sys/time.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace CBF;
+
+const unsigned int resource_dim = 30;
+const unsigned int task_dim = 6;
+const unsigned int subordinates = 8;
+
+//! Each controller gets its own components, only the coefficients are shared
+PrimitiveControllerPtr create_controller(const std::vector<FloatMatrix> &coefficients) {
+	std::vector<SubordinateControllerPtr> subordinate_controllers;
+	for (unsigned int i = 1; i < coefficients.size(); ++i) {
+		DummyReferencePtr reference(new DummyReference(1, task_dim));
+		reference->set_reference(FloatVector::Constant(task_dim, 0.1 * i));
+
+		subordinate_controllers.push_back(SubordinateControllerPtr(
+			new SubordinateController(
+				0.1,
+				std::vector<ConvergenceCriterionPtr>(),
+				reference,
+				PotentialPtr(new SquarePotential(task_dim)),
+				SensorTransformPtr(new LinearSensorTransform(coefficients[i])),
+				EffectorTransformPtr(new DampedGenericEffectorTransform(task_dim, resource_dim)),
+				std::vector<SubordinateControllerPtr>(),
+				CombinationStrategyPtr(new AddingStrategy)
+			)
+		));
+	}
+
+	DummyReferencePtr reference(new DummyReference(1, task_dim));
+	reference->set_reference(FloatVector::Constant(task_dim, 1.0));
+
+	return PrimitiveControllerPtr(
+		new PrimitiveController(
+			1.0,
+			std::vector<ConvergenceCriterionPtr>(),
+			reference,
+			PotentialPtr(new SquarePotential(task_dim)),
+			SensorTransformPtr(new LinearSensorTransform(coefficients[0])),
+			EffectorTransformPtr(new DampedGenericEffectorTransform(task_dim, resource_dim)),
+			subordinate_controllers,
+			CombinationStrategyPtr(new AddingStrategy),
+			ResourcePtr(new DummyResource(FloatVector::Zero(resource_dim)))
+		)
+	);
+}
+
+double seconds() {
+	timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+int main() {
+	srand(0);
+
+	std::vector<FloatMatrix> coefficients;
+	for (unsigned int i = 0; i <= subordinates; ++i)
+		coefficients.push_back(FloatMatrix::Random(task_dim, resource_dim));
+
+	PrimitiveControllerPtr sequential_controller = create_controller(coefficients);
+	PrimitiveControllerPtr parallel_controller = create_controller(coefficients);
+	parallel_controller->set_thread_pool(ThreadPoolPtr(new ThreadPool(3)));
+
+	for (unsigned int i = 0; i < 100; ++i) {
+		sequential_controller->step();
+		parallel_controller->step();
+
+		if (sequential_controller->result() != parallel_controller->result()) {
+			std::cerr << "Parallel result differs in step " << i << " by "
+				<< (sequential_controller->result() - parallel_controller->result()).norm() << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	const unsigned int cycles = 10000;
+
+	double start = seconds();
+	for (unsigned int i = 0; i < cycles; ++i)
+		sequential_controller->update();
+	double sequential_time = seconds() - start;
+
+	start = seconds();
+	for (unsigned int i = 0; i < cycles; ++i)
+		parallel_controller->update();
+	double parallel_time = seconds() - start;
+
+	std::cout << "update() with " << subordinates << " subordinate controllers, "
+		<< resource_dim << " DOF, task dimension " << task_dim << std::endl;
+	std::cout << "  sequential:           " << 1e6 * sequential_time / cycles << " us" << std::endl;
+	std::cout << "  ThreadPool (3 + 1):   " << 1e6 * parallel_time / cycles << " us" << std::endl;
+
+	std::vector<SensorTransformPtr> sequential_transforms, parallel_transforms;
+	for (unsigned int i = 0; i < coefficients.size(); ++i) {
+		//! const, so the coefficient matrix constructor gets picked
+		const FloatMatrix &coefficient_matrix = coefficients[i];
+		sequential_transforms.push_back(SensorTransformPtr(new LinearSensorTransform(coefficient_matrix)));
+		parallel_transforms.push_back(SensorTransformPtr(new LinearSensorTransform(coefficient_matrix)));
+	}
+
+	CompositeSensorTransform sequential_composite(sequential_transforms);
+	CompositeSensorTransform parallel_composite(parallel_transforms);
+	parallel_composite.set_thread_pool(ThreadPoolPtr(new ThreadPool(3)));
+
+	FloatVector resource_value = FloatVector::Random(resource_dim);
+
+	sequential_time = parallel_time = 0;
+	for (unsigned int i = 0; i < cycles; ++i) {
+		resource_value.array() += 0.001;
+
+		start = seconds();
+		sequential_composite.update(resource_value);
+		sequential_time += seconds() - start;
+
+		start = seconds();
+		parallel_composite.update(resource_value);
+		parallel_time += seconds() - start;
+
+		if (
+			sequential_composite.result() != parallel_composite.result() 
+			|| sequential_composite.task_jacobian() != parallel_composite.task_jacobian()
+		) {
+			std::cerr << "Parallel CompositeSensorTransform differs in cycle " << i << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::cout << "CompositeSensorTransform::update() with " << coefficients.size() << " transforms" << std::endl;
+	std::cout << "  sequential:           " << 1e6 * sequential_time / cycles << " us" << std::endl;
+	std::cout << "  ThreadPool (3 + 1):   " << 1e6 * parallel_time / cycles << " us" << std::endl;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks that the PrimitiveControllerN made by make_fixed_size_controller()
+	moves the resource like the PrimitiveController it replaces, for both
+	effector transforms and all NullspaceProjection modes.
+*/
+
+#include <cbf/primitive_controller_n.h>
+#include <cbf/linear_transform.h>
+#include <cbf/identity_transform.h>
+#include <cbf/generic_transform.h>
+#include <cbf/square_potential.h>
+#include <cbf/dummy_reference.h>
+#include <cbf/dummy_resource.h>
+#include <cbf/combination_strategy.h>
+#include <cbf/convergence_criterion.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+using namespace CBF;
+
+const unsigned int resource_dim = 7;
+
+PrimitiveControllerPtr create_controller(
+	const FloatMatrix &coefficients,
+	bool damped,
+	SubordinateController::NullspaceProjection projection
+) {
+	const unsigned int task_dim = coefficients.rows();
+
+	DummyReferencePtr subordinate_reference(new DummyReference(1, resource_dim));
+	subordinate_reference->set_reference(FloatVector::Constant(resource_dim, 0.5));
+
+	std::vector<SubordinateControllerPtr> subordinates;
+	subordinates.push_back(SubordinateControllerPtr(
+		new SubordinateController(
+			0.1,
+			std::vector<ConvergenceCriterionPtr>(),
+			subordinate_reference,
+			PotentialPtr(new SquarePotential(resource_dim)),
+			SensorTransformPtr(new IdentitySensorTransform(resource_dim)),
+			EffectorTransformPtr(new GenericEffectorTransform(resource_dim, resource_dim)),
+			std::vector<SubordinateControllerPtr>(),
+			CombinationStrategyPtr(new AddingStrategy)
+		)
+	));
+
+	DummyReferencePtr reference(new DummyReference(1, task_dim));
+	reference->set_reference(FloatVector::Constant(task_dim, 1.0));
+
+	EffectorTransformPtr effector_transform;
+	if (damped)
+		effector_transform.reset(new DampedGenericEffectorTransform(task_dim, resource_dim));
+	else
+		effector_transform.reset(new GenericEffectorTransform(task_dim, resource_dim));
+
+	PrimitiveControllerPtr controller(
+		new PrimitiveController(
+			0.1,
+			std::vector<ConvergenceCriterionPtr>(),
+			reference,
+			PotentialPtr(new SquarePotential(task_dim)),
+			SensorTransformPtr(new LinearSensorTransform(coefficients)),
+			effector_transform,
+			subordinates,
+			CombinationStrategyPtr(new AddingStrategy),
+			ResourcePtr(new DummyResource(FloatVector::Zero(resource_dim)))
+		)
+	);
+
+	controller->set_nullspace_projection(projection);
+	return controller;
+}
+
+bool compare(unsigned int task_dim, bool damped, SubordinateController::NullspaceProjection projection) {
+	std::stringstream name;
+	name << task_dim << "x" << resource_dim << (damped ? " damped" : "") << ", projection " << projection;
+
+	//! const, so the coefficient matrix constructor gets picked
+	const FloatMatrix coefficients = FloatMatrix::Random(task_dim, resource_dim);
+
+	PrimitiveControllerPtr controller = create_controller(coefficients, damped, projection);
+	PrimitiveControllerPtr fixed = make_fixed_size_controller(create_controller(coefficients, damped, projection));
+
+	if (typeid(*fixed) == typeid(PrimitiveController)) {
+		std::cerr << name.str() << ": no fixed size controller made" << std::endl;
+		return false;
+	}
+
+	for (unsigned int i = 0; i < 50; ++i) {
+		controller->step();
+		fixed->step();
+
+		const Float difference = (controller->resource()->get() - fixed->resource()->get()).norm();
+		if (difference > 1e-10) {
+			std::cerr << name.str() << ": resources differ by " << difference << " in step " << i << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main() {
+	srand(0);
+	bool ok = true;
+
+	const SubordinateController::NullspaceProjection projections[] = {
+		SubordinateController::ExplicitProjector,
+		SubordinateController::MatrixVectorProjection,
+		SubordinateController::DecompositionProjection
+	};
+
+	for (unsigned int p = 0; p < 3; ++p) {
+		for (unsigned int damped = 0; damped < 2; ++damped) {
+			ok &= compare(3, damped, projections[p]);
+			ok &= compare(6, damped, projections[p]);
+		}
+	}
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,148 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks the CycleTimeHistogram bookkeeping, also with several threads 
+	recording at once, and, when CBF is built with CBF_PROFILING, that 
+	stepping a controller with a composite sensor transform fills a 
+	histogram for each of its nodes.
+*/
+
+#include <cbf/config.h>
+#include <cbf/profiling.h>
+#include <cbf/primitive_controller.h>
+#include <cbf/linear_transform.h>
+#include <cbf/composite_transform.h>
+#include <cbf/generic_transform.h>
+#include <cbf/square_potential.h>
+#include <cbf/dummy_reference.h>
+#include <cbf/dummy_resource.h>
+#include <cbf/combination_strategy.h>
+#include <cbf/convergence_criterion.h>
+#include <cbf/thread_pool.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace CBF;
+
+bool check(bool condition, const std::string &message) {
+	if (!condition) std::cerr << message << std::endl;
+	return condition;
+}
+
+//! Each job looks up the shared histogram and records into it
+struct RecordTask : public ParallelTask {
+	enum { Samples = 100000 };
+
+	virtual void run(unsigned int index) {
+		CycleTimeHistogram *histogram = cycle_time_histogram("concurrent");
+		for (unsigned int i = 0; i < Samples; ++i)
+			histogram->record(1000 + index);
+	}
+};
+
+int main() {
+	bool ok = true;
+
+	CycleTimeHistogram histogram;
+	for (unsigned int i = 0; i < 99; ++i)
+		histogram.record(1000);
+	histogram.record(100000);
+
+	ok &= check(histogram.samples() == 100, "wrong sample count");
+	ok &= check(histogram.min() == 1000 && histogram.max() == 100000, "wrong min/max");
+	ok &= check(histogram.mean() == 1990, "wrong mean");
+	//! 1000ns lie in the bucket [512, 1024)
+	ok &= check(histogram.quantile(0.5) == 1024, "wrong median");
+	ok &= check(histogram.quantile(0.99) == 1024, "wrong p99");
+	ok &= check(histogram.quantile(1.0) == 100000, "wrong maximum quantile");
+
+	histogram.reset();
+	ok &= check(histogram.samples() == 0 && histogram.quantile(0.5) == 0, "reset() left samples");
+
+	const unsigned int jobs = 4;
+	ThreadPool pool(jobs - 1);
+	RecordTask task;
+	pool.run(task, jobs);
+
+	const CycleTimeHistogram concurrent = *cycle_time_histogram("concurrent");
+	ok &= check(concurrent.samples() == jobs * RecordTask::Samples, "lost samples recording concurrently");
+	ok &= check(concurrent.min() == 1000 && concurrent.max() == 1000 + jobs - 1, "wrong concurrent min/max");
+
+	//! Objects of the same name get a histogram each
+	int first, second;
+	ok &= check(cycle_time_histogram("owned", &first) == cycle_time_histogram("owned", &first), "owner got another histogram");
+	ok &= check(cycle_time_histogram("owned", &first) != cycle_time_histogram("owned", &second), "owners share a histogram");
+	ok &= check(cycle_time_histograms().count("owned#2") == 1, "second owner not listed");
+
+	#ifdef CBF_PROFILING
+		const FloatMatrix coefficients = FloatMatrix::Random(3, 7);
+
+		PrimitiveController controller(
+			1.0,
+			std::vector<ConvergenceCriterionPtr>(),
+			ReferencePtr(new DummyReference(1, 6)),
+			PotentialPtr(new SquarePotential(6)),
+			SensorTransformPtr(new CompositeSensorTransform(
+				SensorTransformPtr(new LinearSensorTransform(coefficients)),
+				SensorTransformPtr(new LinearSensorTransform(coefficients))
+			)),
+			EffectorTransformPtr(new DampedGenericEffectorTransform(6, 7)),
+			std::vector<SubordinateControllerPtr>(),
+			CombinationStrategyPtr(new AddingStrategy),
+			ResourcePtr(new DummyResource(FloatVector::Zero(7)))
+		);
+
+		reset_cycle_time_histograms();
+
+		const unsigned int cycles = 100;
+		for (unsigned int i = 0; i < cycles; ++i)
+			controller.step();
+
+		std::map<std::string, CycleTimeHistogram> histograms = cycle_time_histograms();
+		const std::string expected[] = {
+			controller.name() + ".update",
+			controller.name() + ".nullspace_projection",
+			controller.effector_transform()->name() + ".update",
+			controller.potential()->name() + ".gradient"
+		};
+
+		for (unsigned int i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i)
+			ok &= check(histograms[expected[i]].samples() >= cycles, "no samples for " + expected[i]);
+
+		//! Objects built without XML all carry their base class name, so the
+		//! composite and both of its children are told apart by a number
+		const std::string sensor_transforms[] = {
+			controller.sensor_transform()->name() + ".update",
+			controller.sensor_transform()->name() + ".update#2",
+			controller.sensor_transform()->name() + ".update#3"
+		};
+
+		for (unsigned int i = 0; i < 3; ++i)
+			ok &= check(histograms[sensor_transforms[i]].samples() == cycles, "wrong sample count for " + sensor_transforms[i]);
+
+		print_cycle_time_histograms(std::cout);
+	#else
+		std::cout << "CBF is built without CBF_PROFILING, only checked the histograms" << std::endl;
+	#endif
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,158 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks that the PseudoInverseSolvers agree with the JacobiSVD over a 
+	grid of task and resource dimensions, for each inversion rule they 
+	support, also when a workspace is reused.
+
+	Then the WarmStartedSVD is compared to the JacobiSVD on a 6x7 
+	jacobian that drifts slowly like the one of an arm along a trajectory.
+	cbf_bench reports how long each solver takes.
+*/
+
+#include <cbf/utilities.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace CBF;
+
+enum Rule { Plain, Damped };
+
+struct Candidate {
+	Candidate(const std::string &name, PseudoInverseSolver solver, Rule rule) :
+		m_Name(name), m_Solver(solver), m_Rule(rule) { }
+
+	std::string m_Name;
+	PseudoInverseSolver m_Solver;
+	Rule m_Rule;
+};
+
+const Float damping_constant = 0.01;
+
+void invert(const FloatMatrix &m, FloatMatrix &result, PseudoInverseWorkspace &workspace, Rule rule) {
+	if (rule == Plain)
+		pseudo_inverse(m, result, workspace);
+	else
+		damped_pseudo_inverse(m, result, workspace, damping_constant);
+}
+
+int main() {
+	srand(0);
+
+	std::vector<Candidate> candidates;
+	candidates.push_back(Candidate("JacobiSVD", JacobiSVDSolver, Plain));
+	candidates.push_back(Candidate("QR", QRSolver, Plain));
+	candidates.push_back(Candidate("WarmStartedSVD", WarmStartedSVDSolver, Plain));
+	#ifdef CBF_HAVE_EIGEN_3_3
+		candidates.push_back(Candidate("BDCSVD", BDCSVDSolver, Plain));
+		candidates.push_back(Candidate("CompleteOrthogonalDecomposition", CompleteOrthogonalDecompositionSolver, Plain));
+	#endif
+	candidates.push_back(Candidate("JacobiSVD (damped)", JacobiSVDSolver, Damped));
+	candidates.push_back(Candidate("DampedLeastSquares (damped)", DampedLeastSquaresSolver, Damped));
+	candidates.push_back(Candidate("WarmStartedSVD (damped)", WarmStartedSVDSolver, Damped));
+	#ifdef CBF_HAVE_EIGEN_3_3
+		candidates.push_back(Candidate("BDCSVD (damped)", BDCSVDSolver, Damped));
+	#endif
+
+	const unsigned int task_dims[] = { 3, 6 };
+	const unsigned int resource_dims[] = { 7, 20, 40 };
+	const Float tolerance = 1e-8;
+
+	bool failed = false;
+
+	for (unsigned int t = 0; t < sizeof(task_dims) / sizeof(task_dims[0]); ++t) {
+		for (unsigned int r = 0; r < sizeof(resource_dims) / sizeof(resource_dims[0]); ++r) {
+			const FloatMatrix m = FloatMatrix::Random(task_dims[t], resource_dims[r]);
+
+			FloatMatrix reference[2];
+			pseudo_inverse(m, reference[Plain]);
+			damped_pseudo_inverse(m, reference[Damped], damping_constant);
+
+			for (unsigned int c = 0; c < candidates.size(); ++c) {
+				PseudoInverseWorkspace workspace(candidates[c].m_Solver);
+				FloatMatrix result;
+
+				//! The second call reuses the decomposition in the workspace
+				for (unsigned int i = 0; i < 2; ++i)
+					invert(m, result, workspace, candidates[c].m_Rule);
+
+				Float error = (result - reference[candidates[c].m_Rule]).cwiseAbs().maxCoeff();
+
+				if (error > tolerance) {
+					std::cerr << task_dims[t] << "x" << resource_dims[r] << ": " 
+						<< candidates[c].m_Name << " deviates by " << error << std::endl;
+					failed = true;
+				}
+			}
+		}
+	}
+
+	const FloatMatrix start_jacobian = FloatMatrix::Random(6, 7);
+	const FloatMatrix drift = FloatMatrix::Random(6, 7);
+	const unsigned int steps = 10000;
+
+	PseudoInverseWorkspace full_workspace(JacobiSVDSolver);
+	PseudoInverseWorkspace warm_workspace(WarmStartedSVDSolver);
+	FloatMatrix jacobian, full_result, warm_result;
+	Float max_error = 0;
+
+	for (unsigned int i = 0; i < steps; ++i) {
+		jacobian = start_jacobian + sin(0.001 * i) * drift;
+		damped_pseudo_inverse(jacobian, full_result, full_workspace, damping_constant);
+		damped_pseudo_inverse(jacobian, warm_result, warm_workspace, damping_constant);
+		max_error = std::max(max_error, (full_result - warm_result).cwiseAbs().maxCoeff());
+	}
+
+	std::cout << "drifting 6x7 jacobian, " << steps << " steps: "
+		<< warm_workspace.m_WarmStartedSVD.warm_starts() << " warm starts, "
+		<< warm_workspace.m_WarmStartedSVD.full_decompositions() << " full decompositions" << std::endl;
+
+	if (warm_workspace.m_WarmStartedSVD.warm_starts() == 0) {
+		std::cerr << "WarmStartedSVD never warm started on the drifting jacobian" << std::endl;
+		failed = true;
+	}
+
+	if (max_error > tolerance) {
+		std::cerr << "WarmStartedSVD deviates by " << max_error << " on the drifting jacobian" << std::endl;
+		failed = true;
+	}
+
+	//! Asked for the full V, the warm started decomposition completes the thin one with the rest of Q
+	WarmStartedSVD svd;
+	for (unsigned int i = 0; i < 3; ++i) {
+		jacobian = start_jacobian + sin(0.001 * i) * drift;
+		svd.compute(jacobian, Eigen::ComputeThinU | Eigen::ComputeFullV);
+	}
+
+	const FloatMatrix &v = svd.matrixV();
+	const Float orthogonality_error = (v.transpose() * v - FloatMatrix::Identity(7, 7)).cwiseAbs().maxCoeff();
+	const Float reconstruction_error = 
+		(svd.matrixU() * svd.singularValues().asDiagonal() * v.leftCols(6).transpose() - jacobian).cwiseAbs().maxCoeff();
+
+	if (svd.warm_starts() != 2 || v.cols() != 7 || orthogonality_error > tolerance || reconstruction_error > tolerance) {
+		std::cerr << "WarmStartedSVD computed a wrong full V" << std::endl;
+		failed = true;
+	}
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,224 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks that PythonPotential and PythonSensorTransform give the same
+	(double precision) results for scripts writing the arrays in place and
+	for scripts assigning lists, that each instance has a namespace of its
+	own, that changed scripts get recompiled and that the scripts can be
+	run from another thread. Prints how long a call takes in both styles.
+
+	The scripts only index the arrays, so they also work without NumPy.
+*/
+
+#include <cbf/python_wrap.h>
+
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+#include <sys/time.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace CBF;
+
+const char *potential_in_place =
+	"for i in range(len(input)):\n"
+	"	result[i] = gain * (references[0][i] - input[i])\n";
+
+const char *potential_lists =
+	"result = [gain * (r - x) for r, x in zip(references[0], input)]\n";
+
+const char *transform_in_place =
+	"for i in range(2):\n"
+	"	result[i] = 0\n"
+	"	for k in range(3):\n"
+	"		jacobian[i, k] = j[i][k]\n"
+	"		result[i] += j[i][k] * resource[k]\n";
+
+const char *transform_lists =
+	"jacobian = j\n"
+	"result = [sum(a * b for a, b in zip(row, resource)) for row in j]\n";
+
+double seconds() {
+	timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+PythonPotentialPtr create_potential(const std::string &gain, const std::string &script) {
+	PythonPotentialPtr potential(new PythonPotential(3));
+	potential->m_InitScript = "gain = " + gain + "\n";
+	potential->m_ExecScript = script;
+	return potential;
+}
+
+PythonSensorTransformPtr create_transform(const std::string &script) {
+	PythonSensorTransformPtr transform(new PythonSensorTransform(2, 3));
+	transform->m_InitScript = "j = [[1, 0.3, -12], [0.1, 1, 20]]\n";
+	transform->m_ExecScript = script;
+	return transform;
+}
+
+//! The microseconds a call takes on average
+double time_potential(PythonPotentialPtr potential) {
+	const unsigned int cycles = 10000;
+	std::vector<FloatVector> references(1, FloatVector::Constant(3, 1.0));
+	FloatVector input = FloatVector::Zero(3), result;
+
+	const double start = seconds();
+	for (unsigned int i = 0; i < cycles; ++i) {
+		input.array() += 0.0001;
+		potential->gradient(result, references, input);
+	}
+	return 1e6 * (seconds() - start) / cycles;
+}
+
+double time_transform(PythonSensorTransformPtr transform) {
+	const unsigned int cycles = 10000;
+	FloatVector resource_value = FloatVector::Zero(3);
+
+	const double start = seconds();
+	for (unsigned int i = 0; i < cycles; ++i) {
+		resource_value.array() += 0.0001;
+		transform->update(resource_value);
+	}
+	return 1e6 * (seconds() - start) / cycles;
+}
+
+bool check_potential() {
+	PythonPotentialPtr in_place = create_potential("0.1", potential_in_place);
+	PythonPotentialPtr lists = create_potential("0.1", potential_lists);
+
+	std::vector<FloatVector> references(2, FloatVector::Zero(3));
+	references[0] << 1.0 / 3.0, 2.0, -1.0;
+	FloatVector input(3), expected(3), in_place_result, lists_result;
+	input << 0.1, 0.2, 0.3;
+	expected = 0.1 * (references[0] - input);
+
+	in_place->gradient(in_place_result, references, input);
+	lists->gradient(lists_result, references, input);
+
+	if ((in_place_result - expected).norm() > 1e-15 || (lists_result - expected).norm() > 1e-15) {
+		std::cerr << "potential: wrong gradients " << in_place_result.transpose()
+			<< " and " << lists_result.transpose() << std::endl;
+		return false;
+	}
+
+	//! One reference less, so the reference arrays are rebuilt
+	references.pop_back();
+	references[0] *= 2;
+	in_place->gradient(in_place_result, references, input);
+	if ((in_place_result - 0.1 * (references[0] - input)).norm() > 1e-15) {
+		std::cerr << "potential: wrong gradient after changing the references" << std::endl;
+		return false;
+	}
+
+	//! The same names in other instances, in place and in the main module
+	PythonPotentialPtr other = create_potential("-2.0", potential_in_place);
+	other->gradient(lists_result, references, input);
+	in_place->gradient(in_place_result, references, input);
+	if ((lists_result + 20 * in_place_result).norm() > 1e-14) {
+		std::cerr << "potential: instances share their namespaces" << std::endl;
+		return false;
+	}
+
+	in_place->m_ExecScript = "result[0] = 1\nresult[1] = 2\nresult[2] = 3\n";
+	in_place->gradient(in_place_result, references, input);
+	if ((in_place_result - FloatVector::LinSpaced(3, 1.0, 3.0)).norm() != 0) {
+		std::cerr << "potential: changed script not recompiled" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool check_transform() {
+	PythonSensorTransformPtr in_place = create_transform(transform_in_place);
+	PythonSensorTransformPtr lists = create_transform(transform_lists);
+
+	FloatMatrix jacobian(2, 3);
+	jacobian << 1, 0.3, -12, 0.1, 1, 20;
+	FloatVector resource_value(3);
+	resource_value << 0.1, 1.0 / 7.0, -0.3;
+
+	in_place->update(resource_value);
+	lists->update(resource_value);
+
+	const PythonSensorTransformPtr transforms[] = { in_place, lists };
+	for (unsigned int i = 0; i < 2; ++i) {
+		if (
+			(transforms[i]->result() - jacobian * resource_value).norm() > 1e-14 ||
+			(transforms[i]->task_jacobian() - jacobian).norm() != 0
+		) {
+			std::cerr << "transform: wrong result " << transforms[i]->result().transpose() << std::endl;
+			return false;
+		}
+	}
+
+	try {
+		in_place->update(FloatVector::Zero(2));
+		std::cerr << "transform: accepted a resource value of the wrong size" << std::endl;
+		return false;
+	} catch (std::runtime_error &e) { }
+
+	return true;
+}
+
+void run_potential(PythonPotentialPtr potential, FloatVector *result) {
+	potential->gradient(*result, std::vector<FloatVector>(1, FloatVector::Ones(3)), FloatVector::Zero(3));
+}
+
+//! Only works if the GIL is not held by the main thread between calls
+bool check_threads() {
+	PythonPotentialPtr potential = create_potential("0.5", potential_in_place);
+	FloatVector first, second;
+
+	boost::thread a(boost::bind(run_potential, potential, &first));
+	boost::thread b(boost::bind(run_potential, create_potential("0.25", potential_in_place), &second));
+	a.join();
+	b.join();
+
+	if ((first - FloatVector::Constant(3, 0.5)).norm() != 0 || (second - FloatVector::Constant(3, 0.25)).norm() != 0) {
+		std::cerr << "threads: wrong results" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+int main() {
+	bool ok = true;
+
+	ok &= check_potential();
+	ok &= check_transform();
+	ok &= check_threads();
+
+	std::cout << "PythonPotential" << std::endl;
+	std::cout << "  lists:    " << time_potential(create_potential("0.1", potential_lists)) << " us" << std::endl;
+	std::cout << "  in place: " << time_potential(create_potential("0.1", potential_in_place)) << " us" << std::endl;
+
+	std::cout << "PythonSensorTransform" << std::endl;
+	std::cout << "  lists:    " << time_transform(create_transform(transform_lists)) << " us" << std::endl;
+	std::cout << "  in place: " << time_transform(create_transform(transform_in_place)) << " us" << std::endl;
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
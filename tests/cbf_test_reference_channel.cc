@@ -0,0 +1,183 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks ChannelReference's semantics, that a consumer never sees torn
+	or out of order values while another thread publishes as fast as it
+	can, and that publishing and updating do not touch the heap (counted
+	with allocation_counter.h).
+*/
+
+#include <cbf/reference_channel.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <sys/time.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+#include "allocation_counter.h"
+
+using namespace CBF;
+
+double seconds() {
+	timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+bool check_semantics() {
+	ChannelReference reference(3);
+
+	reference.update();
+	if (reference.get().size() != 0 || reference.version() != 0) {
+		std::cerr << "references before the first value" << std::endl;
+		return false;
+	}
+
+	reference.publish(FloatVector::Constant(3, 1));
+	reference.publish(FloatVector::Constant(3, 2));
+	reference.update();
+	if (reference.get().size() != 1 || reference.get()[0] != FloatVector::Constant(3, 2)) {
+		std::cerr << "did not get the latest value" << std::endl;
+		return false;
+	}
+
+	const unsigned long version = reference.version();
+	reference.update();
+	if (reference.version() != version || reference.get().size() != 1) {
+		std::cerr << "changed without a new value" << std::endl;
+		return false;
+	}
+
+	reference.withdraw();
+	reference.update();
+	if (reference.get().size() != 0 || reference.version() == version) {
+		std::cerr << "still has references after withdraw()" << std::endl;
+		return false;
+	}
+
+	try {
+		reference.publish(FloatVector::Zero(2));
+		std::cerr << "published a value of the wrong dimension" << std::endl;
+		return false;
+	} catch (std::runtime_error &) { }
+
+	return true;
+}
+
+struct Producer {
+	ReferenceChannel &m_Channel;
+	unsigned int m_Count;
+
+	Producer(ReferenceChannel &channel, unsigned int count) : m_Channel(channel), m_Count(count) { }
+
+	//! Each value is its number in all coordinates, written in place
+	void run() {
+		for (unsigned int i = 1; i <= m_Count; ++i) {
+			m_Channel.back().setConstant(i);
+			m_Channel.publish();
+
+			//! Interleave with the consumer on a single core, too
+			if (i % 100 == 0)
+				boost::this_thread::yield();
+		}
+	}
+};
+
+bool check_threads() {
+	const unsigned int dim = 64, count = 200000;
+	ReferenceChannel channel(dim);
+	Producer producer(channel, count);
+
+	unsigned int fetched = 0;
+	Float last = 0;
+
+	const double start = seconds();
+	boost::thread thread(boost::bind(&Producer::run, &producer));
+
+	while (last != count) {
+		if (!channel.fetch()) {
+			boost::this_thread::yield();
+			continue;
+		}
+
+		++fetched;
+		const FloatVector &value = channel.value();
+		if (value.minCoeff() != value.maxCoeff()) {
+			std::cerr << "torn value " << value.minCoeff() << " ... " << value.maxCoeff() << std::endl;
+			thread.join();
+			return false;
+		}
+
+		if (value[0] <= last) {
+			std::cerr << "value " << value[0] << " after " << last << std::endl;
+			thread.join();
+			return false;
+		}
+
+		last = value[0];
+	}
+
+	thread.join();
+
+	std::cout << count << " values published, " << fetched << " fetched in "
+		<< seconds() - start << " s" << std::endl;
+
+	return true;
+}
+
+bool check_allocations() {
+	ChannelReference reference(16);
+	const FloatVector value = FloatVector::Random(16);
+
+	//! The first value sets up the references
+	reference.publish(value);
+	reference.update();
+
+	num_allocations = 0;
+	counting = true;
+
+	for (unsigned int i = 0; i < 100; ++i) {
+		reference.publish(value);
+		reference.update();
+		reference.withdraw();
+		reference.update();
+	}
+
+	counting = false;
+
+	if (num_allocations != 0) {
+		std::cerr << num_allocations << " allocations during 100 updates" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+int main() {
+	bool ok = true;
+
+	ok &= check_semantics();
+	ok &= check_threads();
+	ok &= check_allocations();
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
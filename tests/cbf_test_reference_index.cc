@@ -0,0 +1,216 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks that SquarePotential, AxisPotential and AxisAnglePotential
+	head for the same reference with their ReferenceIndex as with the
+	linear scan over thousands of references, that the index is only
+	rebuilt when the references change, and prints how long a gradient
+	takes both ways.
+*/
+
+#include <cbf/square_potential.h>
+#include <cbf/axis_potential.h>
+#include <cbf/axis_angle_potential.h>
+#include <cbf/dummy_reference.h>
+#include <cbf/composite_reference.h>
+
+#include <sys/time.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace CBF;
+
+double seconds() {
+	timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+std::vector<FloatVector> random_vectors(unsigned int count, unsigned int dim, Float scale) {
+	std::vector<FloatVector> vectors;
+	for (unsigned int i = 0; i < count; ++i)
+		vectors.push_back(scale * FloatVector::Random(dim));
+	return vectors;
+}
+
+//! indexed and linear are the same potential, the latter with the index disabled
+bool compare(
+	const std::string &name,
+	Potential &indexed,
+	Potential &linear,
+	const std::vector<FloatVector> &references,
+	const std::vector<FloatVector> &inputs
+) {
+	FloatVector indexed_result, linear_result;
+	double indexed_time = 0, linear_time = 0;
+
+	for (unsigned int i = 0; i < inputs.size(); ++i) {
+		double start = seconds();
+		indexed.gradient_for_version(indexed_result, references, inputs[i], 1);
+		indexed_time += seconds() - start;
+
+		start = seconds();
+		linear.gradient(linear_result, references, inputs[i]);
+		linear_time += seconds() - start;
+
+		if ((indexed_result - linear_result).norm() > 1e-12) {
+			std::cerr << name << ": gradients differ for input " << inputs[i].transpose() << std::endl;
+			return false;
+		}
+	}
+
+	std::cout << name << " with " << references.size() << " references" << std::endl;
+	std::cout << "  linear:  " << 1e6 * linear_time / inputs.size() << " us" << std::endl;
+	std::cout << "  indexed: " << 1e6 * indexed_time / inputs.size() << " us" << std::endl;
+
+	return true;
+}
+
+bool check_potentials() {
+	const unsigned int count = 5000, queries = 500;
+	bool ok = true;
+
+	{
+		SquarePotential indexed(3, 0.5), linear(3, 0.5);
+		indexed.set_max_gradient_step_norm(100);
+		linear.set_max_gradient_step_norm(100);
+		linear.m_ReferenceIndex.m_Threshold = 0;
+		ok &= compare("SquarePotential", indexed, linear, random_vectors(count, 3, 1.0), random_vectors(queries, 3, 1.2));
+	}
+
+	{
+		AxisPotential indexed(3), linear(3);
+		linear.m_ReferenceIndex.m_Threshold = 0;
+		ok &= compare("AxisPotential", indexed, linear, random_vectors(count, 3, 1.0), random_vectors(queries, 3, 1.0));
+	}
+
+	{
+		AxisAnglePotential indexed(0.3), linear(0.3);
+		linear.m_ReferenceIndex.m_Threshold = 0;
+		ok &= compare("AxisAnglePotential", indexed, linear, random_vectors(count, 3, M_PI / std::sqrt(3.0)), random_vectors(queries, 3, M_PI / std::sqrt(3.0)));
+	}
+
+	return ok;
+}
+
+bool check_rebuilds() {
+	SquarePotential potential(2);
+	DummyReference reference(100, 2);
+	reference.set_references(random_vectors(100, 2, 1.0));
+
+	FloatVector input = FloatVector::Zero(2), result;
+	const unsigned long version = reference.version();
+
+	for (unsigned int i = 0; i < 10; ++i) {
+		//! Reading the references, like the C API does, keeps the version
+		static_cast<const DummyReference &>(reference).references();
+		reference.references();
+		potential.gradient_for_version(result, reference.get(), input, reference.version());
+	}
+
+	if (potential.m_ReferenceIndex.builds() != 1) {
+		std::cerr << "rebuilt the index for an unchanged version" << std::endl;
+		return false;
+	}
+
+	reference.set_references(random_vectors(100, 2, 1.0));
+	if (reference.version() == version) {
+		std::cerr << "set_references() kept the version" << std::endl;
+		return false;
+	}
+
+	potential.gradient_for_version(result, reference.get(), input, reference.version());
+	if (potential.m_ReferenceIndex.builds() != 2) {
+		std::cerr << "did not rebuild the index for a new version" << std::endl;
+		return false;
+	}
+
+	//! Without versions the references are compared, they did not change
+	std::vector<FloatVector> references = reference.get();
+	potential.gradient(result, references, input);
+	potential.gradient(result, references, input);
+	if (potential.m_ReferenceIndex.builds() != 2) {
+		std::cerr << "wrong number of builds for unversioned references" << std::endl;
+		return false;
+	}
+
+	references[17] = FloatVector::Zero(2);
+	potential.gradient(result, references, input);
+	if (potential.m_ReferenceIndex.builds() != 3 || result.norm() != 0) {
+		std::cerr << "did not notice a changed reference" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+//! A reference not keeping versions
+struct UnversionedReference : public Reference {
+	UnversionedReference() { m_References.push_back(FloatVector::Zero(1)); }
+	virtual void update() { }
+	virtual unsigned int dim() { return 1; }
+};
+
+bool check_composite_versions() {
+	DummyReferencePtr first(new DummyReference(1, 2)), second(new DummyReference(1, 1));
+	std::vector<ReferencePtr> references;
+	references.push_back(first);
+	references.push_back(second);
+	CompositeReference composite(references);
+
+	composite.update();
+	const unsigned long version = composite.version();
+	composite.update();
+	if (version == 0 || composite.version() != version) {
+		std::cerr << "composite of versioned references did not keep a version" << std::endl;
+		return false;
+	}
+
+	second->set_reference(FloatVector::Ones(1));
+	composite.update();
+	if (composite.version() == version) {
+		std::cerr << "composite kept its version for a changed reference" << std::endl;
+		return false;
+	}
+
+	//! An unversioned reference makes the composite unversioned
+	references.push_back(ReferencePtr(new UnversionedReference()));
+	composite.set_references(references);
+	composite.update();
+	if (composite.version() != 0) {
+		std::cerr << "composite of an unversioned reference kept a version" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+int main() {
+	srand(0);
+	bool ok = true;
+
+	ok &= check_potentials();
+	ok &= check_rebuilds();
+	ok &= check_composite_versions();
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,152 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks that resources change their version exactly when their value may
+	have changed, and that a sensor transform used several times per cycle
+	(twice in a WeightedSumSensorTransform and once more by a subordinate
+	controller) is evaluated once per resource version.
+*/
+
+#include <cbf/primitive_controller.h>
+#include <cbf/linear_transform.h>
+#include <cbf/weighted_sum_transforms.h>
+#include <cbf/generic_transform.h>
+#include <cbf/square_potential.h>
+#include <cbf/dummy_reference.h>
+#include <cbf/dummy_resource.h>
+#include <cbf/composite_resource.h>
+#include <cbf/combination_strategy.h>
+#include <cbf/convergence_criterion.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace CBF;
+
+//! Counts how often it gets evaluated
+struct CountingSensorTransform : public LinearSensorTransform {
+	CountingSensorTransform(const FloatMatrix &coefficients) :
+		LinearSensorTransform(coefficients),
+		m_Updates(0)
+	{ }
+
+	virtual void update(const FloatVector &resource_value) {
+		++m_Updates;
+		LinearSensorTransform::update(resource_value);
+	}
+
+	unsigned int m_Updates;
+};
+
+bool check(bool condition, const std::string &message) {
+	if (!condition) std::cerr << message << std::endl;
+	return condition;
+}
+
+int main() {
+	bool ok = true;
+
+	DummyResourcePtr resource(new DummyResource(FloatVector::Zero(4)));
+	DummyResourcePtr other_resource(new DummyResource(FloatVector::Zero(4)));
+
+	unsigned long version = resource->version();
+	ok &= check(version != 0, "DummyResource has no version");
+	ok &= check(version != other_resource->version(), "two resources share a version");
+
+	resource->update();
+	ok &= check(resource->version() == version, "update() changed the version of a DummyResource");
+
+	resource->add(FloatVector::Ones(4));
+	ok &= check(resource->version() > version, "add() did not change the version");
+
+	version = resource->version();
+	resource->set(FloatVector::Zero(4));
+	ok &= check(resource->version() > version, "set() did not change the version");
+
+	std::vector<ResourcePtr> resources;
+	resources.push_back(resource);
+	resources.push_back(other_resource);
+	CompositeResource composite(resources);
+
+	composite.update();
+	version = composite.version();
+	composite.update();
+	ok &= check(composite.version() == version, "CompositeResource changed its version without its resources doing so");
+
+	other_resource->add(FloatVector::Ones(4));
+	composite.update();
+	ok &= check(composite.version() != version, "CompositeResource kept its version though a resource changed");
+
+	//! One transform used three times per cycle
+	const FloatMatrix coefficients = FloatMatrix::Random(2, 4);
+	boost::shared_ptr<CountingSensorTransform> counting(new CountingSensorTransform(coefficients));
+
+	std::vector<SensorTransformPtr> transforms(2, counting);
+	FloatVector weights(2);
+	weights << 1.0, -0.5;
+
+	std::vector<SubordinateControllerPtr> subordinate_controllers;
+	subordinate_controllers.push_back(SubordinateControllerPtr(
+		new SubordinateController(
+			0.1,
+			std::vector<ConvergenceCriterionPtr>(),
+			ReferencePtr(new DummyReference(1, 2)),
+			PotentialPtr(new SquarePotential(2)),
+			counting,
+			EffectorTransformPtr(new DampedGenericEffectorTransform(2, 4)),
+			std::vector<SubordinateControllerPtr>(),
+			CombinationStrategyPtr(new AddingStrategy)
+		)
+	));
+
+	DummyReferencePtr reference(new DummyReference(1, 2));
+	reference->set_reference(FloatVector::Ones(2));
+
+	PrimitiveController controller(
+		1.0,
+		std::vector<ConvergenceCriterionPtr>(),
+		reference,
+		PotentialPtr(new SquarePotential(2)),
+		SensorTransformPtr(new WeightedSumSensorTransform(transforms, weights)),
+		EffectorTransformPtr(new DampedGenericEffectorTransform(2, 4)),
+		subordinate_controllers,
+		CombinationStrategyPtr(new AddingStrategy),
+		resource
+	);
+
+	const unsigned int cycles = 10;
+	for (unsigned int i = 0; i < cycles; ++i)
+		controller.step();
+
+	ok &= check(counting->m_Updates == cycles, "shared transform was evaluated more than once per cycle");
+
+	//! The last step moved the resource, after that there is nothing to evaluate
+	controller.update();
+	controller.update();
+	ok &= check(counting->m_Updates == cycles + 1, "transform was evaluated again for an unchanged resource");
+
+	//! The weighted sum must still see the current resource value
+	ok &= check(
+		(controller.sensor_transform()->result() - 0.5 * coefficients * resource->get()).norm() < 1e-12,
+		"wrong weighted sum"
+	);
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
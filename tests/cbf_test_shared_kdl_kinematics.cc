@@ -0,0 +1,107 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks that a position and an axis angle transform sharing one
+	KDLChainKinematics solve the chain only once per cycle and compute the
+	same results as two transforms solving on their own, also when they 
+	are batch evaluated in parallel on a thread pool.
+*/
+
+#include <cbf/kdl_transforms.h>
+#include <cbf/composite_transform.h>
+#include <cbf/thread_pool.h>
+
+#include <kdl/chain.hpp>
+#include <kdl/segment.hpp>
+#include <kdl/joint.hpp>
+#include <kdl/frames.hpp>
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace CBF;
+
+boost::shared_ptr<KDL::Chain> create_chain() {
+	boost::shared_ptr<KDL::Chain> chain(new KDL::Chain);
+
+	for (unsigned int i = 0; i < 7; ++i)
+		chain->addSegment(KDL::Segment(
+			KDL::Joint(i % 2 ? KDL::Joint::RotY : KDL::Joint::RotZ),
+			KDL::Frame(KDL::Vector(0.0, 0.0, 0.2))
+		));
+
+	return chain;
+}
+
+int main() {
+	boost::shared_ptr<KDL::Chain> chain = create_chain();
+
+	CompositeSensorTransform separate(
+		SensorTransformPtr(new KDLChainPositionSensorTransform(chain)),
+		SensorTransformPtr(new KDLChainAxisAngleSensorTransform(chain))
+	);
+
+	KDLChainKinematicsPtr kinematics(new KDLChainKinematics(chain));
+	CompositeSensorTransform shared(
+		SensorTransformPtr(new KDLChainPositionSensorTransform(kinematics)),
+		SensorTransformPtr(new KDLChainAxisAngleSensorTransform(kinematics))
+	);
+
+	const unsigned int cycles = 100;
+	FloatVector resource_value = FloatVector::Zero(7);
+
+	for (unsigned int i = 0; i < cycles; ++i) {
+		resource_value.array() += 0.01;
+
+		separate.update(resource_value);
+		shared.update(resource_value);
+
+		if (separate.result() != shared.result() || separate.task_jacobian() != shared.task_jacobian()) {
+			std::cerr << "Shared kinematics differ in cycle " << i << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (kinematics->computations() != cycles) {
+		std::cerr << "Solved the chain " << kinematics->computations() << " times in " << cycles << " cycles" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (kinematics->jacobian_computations() != cycles) {
+		std::cerr << "Computed the jacobian " << kinematics->jacobian_computations() << " times in " << cycles << " cycles" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	//! The children of the pooled composite run their batches at the same time
+	shared.set_thread_pool(ThreadPoolPtr(new ThreadPool(2)));
+
+	const FloatMatrix resource_values = FloatMatrix::Random(7, 500);
+	FloatMatrix separate_results, separate_task_jacobians, shared_results, shared_task_jacobians;
+
+	for (unsigned int i = 0; i < 20; ++i) {
+		separate.update_batch(resource_values, separate_results, separate_task_jacobians);
+		shared.update_batch(resource_values, shared_results, shared_task_jacobians);
+
+		if (separate_results != shared_results || separate_task_jacobians != shared_task_jacobians) {
+			std::cerr << "Pooled batches of shared kinematics differ in run " << i << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,233 @@
+/*
+    This file is part of CBF.
+
+    CBF is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    CBF is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CBF.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+	Checks that JerkLimitedTaskSpacePlan stays within its velocity,
+	acceleration and jerk limits and arrives exactly at the target, from
+	rest, from a moving start and with targets changing while it moves,
+	and prints how long an update and a replan take.
+*/
+
+#include <cbf/task_space_plan.h>
+#include <cbf/dummy_reference.h>
+
+#include <sys/time.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace CBF;
+
+const Float cycle_time = 0.001;
+
+double seconds() {
+	timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+struct Limits {
+	FloatVector velocity, acceleration, jerk;
+
+	Limits(unsigned int dim) :
+		velocity(FloatVector::LinSpaced(dim, 0.5, 1.0)),
+		acceleration(FloatVector::LinSpaced(dim, 2.0, 1.0)),
+		jerk(FloatVector::LinSpaced(dim, 10.0, 30.0))
+	{ }
+};
+
+//! Runs the plan for cycles cycles (or until it arrives if cycles is 0), checking the limits
+bool run(const std::string &name, JerkLimitedTaskSpacePlan &plan, const Limits &limits, unsigned int cycles) {
+	const Float tolerance = 1e-9;
+	FloatVector last_position = plan.position();
+	FloatVector last_acceleration = plan.acceleration();
+
+	for (unsigned int cycle = 0; cycles == 0 ? !plan.reached() : cycle < cycles; ++cycle) {
+		if (cycle > 1000000) {
+			std::cerr << name << ": does not arrive" << std::endl;
+			return false;
+		}
+
+		plan.update();
+
+		const FloatVector velocity = plan.velocity(), acceleration = plan.acceleration();
+		const FloatVector jerk = (acceleration - last_acceleration) / cycle_time;
+
+		for (unsigned int i = 0; i < plan.dim(); ++i) {
+			if (
+				std::fabs(velocity[i]) > limits.velocity[i] + tolerance ||
+				std::fabs(acceleration[i]) > limits.acceleration[i] + tolerance ||
+				std::fabs(jerk[i]) > limits.jerk[i] * (1 + 1e-6)
+			) {
+				std::cerr << name << ": dimension " << i << " exceeds the limits in cycle " << cycle
+					<< ": v " << velocity[i] << ", a " << acceleration[i] << ", j " << jerk[i] << std::endl;
+				return false;
+			}
+		}
+
+		//! The reference moves at the velocity
+		if ((plan.position() - last_position).norm() > (limits.velocity.norm() + tolerance) * cycle_time) {
+			std::cerr << name << ": jumps in cycle " << cycle << std::endl;
+			return false;
+		}
+
+		if ((plan.get()[0] - plan.position()).norm() != 0) {
+			std::cerr << name << ": reference and position differ" << std::endl;
+			return false;
+		}
+
+		last_position = plan.position();
+		last_acceleration = acceleration;
+	}
+
+	return true;
+}
+
+bool check_from_rest() {
+	const unsigned int dim = 3;
+	Limits limits(dim);
+	DummyReferencePtr reference(new DummyReference(1, dim));
+	JerkLimitedTaskSpacePlan plan(reference, limits.velocity, limits.acceleration, limits.jerk, cycle_time);
+
+	plan.reset(FloatVector::Zero(dim));
+
+	FloatVector target(dim);
+	target << 1.0, -0.02, 0.3;
+	reference->set_reference(target);
+
+	if (!run("from rest", plan, limits, 0))
+		return false;
+
+	if ((plan.position() - target).norm() != 0 || plan.velocity().norm() != 0) {
+		std::cerr << "from rest: ends at " << plan.position().transpose() << std::endl;
+		return false;
+	}
+
+	//! Dimension 0 is the slowest, allow it the time without jerk limit plus two jerk ramps
+	const Float bound = 1.0 / 0.5 + 0.5 / 2.0 + 2 * 2.0 / 10.0 + 0.01;
+	plan.reset(FloatVector::Zero(dim));
+	if (plan.remaining_time() > bound) {
+		std::cerr << "from rest: plans " << plan.remaining_time() << " s" << std::endl;
+		return false;
+	}
+
+	unsigned int cycles = 0;
+	while (!plan.reached()) {
+		plan.update();
+		++cycles;
+	}
+
+	if (cycles * cycle_time > bound) {
+		std::cerr << "from rest: took " << cycles * cycle_time << " s" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool check_moving_start() {
+	const unsigned int dim = 2;
+	Limits limits(dim);
+	DummyReferencePtr reference(new DummyReference(1, dim));
+	JerkLimitedTaskSpacePlan plan(reference, limits.velocity, limits.acceleration, limits.jerk, cycle_time);
+
+	//! Heading away from the target, still accelerating but able to stay below the maximum velocity
+	FloatVector velocity(dim), acceleration(dim);
+	velocity << 0.4, -0.9;
+	acceleration << 0.8, -0.5;
+	reference->set_reference(FloatVector::Constant(dim, -0.1));
+	plan.reset(FloatVector::Zero(dim), velocity, acceleration);
+
+	if (!run("moving start", plan, limits, 0))
+		return false;
+
+	if ((plan.position() - reference->get()[0]).norm() != 0) {
+		std::cerr << "moving start: ends at " << plan.position().transpose() << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool check_changing_targets() {
+	const unsigned int dim = 6;
+	Limits limits(dim);
+	DummyReferencePtr reference(new DummyReference(1, dim));
+	JerkLimitedTaskSpacePlan plan(reference, limits.velocity, limits.acceleration, limits.jerk, cycle_time);
+	plan.reset(FloatVector::Zero(dim));
+
+	for (unsigned int i = 0; i < 200; ++i) {
+		reference->set_reference(FloatVector::Random(dim));
+		if (!run("changing targets", plan, limits, 1 + rand() % 500))
+			return false;
+	}
+
+	if (!run("changing targets", plan, limits, 0))
+		return false;
+
+	if ((plan.position() - reference->get()[0]).norm() != 0) {
+		std::cerr << "changing targets: ends at " << plan.position().transpose() << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+void time_updates() {
+	const unsigned int dim = 6, cycles = 10000;
+	Limits limits(dim);
+	DummyReferencePtr reference(new DummyReference(1, dim));
+	JerkLimitedTaskSpacePlan plan(reference, limits.velocity, limits.acceleration, limits.jerk, cycle_time);
+	plan.reset(FloatVector::Zero(dim));
+	reference->set_reference(FloatVector::Constant(dim, 100));
+
+	double start = seconds();
+	for (unsigned int i = 0; i < cycles; ++i)
+		plan.update();
+	const double update_time = (seconds() - start) / cycles;
+
+	std::vector<FloatVector> targets;
+	for (unsigned int i = 0; i < 1000; ++i)
+		targets.push_back(FloatVector::Random(dim));
+
+	start = seconds();
+	for (unsigned int i = 0; i < targets.size(); ++i) {
+		reference->set_reference(targets[i]);
+		plan.update();
+	}
+	const double replan_time = (seconds() - start) / targets.size();
+
+	std::cout << "JerkLimitedTaskSpacePlan, " << dim << " dimensions" << std::endl;
+	std::cout << "  update: " << 1e6 * update_time << " us" << std::endl;
+	std::cout << "  replan: " << 1e6 * replan_time << " us" << std::endl;
+}
+
+int main() {
+	srand(0);
+	bool ok = true;
+
+	ok &= check_from_rest();
+	ok &= check_moving_start();
+	ok &= check_changing_targets();
+
+	time_updates();
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}